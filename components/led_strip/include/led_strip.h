@@ -0,0 +1,319 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_strip_rmt.h"
+#include "esp_idf_version.h"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+#include "led_strip_spi.h"
+#include "led_strip_i2s.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Set RGB for a specific pixel
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param red: red part of color
+ * @param green: green part of color
+ * @param blue: blue part of color
+ *
+ * @return
+ *      - ESP_OK: Set RGB for a specific pixel successfully
+ *      - ESP_ERR_INVALID_ARG: Set RGB for a specific pixel failed because of invalid parameters
+ *      - ESP_FAIL: Set RGB for a specific pixel failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
+
+/**
+ * @brief Set RGBW for a specific pixel
+ *
+ * @note Only call this function if your led strip does have the white component (e.g. SK6812-RGBW)
+ * @note Also see `led_strip_set_pixel` if you only want to specify the RGB part of the color and bypass the white component
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param red: red part of color
+ * @param green: green part of color
+ * @param blue: blue part of color
+ * @param white: separate white component
+ *
+ * @return
+ *      - ESP_OK: Set RGBW color for a specific pixel successfully
+ *      - ESP_ERR_INVALID_ARG: Set RGBW color for a specific pixel failed because of an invalid argument
+ *      - ESP_FAIL: Set RGBW color for a specific pixel failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
+
+/**
+ * @brief Set a span of consecutive pixels from a buffer
+ *
+ * @note The span is checked once, and backends supporting it convert the whole span at once, which is much faster
+ *       than calling `led_strip_set_pixel` for each pixel
+ *
+ * @param strip: LED strip
+ * @param offset: index of the first pixel to set
+ * @param src: pixel data, 3 bytes (red, green, blue) or 4 bytes (red, green, blue, white) per pixel
+ * @param count: number of pixels to set
+ * @param format: layout of the pixel data, `LED_STRIP_SRC_FORMAT_RGBW` is only allowed for strips with a white component
+ *
+ * @return
+ *      - ESP_OK: Set the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Set the pixels failed because of an invalid argument
+ *      - ESP_FAIL: Set the pixels failed because other error occurred
+ */
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t offset, const uint8_t *src, uint32_t count, led_strip_src_format_t format);
+
+/**
+ * @brief Set a span of consecutive pixels to the same RGB color
+ *
+ * @param strip: LED strip
+ * @param offset: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param red: red part of color
+ * @param green: green part of color
+ * @param blue: blue part of color
+ *
+ * @return
+ *      - ESP_OK: Fill the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Fill the pixels failed because of an invalid argument
+ *      - ESP_FAIL: Fill the pixels failed because other error occurred
+ */
+esp_err_t led_strip_fill(led_strip_handle_t strip, uint32_t offset, uint32_t count, uint32_t red, uint32_t green, uint32_t blue);
+
+/**
+ * @brief Set a span of consecutive pixels to the same RGBW color
+ *
+ * @note Only call this function if your led strip does have the white component (e.g. SK6812-RGBW)
+ *
+ * @param strip: LED strip
+ * @param offset: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param red: red part of color
+ * @param green: green part of color
+ * @param blue: blue part of color
+ * @param white: separate white component
+ *
+ * @return
+ *      - ESP_OK: Fill the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Fill the pixels failed because of an invalid argument
+ *      - ESP_FAIL: Fill the pixels failed because other error occurred
+ */
+esp_err_t led_strip_fill_rgbw(led_strip_handle_t strip, uint32_t offset, uint32_t count, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
+
+/**
+ * @brief Read back the color of a specific pixel, as last set
+ *
+ * @note The color is decoded from the backend's own buffer, so the application doesn't need to keep a copy of the strip
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to read
+ * @param red: returned red part of color
+ * @param green: returned green part of color
+ * @param blue: returned blue part of color
+ *
+ * @return
+ *      - ESP_OK: Read the pixel successfully
+ *      - ESP_ERR_INVALID_ARG: Read the pixel failed because of an invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: Read the pixel failed because the backend doesn't support reading back
+ */
+esp_err_t led_strip_get_pixel(led_strip_handle_t strip, uint32_t index, uint8_t *red, uint8_t *green, uint8_t *blue);
+
+/**
+ * @brief Read back a span of consecutive pixels, as last set
+ *
+ * @param strip: LED strip
+ * @param offset: index of the first pixel to read
+ * @param dst: output buffer, receives 3 bytes (red, green, blue) or 4 bytes (red, green, blue, white) per pixel
+ * @param count: number of pixels to read
+ * @param format: layout of the output, `LED_STRIP_SRC_FORMAT_RGBW` is only allowed for strips with a white component
+ *
+ * @return
+ *      - ESP_OK: Read the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Read the pixels failed because of an invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: Read the pixels failed because the backend doesn't support reading back
+ */
+esp_err_t led_strip_get_pixels(led_strip_handle_t strip, uint32_t offset, uint8_t *dst, uint32_t count, led_strip_src_format_t format);
+
+/**
+ * @brief Set the global brightness field of a pixel
+ *
+ * @note Only clocked LEDs (APA102, SK9822, HD108) have a brightness field. It scales the LED current on top of the color,
+ *       so dim colors keep their full color resolution. The brightness is kept when the color of the pixel changes,
+ *       and is `LED_STRIP_BRIGHTNESS_MAX` after the strip is created.
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param brightness: brightness level, 0 - `LED_STRIP_BRIGHTNESS_MAX`
+ *
+ * @return
+ *      - ESP_OK: Set the brightness successfully
+ *      - ESP_ERR_INVALID_ARG: Set the brightness failed because of an invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: Set the brightness failed because the LEDs have no brightness field
+ */
+esp_err_t led_strip_set_pixel_brightness(led_strip_handle_t strip, uint32_t index, uint8_t brightness);
+
+/**
+ * @brief Set the color lookup table applied to the pixels when they are sent to the LEDs
+ *
+ * @note The table is not copied, it must stay valid while it is set. After changing its content, call this function again:
+ *       the whole strip is sent with the new table at the next refresh, without setting the pixels again.
+ *       The pixels read back by `led_strip_get_pixels` are the colors set, before the table.
+ *
+ * @param strip: LED strip
+ * @param lut: color lookup table, NULL to send the colors as they are
+ *
+ * @return
+ *      - ESP_OK: Set the color lookup table successfully
+ *      - ESP_ERR_INVALID_ARG: Set the color lookup table failed because of an invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: Set the color lookup table failed because the backend doesn't support it
+ *      - ESP_ERR_NO_MEM: Set the color lookup table failed because of out of memory
+ */
+esp_err_t led_strip_set_color_lut(led_strip_handle_t strip, const led_strip_color_lut_t *lut);
+
+/**
+ * @brief Fill a color lookup table with a gamma curve, scaled by a gain per channel (white balance) and a brightness
+ *
+ * Each entry is `255 * (level / 255) ^ gamma * gain / 255 * brightness / 255`, rounded to the nearest level.
+ * A gamma of 1 with gains and brightness of 255 gives the identity table.
+ *
+ * @param lut: color lookup table to fill
+ * @param gamma: gamma of the LEDs, e.g. 2.2, 1 for none
+ * @param gain: gain of red, green, blue and white, 0 - 255
+ * @param brightness: brightness of all the channels, 0 - 255
+ *
+ * @return
+ *      - ESP_OK: Fill the color lookup table successfully
+ *      - ESP_ERR_INVALID_ARG: Fill the color lookup table failed because of an invalid argument
+ */
+esp_err_t led_strip_color_lut_init(led_strip_color_lut_t *lut, float gamma, const uint8_t gain[4], uint8_t brightness);
+
+/**
+ * @brief Set the white extraction table applied to the pixels of RGBW LEDs when they are sent to the LEDs
+ *
+ * The white LED of each pixel takes over the part of red, green and blue its light can reproduce, added to the white set.
+ * The extraction runs after the color lookup table, if one is set, so it works on the levels sent to the LEDs.
+ *
+ * @note The table is not copied, it must stay valid while it is set. After changing its content, call this function again.
+ *       The pixels read back by `led_strip_get_pixels` are the colors set, before the extraction.
+ *
+ * @param strip: LED strip
+ * @param lut: white extraction table, NULL to send the colors as they are
+ *
+ * @return
+ *      - ESP_OK: Set the white extraction table successfully
+ *      - ESP_ERR_INVALID_ARG: Set the white extraction table failed because of an invalid argument, or the LEDs have no white channel
+ *      - ESP_ERR_NOT_SUPPORTED: Set the white extraction table failed because the backend doesn't support it
+ *      - ESP_ERR_NO_MEM: Set the white extraction table failed because of out of memory
+ */
+esp_err_t led_strip_set_white_lut(led_strip_handle_t strip, const led_strip_white_lut_t *lut);
+
+/**
+ * @brief Fill a white extraction table from the color of the white LEDs' light
+ *
+ * The color is the red, green and blue levels matching the light of the white LED at full level.
+ * {255, 255, 255} extracts the minimum of red, green and blue, a warm white LED has less blue, e.g. {255, 200, 140}.
+ *
+ * @param lut: white extraction table to fill
+ * @param white_rgb: red, green and blue of the white LED at full level, at least one of them not 0
+ *
+ * @return
+ *      - ESP_OK: Fill the white extraction table successfully
+ *      - ESP_ERR_INVALID_ARG: Fill the white extraction table failed because of an invalid argument
+ */
+esp_err_t led_strip_white_lut_init(led_strip_white_lut_t *lut, const uint8_t white_rgb[3]);
+
+/**
+ * @brief Set HSV for a specific pixel
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param hue: hue part of color (0 - 360)
+ * @param saturation: saturation part of color (0 - 255)
+ * @param value: value part of color (0 - 255)
+ *
+ * @return
+ *      - ESP_OK: Set HSV color for a specific pixel successfully
+ *      - ESP_ERR_INVALID_ARG: Set HSV color for a specific pixel failed because of an invalid argument
+ *      - ESP_FAIL: Set HSV color for a specific pixel failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint8_t saturation, uint8_t value);
+
+/**
+ * @brief Set a span of consecutive pixels from HSV colors
+ *
+ * @note The colors are converted with `led_strip_hsv_to_rgb` and set with `led_strip_set_pixels`, a few pixels at a time,
+ *       so a span running past the end of the strip may have been set up to the last full chunk when the error is returned
+ *
+ * @param strip: LED strip
+ * @param offset: index of the first pixel to set
+ * @param src: HSV color of each pixel
+ * @param count: number of pixels to set
+ *
+ * @return
+ *      - ESP_OK: Set the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Set the pixels failed because of an invalid argument
+ *      - ESP_FAIL: Set the pixels failed because other error occurred
+ */
+esp_err_t led_strip_set_pixels_hsv(led_strip_handle_t strip, uint32_t offset, const led_strip_hsv_t *src, uint32_t count);
+
+/**
+ * @brief Convert HSV colors to RGB
+ *
+ * The result is the same as the conversion of `led_strip_set_pixel_hsv`, computed in fixed point without division.
+ *
+ * @param src: HSV color of each pixel
+ * @param dst: red, green and blue of each pixel, 3 bytes per pixel
+ * @param count: number of pixels to convert
+ */
+void led_strip_hsv_to_rgb(const led_strip_hsv_t *src, uint8_t *dst, uint32_t count);
+
+/**
+ * @brief Refresh memory colors to LEDs
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Refresh successfully
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ *
+ * @note:
+ *      After updating the LED colors in the memory, a following invocation of this API is needed to flush colors to strip.
+ */
+esp_err_t led_strip_refresh(led_strip_handle_t strip);
+
+/**
+ * @brief Clear LED strip (turn off all LEDs)
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Clear LEDs successfully
+ *      - ESP_FAIL: Clear LEDs failed because some other error occurred
+ */
+esp_err_t led_strip_clear(led_strip_handle_t strip);
+
+/**
+ * @brief Free LED strip resources
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Free resources successfully
+ *      - ESP_FAIL: Free resources failed because error occurred
+ */
+esp_err_t led_strip_del(led_strip_handle_t strip);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LED_STRIP_I2S_MAX_LANES 16 /*!< Maximum number of strips driven by one parallel bus */
+
+/**
+ * @brief LED Strip I2S/LCD parallel specific configuration
+ */
+typedef struct {
+    lcd_clock_source_t clk_src;                   /*!< Parallel bus clock source */
+    uint8_t lane_count;                           /*!< Number of strips driven in parallel, 8 or 16 */
+    int data_gpio_nums[LED_STRIP_I2S_MAX_LANES];  /*!< GPIO of each strip's data line, only the first `lane_count` entries are used */
+    int wr_gpio_num;                              /*!< GPIO for the bus write strobe. The strips don't need it, but the peripheral does, so set a spare GPIO */
+    int dc_gpio_num;                              /*!< GPIO for the bus D/C signal. The strips don't need it, but the peripheral does, so set a spare GPIO */
+} led_strip_i2s_config_t;
+
+/**
+ * @brief Create LED strip based on the I2S (ESP32) or LCD_CAM (ESP32-S3) peripheral in parallel mode
+ *
+ * @note All lanes share one LED strip handle. `led_config->max_leds` is the number of LEDs per lane,
+ *       pixel `index` of the handle addresses LED `index % max_leds` of lane `index / max_leds`.
+ * @note `led_config->strip_gpio_num` is ignored, use `data_gpio_nums` instead.
+ *
+ * @param led_config LED strip configuration
+ * @param i2s_config I2S/LCD specific configuration
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: create LED strip handle successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip handle failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: create LED strip handle failed because of out of memory
+ *      - ESP_FAIL: create LED strip handle failed because some other error
+ */
+esp_err_t led_strip_new_i2s_device(const led_strip_config_t *led_config, const led_strip_i2s_config_t *i2s_config, led_strip_handle_t *ret_strip);
+
+#ifdef __cplusplus
+}
+#endif
@@ -31,6 +31,8 @@ typedef struct {
     size_t mem_block_symbols;   /*!< How many RMT symbols can one RMT channel hold at one time. Set to 0 will fallback to use the default size. */
     struct {
         uint32_t with_dma: 1;   /*!< Use DMA to transmit data */
+        uint32_t symbol_cache: 1; /*!< Keep the whole strip encoded as RMT symbols (32 bytes per pixel byte), and only encode the pixels
+                                       changed since the previous refresh. Not supported by the legacy RMT driver */
     } flags;                    /*!< Extra driver flags */
 } led_strip_rmt_config_t;
 
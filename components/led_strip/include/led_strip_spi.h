@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/spi_master.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LED Strip SPI specific configuration
+ */
+typedef struct {
+    spi_clock_source_t clk_src; /*!< SPI clock source */
+    spi_host_device_t spi_bus;  /*!< SPI bus ID. Which buses are available depends on the specific chip */
+    int clk_gpio_num;           /*!< GPIO of the clock line, for clocked LEDs (APA102, SK9822, HD108) only */
+    uint32_t clock_hz;          /*!< SPI clock of clocked LEDs, 0 to use the default of the LED model. Ignored for the other LEDs,
+                                     whose clock is derived from their timing */
+    struct {
+        uint32_t with_dma: 1;   /*!< Use DMA to transmit data */
+        uint32_t streaming: 1;  /*!< Keep a compact framebuffer (3-4 bytes per LED) and encode it on the fly into two small DMA buffers,
+                                     instead of keeping the whole encoded strip (9-12 bytes per LED) in DMA capable memory. Requires `with_dma` */
+    } flags;                    /*!< Extra driver flags */
+} led_strip_spi_config_t;
+
+/**
+ * @brief Create LED strip based on SPI MOSI channel
+ * @note Although only the MOSI line is used for generating the signal, the whole SPI bus can't be used for other purposes.
+ * @note Clocked LEDs (APA102, SK9822, HD108) use the SCLK line as well, on `clk_gpio_num`. Their frames are sent as they are,
+ *       the `streaming` flag and `invert_out` are not supported for them.
+ *
+ * @param led_config LED strip configuration
+ * @param spi_config SPI specific configuration
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: create LED strip handle successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip handle failed because of invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: create LED strip handle failed because of unsupported configuration
+ *      - ESP_ERR_NO_MEM: create LED strip handle failed because of out of memory
+ *      - ESP_FAIL: create LED strip handle failed because some other error
+ */
+esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const led_strip_spi_config_t *spi_config, led_strip_handle_t *ret_strip);
+
+/**
+ * @brief Get the number of SPI bits sent per LED data bit for a one-wire LED model, as `led_strip_new_spi_device` would select it
+ *
+ * The encoded strip takes that many bytes of DMA capable memory per LED data byte, and so does each streaming buffer,
+ * per LED data byte it holds. No SPI bus or device is needed, the SPI clock is computed from the clock source.
+ *
+ * @param clk_src SPI clock source, 0 for the default one
+ * @param led_model LED model, LED_MODEL_WS2812 or LED_MODEL_SK6812
+ * @param ret_bits_per_bit Returned SPI bits per LED bit
+ * @return
+ *      - ESP_OK: the SPI bits per LED bit are returned
+ *      - ESP_ERR_INVALID_ARG: invalid argument, or a clocked LED model
+ *      - ESP_ERR_NOT_SUPPORTED: no SPI clock fits the timing of the LED model
+ */
+esp_err_t led_strip_spi_get_bits_per_bit(spi_clock_source_t clk_src, led_model_t led_model, uint8_t *ret_bits_per_bit);
+
+#ifdef __cplusplus
+}
+#endif
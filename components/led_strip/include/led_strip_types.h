@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LED strip pixel format
+ * @note The order of the channels in the data sent to the LEDs, the colors passed to the API are always red, green, blue (and white).
+ */
+typedef enum {
+    LED_PIXEL_FORMAT_GRB,    /*!< Pixel format: GRB */
+    LED_PIXEL_FORMAT_GRBW,   /*!< Pixel format: GRBW */
+    LED_PIXEL_FORMAT_RGB,    /*!< Pixel format: RGB */
+    LED_PIXEL_FORMAT_BGR,    /*!< Pixel format: BGR */
+    LED_PIXEL_FORMAT_RGBW,   /*!< Pixel format: RGBW */
+    LED_PIXEL_FORMAT_INVALID /*!< Invalid pixel format */
+} led_pixel_format_t;
+
+/**
+ * @brief LED strip model
+ * @note Different led model may have different timing parameters, so we need to distinguish them.
+ */
+typedef enum {
+    LED_MODEL_WS2812, /*!< LED strip model: WS2812 */
+    LED_MODEL_SK6812, /*!< LED strip model: SK6812 */
+    LED_MODEL_APA102, /*!< LED strip model: APA102, clocked, SPI backend only */
+    LED_MODEL_SK9822, /*!< LED strip model: SK9822, clocked, SPI backend only */
+    LED_MODEL_HD108,  /*!< LED strip model: HD108, clocked with 16 bits per color, SPI backend only */
+    LED_MODEL_INVALID /*!< Invalid LED strip model */
+} led_model_t;
+
+#define LED_STRIP_BRIGHTNESS_MAX 31 /*!< Maximum level of the brightness field of clocked LEDs */
+
+/**
+ * @brief Layout of the pixel data passed to `led_strip_set_pixels`
+ */
+typedef enum {
+    LED_STRIP_SRC_FORMAT_RGB,    /*!< 3 bytes per pixel: red, green, blue */
+    LED_STRIP_SRC_FORMAT_RGBW,   /*!< 4 bytes per pixel: red, green, blue, white */
+    LED_STRIP_SRC_FORMAT_INVALID /*!< Invalid source format */
+} led_strip_src_format_t;
+
+/**
+ * @brief HSV color of a pixel, passed to `led_strip_hsv_to_rgb` and `led_strip_set_pixels_hsv`
+ */
+typedef struct {
+    uint16_t hue;       /*!< Hue (0 - 360) */
+    uint8_t saturation; /*!< Saturation (0 - 255) */
+    uint8_t value;      /*!< Value (0 - 255) */
+} led_strip_hsv_t;
+
+/**
+ * @brief Color lookup table, applied to the pixels when a backend encodes them for the LEDs
+ *
+ * One table per channel, typically combining gamma correction, white balance and a master brightness.
+ * The pixels keep the colors they were set to (and read back), the LEDs receive the table entries of these colors.
+ */
+typedef struct {
+    uint8_t channel[4][256]; /*!< Level sent to the LEDs for each level of red, green, blue and white, in this order */
+} led_strip_color_lut_t;
+
+/**
+ * @brief White extraction table of RGBW LEDs, applied to the pixels when a backend encodes them for the LEDs
+ *
+ * The white LED of each pixel takes over the part of red, green and blue it can reproduce, given the color of its light.
+ * The pixels keep the colors they were set to (and read back), the LEDs receive the extracted colors.
+ */
+typedef struct {
+    uint8_t level[3][256]; /*!< Highest white level whose light holds no more than each level of red, green and blue, in this order */
+    uint8_t part[3][256];  /*!< Red, green and blue in the light of each white level */
+} led_strip_white_lut_t;
+
+/**
+ * @brief LED strip handle
+ */
+typedef struct led_strip_t *led_strip_handle_t;
+
+/**
+ * @brief LED Strip Configuration
+ */
+typedef struct {
+    int strip_gpio_num;      /*!< GPIO number that used by LED strip */
+    uint32_t max_leds;       /*!< Maximum LEDs in a single strip */
+    led_pixel_format_t led_pixel_format; /*!< LED pixel format */
+    led_model_t led_model;   /*!< LED model */
+    uint32_t full_refresh_interval; /*!< A refresh only sends the pixels up to the highest one changed since the previous refresh,
+                                         and the whole strip every `full_refresh_interval` refreshes. Set to 0 to use the default (100),
+                                         set to 1 to always send the whole strip */
+
+    struct {
+        uint32_t invert_out: 1; /*!< Invert output signal */
+    } flags;                    /*!< Extra driver flags */
+} led_strip_config_t;
+
+#ifdef __cplusplus
+}
+#endif
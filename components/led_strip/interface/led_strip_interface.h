@@ -0,0 +1,185 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct led_strip_t led_strip_t; /*!< Type of LED strip */
+
+/**
+ * @brief LED strip interface definition
+ */
+struct led_strip_t {
+    /**
+     * @brief Set RGB for a specific pixel
+     *
+     * @param strip: LED strip
+     * @param index: index of pixel to set
+     * @param red: red part of color
+     * @param green: green part of color
+     * @param blue: blue part of color
+     *
+     * @return
+     *      - ESP_OK: Set RGB for a specific pixel successfully
+     *      - ESP_ERR_INVALID_ARG: Set RGB for a specific pixel failed because of invalid parameters
+     *      - ESP_FAIL: Set RGB for a specific pixel failed because other error occurred
+     */
+    esp_err_t (*set_pixel)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
+
+    /**
+     * @brief Set RGBW for a specific pixel. Similar to `set_pixel` but also set the white component
+     *
+     * @param strip: LED strip
+     * @param index: index of pixel to set
+     * @param red: red part of color
+     * @param green: green part of color
+     * @param blue: blue part of color
+     * @param white: separate white component
+     *
+     * @return
+     *      - ESP_OK: Set RGBW color for a specific pixel successfully
+     *      - ESP_ERR_INVALID_ARG: Set RGBW color for a specific pixel failed because of an invalid argument
+     *      - ESP_FAIL: Set RGBW color for a specific pixel failed because other error occurred
+     */
+    esp_err_t (*set_pixel_rgbw)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
+
+    /**
+     * @brief Set a span of consecutive pixels. Optional, `led_strip_set_pixels` falls back to `set_pixel` if it's NULL
+     *
+     * @param strip: LED strip
+     * @param offset: index of the first pixel to set
+     * @param src: pixel data, in the layout given by `format`
+     * @param count: number of pixels to set
+     * @param format: layout of the pixel data
+     *
+     * @return
+     *      - ESP_OK: Set the pixels successfully
+     *      - ESP_ERR_INVALID_ARG: Set the pixels failed because the span is out of the strip or the format doesn't fit the strip
+     *      - ESP_FAIL: Set the pixels failed because other error occurred
+     */
+    esp_err_t (*set_pixels)(led_strip_t *strip, uint32_t offset, const uint8_t *src, uint32_t count, led_strip_src_format_t format);
+
+    /**
+     * @brief Set a span of consecutive pixels to the same color. Optional, `led_strip_fill` falls back to `set_pixel` if it's NULL
+     *
+     * @param strip: LED strip
+     * @param offset: index of the first pixel to set
+     * @param count: number of pixels to set
+     * @param color: one pixel, in the layout given by `format`
+     * @param format: layout of the pixel
+     *
+     * @return
+     *      - ESP_OK: Fill the pixels successfully
+     *      - ESP_ERR_INVALID_ARG: Fill the pixels failed because the span is out of the strip or the format doesn't fit the strip
+     *      - ESP_FAIL: Fill the pixels failed because other error occurred
+     */
+    esp_err_t (*fill)(led_strip_t *strip, uint32_t offset, uint32_t count, const uint8_t *color, led_strip_src_format_t format);
+
+    /**
+     * @brief Read back a span of consecutive pixels from the backend's buffer. Optional, `led_strip_get_pixels` fails if it's NULL
+     *
+     * @param strip: LED strip
+     * @param offset: index of the first pixel to read
+     * @param dst: output buffer, in the layout given by `format`
+     * @param count: number of pixels to read
+     * @param format: layout of the output
+     *
+     * @return
+     *      - ESP_OK: Read the pixels successfully
+     *      - ESP_ERR_INVALID_ARG: Read the pixels failed because the span is out of the strip or the format doesn't fit the strip
+     *      - ESP_FAIL: Read the pixels failed because other error occurred
+     */
+    esp_err_t (*get_pixels)(led_strip_t *strip, uint32_t offset, uint8_t *dst, uint32_t count, led_strip_src_format_t format);
+
+    /**
+     * @brief Set the global brightness field of a pixel, for LEDs that have one. Optional, `led_strip_set_pixel_brightness` fails if it's NULL
+     *
+     * @param strip: LED strip
+     * @param index: index of pixel to set
+     * @param brightness: brightness level, 0 - 31
+     *
+     * @return
+     *      - ESP_OK: Set the brightness successfully
+     *      - ESP_ERR_INVALID_ARG: Set the brightness failed because of invalid parameters
+     *      - ESP_FAIL: Set the brightness failed because other error occurred
+     */
+    esp_err_t (*set_pixel_brightness)(led_strip_t *strip, uint32_t index, uint8_t brightness);
+
+    /**
+     * @brief Set the color lookup table applied when the pixels are encoded. Optional, `led_strip_set_color_lut` fails if it's NULL
+     *
+     * @param strip: LED strip
+     * @param lut: color lookup table, kept by reference, NULL to send the colors as they are
+     *
+     * @return
+     *      - ESP_OK: Set the color lookup table successfully
+     *      - ESP_ERR_NO_MEM: Set the color lookup table failed because of out of memory
+     *      - ESP_FAIL: Set the color lookup table failed because other error occurred
+     */
+    esp_err_t (*set_color_lut)(led_strip_t *strip, const led_strip_color_lut_t *lut);
+
+    /**
+     * @brief Set the white extraction table applied when the pixels are encoded. Optional, `led_strip_set_white_lut` fails if it's NULL
+     *
+     * @param strip: LED strip
+     * @param lut: white extraction table, kept by reference, NULL to send the colors as they are
+     *
+     * @return
+     *      - ESP_OK: Set the white extraction table successfully
+     *      - ESP_ERR_INVALID_ARG: Set the white extraction table failed because the LEDs have no white channel
+     *      - ESP_ERR_NO_MEM: Set the white extraction table failed because of out of memory
+     *      - ESP_FAIL: Set the white extraction table failed because other error occurred
+     */
+    esp_err_t (*set_white_lut)(led_strip_t *strip, const led_strip_white_lut_t *lut);
+
+    /**
+     * @brief Refresh memory colors to LEDs
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: timeout value for refreshing task
+     *
+     * @return
+     *      - ESP_OK: Refresh successfully
+     *      - ESP_FAIL: Refresh failed because some other error occurred
+     *
+     * @note:
+     *      After updating the LED colors in the memory, a following invocation of this API is needed to flush colors to strip.
+     */
+    esp_err_t (*refresh)(led_strip_t *strip);
+
+    /**
+     * @brief Clear LED strip (turn off all LEDs)
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: timeout value for clearing task
+     *
+     * @return
+     *      - ESP_OK: Clear LEDs successfully
+     *      - ESP_FAIL: Clear LEDs failed because some other error occurred
+     */
+    esp_err_t (*clear)(led_strip_t *strip);
+
+    /**
+     * @brief Free LED strip resources
+     *
+     * @param strip: LED strip
+     *
+     * @return
+     *      - ESP_OK: Free resources successfully
+     *      - ESP_FAIL: Free resources failed because error occurred
+     */
+    esp_err_t (*del)(led_strip_t *strip);
+};
+
+#ifdef __cplusplus
+}
+#endif
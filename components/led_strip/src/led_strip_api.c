@@ -0,0 +1,238 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <math.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+
+#define LED_STRIP_HSV_CHUNK 32 // pixels converted on the stack at once by led_strip_set_pixels_hsv
+
+static const char *TAG = "led_strip";
+
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->set_pixel(strip, index, red, green, blue);
+}
+
+esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint8_t saturation, uint8_t value)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    const led_strip_hsv_t hsv = {
+        .hue = hue,
+        .saturation = saturation,
+        .value = value,
+    };
+    uint8_t rgb[3];
+    led_strip_hsv_to_rgb(&hsv, rgb, 1);
+    return strip->set_pixel(strip, index, rgb[0], rgb[1], rgb[2]);
+}
+
+esp_err_t led_strip_set_pixels_hsv(led_strip_handle_t strip, uint32_t offset, const led_strip_hsv_t *src, uint32_t count)
+{
+    ESP_RETURN_ON_FALSE(strip && (src || count == 0), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint8_t rgb[LED_STRIP_HSV_CHUNK * 3];
+    while (count > 0) {
+        uint32_t chunk = count < LED_STRIP_HSV_CHUNK ? count : LED_STRIP_HSV_CHUNK;
+        led_strip_hsv_to_rgb(src, rgb, chunk);
+        ESP_RETURN_ON_ERROR(led_strip_set_pixels(strip, offset, rgb, chunk, LED_STRIP_SRC_FORMAT_RGB), TAG, "set pixels failed");
+        offset += chunk;
+        src += chunk;
+        count -= chunk;
+    }
+    return ESP_OK;
+}
+
+void led_strip_hsv_to_rgb(const led_strip_hsv_t *src, uint8_t *dst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++, dst += 3) {
+        uint32_t rgb_max = src[i].value;
+        // rgb_max * (255 - saturation) / 255, the multiplication by 0x8081 >> 23 is exact for all products of two 8-bit values
+        uint32_t rgb_min = (rgb_max * (255 - src[i].saturation) * 0x8081) >> 23;
+
+        // hue / 60 and hue % 60, the multiplication by 0x8889 >> 21 is exact for all 16-bit values
+        uint32_t sector = ((uint32_t)src[i].hue * 0x8889) >> 21;
+        uint32_t diff = src[i].hue - sector * 60;
+
+        // RGB adjustment amount by hue
+        uint32_t rgb_adj = ((rgb_max - rgb_min) * diff * 0x8889) >> 21;
+        uint32_t rgb_up = rgb_min + rgb_adj;
+        uint32_t rgb_down = rgb_max - rgb_adj;
+
+        switch (sector) {
+        case 0:
+            dst[0] = rgb_max;
+            dst[1] = rgb_up;
+            dst[2] = rgb_min;
+            break;
+        case 1:
+            dst[0] = rgb_down;
+            dst[1] = rgb_max;
+            dst[2] = rgb_min;
+            break;
+        case 2:
+            dst[0] = rgb_min;
+            dst[1] = rgb_max;
+            dst[2] = rgb_up;
+            break;
+        case 3:
+            dst[0] = rgb_min;
+            dst[1] = rgb_down;
+            dst[2] = rgb_max;
+            break;
+        case 4:
+            dst[0] = rgb_up;
+            dst[1] = rgb_min;
+            dst[2] = rgb_max;
+            break;
+        default:
+            dst[0] = rgb_max;
+            dst[1] = rgb_min;
+            dst[2] = rgb_down;
+            break;
+        }
+    }
+}
+
+esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->set_pixel_rgbw(strip, index, red, green, blue, white);
+}
+
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t offset, const uint8_t *src, uint32_t count, led_strip_src_format_t format)
+{
+    ESP_RETURN_ON_FALSE(strip && (src || count == 0) && format < LED_STRIP_SRC_FORMAT_INVALID, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (strip->set_pixels) {
+        return strip->set_pixels(strip, offset, src, count, format);
+    }
+    // backend without span support, set the pixels one by one
+    for (uint32_t i = 0; i < count; i++) {
+        if (format == LED_STRIP_SRC_FORMAT_RGBW) {
+            ESP_RETURN_ON_ERROR(strip->set_pixel_rgbw(strip, offset + i, src[0], src[1], src[2], src[3]), TAG, "set pixel failed");
+            src += 4;
+        } else {
+            ESP_RETURN_ON_ERROR(strip->set_pixel(strip, offset + i, src[0], src[1], src[2]), TAG, "set pixel failed");
+            src += 3;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_fill_color(led_strip_handle_t strip, uint32_t offset, uint32_t count, const uint8_t *color, led_strip_src_format_t format)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (strip->fill) {
+        return strip->fill(strip, offset, count, color, format);
+    }
+    // backend without span support, set the pixels one by one
+    for (uint32_t i = 0; i < count; i++) {
+        if (format == LED_STRIP_SRC_FORMAT_RGBW) {
+            ESP_RETURN_ON_ERROR(strip->set_pixel_rgbw(strip, offset + i, color[0], color[1], color[2], color[3]), TAG, "set pixel failed");
+        } else {
+            ESP_RETURN_ON_ERROR(strip->set_pixel(strip, offset + i, color[0], color[1], color[2]), TAG, "set pixel failed");
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_fill(led_strip_handle_t strip, uint32_t offset, uint32_t count, uint32_t red, uint32_t green, uint32_t blue)
+{
+    const uint8_t color[3] = {red, green, blue};
+    return led_strip_fill_color(strip, offset, count, color, LED_STRIP_SRC_FORMAT_RGB);
+}
+
+esp_err_t led_strip_fill_rgbw(led_strip_handle_t strip, uint32_t offset, uint32_t count, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    const uint8_t color[4] = {red, green, blue, white};
+    return led_strip_fill_color(strip, offset, count, color, LED_STRIP_SRC_FORMAT_RGBW);
+}
+
+esp_err_t led_strip_get_pixels(led_strip_handle_t strip, uint32_t offset, uint8_t *dst, uint32_t count, led_strip_src_format_t format)
+{
+    ESP_RETURN_ON_FALSE(strip && (dst || count == 0) && format < LED_STRIP_SRC_FORMAT_INVALID, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->get_pixels, ESP_ERR_NOT_SUPPORTED, TAG, "backend can't read back pixels");
+    return strip->get_pixels(strip, offset, dst, count, format);
+}
+
+esp_err_t led_strip_get_pixel(led_strip_handle_t strip, uint32_t index, uint8_t *red, uint8_t *green, uint8_t *blue)
+{
+    ESP_RETURN_ON_FALSE(red && green && blue, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint8_t rgb[3];
+    ESP_RETURN_ON_ERROR(led_strip_get_pixels(strip, index, rgb, 1, LED_STRIP_SRC_FORMAT_RGB), TAG, "get pixel failed");
+    *red = rgb[0];
+    *green = rgb[1];
+    *blue = rgb[2];
+    return ESP_OK;
+}
+
+esp_err_t led_strip_set_pixel_brightness(led_strip_handle_t strip, uint32_t index, uint8_t brightness)
+{
+    ESP_RETURN_ON_FALSE(strip && brightness <= LED_STRIP_BRIGHTNESS_MAX, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->set_pixel_brightness, ESP_ERR_NOT_SUPPORTED, TAG, "LEDs have no brightness field");
+    return strip->set_pixel_brightness(strip, index, brightness);
+}
+
+esp_err_t led_strip_set_color_lut(led_strip_handle_t strip, const led_strip_color_lut_t *lut)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->set_color_lut, ESP_ERR_NOT_SUPPORTED, TAG, "backend can't apply a color lookup table");
+    return strip->set_color_lut(strip, lut);
+}
+
+esp_err_t led_strip_color_lut_init(led_strip_color_lut_t *lut, float gamma, const uint8_t gain[4], uint8_t brightness)
+{
+    ESP_RETURN_ON_FALSE(lut && gain && gamma > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    for (int level = 0; level < 256; level++) {
+        // the curve is computed once per level, the channels only differ by their gain
+        float curve = powf(level / 255.0f, gamma) * brightness / 255.0f;
+        for (int c = 0; c < 4; c++) {
+            lut->channel[c][level] = (uint8_t)(curve * gain[c] + 0.5f);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_set_white_lut(led_strip_handle_t strip, const led_strip_white_lut_t *lut)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->set_white_lut, ESP_ERR_NOT_SUPPORTED, TAG, "backend can't apply a white extraction table");
+    return strip->set_white_lut(strip, lut);
+}
+
+esp_err_t led_strip_white_lut_init(led_strip_white_lut_t *lut, const uint8_t white_rgb[3])
+{
+    ESP_RETURN_ON_FALSE(lut && white_rgb && (white_rgb[0] || white_rgb[1] || white_rgb[2]), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    for (int c = 0; c < 3; c++) {
+        for (int level = 0; level < 256; level++) {
+            // part[c][level[c][x]] <= x, so the extracted part never exceeds the color it is taken from
+            uint32_t white = white_rgb[c] ? level * 255 / white_rgb[c] : 255;
+            lut->level[c][level] = white > 255 ? 255 : white;
+            lut->part[c][level] = (level * white_rgb[c] + 127) / 255;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_refresh(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->refresh(strip);
+}
+
+esp_err_t led_strip_clear(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->clear(strip);
+}
+
+esp_err_t led_strip_del(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->del(strip);
+}
@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// a full-length refresh is forced at least this often, to repair pixels that latched a corrupted frame
+#define LED_STRIP_DEFAULT_FULL_REFRESH_INTERVAL 100
+
+/**
+ * @brief Dirty tracking of a strip's pixel buffer
+ *
+ * WS2812-like pixels keep their latched color if they receive no data, so a refresh only needs to
+ * send the pixels up to the highest one that changed since the previous refresh.
+ */
+typedef struct {
+    uint32_t dirty_start;           /*!< Lowest pixel index written since the last refresh */
+    uint32_t dirty_len;             /*!< One past the highest pixel index written since the last refresh */
+    uint32_t refresh_count;         /*!< Number of refreshes since the last full-length one */
+    uint32_t full_refresh_interval; /*!< Force a full-length refresh every that many refreshes */
+} led_strip_dirty_t;
+
+static inline void led_strip_dirty_init(led_strip_dirty_t *dirty, uint32_t strip_len, uint32_t full_refresh_interval)
+{
+    // the state of the LEDs is unknown after power-up, so the first refresh covers the whole strip
+    dirty->dirty_start = 0;
+    dirty->dirty_len = strip_len;
+    dirty->refresh_count = 0;
+    dirty->full_refresh_interval = full_refresh_interval ? full_refresh_interval : LED_STRIP_DEFAULT_FULL_REFRESH_INTERVAL;
+}
+
+static inline void led_strip_dirty_mark(led_strip_dirty_t *dirty, uint32_t index)
+{
+    if (index < dirty->dirty_start) {
+        dirty->dirty_start = index;
+    }
+    if (index >= dirty->dirty_len) {
+        dirty->dirty_len = index + 1;
+    }
+}
+
+/**
+ * @brief Get the range of pixels written since the last refresh, for backends that keep an encoded copy of the strip
+ *
+ * @note Call it before `led_strip_dirty_take`, which starts a new dirty period
+ *
+ * @param[out] start Lowest pixel index written
+ * @return One past the highest pixel index written, not above `start` if nothing was written
+ */
+static inline uint32_t led_strip_dirty_changed(const led_strip_dirty_t *dirty, uint32_t *start)
+{
+    *start = dirty->dirty_start;
+    return dirty->dirty_len;
+}
+
+/**
+ * @brief Get the number of pixels the coming refresh has to send, and start a new dirty period
+ *
+ * @return Number of pixels to send, 0 if nothing changed since the last refresh
+ */
+static inline uint32_t led_strip_dirty_take(led_strip_dirty_t *dirty, uint32_t strip_len)
+{
+    uint32_t len = dirty->dirty_len;
+    if (++dirty->refresh_count >= dirty->full_refresh_interval) {
+        dirty->refresh_count = 0;
+        len = strip_len;
+    }
+    dirty->dirty_start = UINT32_MAX;
+    dirty->dirty_len = 0;
+    return len;
+}
+
+/**
+ * @brief Give back the pixels taken by `led_strip_dirty_take` if the refresh failed
+ */
+static inline void led_strip_dirty_restore(led_strip_dirty_t *dirty, uint32_t len)
+{
+    if (len > dirty->dirty_len) {
+        dirty->dirty_len = len;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,222 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_io.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "led_strip_i2s_encoder.h"
+#include "led_strip_pixels.h"
+
+// three bus slots per LED bit, 1.25us per bit
+#define LED_STRIP_I2S_PCLK_HZ (LED_STRIP_I2S_SLOTS_PER_BIT * 800 * 1000)
+#define LED_STRIP_I2S_DEFAULT_TRANS_QUEUE_SIZE 1
+// reset code duration defaults to 50us, same as the RMT backend
+#define LED_STRIP_I2S_RESET_SLOTS (LED_STRIP_I2S_PCLK_HZ / 1000000 * 50)
+
+static const char *TAG = "led_strip_i2s";
+
+typedef struct {
+    led_strip_t base;
+    esp_lcd_i80_bus_handle_t i80_bus;
+    esp_lcd_panel_io_handle_t io;
+    SemaphoreHandle_t trans_done;
+    uint8_t *dma_buf;
+    size_t dma_buf_size;
+    uint32_t strip_len; // number of LEDs per lane
+    uint8_t lane_count;
+    const led_strip_pixel_format_ops_t *pixel_ops; // channel order and width of the pixels
+    uint8_t bytes_per_pixel;
+    uint8_t pixel_buf[]; // pixel data of each lane, one after another
+} led_strip_i2s_obj;
+
+static bool led_strip_i2s_on_trans_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    led_strip_i2s_obj *i2s_strip = (led_strip_i2s_obj *)user_ctx;
+    BaseType_t high_task_wakeup = pdFALSE;
+    xSemaphoreGiveFromISR(i2s_strip->trans_done, &high_task_wakeup);
+    return high_task_wakeup == pdTRUE;
+}
+
+static esp_err_t led_strip_i2s_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_i2s_obj *i2s_strip = __containerof(strip, led_strip_i2s_obj, base);
+    ESP_RETURN_ON_FALSE(index < i2s_strip->strip_len * i2s_strip->lane_count, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    // in the channel order of the LEDs
+    i2s_strip->pixel_ops->set(&i2s_strip->pixel_buf[index * i2s_strip->bytes_per_pixel], red, green, blue, 0);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_i2s_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_i2s_obj *i2s_strip = __containerof(strip, led_strip_i2s_obj, base);
+    ESP_RETURN_ON_FALSE(index < i2s_strip->strip_len * i2s_strip->lane_count, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(i2s_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    i2s_strip->pixel_ops->set(&i2s_strip->pixel_buf[index * 4], red, green, blue, white);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_i2s_set_pixels(led_strip_t *strip, uint32_t offset, const uint8_t *src, uint32_t count, led_strip_src_format_t format)
+{
+    led_strip_i2s_obj *i2s_strip = __containerof(strip, led_strip_i2s_obj, base);
+    // the lanes are one after another in the pixel buffer, so a span may cross into the next lane
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, i2s_strip->strip_len * i2s_strip->lane_count), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(i2s_strip->pixel_ops->convert[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    i2s_strip->pixel_ops->convert[format](&i2s_strip->pixel_buf[offset * i2s_strip->bytes_per_pixel], src, count);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_i2s_fill(led_strip_t *strip, uint32_t offset, uint32_t count, const uint8_t *color, led_strip_src_format_t format)
+{
+    led_strip_i2s_obj *i2s_strip = __containerof(strip, led_strip_i2s_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, i2s_strip->strip_len * i2s_strip->lane_count), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(i2s_strip->pixel_ops->convert[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    led_strip_pixels_fill(i2s_strip->pixel_ops, &i2s_strip->pixel_buf[offset * i2s_strip->bytes_per_pixel], color, count, format);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_i2s_get_pixels(led_strip_t *strip, uint32_t offset, uint8_t *dst, uint32_t count, led_strip_src_format_t format)
+{
+    led_strip_i2s_obj *i2s_strip = __containerof(strip, led_strip_i2s_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, i2s_strip->strip_len * i2s_strip->lane_count), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(i2s_strip->pixel_ops->read[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    i2s_strip->pixel_ops->read[format](dst, &i2s_strip->pixel_buf[offset * i2s_strip->bytes_per_pixel], count);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_i2s_refresh(led_strip_t *strip)
+{
+    led_strip_i2s_obj *i2s_strip = __containerof(strip, led_strip_i2s_obj, base);
+    size_t lane_bytes = i2s_strip->strip_len * i2s_strip->bytes_per_pixel;
+    const uint8_t *lanes[LED_STRIP_I2S_MAX_LANES];
+    for (int i = 0; i < i2s_strip->lane_count; i++) {
+        lanes[i] = i2s_strip->pixel_buf + i * lane_bytes;
+    }
+
+    // the previous transaction must have finished before the DMA buffer can be rewritten
+    xSemaphoreTake(i2s_strip->trans_done, portMAX_DELAY);
+    if (i2s_strip->lane_count == 8) {
+        led_strip_i2s_encode_8(lanes, lane_bytes, i2s_strip->dma_buf);
+    } else {
+        led_strip_i2s_encode_16(lanes, lane_bytes, (uint16_t *)i2s_strip->dma_buf);
+    }
+    esp_err_t ret = esp_lcd_panel_io_tx_color(i2s_strip->io, -1, i2s_strip->dma_buf, i2s_strip->dma_buf_size);
+    if (ret != ESP_OK) {
+        xSemaphoreGive(i2s_strip->trans_done);
+        ESP_RETURN_ON_ERROR(ret, TAG, "transmit pixels by I2S failed");
+    }
+    // wait for the transaction to finish, so the refresh is synchronous like the other backends
+    xSemaphoreTake(i2s_strip->trans_done, portMAX_DELAY);
+    xSemaphoreGive(i2s_strip->trans_done);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_i2s_clear(led_strip_t *strip)
+{
+    led_strip_i2s_obj *i2s_strip = __containerof(strip, led_strip_i2s_obj, base);
+    // Write zero to turn off all leds
+    memset(i2s_strip->pixel_buf, 0, i2s_strip->strip_len * i2s_strip->lane_count * i2s_strip->bytes_per_pixel);
+    return led_strip_i2s_refresh(strip);
+}
+
+static esp_err_t led_strip_i2s_del(led_strip_t *strip)
+{
+    led_strip_i2s_obj *i2s_strip = __containerof(strip, led_strip_i2s_obj, base);
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_del(i2s_strip->io), TAG, "delete panel io failed");
+    ESP_RETURN_ON_ERROR(esp_lcd_del_i80_bus(i2s_strip->i80_bus), TAG, "delete i80 bus failed");
+    vSemaphoreDelete(i2s_strip->trans_done);
+    heap_caps_free(i2s_strip->dma_buf);
+    free(i2s_strip);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_new_i2s_device(const led_strip_config_t *led_config, const led_strip_i2s_config_t *i2s_config, led_strip_handle_t *ret_strip)
+{
+    led_strip_i2s_obj *i2s_strip = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && i2s_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_pixel_format");
+    ESP_GOTO_ON_FALSE(i2s_config->lane_count == 8 || i2s_config->lane_count == 16, ESP_ERR_INVALID_ARG, err, TAG, "lane_count must be 8 or 16");
+    ESP_GOTO_ON_FALSE(led_config->flags.invert_out == 0, ESP_ERR_NOT_SUPPORTED, err, TAG, "invert_out is not supported");
+    const led_strip_pixel_format_ops_t *pixel_ops = led_strip_pixel_format_get_ops(led_config->led_pixel_format);
+    uint8_t bytes_per_pixel = pixel_ops->bytes_per_pixel;
+    uint8_t lane_count = i2s_config->lane_count;
+    size_t lane_bytes = led_config->max_leds * bytes_per_pixel;
+    i2s_strip = calloc(1, sizeof(led_strip_i2s_obj) + lane_bytes * lane_count);
+    ESP_GOTO_ON_FALSE(i2s_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for i2s strip");
+
+    // the bitstream is followed by the all-low reset slots
+    i2s_strip->dma_buf_size = (lane_bytes * LED_STRIP_I2S_BYTES_PER_LANE_BYTE(lane_count)) + LED_STRIP_I2S_RESET_SLOTS * (lane_count / 8);
+    i2s_strip->dma_buf = heap_caps_aligned_calloc(4, 1, i2s_strip->dma_buf_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ESP_GOTO_ON_FALSE(i2s_strip->dma_buf, ESP_ERR_NO_MEM, err, TAG, "no mem for i2s DMA buffer");
+    led_strip_i2s_prepare_bitstream(i2s_strip->dma_buf, lane_bytes, lane_count);
+
+    i2s_strip->trans_done = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(i2s_strip->trans_done, ESP_ERR_NO_MEM, err, TAG, "no mem for i2s semaphore");
+    xSemaphoreGive(i2s_strip->trans_done);
+
+    esp_lcd_i80_bus_config_t bus_config = {
+        .clk_src = i2s_config->clk_src ? i2s_config->clk_src : LCD_CLK_SRC_DEFAULT,
+        .dc_gpio_num = i2s_config->dc_gpio_num,
+        .wr_gpio_num = i2s_config->wr_gpio_num,
+        .bus_width = lane_count,
+        .max_transfer_bytes = i2s_strip->dma_buf_size,
+    };
+    for (int i = 0; i < lane_count; i++) {
+        bus_config.data_gpio_nums[i] = i2s_config->data_gpio_nums[i];
+    }
+    ESP_GOTO_ON_ERROR(esp_lcd_new_i80_bus(&bus_config, &i2s_strip->i80_bus), err, TAG, "create i80 bus failed");
+
+    esp_lcd_panel_io_i80_config_t io_config = {
+        .cs_gpio_num = -1,
+        .pclk_hz = LED_STRIP_I2S_PCLK_HZ,
+        .trans_queue_depth = LED_STRIP_I2S_DEFAULT_TRANS_QUEUE_SIZE,
+        .on_color_trans_done = led_strip_i2s_on_trans_done,
+        .user_ctx = i2s_strip,
+        .lcd_cmd_bits = 0,
+        .lcd_param_bits = 0,
+    };
+    ESP_GOTO_ON_ERROR(esp_lcd_new_panel_io_i80(i2s_strip->i80_bus, &io_config, &i2s_strip->io), err, TAG, "create panel io failed");
+
+    i2s_strip->lane_count = lane_count;
+    i2s_strip->bytes_per_pixel = bytes_per_pixel;
+    i2s_strip->pixel_ops = pixel_ops;
+    i2s_strip->strip_len = led_config->max_leds;
+    i2s_strip->base.set_pixel = led_strip_i2s_set_pixel;
+    i2s_strip->base.set_pixel_rgbw = led_strip_i2s_set_pixel_rgbw;
+    i2s_strip->base.set_pixels = led_strip_i2s_set_pixels;
+    i2s_strip->base.fill = led_strip_i2s_fill;
+    i2s_strip->base.get_pixels = led_strip_i2s_get_pixels;
+    i2s_strip->base.refresh = led_strip_i2s_refresh;
+    i2s_strip->base.clear = led_strip_i2s_clear;
+    i2s_strip->base.del = led_strip_i2s_del;
+
+    *ret_strip = &i2s_strip->base;
+    return ESP_OK;
+err:
+    if (i2s_strip) {
+        if (i2s_strip->io) {
+            esp_lcd_panel_io_del(i2s_strip->io);
+        }
+        if (i2s_strip->i80_bus) {
+            esp_lcd_del_i80_bus(i2s_strip->i80_bus);
+        }
+        if (i2s_strip->trans_done) {
+            vSemaphoreDelete(i2s_strip->trans_done);
+        }
+        if (i2s_strip->dma_buf) {
+            heap_caps_free(i2s_strip->dma_buf);
+        }
+        free(i2s_strip);
+    }
+    return ret;
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "led_strip_i2s_encoder.h"
+
+// 8x8 bit matrix transpose (Hacker's Delight, transpose8rS32)
+// On return, bit L of out[j] is bit (7 - j) of the byte of lane L
+static inline void led_strip_i2s_transpose8(uint32_t x, uint32_t y, uint8_t out[8])
+{
+    uint32_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+    out[0] = x >> 24;
+    out[1] = x >> 16;
+    out[2] = x >> 8;
+    out[3] = x;
+    out[4] = y >> 24;
+    out[5] = y >> 16;
+    out[6] = y >> 8;
+    out[7] = y;
+}
+
+// the matrix rows are the lanes in reverse order, so that lane 0 ends up in bit 0 of every slot
+#define LED_STRIP_I2S_GATHER_HI(lanes, base, k) \
+    ((uint32_t)(lanes)[(base) + 7][k] << 24 | (uint32_t)(lanes)[(base) + 6][k] << 16 | (uint32_t)(lanes)[(base) + 5][k] << 8 | (lanes)[(base) + 4][k])
+#define LED_STRIP_I2S_GATHER_LO(lanes, base, k) \
+    ((uint32_t)(lanes)[(base) + 3][k] << 24 | (uint32_t)(lanes)[(base) + 2][k] << 16 | (uint32_t)(lanes)[(base) + 1][k] << 8 | (lanes)[(base) + 0][k])
+
+void led_strip_i2s_prepare_bitstream(uint8_t *buf, size_t lane_bytes, uint8_t lane_count)
+{
+    size_t slot_size = lane_count / 8;
+    size_t bits = lane_bytes * 8;
+    memset(buf, 0, bits * LED_STRIP_I2S_SLOTS_PER_BIT * slot_size);
+    for (size_t i = 0; i < bits; i++) {
+        // first slot of every bit: all lanes high
+        memset(buf, 0xFF, slot_size);
+        buf += LED_STRIP_I2S_SLOTS_PER_BIT * slot_size;
+    }
+}
+
+void led_strip_i2s_encode_8(const uint8_t *const lanes[8], size_t lane_bytes, uint8_t *buf)
+{
+    uint8_t data[8];
+    for (size_t k = 0; k < lane_bytes; k++) {
+        led_strip_i2s_transpose8(LED_STRIP_I2S_GATHER_HI(lanes, 0, k), LED_STRIP_I2S_GATHER_LO(lanes, 0, k), data);
+        // only the middle slot of each bit carries data
+        buf[1] = data[0];
+        buf[4] = data[1];
+        buf[7] = data[2];
+        buf[10] = data[3];
+        buf[13] = data[4];
+        buf[16] = data[5];
+        buf[19] = data[6];
+        buf[22] = data[7];
+        buf += 8 * LED_STRIP_I2S_SLOTS_PER_BIT;
+    }
+}
+
+void led_strip_i2s_encode_16(const uint8_t *const lanes[16], size_t lane_bytes, uint16_t *buf)
+{
+    uint8_t lo[8];
+    uint8_t hi[8];
+    for (size_t k = 0; k < lane_bytes; k++) {
+        led_strip_i2s_transpose8(LED_STRIP_I2S_GATHER_HI(lanes, 0, k), LED_STRIP_I2S_GATHER_LO(lanes, 0, k), lo);
+        led_strip_i2s_transpose8(LED_STRIP_I2S_GATHER_HI(lanes, 8, k), LED_STRIP_I2S_GATHER_LO(lanes, 8, k), hi);
+        for (int j = 0; j < 8; j++) {
+            buf[j * LED_STRIP_I2S_SLOTS_PER_BIT + 1] = (uint16_t)hi[j] << 8 | lo[j];
+        }
+        buf += 8 * LED_STRIP_I2S_SLOTS_PER_BIT;
+    }
+}
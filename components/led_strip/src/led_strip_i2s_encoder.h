@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of parallel bus slots used to represent one LED data bit
+ *
+ * Each WS2812 bit is sent as three equal slots: all lanes high, the data bit of each lane, all lanes low.
+ * This gives T0H = 1/3 and T1H = 2/3 of the bit period.
+ */
+#define LED_STRIP_I2S_SLOTS_PER_BIT 3
+
+/**
+ * @brief Size of the parallel bitstream generated for one byte of every lane
+ *
+ * @param lane_count: 8 or 16
+ */
+#define LED_STRIP_I2S_BYTES_PER_LANE_BYTE(lane_count) (8 * LED_STRIP_I2S_SLOTS_PER_BIT * ((lane_count) / 8))
+
+/**
+ * @brief Prepare a parallel bitstream buffer, writing the constant high and low slots of every bit
+ *
+ * @note Only the data slots change from frame to frame, so the encode functions below never touch the others again.
+ *
+ * @param buf: bitstream buffer
+ * @param lane_bytes: number of pixel bytes per lane
+ * @param lane_count: 8 or 16
+ */
+void led_strip_i2s_prepare_bitstream(uint8_t *buf, size_t lane_bytes, uint8_t lane_count);
+
+/**
+ * @brief Transpose pixel bytes of 8 lanes into the data slots of an 8-bit parallel bitstream
+ *
+ * Bit L of data slot j holds bit (7 - j) of the byte from lane L, so bit 7 (MSB) is sent first, as WS2812 expects.
+ *
+ * @param lanes: per-lane pixel data, `lanes[L]` is the first byte of lane L
+ * @param lane_bytes: number of bytes to encode from every lane
+ * @param buf: bitstream buffer prepared by `led_strip_i2s_prepare_bitstream`
+ */
+void led_strip_i2s_encode_8(const uint8_t *const lanes[8], size_t lane_bytes, uint8_t *buf);
+
+/**
+ * @brief Transpose pixel bytes of 16 lanes into the data slots of a 16-bit parallel bitstream
+ *
+ * Same as `led_strip_i2s_encode_8`, lanes 0-7 are placed in the low byte and lanes 8-15 in the high byte of each slot.
+ *
+ * @param lanes: per-lane pixel data, `lanes[L]` is the first byte of lane L
+ * @param lane_bytes: number of bytes to encode from every lane
+ * @param buf: bitstream buffer prepared by `led_strip_i2s_prepare_bitstream`
+ */
+void led_strip_i2s_encode_16(const uint8_t *const lanes[16], size_t lane_bytes, uint16_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stddef.h>
+#include "led_strip_pixels.h"
+
+/*
+ * LED pixel formats: bytes per pixel, then the position of red, green, blue and white in the data sent to the LEDs.
+ * The white position is not used by the 3 bytes formats.
+ */
+#define LED_STRIP_PIXEL_FORMAT_LIST(X) \
+    X(GRB,  3, 1, 0, 2, 3)             \
+    X(GRBW, 4, 1, 0, 2, 3)             \
+    X(RGB,  3, 0, 1, 2, 3)             \
+    X(BGR,  3, 2, 1, 0, 3)             \
+    X(RGBW, 4, 0, 1, 2, 3)
+
+// the `bpp > 3` conditions are constants, the compiler drops them from the generated kernels
+#define LED_STRIP_PIXEL_KERNELS(name, bpp, r, g, b, w)                                                                \
+    static void led_strip_pixel_set_##name(uint8_t *pixel, uint32_t red, uint32_t green, uint32_t blue, uint32_t white) \
+    {                                                                                                                 \
+        pixel[r] = red & 0xFF;                                                                                        \
+        pixel[g] = green & 0xFF;                                                                                      \
+        pixel[b] = blue & 0xFF;                                                                                       \
+        if (bpp > 3) {                                                                                                \
+            pixel[w] = white & 0xFF;                                                                                  \
+        }                                                                                                             \
+    }                                                                                                                 \
+    static void led_strip_pixel_from_rgb_##name(uint8_t *dst, const uint8_t *src, uint32_t count)                     \
+    {                                                                                                                 \
+        for (uint32_t i = 0; i < count; i++, dst += bpp, src += 3) {                                                  \
+            dst[r] = src[0];                                                                                          \
+            dst[g] = src[1];                                                                                          \
+            dst[b] = src[2];                                                                                          \
+            if (bpp > 3) {                                                                                            \
+                dst[w] = 0;                                                                                           \
+            }                                                                                                         \
+        }                                                                                                             \
+    }                                                                                                                 \
+    static void led_strip_pixel_from_rgbw_##name(uint8_t *dst, const uint8_t *src, uint32_t count)                    \
+    {                                                                                                                 \
+        for (uint32_t i = 0; i < count; i++, dst += bpp, src += 4) {                                                  \
+            dst[r] = src[0];                                                                                          \
+            dst[g] = src[1];                                                                                          \
+            dst[b] = src[2];                                                                                          \
+            dst[w] = src[3];                                                                                          \
+        }                                                                                                             \
+    }                                                                                                                 \
+    static void led_strip_pixel_to_rgb_##name(uint8_t *dst, const uint8_t *src, uint32_t count)                       \
+    {                                                                                                                 \
+        for (uint32_t i = 0; i < count; i++, dst += 3, src += bpp) {                                                  \
+            dst[0] = src[r];                                                                                          \
+            dst[1] = src[g];                                                                                          \
+            dst[2] = src[b];                                                                                          \
+        }                                                                                                             \
+    }                                                                                                                 \
+    static void led_strip_pixel_to_rgbw_##name(uint8_t *dst, const uint8_t *src, uint32_t count)                      \
+    {                                                                                                                 \
+        for (uint32_t i = 0; i < count; i++, dst += 4, src += bpp) {                                                  \
+            dst[0] = src[r];                                                                                          \
+            dst[1] = src[g];                                                                                          \
+            dst[2] = src[b];                                                                                          \
+            dst[3] = src[w];                                                                                          \
+        }                                                                                                             \
+    }                                                                                                                 \
+    static void led_strip_pixel_white_##name(uint8_t *dst, const uint8_t *src, uint32_t count,                        \
+                                             const led_strip_white_lut_t *lut, const uint8_t *const byte_lut[4])      \
+    {                                                                                                                 \
+        for (uint32_t i = 0; i < count; i++, dst += bpp, src += bpp) {                                                \
+            uint32_t red = byte_lut[r][src[r]], green = byte_lut[g][src[g]], blue = byte_lut[b][src[b]];              \
+            uint32_t white = byte_lut[w][src[w]];                                                                     \
+            /* the highest white level that fits in all three colors, and in what the white channel has left */       \
+            uint32_t level = 255 - white;                                                                             \
+            level = lut->level[0][red] < level ? lut->level[0][red] : level;                                          \
+            level = lut->level[1][green] < level ? lut->level[1][green] : level;                                      \
+            level = lut->level[2][blue] < level ? lut->level[2][blue] : level;                                        \
+            dst[r] = red - lut->part[0][level];                                                                       \
+            dst[g] = green - lut->part[1][level];                                                                     \
+            dst[b] = blue - lut->part[2][level];                                                                      \
+            dst[w] = white + level;                                                                                   \
+        }                                                                                                             \
+    }
+
+LED_STRIP_PIXEL_FORMAT_LIST(LED_STRIP_PIXEL_KERNELS)
+
+// the RGBW layouts need a white channel, so they have no kernel for the 3 bytes formats
+#define LED_STRIP_PIXEL_OPS(name, bpp, r, g, b, w)                                                       \
+    [LED_PIXEL_FORMAT_##name] = {                                                                       \
+        .bytes_per_pixel = bpp,                                                                         \
+        .channel = {[r] = 0, [g] = 1, [b] = 2, [w] = 3},                                                \
+        .set = led_strip_pixel_set_##name,                                                              \
+        .convert = {                                                                                    \
+            [LED_STRIP_SRC_FORMAT_RGB] = led_strip_pixel_from_rgb_##name,                               \
+            [LED_STRIP_SRC_FORMAT_RGBW] = bpp > 3 ? led_strip_pixel_from_rgbw_##name : NULL,            \
+        },                                                                                              \
+        .read = {                                                                                       \
+            [LED_STRIP_SRC_FORMAT_RGB] = led_strip_pixel_to_rgb_##name,                                 \
+            [LED_STRIP_SRC_FORMAT_RGBW] = bpp > 3 ? led_strip_pixel_to_rgbw_##name : NULL,              \
+        },                                                                                              \
+        .extract_white = bpp > 3 ? led_strip_pixel_white_##name : NULL,                                 \
+    },
+
+static const led_strip_pixel_format_ops_t s_pixel_format_ops[LED_PIXEL_FORMAT_INVALID] = {
+    LED_STRIP_PIXEL_FORMAT_LIST(LED_STRIP_PIXEL_OPS)
+};
+
+#define LED_STRIP_IDENTITY_4(n)  (n), (n) + 1, (n) + 2, (n) + 3
+#define LED_STRIP_IDENTITY_16(n) LED_STRIP_IDENTITY_4(n), LED_STRIP_IDENTITY_4((n) + 4), LED_STRIP_IDENTITY_4((n) + 8), LED_STRIP_IDENTITY_4((n) + 12)
+#define LED_STRIP_IDENTITY_64(n) LED_STRIP_IDENTITY_16(n), LED_STRIP_IDENTITY_16((n) + 16), LED_STRIP_IDENTITY_16((n) + 32), LED_STRIP_IDENTITY_16((n) + 48)
+
+const uint8_t led_strip_pixel_identity_lut[256] = {
+    LED_STRIP_IDENTITY_64(0), LED_STRIP_IDENTITY_64(64), LED_STRIP_IDENTITY_64(128), LED_STRIP_IDENTITY_64(192)
+};
+
+const led_strip_pixel_format_ops_t *led_strip_pixel_format_get_ops(led_pixel_format_t format)
+{
+    if (format >= LED_PIXEL_FORMAT_INVALID) {
+        return NULL;
+    }
+    return &s_pixel_format_ops[format];
+}
@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Check that a span of pixels is within a strip of `strip_len` pixels, without overflowing
+ */
+static inline bool led_strip_pixels_span_valid(uint32_t offset, uint32_t count, uint32_t strip_len)
+{
+    return offset <= strip_len && count <= strip_len - offset;
+}
+
+/**
+ * @brief Copy a span of pixels between a source layout (R, G, B and W bytes) and the strip's pixel buffer
+ */
+typedef void (*led_strip_pixel_span_fn_t)(uint8_t *dst, const uint8_t *src, uint32_t count);
+
+/**
+ * @brief Map each byte of a span of pixels of the strip's pixel buffer through its color table, then extract the white
+ *
+ * @note `dst` may be `src`
+ */
+typedef void (*led_strip_pixel_white_fn_t)(uint8_t *dst, const uint8_t *src, uint32_t count, const led_strip_white_lut_t *white,
+                                           const uint8_t *const byte_lut[4]);
+
+/**
+ * @brief Pixel kernels of one LED pixel format, selected when the strip is created
+ *
+ * The kernels are generated for each pixel format, with the channel order and the pixel width as constants,
+ * so they store the channels without any per-pixel branch.
+ */
+typedef struct {
+    uint8_t bytes_per_pixel; /*!< Bytes per pixel in the pixel buffer, 3 or 4 */
+    uint8_t channel[4];      /*!< Color channel of each byte of a pixel: 0 red, 1 green, 2 blue, 3 white */
+    void (*set)(uint8_t *pixel, uint32_t red, uint32_t green, uint32_t blue, uint32_t white); /*!< Set one pixel, white is ignored with 3 bytes per pixel */
+    led_strip_pixel_span_fn_t convert[LED_STRIP_SRC_FORMAT_INVALID]; /*!< Convert a span from each source layout to the pixel buffer, NULL if the layout has a channel the LEDs don't have */
+    led_strip_pixel_span_fn_t read[LED_STRIP_SRC_FORMAT_INVALID];    /*!< Convert a span from the pixel buffer back to each source layout, NULL if the layout has a channel the LEDs don't have */
+    led_strip_pixel_white_fn_t extract_white; /*!< White extraction of a span, NULL if the LEDs have no white channel */
+} led_strip_pixel_format_ops_t;
+
+/**
+ * @brief Get the pixel kernels of a LED pixel format
+ *
+ * @return Pixel kernels, NULL if the pixel format is invalid
+ */
+const led_strip_pixel_format_ops_t *led_strip_pixel_format_get_ops(led_pixel_format_t format);
+
+/**
+ * @brief Repeat the first `size` bytes of a buffer until it holds `count` copies of them
+ */
+static inline void led_strip_pixels_repeat(uint8_t *buf, size_t size, uint32_t count)
+{
+    size_t done = size;
+    size_t total = size * count;
+    // double the filled part with each copy
+    while (done < total) {
+        size_t len = done < total - done ? done : total - done;
+        memcpy(buf + done, buf, len);
+        done += len;
+    }
+}
+
+/**
+ * @brief Fill a span of the pixel buffer with one pixel, converted from a source layout
+ */
+static inline void led_strip_pixels_fill(const led_strip_pixel_format_ops_t *ops, uint8_t *dst, const uint8_t *color, uint32_t count,
+                                         led_strip_src_format_t format)
+{
+    if (count) {
+        ops->convert[format](dst, color, 1);
+        led_strip_pixels_repeat(dst, ops->bytes_per_pixel, count);
+    }
+}
+
+/**
+ * @brief Identity table, the color table of each byte while only a white extraction table is set
+ */
+extern const uint8_t led_strip_pixel_identity_lut[256];
+
+/**
+ * @brief Color lookup table of each byte of a pixel, in the channel order of the LEDs, and the white extraction after it
+ */
+typedef struct {
+    const led_strip_color_lut_t *lut;          /*!< Color lookup table as set, NULL if none */
+    const led_strip_white_lut_t *white;        /*!< White extraction table as set, NULL if none */
+    led_strip_pixel_white_fn_t extract_white;  /*!< White extraction kernel of the pixel format, NULL if no white extraction table is set */
+    const uint8_t *byte_lut[4]; /*!< Table of the channel of each byte of a pixel */
+    uint8_t bytes_per_pixel;    /*!< Bytes per pixel, 0 if neither a color lookup table nor a white extraction table is set */
+} led_strip_pixel_lut_t;
+
+/**
+ * @brief Arrange the tables of a color lookup table in the channel order of a pixel format, `lut` and `white` NULL to disable them
+ *
+ * @note `white` is only applied by the pixel formats with a white channel
+ */
+static inline void led_strip_pixel_lut_init(led_strip_pixel_lut_t *pixel_lut, const led_strip_pixel_format_ops_t *ops, const led_strip_color_lut_t *lut,
+                                            const led_strip_white_lut_t *white)
+{
+    pixel_lut->lut = lut;
+    pixel_lut->white = white;
+    pixel_lut->extract_white = white ? ops->extract_white : NULL;
+    pixel_lut->bytes_per_pixel = lut || pixel_lut->extract_white ? ops->bytes_per_pixel : 0;
+    for (int i = 0; i < 4; i++) {
+        pixel_lut->byte_lut[i] = lut ? lut->channel[ops->channel[i]] : led_strip_pixel_identity_lut;
+    }
+}
+
+static inline bool led_strip_pixel_lut_active(const led_strip_pixel_lut_t *pixel_lut)
+{
+    return pixel_lut->bytes_per_pixel != 0;
+}
+
+/**
+ * @brief Map LED data bytes through a color lookup table, `pos` being the position in its pixel of the first byte
+ *
+ * @note `dst` may be `src`. With a white extraction table, `pos` must be 0 and `len` a whole number of pixels.
+ */
+static inline void led_strip_pixel_lut_map(const led_strip_pixel_lut_t *pixel_lut, uint8_t *dst, const uint8_t *src, size_t len, uint32_t pos)
+{
+    if (pixel_lut->extract_white) {
+        // the white comes from the three colors of a pixel, so the span holds whole pixels
+        pixel_lut->extract_white(dst, src, len / pixel_lut->bytes_per_pixel, pixel_lut->white, pixel_lut->byte_lut);
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = pixel_lut->byte_lut[pos][src[i]];
+        if (++pos == pixel_lut->bytes_per_pixel) {
+            pos = 0;
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,278 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "driver/rmt_tx.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "led_strip_rmt_encoder.h"
+#include "led_strip_dirty.h"
+#include "led_strip_pixels.h"
+
+#define LED_STRIP_RMT_DEFAULT_RESOLUTION 10000000 // 10MHz resolution
+#define LED_STRIP_RMT_DEFAULT_TRANS_QUEUE_SIZE 4
+#define LED_STRIP_RMT_SYMBOL_CACHE_MAP_PIXELS 16 // pixels mapped through the color LUT at a time when updating the symbol cache
+// the memory size of each RMT channel, in words (4 bytes)
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS 64
+#else
+#define LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS 48
+#endif
+
+static const char *TAG = "led_strip_rmt";
+
+typedef struct {
+    led_strip_t base;
+    rmt_channel_handle_t rmt_chan;
+    rmt_encoder_handle_t strip_encoder;
+    const led_strip_symbol_lut_t *symbol_lut;
+    rmt_symbol_word_t *symbols;      // symbol image of the whole strip, NULL if the symbol cache is disabled
+    led_strip_pixel_lut_t color_lut; // color LUT and white extraction, applied when the pixels are expanded to symbols
+    led_strip_dirty_t dirty;
+    uint32_t strip_len;
+    const led_strip_pixel_format_ops_t *pixel_ops; // channel order and width of the pixels
+    uint8_t bytes_per_pixel;
+    uint8_t pixel_buf[];
+} led_strip_rmt_obj;
+
+static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    led_strip_dirty_mark(&rmt_strip->dirty, index);
+    // in the channel order of the LEDs
+    rmt_strip->pixel_ops->set(&rmt_strip->pixel_buf[index * rmt_strip->bytes_per_pixel], red, green, blue, 0);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(rmt_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    led_strip_dirty_mark(&rmt_strip->dirty, index);
+    rmt_strip->pixel_ops->set(&rmt_strip->pixel_buf[index * 4], red, green, blue, white);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixels(led_strip_t *strip, uint32_t offset, const uint8_t *src, uint32_t count, led_strip_src_format_t format)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, rmt_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(rmt_strip->pixel_ops->convert[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    if (count == 0) {
+        return ESP_OK;
+    }
+    led_strip_dirty_mark(&rmt_strip->dirty, offset);
+    led_strip_dirty_mark(&rmt_strip->dirty, offset + count - 1);
+    rmt_strip->pixel_ops->convert[format](&rmt_strip->pixel_buf[offset * rmt_strip->bytes_per_pixel], src, count);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_fill(led_strip_t *strip, uint32_t offset, uint32_t count, const uint8_t *color, led_strip_src_format_t format)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, rmt_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(rmt_strip->pixel_ops->convert[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    if (count == 0) {
+        return ESP_OK;
+    }
+    led_strip_dirty_mark(&rmt_strip->dirty, offset);
+    led_strip_dirty_mark(&rmt_strip->dirty, offset + count - 1);
+    led_strip_pixels_fill(rmt_strip->pixel_ops, &rmt_strip->pixel_buf[offset * rmt_strip->bytes_per_pixel], color, count, format);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_get_pixels(led_strip_t *strip, uint32_t offset, uint8_t *dst, uint32_t count, led_strip_src_format_t format)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, rmt_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(rmt_strip->pixel_ops->read[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    rmt_strip->pixel_ops->read[format](dst, &rmt_strip->pixel_buf[offset * rmt_strip->bytes_per_pixel], count);
+    return ESP_OK;
+}
+
+static void led_strip_rmt_update_symbols(led_strip_rmt_obj *rmt_strip)
+{
+    uint32_t start;
+    uint32_t end = led_strip_dirty_changed(&rmt_strip->dirty, &start);
+    // the symbols of the other pixels are still valid, the previous transmission has finished using them
+    if (led_strip_pixel_lut_active(&rmt_strip->color_lut)) {
+        // map whole pixels at a time, the white extraction takes the three colors of a pixel
+        uint8_t mapped[LED_STRIP_RMT_SYMBOL_CACHE_MAP_PIXELS * 4];
+        size_t chunk_bytes = LED_STRIP_RMT_SYMBOL_CACHE_MAP_PIXELS * rmt_strip->bytes_per_pixel;
+        for (uint32_t i = start * rmt_strip->bytes_per_pixel; i < end * rmt_strip->bytes_per_pixel; i += chunk_bytes) {
+            size_t len = MIN(chunk_bytes, end * rmt_strip->bytes_per_pixel - i);
+            led_strip_pixel_lut_map(&rmt_strip->color_lut, mapped, &rmt_strip->pixel_buf[i], len, 0);
+            for (size_t j = 0; j < len; j++) {
+                led_strip_symbol_lut_expand(rmt_strip->symbol_lut, mapped[j], &rmt_strip->symbols[(i + j) * 8].val);
+            }
+        }
+        return;
+    }
+    for (uint32_t i = start * rmt_strip->bytes_per_pixel; i < end * rmt_strip->bytes_per_pixel; i++) {
+        led_strip_symbol_lut_expand(rmt_strip->symbol_lut, rmt_strip->pixel_buf[i], &rmt_strip->symbols[i * 8].val);
+    }
+}
+
+static void led_strip_rmt_set_pixel_lut(led_strip_rmt_obj *rmt_strip, const led_strip_color_lut_t *lut, const led_strip_white_lut_t *white)
+{
+    led_strip_pixel_lut_init(&rmt_strip->color_lut, rmt_strip->pixel_ops, lut, white);
+    rmt_led_strip_encoder_set_color_lut(rmt_strip->strip_encoder, led_strip_pixel_lut_active(&rmt_strip->color_lut) ? &rmt_strip->color_lut : NULL);
+    // the LEDs hold the output of the previous table, send the whole strip again at the next refresh
+    led_strip_dirty_mark(&rmt_strip->dirty, 0);
+    led_strip_dirty_mark(&rmt_strip->dirty, rmt_strip->strip_len - 1);
+}
+
+static esp_err_t led_strip_rmt_set_color_lut(led_strip_t *strip, const led_strip_color_lut_t *lut)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    led_strip_rmt_set_pixel_lut(rmt_strip, lut, rmt_strip->color_lut.white);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_white_lut(led_strip_t *strip, const led_strip_white_lut_t *lut)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(rmt_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    led_strip_rmt_set_pixel_lut(rmt_strip, rmt_strip->color_lut.lut, lut);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    rmt_transmit_config_t tx_conf = {
+        .loop_count = 0,
+    };
+
+    if (rmt_strip->symbols) {
+        led_strip_rmt_update_symbols(rmt_strip);
+    }
+    // pixels after the last changed one keep their latched color, no need to send them
+    uint32_t len = led_strip_dirty_take(&rmt_strip->dirty, rmt_strip->strip_len);
+    if (len == 0) {
+        return ESP_OK;
+    }
+    const void *data = rmt_strip->pixel_buf;
+    size_t data_size = len * rmt_strip->bytes_per_pixel;
+    if (rmt_strip->symbols) {
+        data = rmt_strip->symbols;
+        data_size *= 8 * sizeof(rmt_symbol_word_t);
+    }
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), err, TAG, "enable RMT channel failed");
+    ESP_GOTO_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, data, data_size, &tx_conf),
+                      err, TAG, "transmit pixels by RMT failed");
+    ESP_GOTO_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), err, TAG, "flush RMT channel failed");
+    ESP_GOTO_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), err, TAG, "disable RMT channel failed");
+    return ESP_OK;
+err:
+    led_strip_dirty_restore(&rmt_strip->dirty, len);
+    return ret;
+}
+
+static esp_err_t led_strip_rmt_clear(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    // Write zero to turn off all leds
+    memset(rmt_strip->pixel_buf, 0, rmt_strip->strip_len * rmt_strip->bytes_per_pixel);
+    led_strip_dirty_mark(&rmt_strip->dirty, 0);
+    led_strip_dirty_mark(&rmt_strip->dirty, rmt_strip->strip_len - 1);
+    return led_strip_rmt_refresh(strip);
+}
+
+static esp_err_t led_strip_rmt_del(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_ERROR(rmt_del_channel(rmt_strip->rmt_chan), TAG, "delete RMT channel failed");
+    ESP_RETURN_ON_ERROR(rmt_del_encoder(rmt_strip->strip_encoder), TAG, "delete strip encoder failed");
+    free(rmt_strip->symbols);
+    free(rmt_strip);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config, led_strip_handle_t *ret_strip)
+{
+    led_strip_rmt_obj *rmt_strip = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && rmt_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_pixel_format");
+    const led_strip_pixel_format_ops_t *pixel_ops = led_strip_pixel_format_get_ops(led_config->led_pixel_format);
+    uint8_t bytes_per_pixel = pixel_ops->bytes_per_pixel;
+    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + led_config->max_leds * bytes_per_pixel);
+    ESP_GOTO_ON_FALSE(rmt_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for rmt strip");
+    uint32_t resolution = rmt_config->resolution_hz ? rmt_config->resolution_hz : LED_STRIP_RMT_DEFAULT_RESOLUTION;
+
+    // for backward compatibility, if the user does not set the clk_src, use the default value
+    rmt_clock_source_t clk_src = RMT_CLK_SRC_DEFAULT;
+    if (rmt_config->clk_src) {
+        clk_src = rmt_config->clk_src;
+    }
+    size_t mem_block_symbols = LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS;
+    // override the default value if the user sets it
+    if (rmt_config->mem_block_symbols) {
+        mem_block_symbols = rmt_config->mem_block_symbols;
+    }
+    rmt_tx_channel_config_t rmt_chan_config = {
+        .clk_src = clk_src,
+        .gpio_num = led_config->strip_gpio_num,
+        .mem_block_symbols = mem_block_symbols,
+        .resolution_hz = resolution,
+        .trans_queue_depth = LED_STRIP_RMT_DEFAULT_TRANS_QUEUE_SIZE,
+        .flags.with_dma = rmt_config->flags.with_dma,
+        .flags.invert_out = led_config->flags.invert_out,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_tx_channel(&rmt_chan_config, &rmt_strip->rmt_chan), err, TAG, "create RMT TX channel failed");
+
+    led_strip_encoder_config_t strip_encoder_conf = {
+        .resolution = resolution,
+        .led_model = led_config->led_model,
+        .flags.pre_encoded = rmt_config->flags.symbol_cache,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_led_strip_encoder(&strip_encoder_conf, &rmt_strip->strip_encoder), err, TAG, "create LED strip encoder failed");
+    if (rmt_config->flags.symbol_cache) {
+        // the encoder only copies the symbols, the CPU reads them so they can live in any memory
+        rmt_strip->symbol_lut = rmt_led_strip_encoder_get_lut(rmt_strip->strip_encoder);
+        rmt_strip->symbols = calloc(led_config->max_leds * bytes_per_pixel * 8, sizeof(rmt_symbol_word_t));
+        ESP_GOTO_ON_FALSE(rmt_strip->symbols, ESP_ERR_NO_MEM, err, TAG, "no mem for symbol cache");
+    }
+
+
+    rmt_strip->bytes_per_pixel = bytes_per_pixel;
+    rmt_strip->pixel_ops = pixel_ops;
+    rmt_strip->strip_len = led_config->max_leds;
+    led_strip_dirty_init(&rmt_strip->dirty, led_config->max_leds, led_config->full_refresh_interval);
+    rmt_strip->base.set_pixel = led_strip_rmt_set_pixel;
+    rmt_strip->base.set_pixel_rgbw = led_strip_rmt_set_pixel_rgbw;
+    rmt_strip->base.set_pixels = led_strip_rmt_set_pixels;
+    rmt_strip->base.fill = led_strip_rmt_fill;
+    rmt_strip->base.get_pixels = led_strip_rmt_get_pixels;
+    rmt_strip->base.set_color_lut = led_strip_rmt_set_color_lut;
+    rmt_strip->base.set_white_lut = led_strip_rmt_set_white_lut;
+    rmt_strip->base.refresh = led_strip_rmt_refresh;
+    rmt_strip->base.clear = led_strip_rmt_clear;
+    rmt_strip->base.del = led_strip_rmt_del;
+
+    *ret_strip = &rmt_strip->base;
+    return ESP_OK;
+err:
+    if (rmt_strip) {
+        if (rmt_strip->rmt_chan) {
+            rmt_del_channel(rmt_strip->rmt_chan);
+        }
+        if (rmt_strip->strip_encoder) {
+            rmt_del_encoder(rmt_strip->strip_encoder);
+        }
+        free(rmt_strip->symbols);
+        free(rmt_strip);
+    }
+    return ret;
+}
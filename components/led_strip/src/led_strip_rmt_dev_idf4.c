@@ -11,6 +11,9 @@
 #include "driver/rmt.h"
 #include "led_strip.h"
 #include "led_strip_interface.h"
+#include "led_strip_dirty.h"
+#include "led_strip_pixels.h"
+#include "led_strip_symbol_lut.h"
 
 static const char *TAG = "led_strip_rmt";
 
@@ -38,10 +41,15 @@ static uint32_t led_t1h_ticks = 0;
 static uint32_t led_t0l_ticks = 0;
 static uint32_t led_t1l_ticks = 0;
 
+// RMT items of each data nibble, built from the ticks above
+static DRAM_ATTR led_strip_symbol_lut_t led_symbol_lut;
+
 typedef struct {
     led_strip_t base;
     rmt_channel_t rmt_channel;
+    led_strip_dirty_t dirty;
     uint32_t strip_len;
+    const led_strip_pixel_format_ops_t *pixel_ops; // channel order and width of the pixels
     uint8_t bytes_per_pixel;
     uint8_t buffer[0];
 } led_strip_rmt_obj;
@@ -54,23 +62,15 @@ static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, si
         *item_num = 0;
         return;
     }
-    const rmt_item32_t bit0 = {{{ led_t0h_ticks, 1, led_t0l_ticks, 0 }}}; //Logical 0
-    const rmt_item32_t bit1 = {{{ led_t1h_ticks, 1, led_t1l_ticks, 0 }}}; //Logical 1
     size_t size = 0;
     size_t num = 0;
-    uint8_t *psrc = (uint8_t *)src;
+    const uint8_t *psrc = (const uint8_t *)src;
     rmt_item32_t *pdest = dest;
     while (size < src_size && num < wanted_num) {
-        for (int i = 0; i < 8; i++) {
-            // MSB first
-            if (*psrc & (1 << (7 - i))) {
-                pdest->val =  bit1.val;
-            } else {
-                pdest->val =  bit0.val;
-            }
-            num++;
-            pdest++;
-        }
+        // MSB first, 8 items per byte from the lookup table
+        led_strip_symbol_lut_expand(&led_symbol_lut, *psrc, &pdest->val);
+        num += 8;
+        pdest += 8;
         size++;
         psrc++;
     }
@@ -82,22 +82,62 @@ static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uin
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
     ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of the maximum number of leds");
-    uint32_t start = index * rmt_strip->bytes_per_pixel;
-    // In thr order of GRB
-    rmt_strip->buffer[start + 0] = green & 0xFF;
-    rmt_strip->buffer[start + 1] = red & 0xFF;
-    rmt_strip->buffer[start + 2] = blue & 0xFF;
-    if (rmt_strip->bytes_per_pixel > 3) {
-        rmt_strip->buffer[start + 3] = 0;
+    led_strip_dirty_mark(&rmt_strip->dirty, index);
+    // in the channel order of the LEDs
+    rmt_strip->pixel_ops->set(&rmt_strip->buffer[index * rmt_strip->bytes_per_pixel], red, green, blue, 0);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixels(led_strip_t *strip, uint32_t offset, const uint8_t *src, uint32_t count, led_strip_src_format_t format)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, rmt_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of the maximum number of leds");
+    ESP_RETURN_ON_FALSE(rmt_strip->pixel_ops->convert[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    if (count == 0) {
+        return ESP_OK;
+    }
+    led_strip_dirty_mark(&rmt_strip->dirty, offset);
+    led_strip_dirty_mark(&rmt_strip->dirty, offset + count - 1);
+    rmt_strip->pixel_ops->convert[format](&rmt_strip->buffer[offset * rmt_strip->bytes_per_pixel], src, count);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_fill(led_strip_t *strip, uint32_t offset, uint32_t count, const uint8_t *color, led_strip_src_format_t format)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, rmt_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of the maximum number of leds");
+    ESP_RETURN_ON_FALSE(rmt_strip->pixel_ops->convert[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    if (count == 0) {
+        return ESP_OK;
     }
+    led_strip_dirty_mark(&rmt_strip->dirty, offset);
+    led_strip_dirty_mark(&rmt_strip->dirty, offset + count - 1);
+    led_strip_pixels_fill(rmt_strip->pixel_ops, &rmt_strip->buffer[offset * rmt_strip->bytes_per_pixel], color, count, format);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_get_pixels(led_strip_t *strip, uint32_t offset, uint8_t *dst, uint32_t count, led_strip_src_format_t format)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, rmt_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of the maximum number of leds");
+    ESP_RETURN_ON_FALSE(rmt_strip->pixel_ops->read[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    rmt_strip->pixel_ops->read[format](dst, &rmt_strip->buffer[offset * rmt_strip->bytes_per_pixel], count);
     return ESP_OK;
 }
 
 static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
-    ESP_RETURN_ON_ERROR(rmt_write_sample(rmt_strip->rmt_channel, rmt_strip->buffer, rmt_strip->strip_len * rmt_strip->bytes_per_pixel, true), TAG,
-                        "transmit RMT samples failed");
+    // pixels after the last changed one keep their latched color, no need to send them
+    uint32_t len = led_strip_dirty_take(&rmt_strip->dirty, rmt_strip->strip_len);
+    if (len == 0) {
+        return ESP_OK;
+    }
+    esp_err_t ret = rmt_write_sample(rmt_strip->rmt_channel, rmt_strip->buffer, len * rmt_strip->bytes_per_pixel, true);
+    if (ret != ESP_OK) {
+        led_strip_dirty_restore(&rmt_strip->dirty, len);
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "transmit RMT samples failed");
     vTaskDelay(pdMS_TO_TICKS(LED_STRIP_RESET_MS));
     return ESP_OK;
 }
@@ -107,6 +147,7 @@ static esp_err_t led_strip_rmt_clear(led_strip_t *strip)
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
     // Write zero to turn off all LEDs
     memset(rmt_strip->buffer, 0, rmt_strip->strip_len * rmt_strip->bytes_per_pixel);
+    led_strip_dirty_mark(&rmt_strip->dirty, rmt_strip->strip_len - 1);
     return led_strip_rmt_refresh(strip);
 }
 
@@ -124,16 +165,12 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     esp_err_t ret = ESP_OK;
     ESP_RETURN_ON_FALSE(led_config && dev_config && ret_strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
     ESP_RETURN_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, TAG, "invalid led_pixel_format");
+    ESP_RETURN_ON_FALSE(led_config->led_model == LED_MODEL_WS2812 || led_config->led_model == LED_MODEL_SK6812, ESP_ERR_INVALID_ARG, TAG, "invalid led_model");
     ESP_RETURN_ON_FALSE(dev_config->flags.with_dma == 0, ESP_ERR_NOT_SUPPORTED, TAG, "DMA is not supported");
+    ESP_RETURN_ON_FALSE(dev_config->flags.symbol_cache == 0, ESP_ERR_NOT_SUPPORTED, TAG, "symbol cache is not supported");
 
-    uint8_t bytes_per_pixel = 3;
-    if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRBW) {
-        bytes_per_pixel = 4;
-    } else if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRB) {
-        bytes_per_pixel = 3;
-    } else {
-        assert(false);
-    }
+    const led_strip_pixel_format_ops_t *pixel_ops = led_strip_pixel_format_get_ops(led_config->led_pixel_format);
+    uint8_t bytes_per_pixel = pixel_ops->bytes_per_pixel;
 
     // allocate memory for led_strip object
     rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + led_config->max_leds * bytes_per_pixel);
@@ -171,14 +208,22 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     } else {
         assert(false);
     }
+    const rmt_item32_t bit0 = {{{ led_t0h_ticks, 1, led_t0l_ticks, 0 }}}; //Logical 0
+    const rmt_item32_t bit1 = {{{ led_t1h_ticks, 1, led_t1l_ticks, 0 }}}; //Logical 1
+    led_strip_symbol_lut_init(&led_symbol_lut, bit0.val, bit1.val);
 
     // adapter to translates the LES strip date frame into RMT symbols
     rmt_translator_init((rmt_channel_t)dev_config->rmt_channel, ws2812_rmt_adapter);
 
     rmt_strip->bytes_per_pixel = bytes_per_pixel;
+    rmt_strip->pixel_ops = pixel_ops;
     rmt_strip->rmt_channel = (rmt_channel_t)dev_config->rmt_channel;
     rmt_strip->strip_len = led_config->max_leds;
+    led_strip_dirty_init(&rmt_strip->dirty, led_config->max_leds, led_config->full_refresh_interval);
     rmt_strip->base.set_pixel = led_strip_rmt_set_pixel;
+    rmt_strip->base.set_pixels = led_strip_rmt_set_pixels;
+    rmt_strip->base.fill = led_strip_rmt_fill;
+    rmt_strip->base.get_pixels = led_strip_rmt_get_pixels;
     rmt_strip->base.refresh = led_strip_rmt_refresh;
     rmt_strip->base.clear = led_strip_rmt_clear;
     rmt_strip->base.del = led_strip_rmt_del;
@@ -4,43 +4,89 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <stdbool.h>
 #include "esp_check.h"
 #include "led_strip_rmt_encoder.h"
 
+// number of pixel bytes expanded to symbols at once, 128 symbols cover a refill of any RMT memory block size,
+// and whole pixels of 4 bytes for the white extraction
+#define LED_STRIP_RMT_CHUNK_BYTES 16
+
 static const char *TAG = "led_rmt_encoder";
 
 typedef struct {
     rmt_encoder_t base;
-    rmt_encoder_t *bytes_encoder;
     rmt_encoder_t *copy_encoder;
     int state;
+    bool pre_encoded;      // the data are symbols already, copy them as they are
+    size_t data_offset;    // pixel bytes already expanded to symbols
+    size_t chunk_symbols;  // symbols in `chunk` still to be copied, 0 if the next chunk has to be expanded
+    led_strip_symbol_lut_t lut;
+    const led_strip_pixel_lut_t *color_lut; // applied to the pixel bytes before their expansion, NULL if none
     rmt_symbol_word_t reset_code;
+    rmt_symbol_word_t chunk[LED_STRIP_RMT_CHUNK_BYTES * 8];
 } rmt_led_strip_encoder_t;
 
 static size_t rmt_encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
 {
     rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
-    rmt_encoder_handle_t bytes_encoder = led_encoder->bytes_encoder;
     rmt_encoder_handle_t copy_encoder = led_encoder->copy_encoder;
     rmt_encode_state_t session_state = 0;
     rmt_encode_state_t state = 0;
     size_t encoded_symbols = 0;
     switch (led_encoder->state) {
     case 0: // send RGB data
-        encoded_symbols += bytes_encoder->encode(bytes_encoder, channel, primary_data, data_size, &session_state);
-        if (session_state & RMT_ENCODING_COMPLETE) {
+        if (led_encoder->pre_encoded) {
+            // the pixels are expanded already, the copy encoder moves them to the RMT memory as they are
+            encoded_symbols += copy_encoder->encode(copy_encoder, channel, primary_data, data_size, &session_state);
+            if (session_state & RMT_ENCODING_COMPLETE) {
+                led_encoder->state = 1; // switch to next state when current encoding session finished
+            }
+            if (session_state & RMT_ENCODING_MEM_FULL) {
+                state |= RMT_ENCODING_MEM_FULL;
+                goto out; // yield if there's no free space for encoding artifacts
+            }
+        } else {
+            // expand the pixel bytes chunk by chunk through the lookup table, and let the copy encoder fill the RMT memory in bulk
+            while (led_encoder->chunk_symbols || led_encoder->data_offset < data_size) {
+                if (led_encoder->chunk_symbols == 0) {
+                    const uint8_t *data = (const uint8_t *)primary_data + led_encoder->data_offset;
+                    size_t len = data_size - led_encoder->data_offset;
+                    if (len > LED_STRIP_RMT_CHUNK_BYTES) {
+                        len = LED_STRIP_RMT_CHUNK_BYTES;
+                    }
+                    uint8_t mapped[LED_STRIP_RMT_CHUNK_BYTES];
+                    if (led_encoder->color_lut) {
+                        led_strip_pixel_lut_map(led_encoder->color_lut, mapped, data, len,
+                                                led_encoder->data_offset % led_encoder->color_lut->bytes_per_pixel);
+                        data = mapped;
+                    }
+                    for (size_t i = 0; i < len; i++) {
+                        led_strip_symbol_lut_expand(&led_encoder->lut, data[i], &led_encoder->chunk[i * 8].val);
+                    }
+                    led_encoder->data_offset += len;
+                    led_encoder->chunk_symbols = len * 8;
+                }
+                // the copy encoder keeps track of its position in the chunk until the chunk is complete
+                encoded_symbols += copy_encoder->encode(copy_encoder, channel, led_encoder->chunk,
+                                                        led_encoder->chunk_symbols * sizeof(rmt_symbol_word_t), &session_state);
+                if (session_state & RMT_ENCODING_COMPLETE) {
+                    led_encoder->chunk_symbols = 0;
+                }
+                if (session_state & RMT_ENCODING_MEM_FULL) {
+                    state |= RMT_ENCODING_MEM_FULL;
+                    goto out; // yield if there's no free space for encoding artifacts
+                }
+            }
             led_encoder->state = 1; // switch to next state when current encoding session finished
         }
-        if (session_state & RMT_ENCODING_MEM_FULL) {
-            state |= RMT_ENCODING_MEM_FULL;
-            goto out; // yield if there's no free space for encoding artifacts
-        }
     // fall-through
     case 1: // send reset code
         encoded_symbols += copy_encoder->encode(copy_encoder, channel, &led_encoder->reset_code,
                                                 sizeof(led_encoder->reset_code), &session_state);
         if (session_state & RMT_ENCODING_COMPLETE) {
             led_encoder->state = 0; // back to the initial encoding session
+            led_encoder->data_offset = 0;
             state |= RMT_ENCODING_COMPLETE;
         }
         if (session_state & RMT_ENCODING_MEM_FULL) {
@@ -56,7 +102,6 @@ out:
 static esp_err_t rmt_del_led_strip_encoder(rmt_encoder_t *encoder)
 {
     rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
-    rmt_del_encoder(led_encoder->bytes_encoder);
     rmt_del_encoder(led_encoder->copy_encoder);
     free(led_encoder);
     return ESP_OK;
@@ -65,23 +110,38 @@ static esp_err_t rmt_del_led_strip_encoder(rmt_encoder_t *encoder)
 static esp_err_t rmt_led_strip_encoder_reset(rmt_encoder_t *encoder)
 {
     rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
-    rmt_encoder_reset(led_encoder->bytes_encoder);
     rmt_encoder_reset(led_encoder->copy_encoder);
     led_encoder->state = 0;
+    led_encoder->data_offset = 0;
+    led_encoder->chunk_symbols = 0;
     return ESP_OK;
 }
 
+const led_strip_symbol_lut_t *rmt_led_strip_encoder_get_lut(rmt_encoder_handle_t encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    return &led_encoder->lut;
+}
+
+void rmt_led_strip_encoder_set_color_lut(rmt_encoder_handle_t encoder, const led_strip_pixel_lut_t *color_lut)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    led_encoder->color_lut = color_lut;
+}
+
 esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
 {
     esp_err_t ret = ESP_OK;
     rmt_led_strip_encoder_t *led_encoder = NULL;
     ESP_GOTO_ON_FALSE(config && ret_encoder, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
-    ESP_GOTO_ON_FALSE(config->led_model < LED_MODEL_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led model");
+    // the clocked LED models need a clock line, which RMT can't provide
+    ESP_GOTO_ON_FALSE(config->led_model == LED_MODEL_WS2812 || config->led_model == LED_MODEL_SK6812, ESP_ERR_INVALID_ARG, err, TAG, "invalid led model");
     led_encoder = calloc(1, sizeof(rmt_led_strip_encoder_t));
     ESP_GOTO_ON_FALSE(led_encoder, ESP_ERR_NO_MEM, err, TAG, "no mem for led strip encoder");
     led_encoder->base.encode = rmt_encode_led_strip;
     led_encoder->base.del = rmt_del_led_strip_encoder;
     led_encoder->base.reset = rmt_led_strip_encoder_reset;
+    led_encoder->pre_encoded = config->flags.pre_encoded;
     rmt_bytes_encoder_config_t bytes_encoder_config;
     if (config->led_model == LED_MODEL_SK6812) {
         bytes_encoder_config = (rmt_bytes_encoder_config_t) {
@@ -119,7 +179,8 @@ esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rm
     } else {
         assert(false);
     }
-    ESP_GOTO_ON_ERROR(rmt_new_bytes_encoder(&bytes_encoder_config, &led_encoder->bytes_encoder), err, TAG, "create bytes encoder failed");
+    // all bytes are sent MSB first, which is the order of the lookup table
+    led_strip_symbol_lut_init(&led_encoder->lut, bytes_encoder_config.bit0.val, bytes_encoder_config.bit1.val);
     rmt_copy_encoder_config_t copy_encoder_config = {};
     ESP_GOTO_ON_ERROR(rmt_new_copy_encoder(&copy_encoder_config, &led_encoder->copy_encoder), err, TAG, "create copy encoder failed");
 
@@ -134,9 +195,6 @@ esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rm
     return ESP_OK;
 err:
     if (led_encoder) {
-        if (led_encoder->bytes_encoder) {
-            rmt_del_encoder(led_encoder->bytes_encoder);
-        }
         if (led_encoder->copy_encoder) {
             rmt_del_encoder(led_encoder->copy_encoder);
         }
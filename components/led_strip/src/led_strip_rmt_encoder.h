@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "driver/rmt_encoder.h"
+#include "led_strip_types.h"
+#include "led_strip_symbol_lut.h"
+#include "led_strip_pixels.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Type of led strip encoder configuration
+ */
+typedef struct {
+    uint32_t resolution;   /*!< Encoder resolution, in Hz */
+    led_model_t led_model; /*!< LED model */
+    struct {
+        uint32_t pre_encoded: 1; /*!< The data to encode are RMT symbols already expanded with the encoder's lookup table,
+                                      they are only copied to the RMT memory and followed by the reset code */
+    } flags;                     /*!< Extra encoder flags */
+} led_strip_encoder_config_t;
+
+/**
+ * @brief Create RMT encoder for encoding LED strip pixels into RMT symbols
+ *
+ * @param[in] config Encoder configuration
+ * @param[out] ret_encoder Returned encoder handle
+ * @return
+ *      - ESP_ERR_INVALID_ARG for any invalid arguments
+ *      - ESP_ERR_NO_MEM out of memory when creating led strip encoder
+ *      - ESP_OK if creating encoder successfully
+ */
+esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder);
+
+/**
+ * @brief Get the lookup table expanding pixel bytes to the RMT symbols of the encoder's LED model
+ *
+ * @param[in] encoder Encoder created by `rmt_new_led_strip_encoder`
+ * @return Lookup table, valid until the encoder is deleted
+ */
+const led_strip_symbol_lut_t *rmt_led_strip_encoder_get_lut(rmt_encoder_handle_t encoder);
+
+/**
+ * @brief Set the color lookup table (and white extraction) applied to the pixel bytes before they are expanded to RMT symbols
+ *
+ * @note Not used by a `pre_encoded` encoder, whose symbols are expanded by the caller.
+ *       Only call it while no transmission is in progress.
+ *
+ * @param[in] encoder Encoder created by `rmt_new_led_strip_encoder`
+ * @param[in] color_lut Color lookup table in the channel order of the pixels, kept by reference, NULL to disable it
+ */
+void rmt_led_strip_encoder_set_color_lut(rmt_encoder_handle_t encoder, const led_strip_pixel_lut_t *color_lut);
+
+#ifdef __cplusplus
+}
+#endif
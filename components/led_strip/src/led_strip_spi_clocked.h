@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "led_strip_types.h"
+#include "led_strip_spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Check if an LED model has a clock line (APA102-like), instead of a single self-clocked data line (WS2812-like)
+ */
+static inline bool led_strip_model_is_clocked(led_model_t led_model)
+{
+    return led_model == LED_MODEL_APA102 || led_model == LED_MODEL_SK9822 || led_model == LED_MODEL_HD108;
+}
+
+/**
+ * @brief Create LED strip of clocked LEDs on an SPI bus, the data on MOSI and the clock on SCLK
+ *
+ * @note Called by `led_strip_new_spi_device` for the clocked LED models
+ *
+ * @param led_config LED strip configuration
+ * @param spi_config SPI specific configuration
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: create LED strip handle successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip handle failed because of invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: create LED strip handle failed because of unsupported configuration
+ *      - ESP_ERR_NO_MEM: create LED strip handle failed because of out of memory
+ */
+esp_err_t led_strip_new_spi_clocked_device(const led_strip_config_t *led_config, const led_strip_spi_config_t *spi_config, led_strip_handle_t *ret_strip);
+
+#ifdef __cplusplus
+}
+#endif
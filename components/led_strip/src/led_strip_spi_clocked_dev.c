@@ -0,0 +1,322 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "led_strip_pixels.h"
+#include "led_strip_spi_clocked.h"
+
+#define LED_STRIP_SPI_CLOCKED_TRANS_QUEUE_SIZE 1
+// pixels of a span converted to LED color bytes at once, before being packed into their LED frames
+#define LED_STRIP_SPI_CLOCKED_CHUNK_PIXELS 32
+
+static const char *TAG = "led_strip_spi_clocked";
+
+/**
+ * @brief Frame format of a clocked LED model
+ *
+ * The strip data is a start frame of zeros, one frame per LED, and an end frame. Each LED passes the data on to the
+ * next one delayed by half a clock, so the end frame has to provide one more clock edge for every two LEDs.
+ */
+typedef struct {
+    uint8_t frame_bytes;       // bytes per LED frame
+    uint8_t start_bytes;       // zero bytes of the start frame
+    uint8_t reset_bytes;       // zero bytes between the last LED frame and the end frame
+    uint8_t end_fill;          // value of the end frame bytes
+    uint32_t default_clock_hz;
+    void (*pack)(uint8_t *frame, const uint8_t *colors);        // write 3 color bytes, in the channel order of the LEDs, keeping the brightness field
+    void (*unpack)(uint8_t *colors, const uint8_t *frame);      // read back the 3 color bytes written by pack
+    void (*set_brightness)(uint8_t *frame, uint8_t brightness); // write the brightness field, 0 - LED_STRIP_BRIGHTNESS_MAX
+} led_strip_spi_clocked_model_t;
+
+// APA102 / SK9822 frame: 0b111 and 5 bits of brightness, then 8 bits per color
+static void led_strip_apa102_pack(uint8_t *frame, const uint8_t *colors)
+{
+    frame[1] = colors[0];
+    frame[2] = colors[1];
+    frame[3] = colors[2];
+}
+
+static void led_strip_apa102_unpack(uint8_t *colors, const uint8_t *frame)
+{
+    colors[0] = frame[1];
+    colors[1] = frame[2];
+    colors[2] = frame[3];
+}
+
+static void led_strip_apa102_set_brightness(uint8_t *frame, uint8_t brightness)
+{
+    frame[0] = 0xE0 | brightness;
+}
+
+// HD108 frame: 1 bit set and 5 bits of brightness per color, then 16 bits per color, the 8-bit colors are scaled by 257
+static void led_strip_hd108_pack(uint8_t *frame, const uint8_t *colors)
+{
+    frame[2] = frame[3] = colors[0];
+    frame[4] = frame[5] = colors[1];
+    frame[6] = frame[7] = colors[2];
+}
+
+static void led_strip_hd108_unpack(uint8_t *colors, const uint8_t *frame)
+{
+    colors[0] = frame[2];
+    colors[1] = frame[4];
+    colors[2] = frame[6];
+}
+
+static void led_strip_hd108_set_brightness(uint8_t *frame, uint8_t brightness)
+{
+    uint16_t header = 0x8000 | (brightness << 10) | (brightness << 5) | brightness;
+    frame[0] = header >> 8;
+    frame[1] = header & 0xFF;
+}
+
+static const led_strip_spi_clocked_model_t led_strip_spi_clocked_models[] = {
+    [LED_MODEL_APA102] = {
+        .frame_bytes = 4, .start_bytes = 4, .reset_bytes = 0, .end_fill = 0xFF, .default_clock_hz = 10 * 1000 * 1000,
+        .pack = led_strip_apa102_pack, .unpack = led_strip_apa102_unpack, .set_brightness = led_strip_apa102_set_brightness,
+    },
+    // SK9822 latches the data on a 32 zero bits reset frame, which APA102 would take as a start frame
+    [LED_MODEL_SK9822] = {
+        .frame_bytes = 4, .start_bytes = 4, .reset_bytes = 4, .end_fill = 0x00, .default_clock_hz = 10 * 1000 * 1000,
+        .pack = led_strip_apa102_pack, .unpack = led_strip_apa102_unpack, .set_brightness = led_strip_apa102_set_brightness,
+    },
+    [LED_MODEL_HD108] = {
+        .frame_bytes = 8, .start_bytes = 16, .reset_bytes = 0, .end_fill = 0x00, .default_clock_hz = 20 * 1000 * 1000,
+        .pack = led_strip_hd108_pack, .unpack = led_strip_hd108_unpack, .set_brightness = led_strip_hd108_set_brightness,
+    },
+};
+
+typedef struct {
+    led_strip_t base;
+    spi_host_device_t spi_host;
+    spi_device_handle_t spi_device;
+    const led_strip_spi_clocked_model_t *model;
+    const led_strip_pixel_format_ops_t *pixel_ops; // channel order of the colors in the LED frames
+    uint32_t strip_len;
+    size_t frame_buf_size;
+    uint8_t *led_frames;                           // first LED frame, after the start frame
+    uint8_t frame_buf[] __attribute__((aligned(4))); // start frame, LED frames, reset and end frame, sent as they are
+} led_strip_spi_clocked_obj;
+
+static esp_err_t led_strip_spi_clocked_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_spi_clocked_obj *clocked_strip = __containerof(strip, led_strip_spi_clocked_obj, base);
+    ESP_RETURN_ON_FALSE(index < clocked_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    uint8_t colors[3];
+    clocked_strip->pixel_ops->set(colors, red, green, blue, 0);
+    clocked_strip->model->pack(&clocked_strip->led_frames[index * clocked_strip->model->frame_bytes], colors);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_clocked_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    ESP_LOGE(TAG, "clocked LEDs have no white component");
+    return ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t led_strip_spi_clocked_set_pixels(led_strip_t *strip, uint32_t offset, const uint8_t *src, uint32_t count, led_strip_src_format_t format)
+{
+    led_strip_spi_clocked_obj *clocked_strip = __containerof(strip, led_strip_spi_clocked_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, clocked_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(clocked_strip->pixel_ops->convert[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    const led_strip_spi_clocked_model_t *model = clocked_strip->model;
+    uint8_t *frame = &clocked_strip->led_frames[offset * model->frame_bytes];
+    uint8_t src_bytes_per_pixel = format == LED_STRIP_SRC_FORMAT_RGBW ? 4 : 3;
+    // convert the span to LED color bytes chunk by chunk, and pack them into the LED frames
+    uint8_t chunk[LED_STRIP_SPI_CLOCKED_CHUNK_PIXELS * 3];
+    while (count) {
+        uint32_t len = MIN(count, LED_STRIP_SPI_CLOCKED_CHUNK_PIXELS);
+        clocked_strip->pixel_ops->convert[format](chunk, src, len);
+        for (uint32_t i = 0; i < len; i++, frame += model->frame_bytes) {
+            model->pack(frame, &chunk[i * 3]);
+        }
+        src += len * src_bytes_per_pixel;
+        count -= len;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_clocked_fill(led_strip_t *strip, uint32_t offset, uint32_t count, const uint8_t *color, led_strip_src_format_t format)
+{
+    led_strip_spi_clocked_obj *clocked_strip = __containerof(strip, led_strip_spi_clocked_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, clocked_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(clocked_strip->pixel_ops->convert[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    const led_strip_spi_clocked_model_t *model = clocked_strip->model;
+    uint8_t *frame = &clocked_strip->led_frames[offset * model->frame_bytes];
+    // the brightness fields differ from pixel to pixel, so the frames can't just be copied
+    uint8_t colors[3];
+    clocked_strip->pixel_ops->convert[format](colors, color, 1);
+    for (uint32_t i = 0; i < count; i++, frame += model->frame_bytes) {
+        model->pack(frame, colors);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_clocked_get_pixels(led_strip_t *strip, uint32_t offset, uint8_t *dst, uint32_t count, led_strip_src_format_t format)
+{
+    led_strip_spi_clocked_obj *clocked_strip = __containerof(strip, led_strip_spi_clocked_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, clocked_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(clocked_strip->pixel_ops->read[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    const led_strip_spi_clocked_model_t *model = clocked_strip->model;
+    const uint8_t *frame = &clocked_strip->led_frames[offset * model->frame_bytes];
+    uint8_t dst_bytes_per_pixel = format == LED_STRIP_SRC_FORMAT_RGBW ? 4 : 3;
+    uint8_t chunk[LED_STRIP_SPI_CLOCKED_CHUNK_PIXELS * 3];
+    while (count) {
+        uint32_t len = MIN(count, LED_STRIP_SPI_CLOCKED_CHUNK_PIXELS);
+        for (uint32_t i = 0; i < len; i++, frame += model->frame_bytes) {
+            model->unpack(&chunk[i * 3], frame);
+        }
+        clocked_strip->pixel_ops->read[format](dst, chunk, len);
+        dst += len * dst_bytes_per_pixel;
+        count -= len;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_clocked_set_pixel_brightness(led_strip_t *strip, uint32_t index, uint8_t brightness)
+{
+    led_strip_spi_clocked_obj *clocked_strip = __containerof(strip, led_strip_spi_clocked_obj, base);
+    ESP_RETURN_ON_FALSE(index < clocked_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    clocked_strip->model->set_brightness(&clocked_strip->led_frames[index * clocked_strip->model->frame_bytes], brightness);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_clocked_refresh(led_strip_t *strip)
+{
+    led_strip_spi_clocked_obj *clocked_strip = __containerof(strip, led_strip_spi_clocked_obj, base);
+    // the whole strip is always sent: cut short, the end frame would be shifted into the first LED not sent, as a pixel
+    spi_transaction_t tx_conf;
+    memset(&tx_conf, 0, sizeof(tx_conf));
+    tx_conf.length = clocked_strip->frame_buf_size * 8;
+    tx_conf.tx_buffer = clocked_strip->frame_buf;
+    ESP_RETURN_ON_ERROR(spi_device_transmit(clocked_strip->spi_device, &tx_conf), TAG, "transmit pixels by SPI failed");
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_clocked_clear(led_strip_t *strip)
+{
+    led_strip_spi_clocked_obj *clocked_strip = __containerof(strip, led_strip_spi_clocked_obj, base);
+    const uint8_t black[3] = {0};
+    uint8_t *frame = clocked_strip->led_frames;
+    for (uint32_t i = 0; i < clocked_strip->strip_len; i++, frame += clocked_strip->model->frame_bytes) {
+        clocked_strip->model->pack(frame, black);
+    }
+    return led_strip_spi_clocked_refresh(strip);
+}
+
+static esp_err_t led_strip_spi_clocked_del(led_strip_t *strip)
+{
+    led_strip_spi_clocked_obj *clocked_strip = __containerof(strip, led_strip_spi_clocked_obj, base);
+
+    ESP_RETURN_ON_ERROR(spi_bus_remove_device(clocked_strip->spi_device), TAG, "delete spi device failed");
+    ESP_RETURN_ON_ERROR(spi_bus_free(clocked_strip->spi_host), TAG, "free spi bus failed");
+
+    free(clocked_strip);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_new_spi_clocked_device(const led_strip_config_t *led_config, const led_strip_spi_config_t *spi_config, led_strip_handle_t *ret_strip)
+{
+    led_strip_spi_clocked_obj *clocked_strip = NULL;
+    spi_device_handle_t spi_device = NULL;
+    bool bus_initialized = false;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && spi_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(led_strip_model_is_clocked(led_config->led_model), ESP_ERR_INVALID_ARG, err, TAG, "invalid led_model");
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_pixel_format");
+    const led_strip_pixel_format_ops_t *pixel_ops = led_strip_pixel_format_get_ops(led_config->led_pixel_format);
+    ESP_GOTO_ON_FALSE(pixel_ops->bytes_per_pixel == 3, ESP_ERR_INVALID_ARG, err, TAG, "clocked LEDs have no white component");
+    ESP_GOTO_ON_FALSE(led_config->flags.invert_out == 0, ESP_ERR_NOT_SUPPORTED, err, TAG, "invert_out is not supported");
+    ESP_GOTO_ON_FALSE(spi_config->flags.streaming == 0, ESP_ERR_NOT_SUPPORTED, err, TAG, "streaming mode is not supported");
+    const led_strip_spi_clocked_model_t *model = &led_strip_spi_clocked_models[led_config->led_model];
+
+    // for backward compatibility, if the user does not set the clk_src, use the default value
+    spi_clock_source_t clk_src = SPI_CLK_SRC_DEFAULT;
+    if (spi_config->clk_src) {
+        clk_src = spi_config->clk_src;
+    }
+
+    size_t end_bytes = MAX(4, (led_config->max_leds + 15) / 16);
+    size_t frame_buf_size = model->start_bytes + led_config->max_leds * model->frame_bytes + model->reset_bytes + end_bytes;
+    spi_bus_config_t spi_bus_cfg = {
+        .mosi_io_num = led_config->strip_gpio_num,
+        .sclk_io_num = spi_config->clk_gpio_num,
+        //Only use MOSI and SCLK, set -1 when other pins are not used.
+        .miso_io_num = -1,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = frame_buf_size,
+    };
+    ESP_GOTO_ON_ERROR(spi_bus_initialize(spi_config->spi_bus, &spi_bus_cfg, spi_config->flags.with_dma ? SPI_DMA_CH_AUTO : SPI_DMA_DISABLED), err, TAG, "create SPI bus failed");
+    bus_initialized = true;
+
+    spi_device_interface_config_t spi_dev_cfg = {
+        .clock_source = clk_src,
+        .command_bits = 0,
+        .address_bits = 0,
+        .dummy_bits = 0,
+        .clock_speed_hz = spi_config->clock_hz ? spi_config->clock_hz : model->default_clock_hz,
+        .mode = 0,
+        //set -1 when CS is not used
+        .spics_io_num = -1,
+        .queue_size = LED_STRIP_SPI_CLOCKED_TRANS_QUEUE_SIZE,
+    };
+    ESP_GOTO_ON_ERROR(spi_bus_add_device(spi_config->spi_bus, &spi_dev_cfg, &spi_device), err, TAG, "Failed to add spi device");
+    int clock_khz = 0;
+    spi_device_get_actual_freq(spi_device, &clock_khz);
+    ESP_LOGD(TAG, "SPI clock %dKHz", clock_khz);
+
+    uint32_t mem_caps = MALLOC_CAP_DEFAULT;
+    if (spi_config->flags.with_dma) {
+        // DMA buffer must be placed in internal SRAM
+        mem_caps |= MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA;
+    }
+    clocked_strip = heap_caps_calloc(1, sizeof(led_strip_spi_clocked_obj) + frame_buf_size, mem_caps);
+    ESP_GOTO_ON_FALSE(clocked_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for spi clocked strip");
+
+    // the start and reset frames are zeros, the LEDs start black at full brightness
+    clocked_strip->led_frames = clocked_strip->frame_buf + model->start_bytes;
+    for (uint32_t i = 0; i < led_config->max_leds; i++) {
+        model->set_brightness(&clocked_strip->led_frames[i * model->frame_bytes], LED_STRIP_BRIGHTNESS_MAX);
+    }
+    memset(&clocked_strip->frame_buf[frame_buf_size - end_bytes], model->end_fill, end_bytes);
+
+    clocked_strip->spi_host = spi_config->spi_bus;
+    clocked_strip->spi_device = spi_device;
+    clocked_strip->model = model;
+    clocked_strip->pixel_ops = pixel_ops;
+    clocked_strip->strip_len = led_config->max_leds;
+    clocked_strip->frame_buf_size = frame_buf_size;
+    clocked_strip->base.set_pixel = led_strip_spi_clocked_set_pixel;
+    clocked_strip->base.set_pixel_rgbw = led_strip_spi_clocked_set_pixel_rgbw;
+    clocked_strip->base.set_pixels = led_strip_spi_clocked_set_pixels;
+    clocked_strip->base.fill = led_strip_spi_clocked_fill;
+    clocked_strip->base.get_pixels = led_strip_spi_clocked_get_pixels;
+    clocked_strip->base.set_pixel_brightness = led_strip_spi_clocked_set_pixel_brightness;
+    clocked_strip->base.refresh = led_strip_spi_clocked_refresh;
+    clocked_strip->base.clear = led_strip_spi_clocked_clear;
+    clocked_strip->base.del = led_strip_spi_clocked_del;
+
+    *ret_strip = &clocked_strip->base;
+    return ESP_OK;
+err:
+    if (spi_device) {
+        spi_bus_remove_device(spi_device);
+    }
+    if (bus_initialized) {
+        spi_bus_free(spi_config->spi_bus);
+    }
+    if (clocked_strip) {
+        free(clocked_strip);
+    }
+    return ret;
+}
@@ -0,0 +1,582 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_rom_gpio.h"
+#include "esp_clk_tree.h"
+#include "soc/spi_periph.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "hal/spi_hal.h"
+#include "led_strip_dirty.h"
+#include "led_strip_spi_encoder.h"
+#include "led_strip_pixels.h"
+#include "led_strip_spi_clocked.h"
+
+#define LED_STRIP_SPI_DEFAULT_TRANS_QUEUE_SIZE 4
+// LED data bytes encoded into each streaming buffer, a multiple of 4 for the word stores of the encoder and the white extraction
+#define LED_STRIP_SPI_STREAM_CHUNK_BYTES 256
+#define LED_STRIP_SPI_STREAM_BUFFERS 2
+// pixels of a span converted to LED data bytes at once, before being encoded in one go
+#define LED_STRIP_SPI_SPAN_CHUNK_PIXELS 32
+
+static const char *TAG = "led_strip_spi";
+
+/**
+ * @brief Timing windows of an LED model, in ns
+ *
+ * The high times are the datasheet ones (nominal +/- 150ns), with T1H kept 50ns above the low end for WS2812.
+ * Long low times are tolerated by the LEDs as long as they stay below the reset time, so only a minimum is given.
+ */
+typedef struct {
+    uint16_t t0h_min;
+    uint16_t t0h_max;
+    uint16_t t1h_min;
+    uint16_t t1h_max;
+    uint16_t tl_min;
+} led_strip_spi_timing_t;
+
+static const led_strip_spi_timing_t led_strip_spi_timings[] = {
+    [LED_MODEL_WS2812] = {.t0h_min = 250, .t0h_max = 550, .t1h_min = 700, .t1h_max = 950, .tl_min = 300},
+    [LED_MODEL_SK6812] = {.t0h_min = 150, .t0h_max = 450, .t1h_min = 450, .t1h_max = 750, .tl_min = 300},
+};
+
+typedef struct {
+    led_strip_t base;
+    spi_host_device_t spi_host;
+    spi_device_handle_t spi_device;
+    led_strip_dirty_t dirty;
+    led_strip_spi_pattern_t pattern;
+    uint32_t strip_len;
+    const led_strip_pixel_format_ops_t *pixel_ops; // channel order and width of the pixels
+    uint8_t bytes_per_pixel;
+    bool streaming;                                                 // pixel_buf holds LED data bytes, not their SPI pattern
+    led_strip_pixel_lut_t color_lut;                                // color LUT and white extraction, applied when the LED data bytes are encoded
+    uint8_t *lut_pixels;                                            // LED data bytes as set, kept while a color LUT or white extraction is set
+                                                                    // and not streaming, as the SPI patterns hold their output
+    uint8_t *stream_buf[LED_STRIP_SPI_STREAM_BUFFERS];              // DMA buffers, encoded alternately in streaming mode
+    spi_transaction_t stream_trans[LED_STRIP_SPI_STREAM_BUFFERS];
+    uint8_t pixel_buf[] __attribute__((aligned(4))); // word aligned for the bulk encoder
+} led_strip_spi_obj;
+
+// write the LED data bytes of a pixel, either as they are (streaming mode) or as their SPI pattern
+static void led_strip_spi_write_pixel(led_strip_spi_obj *spi_strip, uint32_t index, const uint8_t *pixel)
+{
+    if (spi_strip->streaming) {
+        memcpy(&spi_strip->pixel_buf[index * spi_strip->bytes_per_pixel], pixel, spi_strip->bytes_per_pixel);
+        return;
+    }
+    uint8_t mapped[4];
+    if (spi_strip->lut_pixels) {
+        memcpy(&spi_strip->lut_pixels[index * spi_strip->bytes_per_pixel], pixel, spi_strip->bytes_per_pixel);
+        led_strip_pixel_lut_map(&spi_strip->color_lut, mapped, pixel, spi_strip->bytes_per_pixel, 0);
+        pixel = mapped;
+    }
+    led_strip_spi_pattern_encode(&spi_strip->pattern, pixel, spi_strip->bytes_per_pixel,
+                                 &spi_strip->pixel_buf[index * spi_strip->bytes_per_pixel * spi_strip->pattern.bits_per_bit]);
+}
+
+// encode the SPI patterns of the whole strip again from the LED data bytes kept while a color LUT or white extraction is set
+static void led_strip_spi_encode_lut_pixels(led_strip_spi_obj *spi_strip)
+{
+    uint8_t chunk[LED_STRIP_SPI_SPAN_CHUNK_PIXELS * 4] __attribute__((aligned(4)));
+    size_t total = spi_strip->strip_len * spi_strip->bytes_per_pixel;
+    // a whole number of pixels per chunk, so each chunk starts with the first byte of a pixel
+    size_t chunk_bytes = LED_STRIP_SPI_SPAN_CHUNK_PIXELS * spi_strip->bytes_per_pixel;
+    for (size_t offset = 0; offset < total; offset += chunk_bytes) {
+        size_t len = MIN(chunk_bytes, total - offset);
+        led_strip_pixel_lut_map(&spi_strip->color_lut, chunk, &spi_strip->lut_pixels[offset], len, 0);
+        led_strip_spi_pattern_encode(&spi_strip->pattern, chunk, len, &spi_strip->pixel_buf[offset * spi_strip->pattern.bits_per_bit]);
+    }
+}
+
+static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    led_strip_dirty_mark(&spi_strip->dirty, index);
+    // LED_PIXEL_FORMAT_GRB takes 72bits(9bytes)
+    uint8_t pixel[4];
+    spi_strip->pixel_ops->set(pixel, red, green, blue, 0);
+    led_strip_spi_write_pixel(spi_strip, index, pixel);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(spi_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    led_strip_dirty_mark(&spi_strip->dirty, index);
+    // LED_PIXEL_FORMAT_GRBW takes 96bits(12bytes)
+    uint8_t pixel[4];
+    spi_strip->pixel_ops->set(pixel, red, green, blue, white);
+    led_strip_spi_write_pixel(spi_strip, index, pixel);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixels(led_strip_t *strip, uint32_t offset, const uint8_t *src, uint32_t count, led_strip_src_format_t format)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, spi_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(spi_strip->pixel_ops->convert[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    if (count == 0) {
+        return ESP_OK;
+    }
+    led_strip_dirty_mark(&spi_strip->dirty, offset);
+    led_strip_dirty_mark(&spi_strip->dirty, offset + count - 1);
+    uint8_t bytes_per_pixel = spi_strip->bytes_per_pixel;
+    if (spi_strip->streaming) {
+        spi_strip->pixel_ops->convert[format](&spi_strip->pixel_buf[offset * bytes_per_pixel], src, count);
+        return ESP_OK;
+    }
+    // convert the span to LED data bytes chunk by chunk, and encode each chunk with one call of the bulk encoder
+    uint8_t chunk[LED_STRIP_SPI_SPAN_CHUNK_PIXELS * 4] __attribute__((aligned(4)));
+    uint8_t src_bytes_per_pixel = format == LED_STRIP_SRC_FORMAT_RGBW ? 4 : 3;
+    while (count) {
+        uint32_t len = MIN(count, LED_STRIP_SPI_SPAN_CHUNK_PIXELS);
+        spi_strip->pixel_ops->convert[format](chunk, src, len);
+        if (spi_strip->lut_pixels) {
+            memcpy(&spi_strip->lut_pixels[offset * bytes_per_pixel], chunk, len * bytes_per_pixel);
+            led_strip_pixel_lut_map(&spi_strip->color_lut, chunk, chunk, len * bytes_per_pixel, 0);
+        }
+        led_strip_spi_pattern_encode(&spi_strip->pattern, chunk, len * bytes_per_pixel,
+                                     &spi_strip->pixel_buf[offset * bytes_per_pixel * spi_strip->pattern.bits_per_bit]);
+        offset += len;
+        src += len * src_bytes_per_pixel;
+        count -= len;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_fill(led_strip_t *strip, uint32_t offset, uint32_t count, const uint8_t *color, led_strip_src_format_t format)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, spi_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(spi_strip->pixel_ops->convert[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    if (count == 0) {
+        return ESP_OK;
+    }
+    led_strip_dirty_mark(&spi_strip->dirty, offset);
+    led_strip_dirty_mark(&spi_strip->dirty, offset + count - 1);
+    uint8_t bytes_per_pixel = spi_strip->bytes_per_pixel;
+    if (spi_strip->streaming) {
+        led_strip_pixels_fill(spi_strip->pixel_ops, &spi_strip->pixel_buf[offset * bytes_per_pixel], color, count, format);
+        return ESP_OK;
+    }
+    // encode the pixel once, then copy its SPI pattern over the span
+    uint8_t pixel[4];
+    spi_strip->pixel_ops->convert[format](pixel, color, 1);
+    if (spi_strip->lut_pixels) {
+        led_strip_pixels_fill(spi_strip->pixel_ops, &spi_strip->lut_pixels[offset * bytes_per_pixel], color, count, format);
+        led_strip_pixel_lut_map(&spi_strip->color_lut, pixel, pixel, bytes_per_pixel, 0);
+    }
+    size_t encoded_size = bytes_per_pixel * spi_strip->pattern.bits_per_bit;
+    uint8_t *buf = &spi_strip->pixel_buf[offset * encoded_size];
+    led_strip_spi_pattern_encode(&spi_strip->pattern, pixel, bytes_per_pixel, buf);
+    led_strip_pixels_repeat(buf, encoded_size, count);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_get_pixels(led_strip_t *strip, uint32_t offset, uint8_t *dst, uint32_t count, led_strip_src_format_t format)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(led_strip_pixels_span_valid(offset, count, spi_strip->strip_len), ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(spi_strip->pixel_ops->read[format], ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    uint8_t bytes_per_pixel = spi_strip->bytes_per_pixel;
+    if (spi_strip->streaming || spi_strip->lut_pixels) {
+        // the colors as they were set, not the output of the color LUT
+        const uint8_t *pixels = spi_strip->streaming ? spi_strip->pixel_buf : spi_strip->lut_pixels;
+        spi_strip->pixel_ops->read[format](dst, &pixels[offset * bytes_per_pixel], count);
+        return ESP_OK;
+    }
+    // decode the SPI patterns back to LED data bytes chunk by chunk
+    uint8_t chunk[LED_STRIP_SPI_SPAN_CHUNK_PIXELS * 4];
+    uint8_t dst_bytes_per_pixel = format == LED_STRIP_SRC_FORMAT_RGBW ? 4 : 3;
+    while (count) {
+        uint32_t len = MIN(count, LED_STRIP_SPI_SPAN_CHUNK_PIXELS);
+        led_strip_spi_pattern_decode(&spi_strip->pattern, &spi_strip->pixel_buf[offset * bytes_per_pixel * spi_strip->pattern.bits_per_bit],
+                                     len * bytes_per_pixel, chunk);
+        spi_strip->pixel_ops->read[format](dst, chunk, len);
+        offset += len;
+        dst += len * dst_bytes_per_pixel;
+        count -= len;
+    }
+    return ESP_OK;
+}
+
+// encode the next chunk of the LED data bytes into the buffer of a streaming transaction, and queue it
+static esp_err_t led_strip_spi_stream_queue(led_strip_spi_obj *spi_strip, spi_transaction_t *trans, size_t *offset, size_t total)
+{
+    size_t len = total - *offset;
+    if (len > LED_STRIP_SPI_STREAM_CHUNK_BYTES) {
+        len = LED_STRIP_SPI_STREAM_CHUNK_BYTES;
+    }
+    uint8_t *buf = spi_strip->stream_buf[trans - spi_strip->stream_trans];
+    const uint8_t *data = &spi_strip->pixel_buf[*offset];
+    uint8_t mapped[LED_STRIP_SPI_STREAM_CHUNK_BYTES] __attribute__((aligned(4)));
+    if (led_strip_pixel_lut_active(&spi_strip->color_lut)) {
+        led_strip_pixel_lut_map(&spi_strip->color_lut, mapped, data, len, *offset % spi_strip->bytes_per_pixel);
+        data = mapped;
+    }
+    led_strip_spi_pattern_encode(&spi_strip->pattern, data, len, buf);
+    trans->length = len * spi_strip->pattern.bits_per_bit * 8;
+    trans->tx_buffer = buf;
+    ESP_RETURN_ON_ERROR(spi_device_queue_trans(spi_strip->spi_device, trans, portMAX_DELAY), TAG, "queue SPI transaction failed");
+    *offset += len;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_refresh_streaming(led_strip_spi_obj *spi_strip, uint32_t len)
+{
+    size_t total = len * spi_strip->bytes_per_pixel;
+    size_t offset = 0;
+    int queued = 0;
+    esp_err_t ret = ESP_OK;
+
+    // the bus is held for the whole frame, so the driver starts each transaction right after the previous one
+    ESP_RETURN_ON_ERROR(spi_device_acquire_bus(spi_strip->spi_device, portMAX_DELAY), TAG, "acquire SPI bus failed");
+    for (int i = 0; i < LED_STRIP_SPI_STREAM_BUFFERS && offset < total && ret == ESP_OK; i++) {
+        ret = led_strip_spi_stream_queue(spi_strip, &spi_strip->stream_trans[i], &offset, total);
+        queued += ret == ESP_OK;
+    }
+    // refill each buffer as soon as its transaction is done, while the other one is being sent
+    while (queued) {
+        spi_transaction_t *done = NULL;
+        esp_err_t result = spi_device_get_trans_result(spi_strip->spi_device, &done, portMAX_DELAY);
+        if (result != ESP_OK) {
+            ret = result;
+            break;
+        }
+        queued--;
+        if (offset < total && ret == ESP_OK) {
+            ret = led_strip_spi_stream_queue(spi_strip, done, &offset, total);
+            queued += ret == ESP_OK;
+        }
+    }
+    spi_device_release_bus(spi_strip->spi_device);
+    return ret;
+}
+
+static esp_err_t led_strip_spi_refresh(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    spi_transaction_t tx_conf;
+    memset(&tx_conf, 0, sizeof(tx_conf));
+
+    // pixels after the last changed one keep their latched color, no need to send them
+    uint32_t len = led_strip_dirty_take(&spi_strip->dirty, spi_strip->strip_len);
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (spi_strip->streaming) {
+        esp_err_t ret = led_strip_spi_refresh_streaming(spi_strip, len);
+        if (ret != ESP_OK) {
+            led_strip_dirty_restore(&spi_strip->dirty, len);
+        }
+        return ret;
+    }
+    tx_conf.length = len * spi_strip->bytes_per_pixel * spi_strip->pattern.bits_per_bit * 8;
+    tx_conf.tx_buffer = spi_strip->pixel_buf;
+    tx_conf.rx_buffer = NULL;
+    esp_err_t ret = spi_device_transmit(spi_strip->spi_device, &tx_conf);
+    if (ret != ESP_OK) {
+        led_strip_dirty_restore(&spi_strip->dirty, len);
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "transmit pixels by SPI failed");
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_clear(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    //Write zero to turn off all leds
+    if (spi_strip->streaming) {
+        memset(spi_strip->pixel_buf, 0, spi_strip->strip_len * spi_strip->bytes_per_pixel);
+    } else if (spi_strip->lut_pixels) {
+        // zero may not be an entry of zero in the color LUT
+        memset(spi_strip->lut_pixels, 0, spi_strip->strip_len * spi_strip->bytes_per_pixel);
+        led_strip_spi_encode_lut_pixels(spi_strip);
+    } else {
+        led_strip_spi_pattern_fill(&spi_strip->pattern, 0, spi_strip->strip_len * spi_strip->bytes_per_pixel, spi_strip->pixel_buf);
+    }
+    led_strip_dirty_mark(&spi_strip->dirty, spi_strip->strip_len - 1);
+
+    return led_strip_spi_refresh(strip);
+}
+
+static esp_err_t led_strip_spi_set_pixel_lut(led_strip_spi_obj *spi_strip, const led_strip_color_lut_t *lut, const led_strip_white_lut_t *white)
+{
+    size_t total = spi_strip->strip_len * spi_strip->bytes_per_pixel;
+    bool active = lut || white;
+    if (!spi_strip->streaming && active && !spi_strip->lut_pixels) {
+        // no color LUT was set, the SPI patterns decode to the colors as they were set
+        spi_strip->lut_pixels = malloc(total);
+        ESP_RETURN_ON_FALSE(spi_strip->lut_pixels, ESP_ERR_NO_MEM, TAG, "no mem for the pixels before the color LUT");
+        led_strip_spi_pattern_decode(&spi_strip->pattern, spi_strip->pixel_buf, total, spi_strip->lut_pixels);
+    }
+    led_strip_pixel_lut_init(&spi_strip->color_lut, spi_strip->pixel_ops, lut, white);
+    if (spi_strip->lut_pixels) {
+        if (active) {
+            led_strip_spi_encode_lut_pixels(spi_strip);
+        } else {
+            led_strip_spi_pattern_encode(&spi_strip->pattern, spi_strip->lut_pixels, total, spi_strip->pixel_buf);
+            free(spi_strip->lut_pixels);
+            spi_strip->lut_pixels = NULL;
+        }
+    }
+    // the LEDs hold the output of the previous table, send the whole strip again at the next refresh
+    led_strip_dirty_mark(&spi_strip->dirty, 0);
+    led_strip_dirty_mark(&spi_strip->dirty, spi_strip->strip_len - 1);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_color_lut(led_strip_t *strip, const led_strip_color_lut_t *lut)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    return led_strip_spi_set_pixel_lut(spi_strip, lut, spi_strip->color_lut.white);
+}
+
+static esp_err_t led_strip_spi_set_white_lut(led_strip_t *strip, const led_strip_white_lut_t *lut)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(spi_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    return led_strip_spi_set_pixel_lut(spi_strip, spi_strip->color_lut.lut, lut);
+}
+
+static esp_err_t led_strip_spi_del(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+
+    ESP_RETURN_ON_ERROR(spi_bus_remove_device(spi_strip->spi_device), TAG, "delete spi device failed");
+    ESP_RETURN_ON_ERROR(spi_bus_free(spi_strip->spi_host), TAG, "free spi bus failed");
+
+    for (int i = 0; i < LED_STRIP_SPI_STREAM_BUFFERS; i++) {
+        heap_caps_free(spi_strip->stream_buf[i]);
+    }
+    free(spi_strip->lut_pixels);
+    free(spi_strip);
+    return ESP_OK;
+}
+
+// check if an SPI bit time (ns) gives LED bit timings within the windows, with t0h_bits/t1h_bits of bits_per_bit SPI bits high
+static bool led_strip_spi_timing_fits(const led_strip_spi_timing_t *timing, uint8_t bits_per_bit, uint8_t t0h_bits, uint8_t t1h_bits, float bit_ns)
+{
+    return t0h_bits * bit_ns >= timing->t0h_min && t0h_bits * bit_ns <= timing->t0h_max &&
+           t1h_bits * bit_ns >= timing->t1h_min && t1h_bits * bit_ns <= timing->t1h_max &&
+           (bits_per_bit - t1h_bits) * bit_ns >= timing->tl_min;
+}
+
+// get the range of SPI bit times (ns) for which a pattern fits the timing windows, false if there is none
+static bool led_strip_spi_bit_ns_range(const led_strip_spi_timing_t *timing, uint8_t bits_per_bit, uint8_t t0h_bits, uint8_t t1h_bits,
+                                       uint32_t *ret_min, uint32_t *ret_max)
+{
+    uint8_t tl_bits = bits_per_bit - t1h_bits;
+    *ret_min = MAX(MAX((timing->t0h_min + t0h_bits - 1) / t0h_bits, (timing->t1h_min + t1h_bits - 1) / t1h_bits),
+                   (timing->tl_min + tl_bits - 1) / tl_bits);
+    *ret_max = MIN(timing->t0h_max / t0h_bits, timing->t1h_max / t1h_bits);
+    return *ret_min <= *ret_max;
+}
+
+/**
+ * @brief Find the SPI clock and bit pattern for an LED model, and add the SPI device with that clock
+ *
+ * Patterns with fewer SPI bits per LED bit are tried first, as they need less memory and bus bandwidth,
+ * and among the patterns of the same length, the one allowing the shortest LED bit.
+ * For each of them, the fastest clock that keeps the LED timings within their windows is requested,
+ * and the pattern is only used if the clock the driver actually sets up still fits.
+ * Without `ret_device`, the clock is computed from the clock source instead, and no device is added.
+ */
+static esp_err_t led_strip_spi_select_timing(spi_host_device_t spi_host, spi_clock_source_t clk_src, led_model_t led_model,
+                                             spi_device_handle_t *ret_device, led_strip_spi_pattern_t *ret_pattern)
+{
+    const led_strip_spi_timing_t *timing = &led_strip_spi_timings[led_model];
+    uint32_t src_hz = 0;
+    if (!ret_device) {
+        ESP_RETURN_ON_ERROR(esp_clk_tree_src_get_freq_hz((soc_module_clk_t)(clk_src ? clk_src : SPI_CLK_SRC_DEFAULT),
+                                                         ESP_CLK_TREE_SRC_FREQ_PRECISION_APPROX, &src_hz), TAG, "Failed to get the SPI clock source frequency");
+    }
+    spi_device_interface_config_t spi_dev_cfg = {
+        .clock_source = clk_src,
+        .command_bits = 0,
+        .address_bits = 0,
+        .dummy_bits = 0,
+        .mode = 0,
+        //set -1 when CS is not used
+        .spics_io_num = -1,
+        .queue_size = LED_STRIP_SPI_DEFAULT_TRANS_QUEUE_SIZE,
+    };
+
+    for (uint8_t n = LED_STRIP_SPI_MIN_BITS_PER_BIT; n <= LED_STRIP_SPI_MAX_BITS_PER_BIT; n++) {
+        uint64_t tried = 0; // one bit per (T0H, T1H) pair
+        while (true) {
+            uint8_t best_k0 = 0;
+            uint8_t best_k1 = 0;
+            uint32_t best_min = UINT32_MAX;
+            uint32_t best_max = 0;
+            for (uint8_t k1 = 2; k1 < n; k1++) {
+                for (uint8_t k0 = 1; k0 < k1; k0++) {
+                    uint32_t bit_ns_min, bit_ns_max;
+                    if (!(tried & (1ULL << (k0 * 8 + k1))) && led_strip_spi_bit_ns_range(timing, n, k0, k1, &bit_ns_min, &bit_ns_max) &&
+                            bit_ns_min < best_min) {
+                        best_k0 = k0;
+                        best_k1 = k1;
+                        best_min = bit_ns_min;
+                        best_max = bit_ns_max;
+                    }
+                }
+            }
+            if (best_k0 == 0) {
+                break;
+            }
+            tried |= 1ULL << (best_k0 * 8 + best_k1);
+
+            // ask for the fastest clock, then for the middle of the range in case the clock divider rounds it out
+            uint32_t bit_ns_tries[] = {best_min, (best_min + best_max) / 2};
+            for (int i = 0; i < 2; i++) {
+                spi_device_handle_t device = NULL;
+                int clock_khz = 0;
+                spi_dev_cfg.clock_speed_hz = 1000000000 / bit_ns_tries[i];
+                if (ret_device) {
+                    ESP_RETURN_ON_ERROR(spi_bus_add_device(spi_host, &spi_dev_cfg, &device), TAG, "Failed to add spi device");
+                    spi_device_get_actual_freq(device, &clock_khz);
+                } else {
+                    clock_khz = spi_get_actual_clock(src_hz, spi_dev_cfg.clock_speed_hz, 128) / 1000;
+                }
+                if (clock_khz > 0 && led_strip_spi_timing_fits(timing, n, best_k0, best_k1, 1e6f / clock_khz)) {
+                    ESP_LOGD(TAG, "SPI clock %dKHz, %d bits per LED bit, T0H %d bits, T1H %d bits", clock_khz, n, best_k0, best_k1);
+                    led_strip_spi_pattern_init(ret_pattern, n, best_k0, best_k1);
+                    if (ret_device) {
+                        *ret_device = device;
+                    }
+                    return ESP_OK;
+                }
+                if (device) {
+                    spi_bus_remove_device(device);
+                }
+            }
+        }
+    }
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t led_strip_spi_get_bits_per_bit(spi_clock_source_t clk_src, led_model_t led_model, uint8_t *ret_bits_per_bit)
+{
+    ESP_RETURN_ON_FALSE(ret_bits_per_bit, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(led_model == LED_MODEL_WS2812 || led_model == LED_MODEL_SK6812, ESP_ERR_INVALID_ARG, TAG, "invalid led_model");
+    led_strip_spi_pattern_t pattern;
+    ESP_RETURN_ON_ERROR(led_strip_spi_select_timing(SPI2_HOST, clk_src, led_model, NULL, &pattern), TAG, "no SPI timing for the LED model");
+    *ret_bits_per_bit = pattern.bits_per_bit;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const led_strip_spi_config_t *spi_config, led_strip_handle_t *ret_strip)
+{
+    led_strip_spi_obj *spi_strip = NULL;
+    spi_device_handle_t spi_device = NULL;
+    bool bus_initialized = false;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && spi_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    if (led_strip_model_is_clocked(led_config->led_model)) {
+        // clocked LEDs take their frames as they are, without the bit patterns of the one-wire LEDs
+        return led_strip_new_spi_clocked_device(led_config, spi_config, ret_strip);
+    }
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_pixel_format");
+    ESP_GOTO_ON_FALSE(led_config->led_model == LED_MODEL_WS2812 || led_config->led_model == LED_MODEL_SK6812, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_model");
+    const led_strip_pixel_format_ops_t *pixel_ops = led_strip_pixel_format_get_ops(led_config->led_pixel_format);
+    uint8_t bytes_per_pixel = pixel_ops->bytes_per_pixel;
+    bool streaming = spi_config->flags.streaming;
+    ESP_GOTO_ON_FALSE(!streaming || spi_config->flags.with_dma, ESP_ERR_INVALID_ARG, err, TAG, "streaming mode requires DMA");
+
+    // for backward compatibility, if the user does not set the clk_src, use the default value
+    spi_clock_source_t clk_src = SPI_CLK_SRC_DEFAULT;
+    if (spi_config->clk_src) {
+        clk_src = spi_config->clk_src;
+    }
+
+    // in streaming mode, the pixel buffer holds the LED data bytes only, and the encoded chunks go to small DMA buffers
+    size_t transfer_color_bytes = streaming ? LED_STRIP_SPI_STREAM_CHUNK_BYTES : led_config->max_leds * bytes_per_pixel;
+    spi_bus_config_t spi_bus_cfg = {
+        .mosi_io_num = led_config->strip_gpio_num,
+        //Only use MOSI to generate the signal, set -1 when other pins are not used.
+        .miso_io_num = -1,
+        .sclk_io_num = -1,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        // the bit pattern, hence the transfer size, is only known once the clock is set up
+        .max_transfer_sz = transfer_color_bytes * LED_STRIP_SPI_MAX_BITS_PER_BIT,
+    };
+    ESP_GOTO_ON_ERROR(spi_bus_initialize(spi_config->spi_bus, &spi_bus_cfg, spi_config->flags.with_dma ? SPI_DMA_CH_AUTO : SPI_DMA_DISABLED), err, TAG, "create SPI bus failed");
+    bus_initialized = true;
+
+    if (led_config->flags.invert_out == true) {
+        esp_rom_gpio_connect_out_signal(led_config->strip_gpio_num, spi_periph_signal[spi_config->spi_bus].spid_out, true, false);
+    }
+
+    // the number of SPI bits per LED bit depends on the clock the SPI driver can set up from the clock source
+    led_strip_spi_pattern_t pattern;
+    ESP_GOTO_ON_ERROR(led_strip_spi_select_timing(spi_config->spi_bus, clk_src, led_config->led_model, &spi_device, &pattern), err,
+                      TAG, "no SPI clock fits the LED timing");
+
+    uint32_t mem_caps = MALLOC_CAP_DEFAULT;
+    size_t pixel_buf_size = led_config->max_leds * bytes_per_pixel;
+    if (!streaming) {
+        if (spi_config->flags.with_dma) {
+            // DMA buffer must be placed in internal SRAM
+            mem_caps |= MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA;
+        }
+        pixel_buf_size *= pattern.bits_per_bit;
+    }
+    spi_strip = heap_caps_calloc(1, sizeof(led_strip_spi_obj) + pixel_buf_size, mem_caps);
+    ESP_GOTO_ON_FALSE(spi_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for spi strip");
+    if (streaming) {
+        for (int i = 0; i < LED_STRIP_SPI_STREAM_BUFFERS; i++) {
+            spi_strip->stream_buf[i] = heap_caps_aligned_calloc(4, 1, LED_STRIP_SPI_STREAM_CHUNK_BYTES * pattern.bits_per_bit, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+            ESP_GOTO_ON_FALSE(spi_strip->stream_buf[i], ESP_ERR_NO_MEM, err, TAG, "no mem for spi streaming buffer");
+        }
+    }
+
+    spi_strip->spi_host = spi_config->spi_bus;
+    spi_strip->spi_device = spi_device;
+    spi_strip->pattern = pattern;
+    spi_strip->bytes_per_pixel = bytes_per_pixel;
+    spi_strip->pixel_ops = pixel_ops;
+    spi_strip->streaming = streaming;
+    spi_strip->strip_len = led_config->max_leds;
+    led_strip_dirty_init(&spi_strip->dirty, led_config->max_leds, led_config->full_refresh_interval);
+    spi_strip->base.set_pixel = led_strip_spi_set_pixel;
+    spi_strip->base.set_pixel_rgbw = led_strip_spi_set_pixel_rgbw;
+    spi_strip->base.set_pixels = led_strip_spi_set_pixels;
+    spi_strip->base.fill = led_strip_spi_fill;
+    spi_strip->base.get_pixels = led_strip_spi_get_pixels;
+    spi_strip->base.set_color_lut = led_strip_spi_set_color_lut;
+    spi_strip->base.set_white_lut = led_strip_spi_set_white_lut;
+    spi_strip->base.refresh = led_strip_spi_refresh;
+    spi_strip->base.clear = led_strip_spi_clear;
+    spi_strip->base.del = led_strip_spi_del;
+
+    *ret_strip = &spi_strip->base;
+    return ESP_OK;
+err:
+    if (spi_device) {
+        spi_bus_remove_device(spi_device);
+    }
+    if (bus_initialized) {
+        spi_bus_free(spi_config->spi_bus);
+    }
+    if (spi_strip) {
+        for (int i = 0; i < LED_STRIP_SPI_STREAM_BUFFERS; i++) {
+            heap_caps_free(spi_strip->stream_buf[i]);
+        }
+        free(spi_strip);
+    }
+    return ret;
+}
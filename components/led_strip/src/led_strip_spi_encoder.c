@@ -0,0 +1,190 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdbool.h>
+#include <string.h>
+#include "led_strip_spi_encoder.h"
+
+// the word stores below place the pattern bytes in memory order on a little-endian CPU
+_Static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "SPI encoder requires a little-endian target");
+
+// The 24-bit pattern of a data byte, MSB first: a "1 d 0" triplet per data bit, d being the data bit
+#define LED_STRIP_SPI_BIT(d, k) ((((d) >> (k)) & 1) << (3 * (k) + 1))
+#define LED_STRIP_SPI_PATTERN(d)                                                    \
+    (0x924924 | LED_STRIP_SPI_BIT(d, 0) | LED_STRIP_SPI_BIT(d, 1) | LED_STRIP_SPI_BIT(d, 2) | \
+     LED_STRIP_SPI_BIT(d, 3) | LED_STRIP_SPI_BIT(d, 4) | LED_STRIP_SPI_BIT(d, 5) |            \
+     LED_STRIP_SPI_BIT(d, 6) | LED_STRIP_SPI_BIT(d, 7))
+// The same pattern with its three bytes in memory order, first byte in the lowest bits
+#define LED_STRIP_SPI_ENTRY(d) \
+    ((LED_STRIP_SPI_PATTERN(d) >> 16) | (LED_STRIP_SPI_PATTERN(d) & 0xFF00) | ((LED_STRIP_SPI_PATTERN(d) & 0xFF) << 16))
+
+#define LED_STRIP_SPI_ENTRY4(d) \
+    LED_STRIP_SPI_ENTRY(d), LED_STRIP_SPI_ENTRY((d) + 1), LED_STRIP_SPI_ENTRY((d) + 2), LED_STRIP_SPI_ENTRY((d) + 3)
+#define LED_STRIP_SPI_ENTRY16(d) \
+    LED_STRIP_SPI_ENTRY4(d), LED_STRIP_SPI_ENTRY4((d) + 4), LED_STRIP_SPI_ENTRY4((d) + 8), LED_STRIP_SPI_ENTRY4((d) + 12)
+#define LED_STRIP_SPI_ENTRY64(d) \
+    LED_STRIP_SPI_ENTRY16(d), LED_STRIP_SPI_ENTRY16((d) + 16), LED_STRIP_SPI_ENTRY16((d) + 32), LED_STRIP_SPI_ENTRY16((d) + 48)
+
+static const uint32_t led_strip_spi_lut[256] = {
+    LED_STRIP_SPI_ENTRY64(0), LED_STRIP_SPI_ENTRY64(64), LED_STRIP_SPI_ENTRY64(128), LED_STRIP_SPI_ENTRY64(192),
+};
+
+static inline void led_strip_spi_store3(uint32_t pattern, uint8_t *buf)
+{
+    buf[0] = pattern;
+    buf[1] = pattern >> 8;
+    buf[2] = pattern >> 16;
+}
+
+// 4 patterns of 3 bytes make 3 words
+static inline void led_strip_spi_store12(uint32_t p0, uint32_t p1, uint32_t p2, uint32_t p3, uint32_t *buf)
+{
+    buf[0] = p0 | p1 << 24;
+    buf[1] = p1 >> 8 | p2 << 16;
+    buf[2] = p2 >> 16 | p3 << 8;
+}
+
+void led_strip_spi_encode(const uint8_t *data, size_t len, uint8_t *buf)
+{
+    // a 3-byte step moves the alignment by 3 mod 4, so at most 3 single bytes reach a word boundary
+    while (len && ((uintptr_t)buf & 3)) {
+        led_strip_spi_store3(led_strip_spi_lut[*data++], buf);
+        buf += LED_STRIP_SPI_BYTES_PER_COLOR_BYTE;
+        len--;
+    }
+    uint32_t *words = (uint32_t *)buf;
+    for (; len >= 4; len -= 4) {
+        led_strip_spi_store12(led_strip_spi_lut[data[0]], led_strip_spi_lut[data[1]],
+                              led_strip_spi_lut[data[2]], led_strip_spi_lut[data[3]], words);
+        data += 4;
+        words += 3;
+    }
+    buf = (uint8_t *)words;
+    while (len--) {
+        led_strip_spi_store3(led_strip_spi_lut[*data++], buf);
+        buf += LED_STRIP_SPI_BYTES_PER_COLOR_BYTE;
+    }
+}
+
+void led_strip_spi_encode_fill(uint8_t value, size_t len, uint8_t *buf)
+{
+    uint32_t pattern = led_strip_spi_lut[value];
+    while (len && ((uintptr_t)buf & 3)) {
+        led_strip_spi_store3(pattern, buf);
+        buf += LED_STRIP_SPI_BYTES_PER_COLOR_BYTE;
+        len--;
+    }
+    uint32_t words[3];
+    led_strip_spi_store12(pattern, pattern, pattern, pattern, words);
+    uint32_t *out = (uint32_t *)buf;
+    for (; len >= 4; len -= 4) {
+        out[0] = words[0];
+        out[1] = words[1];
+        out[2] = words[2];
+        out += 3;
+    }
+    buf = (uint8_t *)out;
+    while (len--) {
+        led_strip_spi_store3(pattern, buf);
+        buf += LED_STRIP_SPI_BYTES_PER_COLOR_BYTE;
+    }
+}
+
+void led_strip_spi_pattern_init(led_strip_spi_pattern_t *pattern, uint8_t bits_per_bit, uint8_t t0h_bits, uint8_t t1h_bits)
+{
+    // an LED bit is its high SPI bits followed by low ones, MSB first
+    uint32_t bit0 = ((1U << t0h_bits) - 1) << (bits_per_bit - t0h_bits);
+    uint32_t bit1 = ((1U << t1h_bits) - 1) << (bits_per_bit - t1h_bits);
+    pattern->bits_per_bit = bits_per_bit;
+    pattern->t0h_bits = t0h_bits;
+    pattern->t1h_bits = t1h_bits;
+    for (int n = 0; n < 16; n++) {
+        uint32_t bits = 0;
+        for (int i = 3; i >= 0; i--) {
+            bits = bits << bits_per_bit | (n & (1 << i) ? bit1 : bit0);
+        }
+        pattern->nibble[n] = bits;
+    }
+}
+
+static inline bool led_strip_spi_pattern_is_3bit(const led_strip_spi_pattern_t *pattern)
+{
+    return pattern->bits_per_bit == 3 && pattern->t0h_bits == 1 && pattern->t1h_bits == 2;
+}
+
+// store the `bits_per_bit` * 8 bits of an LED byte, MSB first
+static inline void led_strip_spi_pattern_store(const led_strip_spi_pattern_t *pattern, uint8_t data, uint8_t *buf)
+{
+    uint8_t n = pattern->bits_per_bit;
+    uint64_t bits = (uint64_t)pattern->nibble[data >> 4] << (4 * n) | pattern->nibble[data & 0x0F];
+    for (int i = n - 1; i >= 0; i--) {
+        *buf++ = bits >> (8 * i);
+    }
+}
+
+void led_strip_spi_pattern_encode(const led_strip_spi_pattern_t *pattern, const uint8_t *data, size_t len, uint8_t *buf)
+{
+    if (led_strip_spi_pattern_is_3bit(pattern)) {
+        led_strip_spi_encode(data, len, buf);
+        return;
+    }
+    while (len--) {
+        led_strip_spi_pattern_store(pattern, *data++, buf);
+        buf += pattern->bits_per_bit;
+    }
+}
+
+// get an LED byte back from its `n` * 8 SPI bits, sampling SPI bit number `sample` (counting from 0) of each LED bit
+static inline uint8_t led_strip_spi_pattern_load(const uint8_t *buf, uint8_t n, uint8_t sample)
+{
+    uint64_t bits = 0;
+    for (int i = 0; i < n; i++) {
+        bits = bits << 8 | buf[i];
+    }
+    uint8_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value |= ((bits >> (i * n + n - 1 - sample)) & 1) << i;
+    }
+    return value;
+}
+
+void led_strip_spi_pattern_decode(const led_strip_spi_pattern_t *pattern, const uint8_t *buf, size_t len, uint8_t *data)
+{
+    // SPI bit number t0h_bits of an LED bit is high for a 1 and low for a 0
+    if (led_strip_spi_pattern_is_3bit(pattern)) {
+        // the middle bit of each 3-bit group, picked with one mask per LED bit
+        for (size_t i = 0; i < len; i++, buf += 3) {
+            uint32_t b0 = buf[0];
+            uint32_t b1 = buf[1];
+            uint32_t b2 = buf[2];
+            data[i] = (b0 << 1 & 0x80) | (b0 << 3 & 0x40) | (b0 << 5 & 0x20) | (b1 >> 1 & 0x10) |
+                      (b1 << 1 & 0x08) | (b2 >> 5 & 0x04) | (b2 >> 3 & 0x02) | (b2 >> 1 & 0x01);
+        }
+        return;
+    }
+    for (size_t i = 0; i < len; i++, buf += pattern->bits_per_bit) {
+        data[i] = led_strip_spi_pattern_load(buf, pattern->bits_per_bit, pattern->t0h_bits);
+    }
+}
+
+void led_strip_spi_pattern_fill(const led_strip_spi_pattern_t *pattern, uint8_t value, size_t len, uint8_t *buf)
+{
+    if (led_strip_spi_pattern_is_3bit(pattern)) {
+        led_strip_spi_encode_fill(value, len, buf);
+        return;
+    }
+    if (len == 0) {
+        return;
+    }
+    // encode the value once, then copy it over the rest of the buffer in doubling blocks
+    size_t done = pattern->bits_per_bit;
+    size_t total = len * pattern->bits_per_bit;
+    led_strip_spi_pattern_store(pattern, value, buf);
+    while (done < total) {
+        size_t n = done < total - done ? done : total - done;
+        memcpy(buf + done, buf, n);
+        done += n;
+    }
+}
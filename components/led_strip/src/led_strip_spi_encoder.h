@@ -0,0 +1,103 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of SPI bytes used to represent one LED data byte with the 3-bit pattern
+ *
+ * Each LED bit is sent as three SPI bits: 100 for a 0, 110 for a 1.
+ */
+#define LED_STRIP_SPI_BYTES_PER_COLOR_BYTE 3
+
+#define LED_STRIP_SPI_MIN_BITS_PER_BIT 3 /*!< Fewest SPI bits per LED bit */
+#define LED_STRIP_SPI_MAX_BITS_PER_BIT 8 /*!< Most SPI bits per LED bit */
+
+/**
+ * @brief SPI bit pattern of the LED bits
+ *
+ * Each LED bit is sent as `bits_per_bit` SPI bits, of which the first `t0h_bits` (for a 0) or `t1h_bits` (for a 1) are high.
+ * As an LED byte takes `bits_per_bit` * 8 SPI bits, it is also the number of SPI bytes per LED byte.
+ */
+typedef struct {
+    uint8_t bits_per_bit;  /*!< SPI bits per LED bit, from LED_STRIP_SPI_MIN_BITS_PER_BIT to LED_STRIP_SPI_MAX_BITS_PER_BIT */
+    uint8_t t0h_bits;      /*!< High SPI bits of a 0 */
+    uint8_t t1h_bits;      /*!< High SPI bits of a 1 */
+    uint32_t nibble[16];   /*!< SPI bits of each LED data nibble, in the low `bits_per_bit` * 4 bits */
+} led_strip_spi_pattern_t;
+
+/**
+ * @brief Build the pattern tables for a number of SPI bits per LED bit
+ *
+ * @param pattern: pattern to initialize
+ * @param bits_per_bit: SPI bits per LED bit
+ * @param t0h_bits: high SPI bits of a 0, at least 1
+ * @param t1h_bits: high SPI bits of a 1, more than `t0h_bits` and less than `bits_per_bit`
+ */
+void led_strip_spi_pattern_init(led_strip_spi_pattern_t *pattern, uint8_t bits_per_bit, uint8_t t0h_bits, uint8_t t1h_bits);
+
+/**
+ * @brief Encode LED data bytes with a pattern
+ *
+ * The 3-bit pattern (100/110) goes through `led_strip_spi_encode`, the others through the pattern's nibble table.
+ *
+ * @param pattern: pattern built by `led_strip_spi_pattern_init`
+ * @param data: LED data bytes, in the order they are sent
+ * @param len: number of LED data bytes
+ * @param buf: output buffer, receives `len * pattern->bits_per_bit` bytes
+ */
+void led_strip_spi_pattern_encode(const led_strip_spi_pattern_t *pattern, const uint8_t *data, size_t len, uint8_t *buf);
+
+/**
+ * @brief Encode the same LED data byte repeatedly with a pattern, e.g. to clear a strip
+ *
+ * @param pattern: pattern built by `led_strip_spi_pattern_init`
+ * @param value: LED data byte
+ * @param len: number of LED data bytes
+ * @param buf: output buffer, receives `len * pattern->bits_per_bit` bytes
+ */
+void led_strip_spi_pattern_fill(const led_strip_spi_pattern_t *pattern, uint8_t value, size_t len, uint8_t *buf);
+
+/**
+ * @brief Decode LED data bytes from their SPI pattern
+ *
+ * @param pattern: pattern the bytes were encoded with
+ * @param buf: encoded bytes, `len * pattern->bits_per_bit` bytes
+ * @param len: number of LED data bytes
+ * @param data: output buffer, receives `len` LED data bytes
+ */
+void led_strip_spi_pattern_decode(const led_strip_spi_pattern_t *pattern, const uint8_t *buf, size_t len, uint8_t *data);
+
+/**
+ * @brief Encode LED data bytes into their 3-bit SPI pattern
+ *
+ * Runs of 4 bytes are encoded with 32-bit stores once `buf` is word aligned, so passing a word aligned
+ * buffer and a multiple of 4 bytes gives the fastest path. Any alignment and length is supported.
+ *
+ * @param data: LED data bytes, in the order they are sent
+ * @param len: number of LED data bytes
+ * @param buf: output buffer, receives `len * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE` bytes
+ */
+void led_strip_spi_encode(const uint8_t *data, size_t len, uint8_t *buf);
+
+/**
+ * @brief Encode the same LED data byte repeatedly into its 3-bit SPI pattern
+ *
+ * @param value: LED data byte
+ * @param len: number of LED data bytes
+ * @param buf: output buffer, receives `len * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE` bytes
+ */
+void led_strip_spi_encode_fill(uint8_t value, size_t len, uint8_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Table expanding LED data to RMT symbols, one 32-bit symbol per bit, MSB first
+ *
+ * The table is indexed by nibble, so it holds 16 x 4 symbols (256 bytes) and a byte expands with two lookups.
+ * Symbols are kept as raw 32-bit words, so the same table serves `rmt_symbol_word_t` (IDF 5) and `rmt_item32_t` (IDF 4).
+ */
+typedef struct {
+    uint32_t nibble[16][4];
+} led_strip_symbol_lut_t;
+
+/**
+ * @brief Fill the table from the symbols of a 0 bit and a 1 bit
+ */
+static inline void led_strip_symbol_lut_init(led_strip_symbol_lut_t *lut, uint32_t bit0, uint32_t bit1)
+{
+    for (int n = 0; n < 16; n++) {
+        for (int i = 0; i < 4; i++) {
+            lut->nibble[n][i] = n & (1 << (3 - i)) ? bit1 : bit0;
+        }
+    }
+}
+
+/**
+ * @brief Expand one byte to its 8 symbols
+ *
+ * @note Always inlined, so it ends up in IRAM together with an IRAM_ATTR caller
+ */
+__attribute__((always_inline))
+static inline void led_strip_symbol_lut_expand(const led_strip_symbol_lut_t *lut, uint8_t data, uint32_t *symbols)
+{
+    const uint32_t *hi = lut->nibble[data >> 4];
+    const uint32_t *lo = lut->nibble[data & 0x0F];
+    symbols[0] = hi[0];
+    symbols[1] = hi[1];
+    symbols[2] = hi[2];
+    symbols[3] = hi[3];
+    symbols[4] = lo[0];
+    symbols[5] = lo[1];
+    symbols[6] = lo[2];
+    symbols[7] = lo[3];
+}
+
+#ifdef __cplusplus
+}
+#endif
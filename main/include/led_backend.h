@@ -0,0 +1,25 @@
+#ifndef LED_BACKEND_H_
+#define LED_BACKEND_H_
+#include <stdint.h>
+#include "led_strip.h"
+
+/**
+ * @brief LED strip backends the application can drive a one-wire strip (WS2812, SK6812) with.
+ */
+typedef enum
+{
+    LED_BACKEND_RMT,            // RMT, the channel memory refilled from the RMT interrupt
+    LED_BACKEND_RMT_DMA,        // RMT with DMA (ESP32-S3)
+    LED_BACKEND_SPI_DMA,        // SPI with DMA, the whole strip encoded in DMA capable memory
+    LED_BACKEND_SPI_DMA_STREAM, // SPI with DMA, encoded on the fly into two small DMA buffers
+    LED_BACKEND_COUNT,
+} led_backend_t;
+
+led_backend_t led_backend_select(uint32_t ledCount, uint8_t bytesPerPixel,
+                                 led_model_t ledModel);                    // Select the backend for a strip length, pixel format and LED model
+const char *led_backend_name(led_backend_t backend);                        // Name of a backend, for logs
+esp_err_t led_backend_new_strip(led_backend_t backend, const led_strip_config_t *stripConfig,
+                                led_strip_handle_t *retStrip);              // Create an LED strip with a backend
+void led_backend_benchmark(const led_strip_config_t *stripConfig);         // Measure the backends, log a table row for each and keep their costs
+
+#endif /* LED_BACKEND_H_ */
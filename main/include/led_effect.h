@@ -0,0 +1,55 @@
+#ifndef LED_EFFECT_H_
+#define LED_EFFECT_H_
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_shader.h"
+
+struct ledState;
+
+/**
+ * @brief Effects rendered on the device, frame by frame, from a single effect command.
+ */
+typedef enum
+{
+    LED_EFFECT_NONE,     // No effect, the LEDs keep the last frame
+    LED_EFFECT_RAINBOW,  // Rainbow moving along the strip
+    LED_EFFECT_CHASE,    // Dot of the first color with a fading tail, running over the second color
+    LED_EFFECT_BREATHE,  // Whole strip fading from the second color to the first color and back
+    LED_EFFECT_TWINKLE,  // LEDs lighting up in the first color at random, fading back to the second color
+    LED_EFFECT_FIRE,     // Flames rising from the start of the strip
+    LED_EFFECT_GRADIENT, // Gradient from the first color to the second color and back, scrolling along the strip
+    LED_EFFECT_SHADER,   // Shader program run for each LED
+    LED_EFFECT_COUNT,
+} led_effect_type_t;
+
+// Parameters of an effect
+typedef struct
+{
+    led_effect_type_t type;
+    uint8_t colors[2][3]; // First and second color, red, green and blue
+    uint32_t period_ms;   // Duration of a cycle: the rainbow or gradient moving by its size, the chase running the strip,
+                          // a breath, the fading of a twinkle
+    uint16_t size;        // Length in LEDs of the rainbow, the gradient or the tail of the chase
+    uint8_t density;      // Chance per frame (/ 256) of each LED to twinkle, or of a new spark of the fire
+    uint8_t fps;          // Frame rate, 0 for CONFIG_LED_EFFECT_FPS
+    uint32_t seed;        // Seed of the random numbers of twinkle and fire, the same seed gives the same frames
+    led_shader_t *shader; // Program of the shader effect, owned by the effect once it is started
+} led_effect_params_t;
+
+// A running effect, with the state of the effects that depend on the previous frame
+typedef struct
+{
+    led_effect_params_t params;
+    int count;       // Number of LEDs
+    uint8_t *cells;  // Brightness of each LED for twinkle, heat of each LED for fire, NULL for the other effects
+    uint32_t random; // State of the random number generator
+    uint32_t lastMs; // Time of the previous frame
+} led_effect_t;
+
+const char *led_effect_name(led_effect_type_t type);                                        // Name of an effect, as in the effect command
+led_effect_type_t led_effect_from_name(const char *name);                                   // Effect of a name, LED_EFFECT_COUNT if unknown
+esp_err_t led_effect_init(led_effect_t *effect, const led_effect_params_t *params, int count); // Start an effect on count LEDs
+void led_effect_render(led_effect_t *effect, uint32_t timeMs, struct ledState *states);        // Render the frame of a time since the start
+void led_effect_deinit(led_effect_t *effect);                                                  // Free the state of an effect
+
+#endif /* LED_EFFECT_H_ */
@@ -0,0 +1,28 @@
+#ifndef LED_LAYER_H_
+#define LED_LAYER_H_
+#include <stdint.h>
+
+struct ledState;
+
+// Pixel of an overlay layer: red in the low byte, then green, blue and the coverage (alpha), 0 where the layer is transparent
+#define LED_LAYER_PIXEL(red, green, blue, alpha) \
+    ((uint32_t)(alpha) << 24 | (uint32_t)(blue) << 16 | (uint32_t)(green) << 8 | (uint32_t)(red))
+
+/**
+ * @brief Blend modes of an overlay layer over the layers below it.
+ */
+typedef enum
+{
+    LED_LAYER_BLEND_OVER,     // The layer covers the layers below
+    LED_LAYER_BLEND_ADD,      // The layer is added to the layers below, up to full level
+    LED_LAYER_BLEND_MULTIPLY, // The layers below are scaled by the layer, white leaves them unchanged
+    LED_LAYER_BLEND_MAX,      // Each channel takes the higher level of the layer and the layers below
+    LED_LAYER_BLEND_COUNT,
+} led_layer_blend_t;
+
+const char *led_layer_blend_name(led_layer_blend_t blend);       // Name of a blend mode, as in the layer command
+led_layer_blend_t led_layer_blend_from_name(const char *name); // Blend mode of a name, LED_LAYER_BLEND_COUNT if unknown
+void led_layer_blend(struct ledState *dst, const uint32_t *src, int count, uint8_t opacity,
+                     led_layer_blend_t blend); // Blend consecutive pixels of an overlay layer into a frame
+
+#endif /* LED_LAYER_H_ */
@@ -0,0 +1,42 @@
+#ifndef LED_LAYOUT_H_
+#define LED_LAYOUT_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define LED_LAYOUT_NONE 0xFFFF    // Cell of the layout without an LED
+#define LED_LAYOUT_MAX_CELLS 8192 // Largest width x height of a layout
+
+/**
+ * @brief Description of how the LED strip is laid out, either as a matrix wired row by row, or as a list of coordinates.
+ *
+ * The matrix is wired from its top left corner along the rows, before the rotation. The LEDs past the matrix or the
+ * list of coordinates keep their order after the LEDs laid out.
+ */
+typedef struct
+{
+    uint16_t width;              // Columns of the layout, as addressed by the commands
+    uint16_t height;             // Rows of the layout
+    bool serpentine;             // Every other row of the wiring runs backwards
+    bool mirror;                 // The rows of the wiring run from right to left
+    uint16_t rotation;           // Rotation of the wiring, in degrees clockwise: 0, 90, 180 or 270
+    const uint16_t *coordinates; // x and y of each LED in the order of the wiring in place of the matrix, NULL for a matrix
+    int coordinate_count;        // LEDs with coordinates
+} led_layout_desc_t;
+
+// A layout compiled to lookup tables, the LEDs are addressed in the order of the rows of the layout
+typedef struct
+{
+    uint16_t width;
+    uint16_t height;
+    int count;          // Number of LEDs
+    bool wiring_order;  // Every LED has its index on the LED strip, the LEDs need no remapping
+    uint16_t *physical; // Index on the LED strip of each LED
+    uint16_t *cells;    // LED at x + y * width, LED_LAYOUT_NONE where there is none
+} led_layout_t;
+
+esp_err_t led_layout_compile(const led_layout_desc_t *desc, int count, led_layout_t **layout); // Compile a layout for count LEDs
+int led_layout_index(const led_layout_t *layout, int x, int y);                               // LED at a position, -1 if none
+void led_layout_free(led_layout_t *layout);                                                   // Free a layout
+
+#endif /* LED_LAYOUT_H_ */
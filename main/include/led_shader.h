@@ -0,0 +1,62 @@
+#ifndef LED_SHADER_H_
+#define LED_SHADER_H_
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+struct ledState;
+
+#define LED_SHADER_MAX_LENGTH 512 // Longest program, in bytes
+#define LED_SHADER_STACK_SIZE 16  // Deepest stack of a program
+#define LED_SHADER_REGISTERS 8    // Registers of a program, 0 at the start of each LED
+
+/**
+ * @brief Instructions of a shader program.
+ *
+ * A program runs once per LED and frame on a stack of 16.16 fixed point numbers, and ends with the color of the LED.
+ * The instructions are one byte, followed by their operand if they have one (little endian). Jumps only go forward,
+ * so every LED runs at most as many instructions as the program has.
+ */
+typedef enum
+{
+    LED_SHADER_OP_PUSH,  // int16: push the operand / 256
+    LED_SHADER_OP_PUSHW, // int32: push the operand / 65536
+    LED_SHADER_OP_INDEX, // Push the LED number
+    LED_SHADER_OP_POS,   // Push the position of the LED along the strip, from 0 (first LED) to 1 (past the last LED)
+    LED_SHADER_OP_TIME,  // Push the time since the effect started, in seconds
+    LED_SHADER_OP_LOAD,  // uint8: push a register
+    LED_SHADER_OP_STORE, // uint8: pop into a register
+    LED_SHADER_OP_DUP,   // Push the top of the stack again
+    LED_SHADER_OP_DROP,  // Pop
+    LED_SHADER_OP_SWAP,  // Swap the two top values
+    LED_SHADER_OP_OVER,  // Push the value below the top
+    LED_SHADER_OP_ADD,   // Pop b, a: push a + b
+    LED_SHADER_OP_SUB,   // Pop b, a: push a - b
+    LED_SHADER_OP_MUL,   // Pop b, a: push a * b
+    LED_SHADER_OP_DIV,   // Pop b, a: push a / b, 0 if b is 0
+    LED_SHADER_OP_MOD,   // Pop b, a: push a modulo b with the sign of b, 0 if b is 0
+    LED_SHADER_OP_NEG,   // Pop a: push -a
+    LED_SHADER_OP_ABS,   // Pop a: push |a|
+    LED_SHADER_OP_FLOOR, // Pop a: push the integer part of a, rounded down
+    LED_SHADER_OP_FRACT, // Pop a: push a - floor(a)
+    LED_SHADER_OP_MIN,   // Pop b, a: push the lower of a and b
+    LED_SHADER_OP_MAX,   // Pop b, a: push the higher of a and b
+    LED_SHADER_OP_SIN,   // Pop a: push the sine of a turns (a full turn is 1)
+    LED_SHADER_OP_NOISE, // Pop a: push smooth noise from 0 to 1, changing over each unit of a
+    LED_SHADER_OP_LT,    // Pop b, a: push 1 if a < b, 0 otherwise
+    LED_SHADER_OP_JZ,    // uint8: pop a, skip the operand number of bytes after the instruction if a is 0
+    LED_SHADER_OP_JMP,   // uint8: skip the operand number of bytes after the instruction
+    LED_SHADER_OP_RGB,   // Pop blue, green, red (0 - 1): the color of the LED, ends the program
+    LED_SHADER_OP_HSV,   // Pop value, saturation (0 - 1), hue (turns): the color of the LED, ends the program
+    LED_SHADER_OP_COUNT,
+} led_shader_op_t;
+
+// A verified shader program, ready to run
+typedef struct led_shader led_shader_t;
+
+esp_err_t led_shader_load(const uint8_t *code, size_t length, uint32_t budget, led_shader_t **shader); // Verify and load a program
+uint32_t led_shader_cost(const led_shader_t *shader);                                                 // Most instructions run for one LED
+void led_shader_run(const led_shader_t *shader, uint32_t timeMs, int count, struct ledState *states); // Run the program for each LED
+void led_shader_free(led_shader_t *shader);                                                           // Free a program
+
+#endif /* LED_SHADER_H_ */
@@ -1,8 +1,7 @@
 
 #ifndef MAIN_INCLUDE_MQTT_HANDLER_H_
 #define MAIN_INCLUDE_MQTT_HANDLER_H_
-#include "led_strip.h"
 
-void mqtt_app_start(led_strip_handle_t strip);
+void mqtt_app_start(void);
 
 #endif /* MAIN_INCLUDE_MQTT_HANDLER_H_ */
@@ -0,0 +1,110 @@
+
+#ifndef MAIN_INCLUDE_RENDER_HANDLER_H_
+#define MAIN_INCLUDE_RENDER_HANDLER_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "led_strip.h"
+#include "led_effect.h"
+#include "led_layer.h"
+#include "led_layout.h"
+
+#ifdef CONFIG_LED_DITHER
+#define RENDER_DITHER_DEFAULT true // Temporal dithering is on until a color config turns it off
+#else
+#define RENDER_DITHER_DEFAULT false
+#endif
+
+// Color of a single LED
+struct ledState
+{
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+};
+
+// A single LED update of a frame
+typedef struct
+{
+    uint16_t index;
+    struct ledState color;
+    uint8_t alpha; // Coverage of the LED on an overlay layer, 0 makes it transparent again, ignored on the base layer
+} render_pixel_t;
+
+// A frame of the normal lane: the LED updates of one command
+typedef struct
+{
+    bool timed;             // The frame has a presentation timestamp, and is played out through the jitter buffer
+    int64_t pts_us;         // Presentation timestamp, on the clock of the sender
+    int64_t received_us;    // Time the frame was received, on the local clock
+    int64_t play_at_us;     // Local time the frame is latched at, set by the jitter buffer
+    uint32_t transition_ms; // Duration of the fade of the LEDs from their current color, 0 to set them at once
+    uint8_t layer;          // Layer the LEDs are drawn on, 0 for the base layer
+    uint32_t layout;        // Generation of the layout the LEDs are numbered in, set when the frame is allocated
+    uint32_t count;
+    render_pixel_t pixels[];
+} render_frame_t;
+
+// Commands of the priority lane
+typedef enum
+{
+    RENDER_PRIORITY_BLACKOUT,     // Turn all LEDs off
+    RENDER_PRIORITY_DIMMER,       // Set the master dimmer level
+    RENDER_PRIORITY_SCENE_STORE,  // Store the current frame in a scene slot
+    RENDER_PRIORITY_SCENE_RECALL, // Show the frame stored in a scene slot
+    RENDER_PRIORITY_COLOR_CONFIG, // Set the gamma, white balance and temporal dithering
+    RENDER_PRIORITY_EFFECT,       // Start an effect rendered on the device, or stop it
+    RENDER_PRIORITY_LAYER,        // Set the opacity and blend mode of an overlay layer, or clear it
+    RENDER_PRIORITY_LAYOUT,       // Set the layout the LEDs are addressed in
+} render_priority_type_t;
+
+typedef struct
+{
+    render_priority_type_t type;
+    uint8_t value;              // Dimmer level (0 - 255) or scene slot
+    float gamma;                // Gamma of the LEDs, for RENDER_PRIORITY_COLOR_CONFIG
+    uint8_t white_balance[4];   // Gain of red, green, blue and white (0 - 255), for RENDER_PRIORITY_COLOR_CONFIG
+    bool dither;                // Temporal dithering on, for RENDER_PRIORITY_COLOR_CONFIG
+    led_effect_params_t effect; // Effect to start, LED_EFFECT_NONE to stop it, for RENDER_PRIORITY_EFFECT
+    uint8_t layer;              // Layer of the effect, or overlay layer of RENDER_PRIORITY_LAYER
+    uint8_t opacity;            // Opacity of the layer, for RENDER_PRIORITY_LAYER
+    led_layer_blend_t blend;    // Blend mode of the layer, for RENDER_PRIORITY_LAYER
+    bool clear;                 // Make the whole layer transparent, for RENDER_PRIORITY_LAYER
+    led_layout_t *layout;       // Layout taken by the render task, NULL for the order of the wiring, for RENDER_PRIORITY_LAYOUT
+    uint32_t layout_generation; // Generation of the layout, set when the command is queued, for RENDER_PRIORITY_LAYOUT
+    int64_t received_us;        // Time the command was received, for the latency measurement
+} render_priority_cmd_t;
+
+// Render statistics
+typedef struct
+{
+    uint32_t frames_rendered;         // Frames of the normal lane rendered
+    uint32_t frames_dropped;          // Frames dropped because the normal lane was full
+    uint32_t frames_flushed;          // Pending frames flushed by a blackout or scene recall, or numbered in a previous layout
+    uint32_t refresh_skipped;         // Refreshes skipped because the frame did not change
+    uint32_t priority_commands;       // Commands of the priority lane executed
+    uint32_t priority_latency_max_us; // Longest time from reception to refresh of a priority command
+    uint32_t jitter_depth;            // Timed frames waiting in the jitter buffer
+    uint32_t jitter_underruns;        // Timed frames due while the jitter buffer was empty, the stream stalled
+    uint32_t jitter_late_drops;       // Timed frames dropped because they arrived after their playout time
+    uint32_t power_estimate_ma;       // Estimated current of the LED strip at the last refresh
+    uint8_t power_scale;              // Scale of the master dimmer applied by the power limiter (255 = not limited)
+    uint32_t effect_frames;           // Frames of the running effects rendered
+    uint32_t effect_render_max_us;    // Longest time to render a frame of an effect, before it is written to the LED strip
+    uint32_t stack_free;              // Least free stack of the render task so far, in bytes
+} render_stats_t;
+
+// Callback invoked by the render task once the queued commands have been rendered
+typedef void (*render_frame_cb_t)(void *arg);
+
+void render_start(led_strip_handle_t strip);                                // Start the render task
+void render_set_frame_callback(render_frame_cb_t cb, void *arg);            // Register the frame rendered callback
+render_frame_t *render_frame_alloc(uint32_t count);                         // Allocate a frame for the normal lane
+esp_err_t render_submit_frame(render_frame_t *frame);                       // Queue a frame on the normal lane, takes ownership
+esp_err_t render_submit_priority(const render_priority_cmd_t *cmd);         // Queue a command on the priority lane
+void render_read_led_states(int start, struct ledState *states, int count); // Read LEDs of the current frame
+uint32_t render_get_frame_hash(void);                                       // Get the rolling hash of the current frame
+void render_get_stats(render_stats_t *stats);                               // Get the render statistics
+
+#endif /* MAIN_INCLUDE_RENDER_HANDLER_H_ */
@@ -0,0 +1,389 @@
+/**
+ * @file led_backend.c
+ * @brief This file contains the selection of the LED strip backend from the strip length, and a benchmark of the backends.
+ */
+
+#include <stdio.h>    // Standard input/output functions
+#include <stdint.h>   // Standard integer types
+#include <stddef.h>   // Standard definitions
+#include <stdbool.h>  // Boolean type
+#include <stdlib.h>   // Memory allocation functions
+#include <inttypes.h> // Format macros of the standard integer types
+
+#include "esp_log.h"           // ESP32 logging functions
+#include "esp_err.h"           // ESP32 error codes
+#include "esp_heap_caps.h"     // Heap allocation by memory capabilities
+#include "esp_timer.h"         // High resolution timer
+#include "esp_idf_version.h"   // ESP-IDF version macros
+#include "freertos/FreeRTOS.h" // FreeRTOS functions
+#include "freertos/task.h"     // FreeRTOS task functions
+
+#include "led_strip.h"   // LED strip library
+#include "led_backend.h" // LED backend functions
+
+static const char *TAG = "LED_BACKEND";
+
+#define LED_BACKEND_DMA_RESERVE 32768          // DMA capable RAM left for Wi-Fi and lwIP, which allocate it after the LED strip
+#define LED_BACKEND_BIT_NS 1250                // Duration of an LED data bit (800 kHz)
+#define LED_BACKEND_ISR_NS 2000                // CPU time spent in and around an interrupt, estimated (see BackendCosts)
+#define LED_BACKEND_MIN_ISR_DEADLINE_US 200    // Interrupts can be held off this long by Wi-Fi and flash operations
+#define LED_BACKEND_MAX_SHORT_DEADLINE_ISRS 64 // Refill interrupts tolerated per refresh below LED_BACKEND_MIN_ISR_DEADLINE_US
+#define LED_BACKEND_RMT_DMA_MEM_SYMBOLS 1024   // RMT symbols of the DMA buffer, used by LED_BACKEND_RMT_DMA
+#define LED_BACKEND_BENCHMARK_REFRESHES 10     // Refreshes averaged by the benchmark
+#define LED_BACKEND_SPI_STREAM_BYTES 256       // LED data bytes per streaming buffer of LED_BACKEND_SPI_DMA_STREAM
+#define LED_BACKEND_SPI_STREAM_BUFFERS 2       // Streaming buffers of LED_BACKEND_SPI_DMA_STREAM
+#define LED_BACKEND_SPI_BITS_PER_BIT 3         // SPI bits per LED bit assumed if the SPI timing cannot be computed
+#define LED_BACKEND_IDLE_SAMPLE_MS 20          // Time the spin task is counted without a refresh, to calibrate it
+#define LED_BACKEND_SPIN_STACK_SIZE 1024       // Stack of the spin task of the benchmark
+
+// RMT channel memory of the led_strip RMT backend, refilled by half from the RMT interrupt
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define LED_BACKEND_RMT_MEM_SYMBOLS 64
+#else
+#define LED_BACKEND_RMT_MEM_SYMBOLS 48
+#endif
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0) && CONFIG_SOC_RMT_SUPPORT_DMA
+#define LED_BACKEND_HAS_RMT_DMA 1
+#else
+#define LED_BACKEND_HAS_RMT_DMA 0
+#endif
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0) && CONFIG_SOC_GPSPI_SUPPORTED
+#define LED_BACKEND_HAS_SPI 1
+#else
+#define LED_BACKEND_HAS_SPI 0
+#endif
+
+/**
+ * @brief Cost of a backend, per LED data byte (3 per LED for RGB, 4 for RGBW).
+ */
+typedef struct
+{
+    const char *name;
+    bool supported;
+    uint16_t encodeNsPerByte; // CPU time to encode one LED data byte
+    uint16_t bytesPerIsr;     // LED data bytes sent between two interrupts of a refresh, 0 for one interrupt per refresh
+    uint8_t dmaRamPerByte;    // DMA capable RAM per LED data byte
+    uint16_t dmaRamFixed;     // DMA capable RAM independent of the strip length
+    bool spiPattern;          // The DMA capable RAM holds SPI patterns, it is scaled by the SPI bits per LED bit
+    bool encodesOnSet;        // The pixels are encoded when they are set, the benchmark measures the encode time
+    uint32_t measuredLeds;    // Strip length the benchmark measured the backend with, 0 if it did not
+    uint32_t measuredDmaRam;  // DMA capable RAM the backend used in the benchmark
+    uint32_t measuredCpuUs;   // CPU time of a refresh in the benchmark (interrupts and encoding), plus the set time if encodesOnSet
+} led_backend_cost_t;
+
+/*
+ * Reference costs, used for a strip length the benchmark did not measure. Where each value comes from:
+ * - bytesPerIsr and the DMA capable RAM follow from the buffer sizes of the led_strip component, they are exact for
+ *   every target and ESP-IDF version: RMT refills half of its channel memory (LED_BACKEND_RMT_MEM_SYMBOLS, 8 symbols
+ *   per byte) per interrupt, or half of its DMA buffer; SPI-DMA sends the whole strip in one transaction, and
+ *   streaming SPI one 256 bytes chunk per transaction into two DMA buffers. The DMA capable RAM of SPI is given per
+ *   SPI bit per LED bit, from 3 to 8 depending on the SPI clock.
+ * - encodeNsPerByte is an estimate for an ESP32 core at 240 MHz, scaled from the host benchmarks of the encoders
+ *   (bench_spi_encoder, test/host), not a measurement on a target.
+ * - LED_BACKEND_ISR_NS is an estimate of the interrupt entry and exit and of the driver's handler, not a measurement.
+ * CONFIG_LED_BACKEND_BENCHMARK measures on the actual target the DMA capable RAM, the encode time of the backends
+ * encoding when the pixels are set, and the CPU time of a refresh, which replace the reference values for the
+ * measured strip length, and marks the backends that failed unsupported.
+ */
+static led_backend_cost_t BackendCosts[LED_BACKEND_COUNT] = {
+    [LED_BACKEND_RMT] = {
+        .name = "RMT",
+        .supported = true,
+        .encodeNsPerByte = 150,
+        .bytesPerIsr = LED_BACKEND_RMT_MEM_SYMBOLS / 2 / 8,
+    },
+    [LED_BACKEND_RMT_DMA] = {
+        .name = "RMT-DMA",
+        .supported = LED_BACKEND_HAS_RMT_DMA,
+        .encodeNsPerByte = 150,
+        .bytesPerIsr = LED_BACKEND_RMT_DMA_MEM_SYMBOLS / 2 / 8,
+        .dmaRamFixed = LED_BACKEND_RMT_DMA_MEM_SYMBOLS * 4,
+    },
+    [LED_BACKEND_SPI_DMA] = {
+        .name = "SPI-DMA",
+        .supported = LED_BACKEND_HAS_SPI,
+        .encodeNsPerByte = 60,
+        .bytesPerIsr = 0,
+        .dmaRamPerByte = 1,
+        .spiPattern = true,
+        .encodesOnSet = true,
+    },
+    [LED_BACKEND_SPI_DMA_STREAM] = {
+        .name = "SPI-DMA streaming",
+        .supported = LED_BACKEND_HAS_SPI,
+        .encodeNsPerByte = 60,
+        .bytesPerIsr = LED_BACKEND_SPI_STREAM_BYTES,
+        .dmaRamFixed = LED_BACKEND_SPI_STREAM_BUFFERS * LED_BACKEND_SPI_STREAM_BYTES,
+        .spiPattern = true,
+    },
+};
+
+/**
+ * @brief Returns the name of a backend.
+ *
+ * @param backend The backend.
+ * @return The name of the backend, for logs.
+ */
+const char *led_backend_name(led_backend_t backend)
+{
+    return backend < LED_BACKEND_COUNT ? BackendCosts[backend].name : "unknown";
+}
+
+/**
+ * @brief Selects the backend of a one-wire LED strip.
+ *
+ * The backends are tried from the one using the fewest peripherals and memory: RMT, RMT with DMA, SPI with DMA,
+ * then SPI with DMA streaming. A backend is rejected if its DMA buffers do not fit in the largest free DMA capable
+ * block (minus a reserve for Wi-Fi), or if a refresh needs too many interrupts with a short deadline, since a late one
+ * corrupts the frame. If every backend is rejected, the one fitting in memory with the lowest CPU time is used.
+ * The DMA capable RAM of SPI follows the SPI bits per LED bit the driver selects for the LED model, and the DMA
+ * capable RAM and CPU time measured by led_backend_benchmark for the same strip length replace the reference ones.
+ *
+ * @param ledCount The number of LEDs in the strip.
+ * @param bytesPerPixel The number of data bytes per LED (3 for RGB, 4 for RGBW).
+ * @param ledModel The LED model, which sets the SPI bits per LED bit.
+ * @return The selected backend.
+ */
+led_backend_t led_backend_select(uint32_t ledCount, uint8_t bytesPerPixel, led_model_t ledModel)
+{
+    uint32_t bytes = ledCount * bytesPerPixel;
+    size_t dmaFree = heap_caps_get_largest_free_block(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    led_backend_t fallback = LED_BACKEND_RMT;
+    uint32_t fallbackCpuUs = UINT32_MAX;
+
+    uint8_t spiBitsPerBit = LED_BACKEND_SPI_BITS_PER_BIT;
+#if LED_BACKEND_HAS_SPI
+    if (led_strip_spi_get_bits_per_bit(SPI_CLK_SRC_DEFAULT, ledModel, &spiBitsPerBit) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "No SPI timing for the LED model, assuming %d SPI bits per LED bit", LED_BACKEND_SPI_BITS_PER_BIT);
+        spiBitsPerBit = LED_BACKEND_SPI_BITS_PER_BIT;
+    }
+#endif
+
+    for (led_backend_t backend = 0; backend < LED_BACKEND_COUNT; backend++)
+    {
+        const led_backend_cost_t *cost = &BackendCosts[backend];
+        if (!cost->supported)
+        {
+            continue;
+        }
+        uint32_t dmaRam = cost->dmaRamFixed + bytes * cost->dmaRamPerByte;
+        if (cost->spiPattern)
+        {
+            dmaRam *= spiBitsPerBit;
+        }
+        if (cost->measuredLeds == ledCount)
+        {
+            dmaRam = cost->measuredDmaRam;
+        }
+        uint32_t isrs = cost->bytesPerIsr ? (bytes + cost->bytesPerIsr - 1) / cost->bytesPerIsr : 1;
+        uint32_t deadlineUs = cost->bytesPerIsr ? cost->bytesPerIsr * 8 * LED_BACKEND_BIT_NS / 1000 : UINT32_MAX;
+        uint32_t cpuUs = (bytes * cost->encodeNsPerByte + isrs * LED_BACKEND_ISR_NS) / 1000;
+        if (cost->measuredLeds == ledCount)
+        {
+            cpuUs = cost->measuredCpuUs;
+        }
+        ESP_LOGD(TAG, "%s: %" PRIu32 " bytes DMA RAM, %" PRIu32 " interrupts, %" PRIu32 " us CPU per refresh",
+                 cost->name, dmaRam, isrs, cpuUs);
+
+        if (dmaRam && dmaRam + LED_BACKEND_DMA_RESERVE > dmaFree)
+        {
+            ESP_LOGD(TAG, "%s: not enough DMA capable RAM (%u bytes free)", cost->name, (unsigned)dmaFree);
+            continue;
+        }
+        if (isrs <= LED_BACKEND_MAX_SHORT_DEADLINE_ISRS || deadlineUs >= LED_BACKEND_MIN_ISR_DEADLINE_US)
+        {
+            ESP_LOGI(TAG, "%s backend selected for %" PRIu32 " LEDs: %" PRIu32 " interrupts per refresh, %" PRIu32 " bytes DMA RAM",
+                     cost->name, ledCount, isrs, dmaRam);
+            return backend;
+        }
+        if (cpuUs < fallbackCpuUs)
+        {
+            fallback = backend;
+            fallbackCpuUs = cpuUs;
+        }
+    }
+    ESP_LOGW(TAG, "%s backend selected for %" PRIu32 " LEDs, no backend avoids frequent interrupts with short deadlines",
+             BackendCosts[fallback].name, ledCount);
+    return fallback;
+}
+
+/**
+ * @brief Creates a one-wire LED strip with a backend.
+ *
+ * @param backend The backend.
+ * @param stripConfig The LED strip configuration.
+ * @param retStrip Returned LED strip handle.
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED if the backend is not available on this target, or the error of the backend.
+ */
+esp_err_t led_backend_new_strip(led_backend_t backend, const led_strip_config_t *stripConfig, led_strip_handle_t *retStrip)
+{
+    switch (backend)
+    {
+    case LED_BACKEND_RMT:
+    case LED_BACKEND_RMT_DMA:
+    {
+        led_strip_rmt_config_t rmt_config = {
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
+            .rmt_channel = 0,
+#else
+            .clk_src = RMT_CLK_SRC_DEFAULT,         // different clock source can lead to different power consumption
+            .resolution_hz = CONFIG_LED_RMT_RES_HZ, // RMT counter clock frequency
+#endif
+        };
+#if LED_BACKEND_HAS_RMT_DMA
+        if (backend == LED_BACKEND_RMT_DMA)
+        {
+            rmt_config.mem_block_symbols = LED_BACKEND_RMT_DMA_MEM_SYMBOLS; // size of the DMA buffer
+            rmt_config.flags.with_dma = true;
+        }
+#else
+        if (backend == LED_BACKEND_RMT_DMA)
+        {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+#endif
+        return led_strip_new_rmt_device(stripConfig, &rmt_config, retStrip);
+    }
+#if LED_BACKEND_HAS_SPI
+    case LED_BACKEND_SPI_DMA:
+    case LED_BACKEND_SPI_DMA_STREAM:
+    {
+        led_strip_spi_config_t spi_config = {
+            .clk_src = SPI_CLK_SRC_DEFAULT,                           // different clock source can lead to different power consumption
+            .spi_bus = SPI2_HOST,                                     // SPI bus ID
+            .flags.with_dma = true,                                   // the strip is sent without CPU intervention
+            .flags.streaming = backend == LED_BACKEND_SPI_DMA_STREAM, // encode into two small DMA buffers
+        };
+        return led_strip_new_spi_device(stripConfig, &spi_config, retStrip);
+    }
+#endif
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+
+static volatile uint32_t spinCount; // Loops of the spin task of the benchmark
+
+// Function to count loops on the core of the benchmark, with the CPU time the other tasks and the interrupts leave
+static void led_backend_spin_task(void *arg)
+{
+    for (;;)
+    {
+        spinCount++;
+    }
+}
+
+// Function to get the spin task loops and the time, in us
+static void led_backend_spin_sample(uint32_t *spins, int64_t *timeUs)
+{
+    *spins = spinCount;
+    *timeUs = esp_timer_get_time();
+}
+
+/**
+ * @brief Measures each backend available on this target with the strip configuration, and logs a table row per backend.
+ *
+ * The strip is created, fully set and refreshed by each backend in turn, then deleted. The time to set the pixels is the
+ * encode time of the backends encoding ahead (SPI), the refresh time includes the encode time of the others (RMT).
+ * The CPU time of a refresh is measured with a spin task on the same core at the idle priority: it loops while the
+ * refresh waits for the peripheral, and loses the time of the interrupts and of the encoding in them. Its loop rate
+ * during the refreshes is compared to its rate while the benchmark sleeps.
+ * The measured DMA capable RAM, encode time and CPU time replace the reference costs of led_backend_select, and a
+ * backend that cannot be created or refreshed is not selected any more.
+ * Call it before the strip used by the application is created, as the backends share the peripherals.
+ *
+ * @param stripConfig The LED strip configuration.
+ */
+void led_backend_benchmark(const led_strip_config_t *stripConfig)
+{
+    uint32_t ledCount = stripConfig->max_leds;
+    bool rgbw = stripConfig->led_pixel_format == LED_PIXEL_FORMAT_GRBW || stripConfig->led_pixel_format == LED_PIXEL_FORMAT_RGBW;
+    uint8_t *pixels = malloc(ledCount * 3);
+    TaskHandle_t spinTask = NULL;
+    if (!pixels || xTaskCreatePinnedToCore(led_backend_spin_task, "led_spin", LED_BACKEND_SPIN_STACK_SIZE, NULL,
+                                           tskIDLE_PRIORITY, &spinTask, xPortGetCoreID()) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Benchmark skipped, out of memory");
+        free(pixels);
+        return;
+    }
+
+    // loops of the spin task per us without a refresh, sharing the core with the idle task as during the refreshes
+    uint32_t spinsBefore, spinsAfter;
+    int64_t timeBefore, timeAfter;
+    led_backend_spin_sample(&spinsBefore, &timeBefore);
+    vTaskDelay(pdMS_TO_TICKS(LED_BACKEND_IDLE_SAMPLE_MS));
+    led_backend_spin_sample(&spinsAfter, &timeAfter);
+    double idleSpinsPerUs = (double)(spinsAfter - spinsBefore) / (timeAfter - timeBefore);
+
+    for (uint32_t i = 0; i < ledCount * 3; i++)
+    {
+        pixels[i] = (uint8_t)(i * 37); // mix of zero and one bits
+    }
+
+    ESP_LOGI(TAG, "Benchmark of %" PRIu32 " LEDs:", ledCount);
+    ESP_LOGI(TAG, "%-18s %10s %12s %16s %14s", "backend", "set (us)", "refresh (us)", "refresh CPU (us)", "DMA RAM (B)");
+    for (led_backend_t backend = 0; backend < LED_BACKEND_COUNT; backend++)
+    {
+        if (!BackendCosts[backend].supported)
+        {
+            continue;
+        }
+        size_t dmaBefore = heap_caps_get_free_size(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        led_strip_handle_t strip;
+        esp_err_t err = led_backend_new_strip(backend, stripConfig, &strip);
+        if (err != ESP_OK)
+        {
+            ESP_LOGI(TAG, "%-18s %s", BackendCosts[backend].name, esp_err_to_name(err));
+            BackendCosts[backend].supported = false;
+            continue;
+        }
+        size_t dmaUsed = dmaBefore - heap_caps_get_free_size(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+
+        int64_t start = esp_timer_get_time();
+        err = led_strip_set_pixels(strip, 0, pixels, ledCount, LED_STRIP_SRC_FORMAT_RGB);
+        int64_t setUs = esp_timer_get_time() - start;
+
+        int64_t refreshUs = 0;
+        double refreshCpuUs = 0;
+        for (int i = 0; i < LED_BACKEND_BENCHMARK_REFRESHES && err == ESP_OK; i++)
+        {
+            // mark the whole strip dirty again, so each refresh sends every LED
+            led_strip_set_pixels(strip, 0, pixels, ledCount, LED_STRIP_SRC_FORMAT_RGB);
+            led_backend_spin_sample(&spinsBefore, &timeBefore);
+            err = led_strip_refresh(strip);
+            led_backend_spin_sample(&spinsAfter, &timeAfter);
+            refreshUs += timeAfter - timeBefore;
+            // the time the spin task could not loop is the CPU time of the refresh on this core
+            double lostUs = (timeAfter - timeBefore) - (spinsAfter - spinsBefore) / idleSpinsPerUs;
+            refreshCpuUs += lostUs > 0 ? lostUs : 0;
+        }
+        if (err == ESP_OK)
+        {
+            uint32_t cpuUs = refreshCpuUs / LED_BACKEND_BENCHMARK_REFRESHES;
+            ESP_LOGI(TAG, "%-18s %10" PRId64 " %12" PRId64 " %16" PRIu32 " %14u", BackendCosts[backend].name,
+                     setUs, refreshUs / LED_BACKEND_BENCHMARK_REFRESHES, cpuUs, (unsigned)dmaUsed);
+            BackendCosts[backend].measuredLeds = ledCount;
+            BackendCosts[backend].measuredDmaRam = dmaUsed;
+            BackendCosts[backend].measuredCpuUs = cpuUs;
+            if (BackendCosts[backend].encodesOnSet)
+            {
+                BackendCosts[backend].encodeNsPerByte = setUs * 1000 / (ledCount * (rgbw ? 4 : 3));
+                BackendCosts[backend].measuredCpuUs += setUs;
+            }
+        }
+        else
+        {
+            ESP_LOGI(TAG, "%-18s %s", BackendCosts[backend].name, esp_err_to_name(err));
+            BackendCosts[backend].supported = false;
+        }
+        led_strip_clear(strip);
+        led_strip_refresh(strip);
+        led_strip_del(strip);
+    }
+    vTaskDelete(spinTask);
+    free(pixels);
+}
@@ -0,0 +1,311 @@
+/**
+ * @file led_effect.c
+ * @brief This file contains the effects rendered on the device.
+ *
+ * Each effect renders a whole frame from the time since it started, in integer arithmetic. The effects that depend on
+ * the previous frame (twinkle, fire) keep one byte per LED and draw their random numbers from a generator seeded by the
+ * effect command, so a sequence of frame times always renders the same frames. The module has no dependency on the
+ * render task or the LED strip, only on the HSV conversion of the LED strip library, so the frames can be rendered on a host.
+ */
+
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Memory allocation functions
+#include <string.h>  // String manipulation functions
+
+#include "esp_err.h" // ESP32 error codes
+
+#include "led_strip.h"      // LED strip library, for the HSV conversion
+#include "render_handler.h" // LED state
+#include "led_effect.h"     // LED effect functions
+
+#define LED_EFFECT_CHUNK 32           // LEDs converted from HSV at once
+#define LED_EFFECT_PHASE_ONE 65536    // Phase of a full cycle, in 16.16 fixed point
+#define LED_EFFECT_FIRE_COOLING 55    // Cooling of the fire, higher values give shorter flames
+#define LED_EFFECT_FIRE_SPARK_LEDS 7  // Sparks of the fire start within this many LEDs from the start of the strip
+#define LED_EFFECT_DEFAULT_SEED 0x2545F491u
+
+static const char *const effectNames[LED_EFFECT_COUNT] = {
+    [LED_EFFECT_NONE] = "none",
+    [LED_EFFECT_RAINBOW] = "rainbow",
+    [LED_EFFECT_CHASE] = "chase",
+    [LED_EFFECT_BREATHE] = "breathe",
+    [LED_EFFECT_TWINKLE] = "twinkle",
+    [LED_EFFECT_FIRE] = "fire",
+    [LED_EFFECT_GRADIENT] = "gradient",
+    [LED_EFFECT_SHADER] = "shader",
+};
+
+// Function to get the next number of the xorshift random number generator of an effect
+static uint32_t led_effect_random(led_effect_t *effect)
+{
+    uint32_t x = effect->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    effect->random = x;
+    return x;
+}
+
+// Function to get a random number from 0 to range - 1
+static uint8_t led_effect_random8(led_effect_t *effect, uint32_t range)
+{
+    return ((led_effect_random(effect) >> 16) * range) >> 16;
+}
+
+// Function to get the phase of the effect cycle at a time, 0 to LED_EFFECT_PHASE_ONE - 1
+static uint32_t led_effect_phase(const led_effect_t *effect, uint32_t timeMs)
+{
+    return (uint32_t)((uint64_t)(timeMs % effect->params.period_ms) * LED_EFFECT_PHASE_ONE / effect->params.period_ms);
+}
+
+// Function to get a triangle wave of a phase, rising from 0 to 255 over the first half of the cycle and back
+static uint32_t led_effect_triangle(uint32_t phase)
+{
+    phase &= LED_EFFECT_PHASE_ONE - 1;
+    return (phase < LED_EFFECT_PHASE_ONE / 2 ? phase : LED_EFFECT_PHASE_ONE - 1 - phase) >> 7;
+}
+
+// Function to mix the two colors of an effect, weight 0 gives the second color, 256 the first
+static void led_effect_mix(const led_effect_t *effect, uint32_t weight, struct ledState *state)
+{
+    const uint8_t *first = effect->params.colors[0];
+    const uint8_t *second = effect->params.colors[1];
+    state->red = (first[0] * weight + second[0] * (256 - weight) + 128) >> 8;
+    state->green = (first[1] * weight + second[1] * (256 - weight) + 128) >> 8;
+    state->blue = (first[2] * weight + second[2] * (256 - weight) + 128) >> 8;
+}
+
+// Rainbow: the hue goes round once every size LEDs, and moves by size LEDs every period
+static void led_effect_rainbow(led_effect_t *effect, uint32_t timeMs, struct ledState *states)
+{
+    uint32_t phase = led_effect_phase(effect, timeMs);
+    uint32_t step = LED_EFFECT_PHASE_ONE / effect->params.size;
+    led_strip_hsv_t hsv[LED_EFFECT_CHUNK];
+    for (int start = 0; start < effect->count; start += LED_EFFECT_CHUNK)
+    {
+        int chunk = effect->count - start < LED_EFFECT_CHUNK ? effect->count - start : LED_EFFECT_CHUNK;
+        for (int i = 0; i < chunk; i++)
+        {
+            uint32_t hue = (phase + (uint32_t)(start + i) * step) & (LED_EFFECT_PHASE_ONE - 1);
+            hsv[i].hue = (hue * 360) >> 16;
+            hsv[i].saturation = 255;
+            hsv[i].value = 255;
+        }
+        led_strip_hsv_to_rgb(hsv, (uint8_t *)&states[start], chunk);
+    }
+}
+
+// Chase: the first color runs along the strip once every period, with a tail of size LEDs fading into the second color
+static void led_effect_chase(led_effect_t *effect, uint32_t timeMs, struct ledState *states)
+{
+    uint32_t head = (uint32_t)((uint64_t)(timeMs % effect->params.period_ms) * effect->count / effect->params.period_ms);
+    uint32_t size = effect->params.size;
+    for (int i = 0; i < effect->count; i++)
+    {
+        // Distance behind the head, the tail wraps around the end of the strip
+        uint32_t behind = head >= (uint32_t)i ? head - i : head + effect->count - i;
+        led_effect_mix(effect, behind < size ? ((size - behind) * 256 + size / 2) / size : 0, &states[i]);
+    }
+}
+
+// Breathe: the whole strip fades from the second color to the first and back once every period, easing at both ends
+static void led_effect_breathe(led_effect_t *effect, uint32_t timeMs, struct ledState *states)
+{
+    // Smoothstep of a triangle wave x / 32768, 3x^2 - 2x^3, as a weight of 0 - 256
+    uint64_t x = led_effect_phase(effect, timeMs);
+    x = x < LED_EFFECT_PHASE_ONE / 2 ? x : LED_EFFECT_PHASE_ONE - 1 - x;
+    uint32_t weight = (x * x * (3 * LED_EFFECT_PHASE_ONE / 2 - 2 * x) + (1ULL << 36)) >> 37;
+    led_effect_mix(effect, weight, &states[0]);
+    for (int i = 1; i < effect->count; i++)
+    {
+        states[i] = states[0];
+    }
+}
+
+// Twinkle: each LED lights up in the first color with a chance of density / 256 per frame, and fades back to the second
+// color over a period
+static void led_effect_twinkle(led_effect_t *effect, uint32_t timeMs, struct ledState *states)
+{
+    // The fading follows the time, whatever the frame rate
+    uint32_t fade = (uint32_t)((uint64_t)(timeMs - effect->lastMs) * 255 / effect->params.period_ms);
+    if (fade == 0 && timeMs != effect->lastMs)
+    {
+        fade = 1;
+    }
+    for (int i = 0; i < effect->count; i++)
+    {
+        uint32_t level = effect->cells[i] > fade ? effect->cells[i] - fade : 0;
+        if (led_effect_random8(effect, 256) < effect->params.density)
+        {
+            level = 255;
+        }
+        effect->cells[i] = level;
+        led_effect_mix(effect, level + (level >> 7), &states[i]);
+    }
+}
+
+// Fire: the heat of each LED cools down, rises along the strip and gets new sparks near the start, then maps to
+// black, red, yellow and white (Fire2012 by Mark Kriegsman)
+static void led_effect_fire(led_effect_t *effect, uint32_t timeMs, struct ledState *states)
+{
+    uint8_t *heat = effect->cells;
+    int count = effect->count;
+    uint32_t cooling = LED_EFFECT_FIRE_COOLING * 10 / count + 2;
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t cool = led_effect_random8(effect, cooling + 1);
+        heat[i] = heat[i] > cool ? heat[i] - cool : 0;
+    }
+    for (int i = count - 1; i >= 2; i--)
+    {
+        heat[i] = (heat[i - 1] + 2 * heat[i - 2]) / 3;
+    }
+    if (led_effect_random8(effect, 256) < effect->params.density)
+    {
+        int spark = led_effect_random8(effect, count < LED_EFFECT_FIRE_SPARK_LEDS ? count : LED_EFFECT_FIRE_SPARK_LEDS);
+        uint32_t level = heat[spark] + 160 + led_effect_random8(effect, 96);
+        heat[spark] = level > 255 ? 255 : level;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t t = heat[i] * 192 >> 8;  // 0 - 191, three ramps of 64 levels
+        uint8_t ramp = (t & 0x3F) << 2; // Position in the ramp, 0 - 252
+        states[i].red = t >= 64 ? 255 : ramp;
+        states[i].green = t >= 128 ? 255 : (t >= 64 ? ramp : 0);
+        states[i].blue = t >= 128 ? ramp : 0;
+    }
+}
+
+// Gradient: the first color blends into the second and back over size LEDs, and moves by size LEDs every period
+static void led_effect_gradient(led_effect_t *effect, uint32_t timeMs, struct ledState *states)
+{
+    uint32_t phase = led_effect_phase(effect, timeMs);
+    uint32_t step = LED_EFFECT_PHASE_ONE / effect->params.size;
+    for (int i = 0; i < effect->count; i++)
+    {
+        uint32_t x = led_effect_triangle(phase + (uint32_t)i * step);
+        led_effect_mix(effect, 256 - x - (x >> 7), &states[i]);
+    }
+}
+
+/**
+ * @brief Gets the name of an effect, as in the effect command.
+ *
+ * @param type The effect.
+ * @return The name, or NULL for an invalid effect.
+ */
+const char *led_effect_name(led_effect_type_t type)
+{
+    return type < LED_EFFECT_COUNT ? effectNames[type] : NULL;
+}
+
+/**
+ * @brief Gets the effect of a name.
+ *
+ * @param name The name of the effect, as in the effect command.
+ * @return The effect, or LED_EFFECT_COUNT if the name is unknown.
+ */
+led_effect_type_t led_effect_from_name(const char *name)
+{
+    led_effect_type_t type = 0;
+    while (type < LED_EFFECT_COUNT && strcmp(name, effectNames[type]) != 0)
+    {
+        type++;
+    }
+    return type;
+}
+
+/**
+ * @brief Starts an effect.
+ *
+ * A period of 0 is taken as 1 ms, a size of 0 as the number of LEDs. The effect takes the shader program of the
+ * parameters, even if it fails to start: free it with led_effect_deinit in any case.
+ *
+ * @param effect The effect to start.
+ * @param params The parameters of the effect.
+ * @param count The number of LEDs.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for an invalid effect, or ESP_ERR_NO_MEM.
+ */
+esp_err_t led_effect_init(led_effect_t *effect, const led_effect_params_t *params, int count)
+{
+    memset(effect, 0, sizeof(*effect));
+    effect->params = *params;
+    effect->count = count;
+    if (params->type >= LED_EFFECT_COUNT || count <= 0 || (params->type == LED_EFFECT_SHADER) != (params->shader != NULL))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (effect->params.period_ms == 0)
+    {
+        effect->params.period_ms = 1;
+    }
+    if (effect->params.size == 0)
+    {
+        effect->params.size = count;
+    }
+    effect->random = params->seed != 0 ? params->seed : LED_EFFECT_DEFAULT_SEED;
+    if (params->type == LED_EFFECT_TWINKLE || params->type == LED_EFFECT_FIRE)
+    {
+        effect->cells = calloc(count, sizeof(uint8_t));
+        if (effect->cells == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Renders a frame of an effect.
+ *
+ * @note Twinkle and fire continue from the previous frame, render their frames in the order of time.
+ *
+ * @param effect The effect.
+ * @param timeMs The time since the start of the effect.
+ * @param[out] states The color of each LED.
+ */
+void led_effect_render(led_effect_t *effect, uint32_t timeMs, struct ledState *states)
+{
+    switch (effect->params.type)
+    {
+    case LED_EFFECT_RAINBOW:
+        led_effect_rainbow(effect, timeMs, states);
+        break;
+    case LED_EFFECT_CHASE:
+        led_effect_chase(effect, timeMs, states);
+        break;
+    case LED_EFFECT_BREATHE:
+        led_effect_breathe(effect, timeMs, states);
+        break;
+    case LED_EFFECT_TWINKLE:
+        led_effect_twinkle(effect, timeMs, states);
+        break;
+    case LED_EFFECT_FIRE:
+        led_effect_fire(effect, timeMs, states);
+        break;
+    case LED_EFFECT_GRADIENT:
+        led_effect_gradient(effect, timeMs, states);
+        break;
+    case LED_EFFECT_SHADER:
+        led_shader_run(effect->params.shader, timeMs, effect->count, states);
+        break;
+    default:
+        break;
+    }
+    effect->lastMs = timeMs;
+}
+
+/**
+ * @brief Frees the state of an effect.
+ *
+ * @param effect The effect.
+ */
+void led_effect_deinit(led_effect_t *effect)
+{
+    free(effect->cells);
+    effect->cells = NULL;
+    led_shader_free(effect->params.shader);
+    effect->params.shader = NULL;
+    effect->params.type = LED_EFFECT_NONE;
+}
@@ -17,7 +17,8 @@
 #include "esp_log.h" // ESP32 logging functions
 #include "esp_err.h" // ESP32 error codes
 
-#include "led_strip.h" // LED strip library
+#include "led_strip.h"   // LED strip library
+#include "led_backend.h" // LED backend selection
 
 static const char *TAG = "LED_HANDLER";
 
@@ -25,6 +26,44 @@ static const char *TAG = "LED_HANDLER";
 #define CONFIG_LED_MODEL_TYPE LED_MODEL_WS2812
 #elif CONFIG_LED_MODEL_SK6812
 #define CONFIG_LED_MODEL_TYPE LED_MODEL_SK6812
+#elif CONFIG_LED_MODEL_APA102
+#define CONFIG_LED_MODEL_TYPE LED_MODEL_APA102
+#elif CONFIG_LED_MODEL_SK9822
+#define CONFIG_LED_MODEL_TYPE LED_MODEL_SK9822
+#elif CONFIG_LED_MODEL_HD108
+#define CONFIG_LED_MODEL_TYPE LED_MODEL_HD108
+#endif
+
+#ifdef CONFIG_LED_PIXEL_FORMAT_GRB
+#define CONFIG_LED_PIXEL_FORMAT_TYPE LED_PIXEL_FORMAT_GRB
+#elif CONFIG_LED_PIXEL_FORMAT_RGB
+#define CONFIG_LED_PIXEL_FORMAT_TYPE LED_PIXEL_FORMAT_RGB
+#elif CONFIG_LED_PIXEL_FORMAT_BGR
+#define CONFIG_LED_PIXEL_FORMAT_TYPE LED_PIXEL_FORMAT_BGR
+#elif CONFIG_LED_PIXEL_FORMAT_GRBW
+#define CONFIG_LED_PIXEL_FORMAT_TYPE LED_PIXEL_FORMAT_GRBW
+#elif CONFIG_LED_PIXEL_FORMAT_RGBW
+#define CONFIG_LED_PIXEL_FORMAT_TYPE LED_PIXEL_FORMAT_RGBW
+#endif
+
+#ifdef CONFIG_LED_BACKEND_RMT
+#define CONFIG_LED_BACKEND_TYPE LED_BACKEND_RMT
+#elif CONFIG_LED_BACKEND_RMT_DMA
+#define CONFIG_LED_BACKEND_TYPE LED_BACKEND_RMT_DMA
+#elif CONFIG_LED_BACKEND_SPI_DMA
+#define CONFIG_LED_BACKEND_TYPE LED_BACKEND_SPI_DMA
+#elif CONFIG_LED_BACKEND_SPI_DMA_STREAM
+#define CONFIG_LED_BACKEND_TYPE LED_BACKEND_SPI_DMA_STREAM
+#endif
+
+#ifdef CONFIG_LED_WHITE_EXTRACTION_CALIBRATED
+#define LED_WHITE_RGB {CONFIG_LED_WHITE_RED, CONFIG_LED_WHITE_GREEN, CONFIG_LED_WHITE_BLUE}
+#elif CONFIG_LED_WHITE_EXTRACTION_MIN
+#define LED_WHITE_RGB {255, 255, 255} // the white LED matches full red, green and blue
+#endif
+
+#ifdef LED_WHITE_RGB
+static led_strip_white_lut_t whiteLut; // White extraction table, kept by reference by the LED strip
 #endif
 
 /**
@@ -38,27 +77,53 @@ led_strip_handle_t configure_led(void)
 {
     // LED strip general initialization, according to your led board design
     led_strip_config_t strip_config = {
-        .strip_gpio_num = CONFIG_LED_GPIO,        // The GPIO that connected to the LED strip's data line
-        .max_leds = CONFIG_LED_COUNT,             // The number of LEDs in the strip,
-        .led_pixel_format = LED_PIXEL_FORMAT_GRB, // Pixel format of your LED strip
-        .led_model = CONFIG_LED_MODEL_TYPE,       // LED strip model
-        .flags.invert_out = false,                // whether to invert the output signal
+        .strip_gpio_num = CONFIG_LED_GPIO,                // The GPIO that connected to the LED strip's data line
+        .max_leds = CONFIG_LED_COUNT,                     // The number of LEDs in the strip,
+        .led_pixel_format = CONFIG_LED_PIXEL_FORMAT_TYPE, // Pixel format of your LED strip
+        .led_model = CONFIG_LED_MODEL_TYPE,               // LED strip model
+        .flags.invert_out = false,                        // whether to invert the output signal
     };
 
-    // LED strip backend configuration: RMT
-    led_strip_rmt_config_t rmt_config = {
-#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
-        .rmt_channel = 0,
+    // LED Strip object handle
+    led_strip_handle_t led_strip;
+
+#ifdef CONFIG_LED_MODEL_CLOCKED
+    // LED strip backend configuration: SPI, with the clock line
+    led_strip_spi_config_t spi_config = {
+        .clk_src = SPI_CLK_SRC_DEFAULT,      // different clock source can lead to different power consumption
+        .spi_bus = SPI2_HOST,                // SPI bus ID
+        .clk_gpio_num = CONFIG_LED_CLK_GPIO, // The GPIO that connected to the LED strip's clock line
+        .clock_hz = CONFIG_LED_CLOCK_HZ,     // 0 uses the default clock of the LED model
+        .flags.with_dma = true,              // the whole strip is sent in one transaction
+    };
+    ESP_ERROR_CHECK(led_strip_new_spi_device(&strip_config, &spi_config, &led_strip));
+    ESP_LOGI(TAG, "Created LED strip object with SPI backend");
 #else
-        .clk_src = RMT_CLK_SRC_DEFAULT,         // different clock source can lead to different power consumption
-        .resolution_hz = CONFIG_LED_RMT_RES_HZ, // RMT counter clock frequency
-        .flags.with_dma = false,                // DMA feature is available on ESP target like ESP32-S3
+#ifdef CONFIG_LED_BACKEND_BENCHMARK
+    led_backend_benchmark(&strip_config);
 #endif
-    };
 
-    // LED Strip object handle
-    led_strip_handle_t led_strip;
-    ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip));
-    ESP_LOGI(TAG, "Created LED strip object with RMT backend");
+    // LED strip backend: RMT, RMT with DMA or SPI with DMA, from the strip length and the free DMA capable memory
+#ifdef CONFIG_LED_BACKEND_AUTO
+    bool rgbw = CONFIG_LED_PIXEL_FORMAT_TYPE == LED_PIXEL_FORMAT_GRBW || CONFIG_LED_PIXEL_FORMAT_TYPE == LED_PIXEL_FORMAT_RGBW;
+    led_backend_t backend = led_backend_select(CONFIG_LED_COUNT, rgbw ? 4 : 3, strip_config.led_model);
+#else
+    led_backend_t backend = CONFIG_LED_BACKEND_TYPE;
+#endif
+
+    ESP_ERROR_CHECK(led_backend_new_strip(backend, &strip_config, &led_strip));
+    ESP_LOGI(TAG, "Created LED strip object with %s backend", led_backend_name(backend));
+#endif
+
+#ifdef LED_WHITE_RGB
+    // the white is extracted when the pixels are encoded, the application keeps setting RGB colors
+    const uint8_t whiteRgb[3] = LED_WHITE_RGB;
+    ESP_ERROR_CHECK(led_strip_white_lut_init(&whiteLut, whiteRgb));
+    esp_err_t err = led_strip_set_white_lut(led_strip, &whiteLut);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "White extraction not applied: %s", esp_err_to_name(err));
+    }
+#endif
     return led_strip;
 }
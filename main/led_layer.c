@@ -0,0 +1,169 @@
+/**
+ * @file led_layer.c
+ * @brief This file contains the blend kernels of the overlay layers.
+ *
+ * A pixel is handled as two 32-bit words of two 8-bit channels each, in 16-bit lanes: red and blue in one word,
+ * green and alpha in the other. A multiplication by a weight from 0 to 256 then scales both channels of a word at once,
+ * as the product of a channel fits in its lane, and additions and comparisons work on both lanes without carrying into
+ * the other. The module has no dependency on the render task or the LED strip, so the kernels can be run on a host.
+ */
+
+#include <stdint.h> // Standard integer types
+#include <string.h> // String manipulation functions
+
+#include "render_handler.h" // LED state
+#include "led_layer.h"      // LED layer functions
+
+#define LED_LAYER_LANES 0x00FF00FFu     // Channels of a word, one in each 16-bit lane
+#define LED_LAYER_LANE_HALF 0x00800080u // Half a step in each lane, for rounding
+#define LED_LAYER_LANE_CARRY 0x01000100u
+#define LED_LAYER_OPAQUE 0x01000000u // Pixels below this have no coverage
+
+static const char *const blendNames[LED_LAYER_BLEND_COUNT] = {
+    [LED_LAYER_BLEND_OVER] = "over",
+    [LED_LAYER_BLEND_ADD] = "add",
+    [LED_LAYER_BLEND_MULTIPLY] = "multiply",
+    [LED_LAYER_BLEND_MAX] = "max",
+};
+
+// Function to mix the channels of two words, weight 0 gives x, 256 gives y
+static inline uint32_t led_layer_lerp(uint32_t x, uint32_t y, uint32_t weight)
+{
+    return ((x * (256 - weight) + y * weight + LED_LAYER_LANE_HALF) >> 8) & LED_LAYER_LANES;
+}
+
+// Function to scale the channels of a word by a weight from 0 to 256
+static inline uint32_t led_layer_scale(uint32_t x, uint32_t weight)
+{
+    return ((x * weight + LED_LAYER_LANE_HALF) >> 8) & LED_LAYER_LANES;
+}
+
+// Function to add the channels of two words, each sum saturating at 255
+static inline uint32_t led_layer_add(uint32_t x, uint32_t y)
+{
+    uint32_t sum = x + y;
+    uint32_t carry = sum & LED_LAYER_LANE_CARRY;
+    return (sum | (carry - (carry >> 8))) & LED_LAYER_LANES;
+}
+
+// Function to get the higher of the channels of two words
+static inline uint32_t led_layer_max(uint32_t x, uint32_t y)
+{
+    // The lane keeps its borrow bit when y is at least x, spread to a mask of the lane
+    uint32_t mask = ((((y | LED_LAYER_LANE_CARRY) - x) >> 8) & 0x00010001u) * 0xFF;
+    return (y & mask) | (x & ~mask);
+}
+
+// Function to multiply the channels of two words, 255 leaves a channel unchanged. The two lanes need their own
+// multiplications, as each is scaled by a different channel.
+static inline uint32_t led_layer_multiply(uint32_t x, uint32_t y)
+{
+    uint32_t low = (x & 0xFF) * (y & 0xFF) + 128;
+    uint32_t high = (x >> 16) * (y >> 16) + 128;
+    return ((low + (low >> 8)) >> 8) | ((high + (high >> 8)) >> 8) << 16;
+}
+
+// Function to blend a word of the layer into a word of the frame with the weight of the pixel
+static inline uint32_t led_layer_blend_word(uint32_t dst, uint32_t src, uint32_t weight, led_layer_blend_t blend)
+{
+    switch (blend)
+    {
+    case LED_LAYER_BLEND_ADD:
+        return led_layer_add(dst, led_layer_scale(src, weight));
+    case LED_LAYER_BLEND_MULTIPLY:
+        return led_layer_lerp(dst, led_layer_multiply(dst, src), weight);
+    case LED_LAYER_BLEND_MAX:
+        return led_layer_max(dst, led_layer_scale(src, weight));
+    default:
+        return led_layer_lerp(dst, src, weight);
+    }
+}
+
+// Function to blend consecutive pixels with one blend mode, inlined with a constant mode so each mode gets its own loop
+static inline __attribute__((always_inline)) void led_layer_blend_span(struct ledState *dst, const uint32_t *src, int count,
+                                                                      uint32_t opacityScale, led_layer_blend_t blend)
+{
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t pixel = src[i];
+        if (pixel < LED_LAYER_OPAQUE)
+        {
+            // Transparent, the frame is left as it is
+            continue;
+        }
+        uint32_t weight = ((pixel >> 24) * opacityScale + 0x8000) >> 16;
+        if (blend == LED_LAYER_BLEND_OVER && weight == 256)
+        {
+            dst[i].red = pixel;
+            dst[i].green = pixel >> 8;
+            dst[i].blue = pixel >> 16;
+            continue;
+        }
+        uint32_t redBlue = dst[i].red | (uint32_t)dst[i].blue << 16;
+        uint32_t green = dst[i].green;
+        redBlue = led_layer_blend_word(redBlue, pixel & LED_LAYER_LANES, weight, blend);
+        green = led_layer_blend_word(green, (pixel >> 8) & LED_LAYER_LANES, weight, blend);
+        dst[i].red = redBlue;
+        dst[i].green = green;
+        dst[i].blue = redBlue >> 16;
+    }
+}
+
+/**
+ * @brief Gets the name of a blend mode, as in the layer command.
+ *
+ * @param blend The blend mode.
+ * @return The name, or NULL for an invalid blend mode.
+ */
+const char *led_layer_blend_name(led_layer_blend_t blend)
+{
+    return blend < LED_LAYER_BLEND_COUNT ? blendNames[blend] : NULL;
+}
+
+/**
+ * @brief Gets the blend mode of a name.
+ *
+ * @param name The name of the blend mode, as in the layer command.
+ * @return The blend mode, or LED_LAYER_BLEND_COUNT if the name is unknown.
+ */
+led_layer_blend_t led_layer_blend_from_name(const char *name)
+{
+    led_layer_blend_t blend = 0;
+    while (blend < LED_LAYER_BLEND_COUNT && strcmp(name, blendNames[blend]) != 0)
+    {
+        blend++;
+    }
+    return blend;
+}
+
+/**
+ * @brief Blends consecutive pixels of an overlay layer into a frame.
+ *
+ * Each pixel is weighted by its coverage and the opacity of the layer. Transparent pixels are skipped.
+ *
+ * @param[in,out] dst The colors of the layers below, replaced by the blended colors.
+ * @param src The pixels of the layer, as LED_LAYER_PIXEL.
+ * @param count The number of pixels.
+ * @param opacity The opacity of the layer, 0 leaves the frame unchanged.
+ * @param blend The blend mode of the layer.
+ */
+void led_layer_blend(struct ledState *dst, const uint32_t *src, int count, uint8_t opacity, led_layer_blend_t blend)
+{
+    // Weight of a pixel from 0 to 256 is its coverage times this scale, in 16.16 fixed point
+    uint32_t opacityScale = ((uint32_t)opacity * (256u << 16) + 65025 / 2) / 65025;
+    switch (blend)
+    {
+    case LED_LAYER_BLEND_ADD:
+        led_layer_blend_span(dst, src, count, opacityScale, LED_LAYER_BLEND_ADD);
+        break;
+    case LED_LAYER_BLEND_MULTIPLY:
+        led_layer_blend_span(dst, src, count, opacityScale, LED_LAYER_BLEND_MULTIPLY);
+        break;
+    case LED_LAYER_BLEND_MAX:
+        led_layer_blend_span(dst, src, count, opacityScale, LED_LAYER_BLEND_MAX);
+        break;
+    default:
+        led_layer_blend_span(dst, src, count, opacityScale, LED_LAYER_BLEND_OVER);
+        break;
+    }
+}
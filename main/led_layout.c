@@ -0,0 +1,173 @@
+/**
+ * @file led_layout.c
+ * @brief This file contains the layouts of the LED strip, compiled to lookup tables when they are loaded.
+ *
+ * The commands address the LEDs in the order of the rows of the layout, from its top left corner, whatever the wiring.
+ * Compiling a layout places each LED of the wiring in its cell, then numbers the cells with an LED row by row. The
+ * table of the index on the LED strip of each LED then remaps a frame with one lookup per LED, and the table of the LED
+ * in each cell gives the LED at a position. The module has no dependency on the render task or the LED strip, so the
+ * layouts can be compiled on a host.
+ */
+
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Memory allocation functions
+#include <string.h>  // String manipulation functions
+
+#include "esp_err.h" // ESP32 error codes
+
+#include "led_layout.h" // LED layout functions
+
+// Function to place the LEDs of a matrix in their cells, in the order of the wiring. Returns the number of LEDs placed.
+static int led_layout_place_matrix(const led_layout_desc_t *desc, int count, uint16_t *cells)
+{
+    bool turned = desc->rotation == 90 || desc->rotation == 270;
+    int wiringWidth = turned ? desc->height : desc->width; // Size of the matrix before the rotation
+    int wiringHeight = turned ? desc->width : desc->height;
+    int placed = wiringWidth * wiringHeight < count ? wiringWidth * wiringHeight : count;
+    for (int i = 0; i < placed; i++)
+    {
+        int u = i % wiringWidth;
+        int v = i / wiringWidth;
+        if (desc->serpentine && (v & 1))
+        {
+            u = wiringWidth - 1 - u;
+        }
+        if (desc->mirror)
+        {
+            u = wiringWidth - 1 - u;
+        }
+        int x = u;
+        int y = v;
+        switch (desc->rotation)
+        {
+        case 90:
+            x = wiringHeight - 1 - v;
+            y = u;
+            break;
+        case 180:
+            x = wiringWidth - 1 - u;
+            y = wiringHeight - 1 - v;
+            break;
+        case 270:
+            x = v;
+            y = wiringWidth - 1 - u;
+            break;
+        }
+        cells[x + y * desc->width] = i;
+    }
+    return placed;
+}
+
+// Function to place the LEDs of a list of coordinates in their cells. Returns the number of LEDs placed, or -1 if a
+// coordinate is out of the layout or taken by another LED.
+static int led_layout_place_coordinates(const led_layout_desc_t *desc, uint16_t *cells)
+{
+    for (int i = 0; i < desc->coordinate_count; i++)
+    {
+        uint16_t x = desc->coordinates[i * 2];
+        uint16_t y = desc->coordinates[i * 2 + 1];
+        if (x >= desc->width || y >= desc->height || cells[x + y * desc->width] != LED_LAYOUT_NONE)
+        {
+            return -1;
+        }
+        cells[x + y * desc->width] = i;
+    }
+    return desc->coordinate_count;
+}
+
+/**
+ * @brief Compiles a layout to the lookup tables of its LEDs.
+ *
+ * @param desc The description of the layout.
+ * @param count The number of LEDs of the LED strip.
+ * @param[out] layout The compiled layout, free it with led_layout_free.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for an invalid layout, ESP_ERR_INVALID_SIZE for a layout of more than
+ *         LED_LAYOUT_MAX_CELLS cells or more coordinates than LEDs, or ESP_ERR_NO_MEM.
+ */
+esp_err_t led_layout_compile(const led_layout_desc_t *desc, int count, led_layout_t **layout)
+{
+    *layout = NULL;
+    if (count <= 0 || count >= LED_LAYOUT_NONE || desc->width == 0 || desc->height == 0 ||
+        (desc->rotation != 0 && desc->rotation != 90 && desc->rotation != 180 && desc->rotation != 270) ||
+        (desc->coordinates == NULL && desc->coordinate_count > 0))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t cellCount = (uint32_t)desc->width * desc->height;
+    if (cellCount > LED_LAYOUT_MAX_CELLS || desc->coordinate_count > count)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // The tables follow the layout in the same allocation
+    led_layout_t *compiled = malloc(sizeof(led_layout_t) + (count + cellCount) * sizeof(uint16_t));
+    if (compiled == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    compiled->width = desc->width;
+    compiled->height = desc->height;
+    compiled->count = count;
+    compiled->physical = (uint16_t *)(compiled + 1);
+    compiled->cells = compiled->physical + count;
+    memset(compiled->cells, 0xFF, cellCount * sizeof(uint16_t));
+
+    // The cells hold the LED of the wiring first, then they are numbered in the order of the rows
+    int placed = desc->coordinates != NULL ? led_layout_place_coordinates(desc, compiled->cells)
+                                           : led_layout_place_matrix(desc, count, compiled->cells);
+    if (placed < 0)
+    {
+        free(compiled);
+        return ESP_ERR_INVALID_ARG;
+    }
+    int index = 0;
+    for (uint32_t cell = 0; cell < cellCount; cell++)
+    {
+        if (compiled->cells[cell] != LED_LAYOUT_NONE)
+        {
+            compiled->physical[index] = compiled->cells[cell];
+            compiled->cells[cell] = index++;
+        }
+    }
+    for (int i = placed; i < count; i++)
+    {
+        compiled->physical[index++] = i;
+    }
+
+    compiled->wiring_order = true;
+    for (int i = 0; i < count && compiled->wiring_order; i++)
+    {
+        compiled->wiring_order = compiled->physical[i] == i;
+    }
+    *layout = compiled;
+    return ESP_OK;
+}
+
+/**
+ * @brief Gets the LED at a position of a layout.
+ *
+ * @param layout The layout.
+ * @param x The column, from the left.
+ * @param y The row, from the top.
+ * @return The index of the LED, or -1 if the position is out of the layout or has no LED.
+ */
+int led_layout_index(const led_layout_t *layout, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= layout->width || y >= layout->height)
+    {
+        return -1;
+    }
+    uint16_t index = layout->cells[x + y * layout->width];
+    return index != LED_LAYOUT_NONE ? index : -1;
+}
+
+/**
+ * @brief Frees a layout.
+ *
+ * @param layout The layout, or NULL.
+ */
+void led_layout_free(led_layout_t *layout)
+{
+    free(layout);
+}
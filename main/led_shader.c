@@ -0,0 +1,521 @@
+/**
+ * @file led_shader.c
+ * @brief This file contains the shader programs, effects defined by the controller as bytecode.
+ *
+ * A program is verified once when it is loaded: every instruction must be known, every jump must go forward to an
+ * instruction, the stack depth must be the same on all paths to an instruction and stay within the stack, and every
+ * path must end with a color. The longest path gives the most instructions run for one LED, which must be within
+ * the instruction budget. The program is then decoded to fixed size instructions with their operands converted,
+ * which the interpreter runs without any check, dispatching from each instruction straight to the next one.
+ * The module has no dependency on the render task or the LED strip, only on the HSV conversion of the LED strip
+ * library, so the programs can be run on a host.
+ */
+
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Memory allocation functions
+#include <string.h>  // String manipulation functions
+#include <math.h>    // Math functions
+
+#include "esp_err.h" // ESP32 error codes
+
+#include "led_strip.h"      // LED strip library, for the HSV conversion
+#include "render_handler.h" // LED state
+#include "led_shader.h"     // LED shader functions
+
+#define LED_SHADER_ONE 65536     // 1 in 16.16 fixed point
+#define LED_SHADER_SIN_STEPS 256 // Steps of the sine table over a turn
+#define LED_SHADER_NOISE_SEED 0x9E3779B1u
+
+// A decoded instruction
+typedef struct
+{
+    uint8_t op;  // Instruction, led_shader_op_t
+    int32_t arg; // Operand: the constant in 16.16, the register, or the instruction a jump goes to
+} led_shader_ins_t;
+
+struct led_shader
+{
+    uint32_t cost;           // Most instructions run for one LED
+    uint32_t length;         // Number of instructions
+    led_shader_ins_t code[]; // Instructions
+};
+
+// Operand size and stack effect of an instruction
+typedef struct
+{
+    uint8_t operand; // Bytes of the operand
+    uint8_t pops;    // Values popped from the stack
+    uint8_t pushes;  // Values pushed on the stack
+} led_shader_info_t;
+
+static const led_shader_info_t opInfo[LED_SHADER_OP_COUNT] = {
+    [LED_SHADER_OP_PUSH] = {2, 0, 1},
+    [LED_SHADER_OP_PUSHW] = {4, 0, 1},
+    [LED_SHADER_OP_INDEX] = {0, 0, 1},
+    [LED_SHADER_OP_POS] = {0, 0, 1},
+    [LED_SHADER_OP_TIME] = {0, 0, 1},
+    [LED_SHADER_OP_LOAD] = {1, 0, 1},
+    [LED_SHADER_OP_STORE] = {1, 1, 0},
+    [LED_SHADER_OP_DUP] = {0, 1, 2},
+    [LED_SHADER_OP_DROP] = {0, 1, 0},
+    [LED_SHADER_OP_SWAP] = {0, 2, 2},
+    [LED_SHADER_OP_OVER] = {0, 2, 3},
+    [LED_SHADER_OP_ADD] = {0, 2, 1},
+    [LED_SHADER_OP_SUB] = {0, 2, 1},
+    [LED_SHADER_OP_MUL] = {0, 2, 1},
+    [LED_SHADER_OP_DIV] = {0, 2, 1},
+    [LED_SHADER_OP_MOD] = {0, 2, 1},
+    [LED_SHADER_OP_NEG] = {0, 1, 1},
+    [LED_SHADER_OP_ABS] = {0, 1, 1},
+    [LED_SHADER_OP_FLOOR] = {0, 1, 1},
+    [LED_SHADER_OP_FRACT] = {0, 1, 1},
+    [LED_SHADER_OP_MIN] = {0, 2, 1},
+    [LED_SHADER_OP_MAX] = {0, 2, 1},
+    [LED_SHADER_OP_SIN] = {0, 1, 1},
+    [LED_SHADER_OP_NOISE] = {0, 1, 1},
+    [LED_SHADER_OP_LT] = {0, 2, 1},
+    [LED_SHADER_OP_JZ] = {1, 1, 0},
+    [LED_SHADER_OP_JMP] = {1, 0, 0},
+    [LED_SHADER_OP_RGB] = {0, 3, 0},
+    [LED_SHADER_OP_HSV] = {0, 3, 0},
+};
+
+static int32_t sinTable[LED_SHADER_SIN_STEPS + 1]; // Sine over a turn in 16.16, with the first step repeated at the end
+static bool sinTableReady;
+
+// Function to check if an instruction ends the program
+static inline bool led_shader_is_end(uint8_t op)
+{
+    return op == LED_SHADER_OP_RGB || op == LED_SHADER_OP_HSV;
+}
+
+// Function to get the sine of a number of turns, interpolated from the sine table
+static inline int32_t led_shader_sin(int32_t turns)
+{
+    uint32_t phase = (uint32_t)turns & (LED_SHADER_ONE - 1);
+    uint32_t step = phase >> 8;
+    int32_t fraction = phase & 0xFF;
+    return sinTable[step] + (((sinTable[step + 1] - sinTable[step]) * fraction) >> 8);
+}
+
+// Function to hash an integer to a value from 0 to 1
+static inline int32_t led_shader_hash(int32_t x)
+{
+    uint32_t h = (uint32_t)x * LED_SHADER_NOISE_SEED;
+    h ^= h >> 15;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    return h >> 16;
+}
+
+// Function to get smooth value noise: random values at the integers, eased in between
+static inline int32_t led_shader_noise(int32_t x)
+{
+    int32_t cell = x >> 16;
+    int64_t fraction = x & (LED_SHADER_ONE - 1);
+    int64_t ease = (fraction * fraction >> 16) * (3 * LED_SHADER_ONE - 2 * fraction) >> 16;
+    int32_t a = led_shader_hash(cell);
+    int32_t b = led_shader_hash(cell + 1);
+    return a + (int32_t)(((int64_t)(b - a) * ease) >> 16);
+}
+
+// Function to get a color channel from a level from 0 to 1
+static inline uint8_t led_shader_channel(int32_t level)
+{
+    if (level <= 0)
+    {
+        return 0;
+    }
+    if (level >= LED_SHADER_ONE)
+    {
+        return 255;
+    }
+    return (level * 255 + LED_SHADER_ONE / 2) >> 16;
+}
+
+/**
+ * @brief Verifies and loads a shader program.
+ *
+ * @param code The bytecode of the program, as described by led_shader_op_t.
+ * @param length The length of the bytecode, up to LED_SHADER_MAX_LENGTH.
+ * @param budget The most instructions a single LED may run.
+ * @param[out] shader The loaded program, free it with led_shader_free.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for an invalid program, ESP_ERR_INVALID_SIZE if it is too long or over
+ *         the budget, or ESP_ERR_NO_MEM.
+ */
+esp_err_t led_shader_load(const uint8_t *code, size_t length, uint32_t budget, led_shader_t **shader)
+{
+    *shader = NULL;
+    if (length == 0 || length > LED_SHADER_MAX_LENGTH)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Decode the instructions, and the instruction starting at each byte (-1 within an operand)
+    led_shader_t *program = calloc(1, sizeof(led_shader_t) + length * sizeof(led_shader_ins_t));
+    int16_t *start = malloc((length + 1) * sizeof(int16_t));
+    int8_t *depth = malloc(length * sizeof(int8_t));
+    uint16_t *cost = malloc(length * sizeof(uint16_t));
+    if (program == NULL || start == NULL || depth == NULL || cost == NULL)
+    {
+        free(program);
+        free(start);
+        free(depth);
+        free(cost);
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = ESP_OK;
+    for (size_t i = 0; i <= length; i++)
+    {
+        start[i] = -1;
+    }
+    for (size_t offset = 0; offset < length && err == ESP_OK;)
+    {
+        uint8_t op = code[offset];
+        if (op >= LED_SHADER_OP_COUNT || offset + 1 + opInfo[op].operand > length)
+        {
+            err = ESP_ERR_INVALID_ARG;
+            break;
+        }
+        const uint8_t *operand = &code[offset + 1];
+        led_shader_ins_t *ins = &program->code[program->length];
+        start[offset] = program->length++;
+        ins->op = op;
+        switch (opInfo[op].operand)
+        {
+        case 1:
+            ins->arg = operand[0];
+            break;
+        case 2:
+            ins->arg = (int32_t)(int16_t)(operand[0] | operand[1] << 8) * 256;
+            break;
+        case 4:
+            ins->arg = (int32_t)((uint32_t)operand[0] | (uint32_t)operand[1] << 8 | (uint32_t)operand[2] << 16 | (uint32_t)operand[3] << 24);
+            break;
+        }
+        offset += 1 + opInfo[op].operand;
+        if ((op == LED_SHADER_OP_LOAD || op == LED_SHADER_OP_STORE) && ins->arg >= LED_SHADER_REGISTERS)
+        {
+            err = ESP_ERR_INVALID_ARG;
+        }
+        if (op == LED_SHADER_OP_JZ || op == LED_SHADER_OP_JMP)
+        {
+            // Resolved to the target instruction once all instructions are decoded, the target byte is kept for now
+            ins->arg += offset;
+        }
+    }
+    for (uint32_t i = 0; i < program->length && err == ESP_OK; i++)
+    {
+        led_shader_ins_t *ins = &program->code[i];
+        if (ins->op == LED_SHADER_OP_JZ || ins->op == LED_SHADER_OP_JMP)
+        {
+            if (ins->arg >= length || start[ins->arg] < 0)
+            {
+                // Past the end or into an operand
+                err = ESP_ERR_INVALID_ARG;
+                break;
+            }
+            ins->arg = start[ins->arg];
+        }
+    }
+
+    // Follow the stack depth along the program, each instruction is only reached from the ones before it
+    for (uint32_t i = 0; i < program->length && err == ESP_OK; i++)
+    {
+        depth[i] = i == 0 ? 0 : -1;
+    }
+    for (uint32_t i = 0; i < program->length && err == ESP_OK; i++)
+    {
+        const led_shader_ins_t *ins = &program->code[i];
+        if (depth[i] < 0)
+        {
+            // Unreachable
+            continue;
+        }
+        int after = depth[i] - opInfo[ins->op].pops + opInfo[ins->op].pushes;
+        if (depth[i] < opInfo[ins->op].pops || after > LED_SHADER_STACK_SIZE)
+        {
+            err = ESP_ERR_INVALID_ARG;
+            break;
+        }
+        uint32_t next[2];
+        int nextCount = 0;
+        if (ins->op == LED_SHADER_OP_JZ || ins->op == LED_SHADER_OP_JMP)
+        {
+            next[nextCount++] = ins->arg;
+        }
+        if (ins->op != LED_SHADER_OP_JMP && !led_shader_is_end(ins->op))
+        {
+            next[nextCount++] = i + 1;
+        }
+        for (int n = 0; n < nextCount && err == ESP_OK; n++)
+        {
+            if (next[n] >= program->length || (depth[next[n]] >= 0 && depth[next[n]] != after))
+            {
+                // Runs past the end without a color, or reaches an instruction with another stack depth
+                err = ESP_ERR_INVALID_ARG;
+                break;
+            }
+            depth[next[n]] = after;
+        }
+    }
+
+    // The most instructions run for one LED, along the longest path. Only the reachable instructions are followed,
+    // an unreachable one may run past the end
+    for (int32_t i = (int32_t)program->length - 1; i >= 0 && err == ESP_OK; i--)
+    {
+        const led_shader_ins_t *ins = &program->code[i];
+        uint32_t longest = 0;
+        if (depth[i] < 0)
+        {
+            cost[i] = 0;
+            continue;
+        }
+        if (ins->op == LED_SHADER_OP_JZ || ins->op == LED_SHADER_OP_JMP)
+        {
+            longest = cost[ins->arg];
+        }
+        if (ins->op != LED_SHADER_OP_JMP && !led_shader_is_end(ins->op) && cost[i + 1] > longest)
+        {
+            longest = cost[i + 1];
+        }
+        cost[i] = 1 + longest;
+    }
+    if (err == ESP_OK)
+    {
+        program->cost = cost[0];
+        err = program->cost <= budget ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    }
+    free(start);
+    free(depth);
+    free(cost);
+    if (err != ESP_OK)
+    {
+        free(program);
+        return err;
+    }
+
+    if (!sinTableReady)
+    {
+        for (int i = 0; i <= LED_SHADER_SIN_STEPS; i++)
+        {
+            sinTable[i] = (int32_t)lroundf(sinf(2.0f * (float)M_PI * i / LED_SHADER_SIN_STEPS) * LED_SHADER_ONE);
+        }
+        sinTable[LED_SHADER_SIN_STEPS] = sinTable[0];
+        sinTableReady = true;
+    }
+    *shader = program;
+    return ESP_OK;
+}
+
+/**
+ * @brief Gets the most instructions a shader program runs for one LED.
+ *
+ * @param shader The program.
+ * @return The number of instructions along the longest path of the program.
+ */
+uint32_t led_shader_cost(const led_shader_t *shader)
+{
+    return shader->cost;
+}
+
+/**
+ * @brief Runs a shader program for each LED.
+ *
+ * Each instruction jumps to the code of the next one through a table of label addresses (threaded dispatch),
+ * without going back to a central switch. The program was verified when it was loaded, so the interpreter
+ * checks neither the stack nor the jumps.
+ *
+ * @param shader The program.
+ * @param timeMs The time since the start of the effect.
+ * @param count The number of LEDs.
+ * @param[out] states The color of each LED.
+ */
+void led_shader_run(const led_shader_t *shader, uint32_t timeMs, int count, struct ledState *states)
+{
+    static const void *const handlers[LED_SHADER_OP_COUNT] = {
+        [LED_SHADER_OP_PUSH] = &&op_push,
+        [LED_SHADER_OP_PUSHW] = &&op_push,
+        [LED_SHADER_OP_INDEX] = &&op_index,
+        [LED_SHADER_OP_POS] = &&op_pos,
+        [LED_SHADER_OP_TIME] = &&op_time,
+        [LED_SHADER_OP_LOAD] = &&op_load,
+        [LED_SHADER_OP_STORE] = &&op_store,
+        [LED_SHADER_OP_DUP] = &&op_dup,
+        [LED_SHADER_OP_DROP] = &&op_drop,
+        [LED_SHADER_OP_SWAP] = &&op_swap,
+        [LED_SHADER_OP_OVER] = &&op_over,
+        [LED_SHADER_OP_ADD] = &&op_add,
+        [LED_SHADER_OP_SUB] = &&op_sub,
+        [LED_SHADER_OP_MUL] = &&op_mul,
+        [LED_SHADER_OP_DIV] = &&op_div,
+        [LED_SHADER_OP_MOD] = &&op_mod,
+        [LED_SHADER_OP_NEG] = &&op_neg,
+        [LED_SHADER_OP_ABS] = &&op_abs,
+        [LED_SHADER_OP_FLOOR] = &&op_floor,
+        [LED_SHADER_OP_FRACT] = &&op_fract,
+        [LED_SHADER_OP_MIN] = &&op_min,
+        [LED_SHADER_OP_MAX] = &&op_max,
+        [LED_SHADER_OP_SIN] = &&op_sin,
+        [LED_SHADER_OP_NOISE] = &&op_noise,
+        [LED_SHADER_OP_LT] = &&op_lt,
+        [LED_SHADER_OP_JZ] = &&op_jz,
+        [LED_SHADER_OP_JMP] = &&op_jmp,
+        [LED_SHADER_OP_RGB] = &&op_rgb,
+        [LED_SHADER_OP_HSV] = &&op_hsv,
+    };
+#define LED_SHADER_NEXT()           \
+    do                              \
+    {                               \
+        ins++;                      \
+        goto *handlers[ins->op];    \
+    } while (0)
+#define LED_SHADER_JUMP()                  \
+    do                                     \
+    {                                      \
+        ins = &shader->code[ins->arg];     \
+        goto *handlers[ins->op];           \
+    } while (0)
+
+    const int32_t time = (int32_t)((uint64_t)timeMs * LED_SHADER_ONE / 1000);
+    int32_t stack[LED_SHADER_STACK_SIZE];
+    int32_t registers[LED_SHADER_REGISTERS];
+    for (int i = 0; i < count; i++)
+    {
+        int32_t *sp = stack; // Next free slot, sp[-1] is the top of the stack
+        const led_shader_ins_t *ins = shader->code;
+        memset(registers, 0, sizeof(registers));
+        goto *handlers[ins->op];
+
+    op_push:
+        *sp++ = ins->arg;
+        LED_SHADER_NEXT();
+    op_index:
+        *sp++ = i * LED_SHADER_ONE;
+        LED_SHADER_NEXT();
+    op_pos:
+        *sp++ = (int32_t)((int64_t)i * LED_SHADER_ONE / count);
+        LED_SHADER_NEXT();
+    op_time:
+        *sp++ = time;
+        LED_SHADER_NEXT();
+    op_load:
+        *sp++ = registers[ins->arg];
+        LED_SHADER_NEXT();
+    op_store:
+        registers[ins->arg] = *--sp;
+        LED_SHADER_NEXT();
+    op_dup:
+        sp[0] = sp[-1];
+        sp++;
+        LED_SHADER_NEXT();
+    op_drop:
+        sp--;
+        LED_SHADER_NEXT();
+    op_swap:
+    {
+        int32_t top = sp[-1];
+        sp[-1] = sp[-2];
+        sp[-2] = top;
+        LED_SHADER_NEXT();
+    }
+    op_over:
+        sp[0] = sp[-2];
+        sp++;
+        LED_SHADER_NEXT();
+    op_add:
+        sp--;
+        sp[-1] = (int32_t)((uint32_t)sp[-1] + (uint32_t)sp[0]);
+        LED_SHADER_NEXT();
+    op_sub:
+        sp--;
+        sp[-1] = (int32_t)((uint32_t)sp[-1] - (uint32_t)sp[0]);
+        LED_SHADER_NEXT();
+    op_mul:
+        sp--;
+        sp[-1] = (int32_t)(((int64_t)sp[-1] * sp[0]) >> 16);
+        LED_SHADER_NEXT();
+    op_div:
+        sp--;
+        sp[-1] = sp[0] != 0 ? (int32_t)((int64_t)sp[-1] * LED_SHADER_ONE / sp[0]) : 0;
+        LED_SHADER_NEXT();
+    op_mod:
+    {
+        sp--;
+        int64_t divisor = sp[0];
+        int64_t remainder = divisor != 0 ? sp[-1] % divisor : 0;
+        if (remainder != 0 && (remainder < 0) != (divisor < 0))
+        {
+            remainder += divisor;
+        }
+        sp[-1] = (int32_t)remainder;
+        LED_SHADER_NEXT();
+    }
+    op_neg:
+        sp[-1] = (int32_t)(0u - (uint32_t)sp[-1]);
+        LED_SHADER_NEXT();
+    op_abs:
+        sp[-1] = sp[-1] < 0 ? (int32_t)(0u - (uint32_t)sp[-1]) : sp[-1];
+        LED_SHADER_NEXT();
+    op_floor:
+        sp[-1] &= ~(LED_SHADER_ONE - 1);
+        LED_SHADER_NEXT();
+    op_fract:
+        sp[-1] &= LED_SHADER_ONE - 1;
+        LED_SHADER_NEXT();
+    op_min:
+        sp--;
+        sp[-1] = sp[0] < sp[-1] ? sp[0] : sp[-1];
+        LED_SHADER_NEXT();
+    op_max:
+        sp--;
+        sp[-1] = sp[0] > sp[-1] ? sp[0] : sp[-1];
+        LED_SHADER_NEXT();
+    op_sin:
+        sp[-1] = led_shader_sin(sp[-1]);
+        LED_SHADER_NEXT();
+    op_noise:
+        sp[-1] = led_shader_noise(sp[-1]);
+        LED_SHADER_NEXT();
+    op_lt:
+        sp--;
+        sp[-1] = sp[-1] < sp[0] ? LED_SHADER_ONE : 0;
+        LED_SHADER_NEXT();
+    op_jz:
+        if (*--sp == 0)
+        {
+            LED_SHADER_JUMP();
+        }
+        LED_SHADER_NEXT();
+    op_jmp:
+        LED_SHADER_JUMP();
+    op_rgb:
+        states[i].red = led_shader_channel(sp[-3]);
+        states[i].green = led_shader_channel(sp[-2]);
+        states[i].blue = led_shader_channel(sp[-1]);
+        continue;
+    op_hsv:
+    {
+        led_strip_hsv_t hsv = {
+            .hue = (((uint32_t)sp[-3] & (LED_SHADER_ONE - 1)) * 360) >> 16,
+            .saturation = led_shader_channel(sp[-2]),
+            .value = led_shader_channel(sp[-1]),
+        };
+        led_strip_hsv_to_rgb(&hsv, (uint8_t *)&states[i], 1);
+        continue;
+    }
+    }
+#undef LED_SHADER_NEXT
+#undef LED_SHADER_JUMP
+}
+
+/**
+ * @brief Frees a shader program.
+ *
+ * @param shader The program, or NULL.
+ */
+void led_shader_free(led_shader_t *shader)
+{
+    free(shader);
+}
@@ -25,10 +25,11 @@
 #include "esp_log.h" // ESP32 logging functions
 #include "esp_err.h" // ESP32 error codes
 
-#include "led_strip.h"    // LED strip functions
-#include "mqtt_handler.h" // MQTT handler functions
-#include "wifi_handler.h" // Wi-Fi handler functions
-#include "led_handler.h"  // LED handler functions
+#include "led_strip.h"      // LED strip functions
+#include "mqtt_handler.h"   // MQTT handler functions
+#include "wifi_handler.h"   // Wi-Fi handler functions
+#include "led_handler.h"    // LED handler functions
+#include "render_handler.h" // Render handler functions
 
 static const char *TAG = "MAIN";
 
@@ -63,6 +64,8 @@ void app_main(void)
     esp_log_level_set("MQTT_HANDLER", ESP_LOG_INFO);
     esp_log_level_set("WIFI_HANDLER", ESP_LOG_INFO);
     esp_log_level_set("LED_HANDLER", ESP_LOG_INFO);
+    esp_log_level_set("LED_BACKEND", ESP_LOG_INFO);
+    esp_log_level_set("RENDER_HANDLER", ESP_LOG_INFO);
 
     // Initialize NVS
     ESP_ERROR_CHECK(nvs_flash_init());
@@ -81,6 +84,9 @@ void app_main(void)
     // Initialize Wi-Fi in station mode
     wifi_init_sta();
 
+    // Start the render task, which owns the LED strip from now on
+    render_start(led_strip);
+
     // Start MQTT application
-    mqtt_app_start(led_strip);
+    mqtt_app_start();
 }
@@ -29,12 +29,13 @@
 #include "lwip/err.h"     // lwIP error codes
 #include "lwip/sys.h"     // lwIP system functions
 
-#include "esp_log.h" // ESP32 logging library
-#include "esp_err.h" // ESP32 error codes
-#include "cJSON.h"   // cJSON library for JSON manipulation
+#include "esp_log.h"   // ESP32 logging library
+#include "esp_err.h"   // ESP32 error codes
+#include "esp_timer.h" // ESP32 high resolution timer
+#include "cJSON.h"     // cJSON library for JSON manipulation
 
-#include "mqtt_client.h" // MQTT client library
-#include "led_strip.h"   // LED strip library
+#include "mqtt_client.h"    // MQTT client library
+#include "render_handler.h" // Render handler functions
 
 // MQTT topics
 #define MQTT_TOPIC_MAIN CONFIG_MQTT_TOPIC_MAIN
@@ -43,18 +44,70 @@
 #define MQTT_TOPIC_BRODCAST_COMMAND MQTT_TOPIC_MAIN "/" CONFIG_MQTT_TOPIC_COMMAND
 #define MQTT_TOPIC_STATE MQTT_DEVICE_ID "/" CONFIG_MQTT_TOPIC_STATE
 #define MQTT_TOPIC_COMMAND MQTT_DEVICE_ID "/" CONFIG_MQTT_TOPIC_COMMAND
+#define MQTT_TOPIC_BRODCAST_PRIORITY MQTT_TOPIC_MAIN "/" CONFIG_MQTT_TOPIC_PRIORITY
+#define MQTT_TOPIC_PRIORITY MQTT_DEVICE_ID "/" CONFIG_MQTT_TOPIC_PRIORITY
+#define MQTT_TOPIC_BRODCAST_CONFIG MQTT_TOPIC_MAIN "/" CONFIG_MQTT_TOPIC_CONFIG
+#define MQTT_TOPIC_CONFIG MQTT_DEVICE_ID "/" CONFIG_MQTT_TOPIC_CONFIG
+#define MQTT_TOPIC_STATS MQTT_DEVICE_ID "/stats"
+
+// LED model published to the type topic
+#ifdef CONFIG_LED_MODEL_WS2812
+#define MQTT_LED_TYPE "WS2812"
+#elif CONFIG_LED_MODEL_SK6812
+#define MQTT_LED_TYPE "SK6812"
+#elif CONFIG_LED_MODEL_APA102
+#define MQTT_LED_TYPE "APA102"
+#elif CONFIG_LED_MODEL_SK9822
+#define MQTT_LED_TYPE "SK9822"
+#elif CONFIG_LED_MODEL_HD108
+#define MQTT_LED_TYPE "HD108"
+#endif
+
+#define MQTT_STATE_CHUNK 32 // LED states read from the render module at once when publishing the state
+#define MQTT_HSV_CHUNK 32   // HSV colors converted to RGB at once
+
+#define MQTT_TRANSITION_MAX_MS 300000 // Longest fade of an LED command, within 65535 steps at the highest transition frame rate
+
+#define MQTT_EFFECT_PERIOD_MS 2000     // Cycle of an effect command without "period-ms"
+#define MQTT_EFFECT_PERIOD_MAX_MS 3600000
+#define MQTT_EFFECT_DENSITY 64         // Twinkle and spark chance of an effect command without "density"
+#define MQTT_EFFECT_FPS_MAX 200
+
+#define MQTT_GAMMA_MIN 0.1
+#define MQTT_GAMMA_MAX 5.0
 
 static const char *TAG = "MQTT_HANDLER"; // Tag for logging
 
-led_strip_handle_t led_strip; // Handle for the LED strip
+static bool statePublished;     // The LED state was published at least once
+static uint32_t publishedHash;  // Hash of the frame last published to the state topic
+static uint32_t publishSkipped; // Number of state publishes skipped because the frame did not change
+
+// Color config, merged with each config message as they may only carry some of the settings
+static render_priority_cmd_t colorConfig = {
+    .type = RENDER_PRIORITY_COLOR_CONFIG,
+    .gamma = 1.0f,
+    .white_balance = {255, 255, 255, 255},
+    .dither = RENDER_DITHER_DEFAULT,
+};
+
+// Settings of each overlay layer, merged with each layer command as they may only carry some of the settings
+static render_priority_cmd_t layerConfigs[CONFIG_LED_LAYER_COUNT];
+
+// Layout the positions of the LED commands are looked up in, NULL while the LEDs are addressed in the order of the wiring.
+// The render task has its own copy, compiled from the same config message.
+static led_layout_t *layout;
+
+// Function to check if the topic of a received message is the given topic
+static bool mqtt_topic_is(esp_mqtt_event_handle_t event, const char *topic)
+{
+    return event->topic_len == strlen(topic) && strncmp(event->topic, topic, event->topic_len) == 0;
+}
 
-// Structure to store the state of each LED
-struct ledState
+// Function to check if the device ID of a command addresses this device
+static bool mqtt_device_id_matches(const cJSON *deviceId)
 {
-    uint8_t red;
-    uint8_t green;
-    uint8_t blue;
-} ledStates[CONFIG_LED_COUNT];
+    return cJSON_IsString(deviceId) && (strcmp(deviceId->valuestring, CONFIG_MQTT_DEVICE_ID) == 0 || strcmp(deviceId->valuestring, "all") == 0);
+}
 
 // Function to log an error if the error code is non-zero
 static void log_error_if_nonzero(const char *message, int error_code)
@@ -69,7 +122,8 @@ static void log_error_if_nonzero(const char *message, int error_code)
  * @brief Publishes the LED state to the MQTT broker.
  *
  * This function creates a JSON object representing the LED state and publishes it to the
- * MQTT state topic. The LED state is obtained from the global variable 'ledStates'.
+ * MQTT state topic. The LED state is read back from the LED strip through the render module, so it is only called
+ * from the render task, through the frame callback.
  *
  * @param client The MQTT client handle.
  *
@@ -101,6 +155,17 @@ static void log_error_if_nonzero(const char *message, int error_code)
  */
 void mqtt_publish_led_state(esp_mqtt_client_handle_t client)
 {
+    uint32_t frameHash = render_get_frame_hash();
+
+    // Skip the publish if the frame did not change since the last one
+    if (statePublished && frameHash == publishedHash)
+    {
+        publishSkipped++;
+        ESP_LOGD(TAG, "LED state unchanged, publish skipped");
+        return;
+    }
+    statePublished = true;
+    publishedHash = frameHash;
 
     // Create a JSON object to represent the LED state
     cJSON *stateJson = cJSON_CreateObject();
@@ -112,16 +177,24 @@ void mqtt_publish_led_state(esp_mqtt_client_handle_t client)
     // Populate the JSON object with LED state data
     if (stateJson != NULL)
     {
+        // The LED states are read back from the LED strip a few at a time
+        struct ledState ledStates[MQTT_STATE_CHUNK];
         for (int i = 0; i < CONFIG_LED_COUNT; i++)
         {
+            if (i % MQTT_STATE_CHUNK == 0)
+            {
+                int count = CONFIG_LED_COUNT - i < MQTT_STATE_CHUNK ? CONFIG_LED_COUNT - i : MQTT_STATE_CHUNK;
+                render_read_led_states(i, ledStates, count);
+            }
+            const struct ledState *ledState = &ledStates[i % MQTT_STATE_CHUNK];
             cJSON *ledJson = cJSON_CreateObject();
             if (ledJson != NULL)
             {
-                cJSON_AddNumberToObject(ledJson, "red", ledStates[i].red);
-                cJSON_AddNumberToObject(ledJson, "green", ledStates[i].green);
-                cJSON_AddNumberToObject(ledJson, "blue", ledStates[i].blue);
-                char n[5];                                 // Declare the variable 'n' with an appropriate size
-                sprintf(n, "%d", i);                       // Initialize the variable 'n' with the value of 'i'
+                cJSON_AddNumberToObject(ledJson, "red", ledState->red);
+                cJSON_AddNumberToObject(ledJson, "green", ledState->green);
+                cJSON_AddNumberToObject(ledJson, "blue", ledState->blue);
+                char n[6];                                 // Up to 65533, the last index of the largest strip
+                snprintf(n, sizeof(n), "%d", i);           // Initialize the variable 'n' with the value of 'i'
                 cJSON_AddItemToObject(lights, n, ledJson); // Use 'n' instead of 'sprint(n)'
             }
         }
@@ -139,19 +212,251 @@ void mqtt_publish_led_state(esp_mqtt_client_handle_t client)
     }
 }
 
+// Function called by the render task once the queued commands have been rendered
+static void mqtt_on_frame_rendered(void *arg)
+{
+    mqtt_publish_led_state((esp_mqtt_client_handle_t)arg);
+}
+
 /**
- * @brief Parses the JSON data received from MQTT and updates the LED strip accordingly.
+ * @brief Publishes the render statistics to the MQTT broker.
+ *
+ * This function is called periodically by the stats timer. The message is published with QoS 0 and
+ * is not retained, as it is only meant for monitoring.
  *
- * This function extracts the color data from the JSON and sets the corresponding LED values.
+ * @param arg The MQTT client handle.
+ *
+ * The MQTT stats message will be following format:
+ * {
+ *     "device-id": "my-device",
+ *     "refresh-skipped": 12,
+ *     "publish-skipped": 12,
+ *     "frames-rendered": 345,
+ *     "frames-dropped": 0,
+ *     "frames-flushed": 3,
+ *     "priority-commands": 5,
+ *     "priority-latency-max-us": 1840,
+ *     "jitter-depth": 4,
+ *     "jitter-underruns": 1,
+ *     "jitter-late-drops": 0,
+ *     "power-estimate-ma": 4200,
+ *     "power-scale": 0.83,
+ *     "effect-frames": 1500,
+ *     "effect-render-max-us": 95,
+ *     "render-stack-free": 2310
+ * }
+ */
+static void mqtt_publish_stats(void *arg)
+{
+    esp_mqtt_client_handle_t client = (esp_mqtt_client_handle_t)arg;
+    render_stats_t renderStats;
+    render_get_stats(&renderStats);
+
+    cJSON *statsJson = cJSON_CreateObject();
+    if (statsJson != NULL)
+    {
+        cJSON_AddStringToObject(statsJson, "device-id", CONFIG_MQTT_DEVICE_ID);
+        cJSON_AddNumberToObject(statsJson, "refresh-skipped", renderStats.refresh_skipped);
+        cJSON_AddNumberToObject(statsJson, "publish-skipped", publishSkipped);
+        cJSON_AddNumberToObject(statsJson, "frames-rendered", renderStats.frames_rendered);
+        cJSON_AddNumberToObject(statsJson, "frames-dropped", renderStats.frames_dropped);
+        cJSON_AddNumberToObject(statsJson, "frames-flushed", renderStats.frames_flushed);
+        cJSON_AddNumberToObject(statsJson, "priority-commands", renderStats.priority_commands);
+        cJSON_AddNumberToObject(statsJson, "priority-latency-max-us", renderStats.priority_latency_max_us);
+        cJSON_AddNumberToObject(statsJson, "jitter-depth", renderStats.jitter_depth);
+        cJSON_AddNumberToObject(statsJson, "jitter-underruns", renderStats.jitter_underruns);
+        cJSON_AddNumberToObject(statsJson, "jitter-late-drops", renderStats.jitter_late_drops);
+        cJSON_AddNumberToObject(statsJson, "power-estimate-ma", renderStats.power_estimate_ma);
+        cJSON_AddNumberToObject(statsJson, "power-scale", ((renderStats.power_scale * 100 + 127) / 255) / 100.0);
+        cJSON_AddNumberToObject(statsJson, "effect-frames", renderStats.effect_frames);
+        cJSON_AddNumberToObject(statsJson, "effect-render-max-us", renderStats.effect_render_max_us);
+        cJSON_AddNumberToObject(statsJson, "render-stack-free", renderStats.stack_free);
+
+        char *statsJsonStr = cJSON_PrintUnformatted(statsJson);
+        if (statsJsonStr != NULL)
+        {
+            esp_mqtt_client_enqueue(client, MQTT_TOPIC_STATS, statsJsonStr, strlen(statsJsonStr), 0, 0, false);
+            free(statsJsonStr);
+        }
+
+        cJSON_Delete(statsJson);
+    }
+}
+
+// Function to add a span of consecutive LEDs given as HSV colors to a frame, the colors are converted in batches
+static void mqtt_add_hsv_span(const cJSON *hsv, render_frame_t *frame)
+{
+    cJSON *start = cJSON_GetObjectItemCaseSensitive(hsv, "start");
+    cJSON *colors = cJSON_GetObjectItemCaseSensitive(hsv, "colors");
+    if (!cJSON_IsNumber(start) || !cJSON_IsArray(colors) || start->valueint < 0 || start->valueint >= CONFIG_LED_COUNT)
+    {
+        ESP_LOGD(TAG, "Invalid HSV data");
+        return;
+    }
+
+    // The colors are a flat array of hue, saturation and value, LEDs past the end of the strip are ignored
+    int count = cJSON_GetArraySize(colors) / 3;
+    if (count > CONFIG_LED_COUNT - start->valueint)
+    {
+        count = CONFIG_LED_COUNT - start->valueint;
+    }
+
+    led_strip_hsv_t hsvColors[MQTT_HSV_CHUNK];
+    uint8_t rgb[MQTT_HSV_CHUNK * 3];
+    const cJSON *item = colors->child;
+    for (int i = 0; i < count;)
+    {
+        int chunk = 0;
+        while (chunk < MQTT_HSV_CHUNK && i + chunk < count)
+        {
+            const cJSON *hue = item;
+            const cJSON *saturation = hue->next;
+            const cJSON *value = saturation->next;
+            item = value->next;
+            if (!cJSON_IsNumber(hue) || !cJSON_IsNumber(saturation) || !cJSON_IsNumber(value) || hue->valueint < 0 ||
+                saturation->valueint < 0 || saturation->valueint > 255 || value->valueint < 0 || value->valueint > 255)
+            {
+                ESP_LOGD(TAG, "Invalid HSV color");
+                count = i + chunk; // The span ends before the invalid color
+                break;
+            }
+            hsvColors[chunk].hue = hue->valueint % 360;
+            hsvColors[chunk].saturation = saturation->valueint;
+            hsvColors[chunk].value = value->valueint;
+            chunk++;
+        }
+
+        led_strip_hsv_to_rgb(hsvColors, rgb, chunk);
+        for (int j = 0; j < chunk; j++)
+        {
+            render_pixel_t *pixel = &frame->pixels[frame->count++];
+            pixel->index = start->valueint + i + j;
+            pixel->color.red = rgb[j * 3 + 0];
+            pixel->color.green = rgb[j * 3 + 1];
+            pixel->color.blue = rgb[j * 3 + 2];
+            pixel->alpha = 255;
+        }
+        i += chunk;
+    }
+}
+
+// Function to get the LED of an entry of the lights, by its number or by its position "x,y" in the layout, -1 if none
+static int mqtt_get_light_index(const char *key)
+{
+    int x;
+    int y;
+    if (strchr(key, ',') == NULL)
+    {
+        return atoi(key);
+    }
+    if (layout == NULL || sscanf(key, "%d,%d", &x, &y) != 2)
+    {
+        return -1;
+    }
+    return led_layout_index(layout, x, y);
+}
+
+// Function to get a rectangle { "x": 2, "y": 0, "width": 4, "height": 3 } of an LED command clipped to the layout, as its
+// first column and row and the column and row past its end. Returns false for an invalid rectangle or without a layout.
+static bool mqtt_get_rect(const cJSON *rect, int bounds[4])
+{
+    static const char *const fields[4] = {"x", "y", "width", "height"};
+
+    if (layout == NULL)
+    {
+        return false;
+    }
+    int values[4];
+    for (int f = 0; f < 4; f++)
+    {
+        const cJSON *value = cJSON_GetObjectItemCaseSensitive(rect, fields[f]);
+        if (!cJSON_IsNumber(value) || value->valueint < 0)
+        {
+            return false;
+        }
+        values[f] = value->valueint < LED_LAYOUT_MAX_CELLS ? value->valueint : LED_LAYOUT_MAX_CELLS;
+    }
+    const int size[2] = {layout->width, layout->height};
+    for (int axis = 0; axis < 2; axis++)
+    {
+        int first = values[axis];
+        int end = values[axis] + values[axis + 2];
+        bounds[axis] = first < size[axis] ? first : size[axis];
+        bounds[axis + 2] = end < size[axis] ? end : size[axis];
+    }
+    return true;
+}
+
+// Function to add the LEDs of the layout within a rectangle of an LED command to a frame, all in the color of the rectangle
+static void mqtt_add_rect(const cJSON *rect, render_frame_t *frame)
+{
+    cJSON *red = cJSON_GetObjectItemCaseSensitive(rect, "red");
+    cJSON *green = cJSON_GetObjectItemCaseSensitive(rect, "green");
+    cJSON *blue = cJSON_GetObjectItemCaseSensitive(rect, "blue");
+    cJSON *alpha = cJSON_GetObjectItemCaseSensitive(rect, "alpha");
+    int bounds[4];
+    if (!mqtt_get_rect(rect, bounds) || !cJSON_IsNumber(red) || !cJSON_IsNumber(green) || !cJSON_IsNumber(blue))
+    {
+        ESP_LOGD(TAG, "Invalid rectangle");
+        return;
+    }
+    for (int y = bounds[1]; y < bounds[3]; y++)
+    {
+        for (int x = bounds[0]; x < bounds[2]; x++)
+        {
+            int index = led_layout_index(layout, x, y);
+            if (index < 0)
+            {
+                // No LED at this position
+                continue;
+            }
+            render_pixel_t *pixel = &frame->pixels[frame->count++];
+            pixel->index = index;
+            pixel->color.red = red->valueint;
+            pixel->color.green = green->valueint;
+            pixel->color.blue = blue->valueint;
+            pixel->alpha = cJSON_IsNumber(alpha) && alpha->valueint >= 0 && alpha->valueint < 255 ? alpha->valueint : 255;
+        }
+    }
+}
+
+/**
+ * @brief Parses the JSON data received from MQTT and queues the LED updates for rendering.
+ *
+ * This function extracts the color data from the JSON and queues it as a frame on the normal lane of the render module.
  * It also performs error checking and validation on the received data.
+ * If the message has a presentation timestamp ("pts", in milliseconds on the clock of the sender),
+ * the frame is latched at its scheduled time by the jitter buffer instead of immediately.
+ * A span of consecutive LEDs can also be given as HSV colors ("hsv"), as a flat array of hue (0 - 359),
+ * saturation and value (0 - 255) from the LED "start", converted to RGB in batches. The "hsv" span is applied
+ * after the "lights", either of them may be left out.
+ * With a "transition-ms", the LEDs fade from their current color to the new one over that time, interpolated by the
+ * render module at the transition frame rate, instead of being set at once.
+ * With a "layer" above 0, the LEDs are drawn on that overlay layer instead of the base layer, each LED covering the layers
+ * below by its optional "alpha" (0 - 255, 255 if missing, 0 makes the LED of the layer transparent again).
+ * Once a layout is set by a config message, the LEDs are numbered row by row in the layout, and the lights can also be
+ * given by their position "x,y". The "rects" set all LEDs of the layout within each rectangle to its color, before the
+ * lights.
  *
  * @param client The MQTT client handle.
  * @param event The MQTT event handle.
+ * @param receivedUs The time the message was received.
  *
  *  * The MQTT command message should be in the following format:
  * {
  *     "device-id": "my-device",
+ *     "pts": 1234567,
+ *     "transition-ms": 1000,
+ *     "layer": 0,
+ *     "rects": [
+ *         { "x": 0, "y": 0, "width": 8, "height": 2, "red": 0, "green": 0, "blue": 64 }
+ *     ],
  *     "lights": {
+ *         "3,1": {
+ *             "red": 255,
+ *             "green": 0,
+ *             "blue": 0
+ *         },
  *         "2": {
  *             "red": 255,
  *             "green": 255,
@@ -169,41 +474,89 @@ void mqtt_publish_led_state(esp_mqtt_client_handle_t client)
  *             "blue": 255
  *         }
  *         ...
+ *     },
+ *     "hsv": {
+ *         "start": 20,
+ *         "colors": [0, 255, 255, 120, 255, 255, 240, 255, 128]
  *     }
  * }
  *
  *
  */
-void led_output_json_parser(esp_mqtt_client_handle_t client, esp_mqtt_event_handle_t event)
+void led_output_json_parser(esp_mqtt_client_handle_t client, esp_mqtt_event_handle_t event, int64_t receivedUs)
 {
 
     // Extract the color data from the received JSON
-    cJSON *root = cJSON_Parse(event->data);
+    cJSON *root = cJSON_ParseWithLength(event->data, event->data_len);
 
     if (root != NULL)
     {
         cJSON *deviceId = cJSON_GetObjectItemCaseSensitive(root, "device-id");
         cJSON *lights = cJSON_GetObjectItemCaseSensitive(root, "lights");
+        cJSON *pts = cJSON_GetObjectItemCaseSensitive(root, "pts");
+        cJSON *hsv = cJSON_GetObjectItemCaseSensitive(root, "hsv");
+        cJSON *transition = cJSON_GetObjectItemCaseSensitive(root, "transition-ms");
+        cJSON *layer = cJSON_GetObjectItemCaseSensitive(root, "layer");
+        cJSON *rects = cJSON_GetObjectItemCaseSensitive(root, "rects");
 
-        // Check if the JSON contains the required fields
-        if (cJSON_IsString(deviceId) && cJSON_IsObject(lights))
+        // Check if the JSON contains the required fields, the layer is optional
+        if (cJSON_IsString(deviceId) && (cJSON_IsObject(lights) || cJSON_IsObject(hsv) || cJSON_IsArray(rects)) &&
+            (layer == NULL || (cJSON_IsNumber(layer) && layer->valueint >= 0 && layer->valueint < CONFIG_LED_LAYER_COUNT)))
         {
-            char *deviceIdStr = deviceId->valuestring;
-
             // Check if the device ID matches the configured device ID or "all"
-            if (strcmp(deviceIdStr, CONFIG_MQTT_DEVICE_ID) == 0 || strcmp(deviceIdStr, "all") == 0)
+            if (mqtt_device_id_matches(deviceId))
             {
+                // At most one update per entry of the lights, one per LED of the HSV span, and one per cell of the rectangles
+                int hsvCount = cJSON_GetArraySize(cJSON_GetObjectItemCaseSensitive(hsv, "colors")) / 3;
+                int rectCount = 0;
+                cJSON *rect = NULL;
+                int bounds[4];
+                cJSON_ArrayForEach(rect, rects)
+                {
+                    if (mqtt_get_rect(rect, bounds))
+                    {
+                        rectCount += (bounds[2] - bounds[0]) * (bounds[3] - bounds[1]);
+                    }
+                }
+                render_frame_t *frame = render_frame_alloc(rectCount + cJSON_GetArraySize(lights) + (hsvCount < CONFIG_LED_COUNT ? hsvCount : CONFIG_LED_COUNT));
+                if (frame == NULL)
+                {
+                    ESP_LOGE(TAG, "No memory for frame");
+                    cJSON_Delete(root);
+                    return;
+                }
+                frame->received_us = receivedUs;
+                if (cJSON_IsNumber(pts))
+                {
+                    frame->timed = true;
+                    frame->pts_us = (int64_t)pts->valuedouble * 1000;
+                }
+                if (cJSON_IsNumber(transition) && transition->valuedouble > 0)
+                {
+                    frame->transition_ms = transition->valuedouble < MQTT_TRANSITION_MAX_MS ? transition->valuedouble : MQTT_TRANSITION_MAX_MS;
+                }
+                if (layer != NULL)
+                {
+                    frame->layer = layer->valueint;
+                }
+
+                cJSON_ArrayForEach(rect, rects)
+                {
+                    mqtt_add_rect(rect, frame);
+                }
+
                 cJSON *led = NULL;
                 cJSON_ArrayForEach(led, lights)
                 {
                     cJSON *red = cJSON_GetObjectItemCaseSensitive(led, "red");
                     cJSON *green = cJSON_GetObjectItemCaseSensitive(led, "green");
                     cJSON *blue = cJSON_GetObjectItemCaseSensitive(led, "blue");
+                    cJSON *alpha = cJSON_GetObjectItemCaseSensitive(led, "alpha");
 
                     // Check if the LED data contains valid color values
                     if (cJSON_IsNumber(red) && cJSON_IsNumber(green) && cJSON_IsNumber(blue))
                     {
-                        int ledValue = atoi(led->string);
+                        int ledValue = mqtt_get_light_index(led->string);
                         int redValue = red->valueint;
                         int greenValue = green->valueint;
                         int blueValue = blue->valueint;
@@ -213,11 +566,13 @@ void led_output_json_parser(esp_mqtt_client_handle_t client, esp_mqtt_event_hand
                         // Check if the LED number is within the valid range
                         if (ledValue >= 0 && ledValue < CONFIG_LED_COUNT)
                         {
-                            // Set the LED color and update the LED state
-                            ESP_ERROR_CHECK(led_strip_set_pixel(led_strip, ledValue, redValue, greenValue, blueValue));
-                            ledStates[ledValue].red = redValue;
-                            ledStates[ledValue].green = greenValue;
-                            ledStates[ledValue].blue = blueValue;
+                            // Add the LED update to the frame
+                            render_pixel_t *pixel = &frame->pixels[frame->count++];
+                            pixel->index = ledValue;
+                            pixel->color.red = redValue;
+                            pixel->color.green = greenValue;
+                            pixel->color.blue = blueValue;
+                            pixel->alpha = cJSON_IsNumber(alpha) && alpha->valueint >= 0 && alpha->valueint < 255 ? alpha->valueint : 255;
                         }
                         else
                         {
@@ -229,9 +584,16 @@ void led_output_json_parser(esp_mqtt_client_handle_t client, esp_mqtt_event_hand
                         ESP_LOGD(TAG, "Invalid LED data");
                     }
                 }
+                if (cJSON_IsObject(hsv))
+                {
+                    mqtt_add_hsv_span(hsv, frame);
+                }
 
-                // Refresh the LED strip to apply the changes
-                ESP_ERROR_CHECK(led_strip_refresh(led_strip));
+                // Queue the frame, the render task applies it and refreshes the LED strip
+                if (render_submit_frame(frame) != ESP_OK)
+                {
+                    ESP_LOGW(TAG, "Failed to queue frame");
+                }
             }
             else
             {
@@ -250,6 +612,415 @@ void led_output_json_parser(esp_mqtt_client_handle_t client, esp_mqtt_event_hand
         ESP_LOGD(TAG, "Failed to parse JSON data");
     }
 }
+
+// Function to check that a field of a command is missing or a number within a range, and get it
+static bool mqtt_get_number(const cJSON *root, const char *name, double min, double max, double *value)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(root, name);
+    if (item == NULL)
+    {
+        return true;
+    }
+    if (!cJSON_IsNumber(item) || item->valuedouble < min || item->valuedouble > max)
+    {
+        return false;
+    }
+    *value = item->valuedouble;
+    return true;
+}
+
+// Function to get a color { "red": 255, "green": 0, "blue": 0 } of an effect command, missing channels are 0
+static bool mqtt_get_effect_color(const cJSON *root, const char *name, uint8_t rgb[3])
+{
+    static const char *const channels[3] = {"red", "green", "blue"};
+
+    const cJSON *color = cJSON_GetObjectItemCaseSensitive(root, name);
+    if (color == NULL)
+    {
+        return true;
+    }
+    if (!cJSON_IsObject(color))
+    {
+        return false;
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        double level = 0;
+        if (!mqtt_get_number(color, channels[c], 0, 255, &level))
+        {
+            return false;
+        }
+        rgb[c] = level;
+    }
+    return true;
+}
+
+// Function to verify and load the shader program [12, 0, 31, ...] of an effect command, within the instruction budget
+static bool mqtt_get_shader(const cJSON *root, led_shader_t **shader)
+{
+    const cJSON *program = cJSON_GetObjectItemCaseSensitive(root, "program");
+    int length = cJSON_GetArraySize(program);
+    if (!cJSON_IsArray(program) || length == 0 || length > LED_SHADER_MAX_LENGTH)
+    {
+        return false;
+    }
+    uint8_t code[LED_SHADER_MAX_LENGTH];
+    int offset = 0;
+    const cJSON *byte;
+    cJSON_ArrayForEach(byte, program)
+    {
+        if (!cJSON_IsNumber(byte) || byte->valuedouble < 0 || byte->valuedouble > 255 || byte->valuedouble != byte->valueint)
+        {
+            return false;
+        }
+        code[offset++] = byte->valueint;
+    }
+    esp_err_t err = led_shader_load(code, length, CONFIG_LED_SHADER_BUDGET / CONFIG_LED_COUNT, shader);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Shader program rejected: %s", esp_err_to_name(err));
+        return false;
+    }
+    ESP_LOGD(TAG, "Shader program of %d bytes, at most %lu instructions per LED", length, (unsigned long)led_shader_cost(*shader));
+    return true;
+}
+
+// Function to get the parameters of an effect command, missing parameters take their default value. A shader program is
+// only loaded once the other parameters are valid.
+static bool mqtt_get_effect(const cJSON *root, led_effect_params_t *params)
+{
+    const cJSON *name = cJSON_GetObjectItemCaseSensitive(root, "effect");
+    if (!cJSON_IsString(name))
+    {
+        return false;
+    }
+    *params = (led_effect_params_t){
+        .type = led_effect_from_name(name->valuestring),
+        .colors = {{255, 255, 255}, {0, 0, 0}},
+    };
+    double periodMs = MQTT_EFFECT_PERIOD_MS;
+    double size = 0;
+    double density = MQTT_EFFECT_DENSITY;
+    double fps = 0;
+    double seed = 0;
+    bool valid = params->type != LED_EFFECT_COUNT &&
+                 mqtt_get_effect_color(root, "color", params->colors[0]) &&
+                 mqtt_get_effect_color(root, "second-color", params->colors[1]) &&
+                 mqtt_get_number(root, "period-ms", 1, MQTT_EFFECT_PERIOD_MAX_MS, &periodMs) &&
+                 mqtt_get_number(root, "size", 0, UINT16_MAX, &size) &&
+                 mqtt_get_number(root, "density", 0, 255, &density) &&
+                 mqtt_get_number(root, "fps", 0, MQTT_EFFECT_FPS_MAX, &fps) &&
+                 mqtt_get_number(root, "seed", 0, UINT32_MAX, &seed) &&
+                 (params->type != LED_EFFECT_SHADER || mqtt_get_shader(root, &params->shader));
+    params->period_ms = periodMs;
+    params->size = size;
+    params->density = density;
+    params->fps = fps;
+    params->seed = seed;
+    return valid;
+}
+
+// Function to get the settings of a layer command, merged with the current settings of the layer
+static bool mqtt_get_layer(const cJSON *root, render_priority_cmd_t *cmd)
+{
+    double layer = -1;
+    if (!mqtt_get_number(root, "layer", 1, CONFIG_LED_LAYER_COUNT - 1, &layer) || layer < 1)
+    {
+        return false;
+    }
+    render_priority_cmd_t *config = &layerConfigs[(int)layer];
+    double opacity = config->opacity;
+    const cJSON *blend = cJSON_GetObjectItemCaseSensitive(root, "blend");
+    const cJSON *clear = cJSON_GetObjectItemCaseSensitive(root, "clear");
+    led_layer_blend_t blendMode = cJSON_IsString(blend) ? led_layer_blend_from_name(blend->valuestring) : config->blend;
+    if (!mqtt_get_number(root, "opacity", 0, 255, &opacity) || blendMode == LED_LAYER_BLEND_COUNT ||
+        (clear != NULL && !cJSON_IsBool(clear)))
+    {
+        return false;
+    }
+    config->opacity = opacity;
+    config->blend = blendMode;
+    *cmd = *config;
+    cmd->clear = cJSON_IsTrue(clear);
+    return true;
+}
+
+// Function to compile the layout { "width": 16, "height": 16, "serpentine": true, "rotation": 90 } of a config message,
+// once for the LED commands and once for the render task, or get the order of the wiring (NULL) for a null layout
+static bool mqtt_get_layout(const cJSON *json, led_layout_t *compiled[2])
+{
+    compiled[0] = NULL;
+    compiled[1] = NULL;
+    if (cJSON_IsNull(json))
+    {
+        return true;
+    }
+    const cJSON *serpentine = cJSON_GetObjectItemCaseSensitive(json, "serpentine");
+    const cJSON *mirror = cJSON_GetObjectItemCaseSensitive(json, "mirror");
+    const cJSON *coordinates = cJSON_GetObjectItemCaseSensitive(json, "coordinates");
+    int coordinateCount = cJSON_GetArraySize(coordinates);
+    double width = 0;
+    double height = 0;
+    double rotation = 0;
+    if (!cJSON_IsObject(json) || !mqtt_get_number(json, "width", 1, UINT16_MAX, &width) || width < 1 ||
+        !mqtt_get_number(json, "height", 1, UINT16_MAX, &height) || height < 1 ||
+        !mqtt_get_number(json, "rotation", 0, 270, &rotation) ||
+        (serpentine != NULL && !cJSON_IsBool(serpentine)) || (mirror != NULL && !cJSON_IsBool(mirror)) ||
+        (coordinates != NULL && (!cJSON_IsArray(coordinates) || coordinateCount % 2 != 0 || coordinateCount > CONFIG_LED_COUNT * 2)))
+    {
+        return false;
+    }
+
+    // The coordinates are a flat array of x and y of each LED, in the order of the wiring
+    uint16_t *values = NULL;
+    if (coordinates != NULL)
+    {
+        values = malloc((coordinateCount > 0 ? coordinateCount : 1) * sizeof(uint16_t));
+        if (values == NULL)
+        {
+            ESP_LOGE(TAG, "No memory for the layout");
+            return false;
+        }
+        int i = 0;
+        const cJSON *value;
+        cJSON_ArrayForEach(value, coordinates)
+        {
+            if (!cJSON_IsNumber(value) || value->valueint < 0 || value->valueint > UINT16_MAX)
+            {
+                free(values);
+                return false;
+            }
+            values[i++] = value->valueint;
+        }
+    }
+    const led_layout_desc_t desc = {
+        .width = width,
+        .height = height,
+        .serpentine = cJSON_IsTrue(serpentine),
+        .mirror = cJSON_IsTrue(mirror),
+        .rotation = rotation,
+        .coordinates = values,
+        .coordinate_count = coordinateCount / 2,
+    };
+    esp_err_t err = led_layout_compile(&desc, CONFIG_LED_COUNT, &compiled[0]);
+    if (err == ESP_OK)
+    {
+        err = led_layout_compile(&desc, CONFIG_LED_COUNT, &compiled[1]);
+    }
+    free(values);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Layout rejected: %s", esp_err_to_name(err));
+        led_layout_free(compiled[0]);
+        compiled[0] = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a priority command received from MQTT and queues it on the priority lane.
+ *
+ * Priority commands bypass the frames queued for rendering: they are executed before the next frame,
+ * and a blackout or scene recall flushes the frames still pending.
+ *
+ * @param event The MQTT event handle.
+ * @param receivedUs The time the message was received, for the latency measurement.
+ *
+ * The MQTT priority message should be in one of the following formats:
+ * { "device-id": "my-device", "command": "blackout" }
+ * { "device-id": "my-device", "command": "dimmer", "level": 128 }
+ * { "device-id": "my-device", "command": "scene-store", "scene": 1 }
+ * { "device-id": "my-device", "command": "scene-recall", "scene": 1 }
+ * { "device-id": "my-device", "command": "effect", "effect": "chase", "color": { "red": 255, "green": 0, "blue": 0 },
+ *   "second-color": { "red": 0, "green": 0, "blue": 0 }, "period-ms": 2000, "size": 10, "density": 64, "fps": 50, "seed": 1,
+ *   "layer": 0 }
+ * { "device-id": "my-device", "command": "effect", "effect": "shader", "program": [3, 4, 0, 64, 0, 13, 11, 0, 0, 1, 0, 0, 1, 28],
+ *   "fps": 60 }
+ * { "device-id": "my-device", "command": "layer", "layer": 1, "opacity": 128, "blend": "add", "clear": false }
+ *
+ * The effect is one of "rainbow", "chase", "breathe", "twinkle", "fire", "gradient", "shader", or "none" to stop
+ * the running effect. All its parameters are optional, except the bytecode "program" of the shader (see led_shader_op_t),
+ * which is rejected if a single LED may run more than CONFIG_LED_SHADER_BUDGET / CONFIG_LED_COUNT instructions.
+ * The layer command sets an overlay layer (1 to CONFIG_LED_LAYER_COUNT - 1). Its blend mode is one of "over", "add",
+ * "multiply" or "max". The opacity and blend mode missing from the command keep their current value, "clear" makes
+ * the whole layer transparent.
+ */
+static void priority_json_parser(esp_mqtt_event_handle_t event, int64_t receivedUs)
+{
+    cJSON *root = cJSON_ParseWithLength(event->data, event->data_len);
+    if (root == NULL)
+    {
+        ESP_LOGD(TAG, "Failed to parse JSON data");
+        return;
+    }
+
+    cJSON *command = cJSON_GetObjectItemCaseSensitive(root, "command");
+    cJSON *level = cJSON_GetObjectItemCaseSensitive(root, "level");
+    cJSON *scene = cJSON_GetObjectItemCaseSensitive(root, "scene");
+    render_priority_cmd_t cmd = {.received_us = receivedUs};
+    bool valid = true;
+    double layer = 0;
+
+    if (!mqtt_device_id_matches(cJSON_GetObjectItemCaseSensitive(root, "device-id")) || !cJSON_IsString(command))
+    {
+        valid = false;
+    }
+    else if (strcmp(command->valuestring, "blackout") == 0)
+    {
+        cmd.type = RENDER_PRIORITY_BLACKOUT;
+    }
+    else if (strcmp(command->valuestring, "dimmer") == 0 && cJSON_IsNumber(level) && level->valueint >= 0 && level->valueint <= 255)
+    {
+        cmd.type = RENDER_PRIORITY_DIMMER;
+        cmd.value = level->valueint;
+    }
+    else if (strcmp(command->valuestring, "scene-store") == 0 && cJSON_IsNumber(scene) && scene->valueint >= 0 && scene->valueint < CONFIG_LED_SCENE_COUNT)
+    {
+        cmd.type = RENDER_PRIORITY_SCENE_STORE;
+        cmd.value = scene->valueint;
+    }
+    else if (strcmp(command->valuestring, "scene-recall") == 0 && cJSON_IsNumber(scene) && scene->valueint >= 0 && scene->valueint < CONFIG_LED_SCENE_COUNT)
+    {
+        cmd.type = RENDER_PRIORITY_SCENE_RECALL;
+        cmd.value = scene->valueint;
+    }
+    else if (strcmp(command->valuestring, "effect") == 0 && mqtt_get_effect(root, &cmd.effect) &&
+             mqtt_get_number(root, "layer", 0, CONFIG_LED_LAYER_COUNT - 1, &layer))
+    {
+        cmd.type = RENDER_PRIORITY_EFFECT;
+        cmd.layer = layer;
+    }
+    else if (strcmp(command->valuestring, "layer") == 0 && mqtt_get_layer(root, &cmd))
+    {
+        cmd.received_us = receivedUs; // The command is a copy of the layer settings
+    }
+    else
+    {
+        valid = false;
+    }
+
+    if (valid)
+    {
+        if (render_submit_priority(&cmd) != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Priority lane full, command dropped");
+            led_shader_free(cmd.effect.shader);
+        }
+    }
+    else
+    {
+        ESP_LOGD(TAG, "Invalid priority command");
+        led_shader_free(cmd.effect.shader);
+    }
+
+    cJSON_Delete(root);
+}
+/**
+ * @brief Parses a color config message received from MQTT and queues it on the priority lane.
+ *
+ * The gamma and white balance are applied by the LED strip driver when it sends the frame to the LEDs,
+ * through a color lookup table that is only rebuilt when a config message arrives. With temporal dithering,
+ * they are applied by the render module with 16 bits per channel instead. Settings missing from
+ * the message keep their current value. Publish the config retained, so the devices get it again when they restart.
+ *
+ * The layout numbers the LEDs row by row as they are laid out, instead of in the order of the wiring: a matrix of "width"
+ * by "height" LEDs wired along its rows from the top left corner, every other row backwards if "serpentine", from right to
+ * left if "mirror", and turned by "rotation" degrees clockwise (0, 90, 180 or 270). Or the position of each LED in the
+ * order of the wiring, as a flat array of x and y in "coordinates". A null layout goes back to the order of the wiring.
+ *
+ * @param event The MQTT event handle.
+ * @param receivedUs The time the message was received, for the latency measurement.
+ *
+ * The MQTT config message should be in the following format:
+ * {
+ *     "device-id": "my-device",
+ *     "gamma": 2.2,
+ *     "white-balance": {
+ *         "red": 255,
+ *         "green": 220,
+ *         "blue": 200,
+ *         "white": 255
+ *     },
+ *     "dither": true,
+ *     "layout": {
+ *         "width": 16,
+ *         "height": 16,
+ *         "serpentine": true,
+ *         "rotation": 90
+ *     }
+ * }
+ */
+static void config_json_parser(esp_mqtt_event_handle_t event, int64_t receivedUs)
+{
+    static const char *const channels[4] = {"red", "green", "blue", "white"};
+
+    cJSON *root = cJSON_ParseWithLength(event->data, event->data_len);
+    if (root == NULL)
+    {
+        ESP_LOGD(TAG, "Failed to parse JSON data");
+        return;
+    }
+
+    if (mqtt_device_id_matches(cJSON_GetObjectItemCaseSensitive(root, "device-id")))
+    {
+        cJSON *gamma = cJSON_GetObjectItemCaseSensitive(root, "gamma");
+        cJSON *whiteBalance = cJSON_GetObjectItemCaseSensitive(root, "white-balance");
+        cJSON *dither = cJSON_GetObjectItemCaseSensitive(root, "dither");
+
+        if (cJSON_IsNumber(gamma) && gamma->valuedouble >= MQTT_GAMMA_MIN && gamma->valuedouble <= MQTT_GAMMA_MAX)
+        {
+            colorConfig.gamma = gamma->valuedouble;
+        }
+        for (int c = 0; c < 4 && cJSON_IsObject(whiteBalance); c++)
+        {
+            cJSON *gain = cJSON_GetObjectItemCaseSensitive(whiteBalance, channels[c]);
+            if (cJSON_IsNumber(gain) && gain->valueint >= 0 && gain->valueint <= 255)
+            {
+                colorConfig.white_balance[c] = gain->valueint;
+            }
+        }
+        if (cJSON_IsBool(dither))
+        {
+            colorConfig.dither = cJSON_IsTrue(dither);
+        }
+
+        colorConfig.received_us = receivedUs;
+        if (render_submit_priority(&colorConfig) != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Priority lane full, color config dropped");
+        }
+
+        cJSON *layoutJson = cJSON_GetObjectItemCaseSensitive(root, "layout");
+        led_layout_t *layouts[2];
+        if (layoutJson != NULL && mqtt_get_layout(layoutJson, layouts))
+        {
+            const render_priority_cmd_t layoutCmd = {
+                .type = RENDER_PRIORITY_LAYOUT,
+                .layout = layouts[1],
+                .received_us = receivedUs,
+            };
+            if (render_submit_priority(&layoutCmd) == ESP_OK)
+            {
+                led_layout_free(layout);
+                layout = layouts[0];
+            }
+            else
+            {
+                ESP_LOGW(TAG, "Priority lane full, layout dropped");
+                led_layout_free(layouts[0]);
+                led_layout_free(layouts[1]);
+            }
+        }
+        else if (layoutJson != NULL)
+        {
+            ESP_LOGD(TAG, "Invalid layout");
+        }
+    }
+
+    cJSON_Delete(root);
+}
+
 /**
  * @brief Event handler registered to receive MQTT events
  *
@@ -265,6 +1036,7 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     ESP_LOGD(TAG, "Event dispatched from event loop base=%s, event_id=%" PRIi32 "", base, event_id);
     esp_mqtt_event_handle_t event = event_data;
     esp_mqtt_client_handle_t client = event->client;
+    int64_t receivedUs = esp_timer_get_time();
     switch ((esp_mqtt_event_id_t)event_id)
     {
     case MQTT_EVENT_CONNECTED:
@@ -276,6 +1048,10 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
         // Subscribe to topics
         esp_mqtt_client_subscribe(client, MQTT_TOPIC_BRODCAST_COMMAND, 2);
         esp_mqtt_client_subscribe(client, MQTT_TOPIC_COMMAND, 2);
+        esp_mqtt_client_subscribe(client, MQTT_TOPIC_BRODCAST_PRIORITY, 2);
+        esp_mqtt_client_subscribe(client, MQTT_TOPIC_PRIORITY, 2);
+        esp_mqtt_client_subscribe(client, MQTT_TOPIC_BRODCAST_CONFIG, 2);
+        esp_mqtt_client_subscribe(client, MQTT_TOPIC_CONFIG, 2);
 
         break;
     case MQTT_EVENT_DISCONNECTED:
@@ -297,14 +1073,22 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
         ESP_LOGD(TAG, "TOPIC=%.*s\r\n", event->topic_len, event->topic);
         ESP_LOGD(TAG, "DATA=%.*s\r\n", event->data_len, event->data);
 
-        // Check if the topic contains MQTT_TOPIC_COMMAND
-        if (strstr(event->topic, MQTT_TOPIC_COMMAND) != NULL || strstr(event->topic, MQTT_TOPIC_BRODCAST_COMMAND) != NULL)
+        // Check if the topic is one of the command topics.
+        // The LED state is published by the render task once the command has been rendered.
+        if (mqtt_topic_is(event, MQTT_TOPIC_PRIORITY) || mqtt_topic_is(event, MQTT_TOPIC_BRODCAST_PRIORITY))
+        {
+            // Handle the priority command
+            priority_json_parser(event, receivedUs);
+        }
+        else if (mqtt_topic_is(event, MQTT_TOPIC_CONFIG) || mqtt_topic_is(event, MQTT_TOPIC_BRODCAST_CONFIG))
+        {
+            // Handle the color config
+            config_json_parser(event, receivedUs);
+        }
+        else if (mqtt_topic_is(event, MQTT_TOPIC_COMMAND) || mqtt_topic_is(event, MQTT_TOPIC_BRODCAST_COMMAND))
         {
             // Handle the LED command
-            led_output_json_parser(client, event);
-
-            // Output the ledState to the MQTT state topic
-            mqtt_publish_led_state(client);
+            led_output_json_parser(client, event, receivedUs);
         }
 
         break;
@@ -328,20 +1112,15 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
 }
 
 /*
- * @brief Starts the MQTT application and initializes the LED strip.
+ * @brief Starts the MQTT application.
  *
  * This function initializes the MQTT client with the provided configuration and starts the client.
- * It also initializes the ledStates array with default values and publishes the LED state to the MQTT state topic.
- *
- * @param strip The handle to the LED strip.
+ * It also publishes the LED state to the MQTT state topic. The render task must have been started before.
  */
 
-void mqtt_app_start(led_strip_handle_t strip)
+void mqtt_app_start(void)
 {
 
-    // Set the LED strip handle
-    led_strip = strip;
-
     // Configure the MQTT client
     esp_mqtt_client_config_t mqtt_cfg = {
         .broker.address.uri = CONFIG_BROKER_URL,
@@ -387,25 +1166,40 @@ void mqtt_app_start(led_strip_handle_t strip)
     }
 #endif /* CONFIG_BROKER_URL_FROM_STDIN */
 
+    // The overlay layers start as the render module sets them up, covering the layers below
+    for (int i = 1; i < CONFIG_LED_LAYER_COUNT; i++)
+    {
+        layerConfigs[i] = (render_priority_cmd_t){
+            .type = RENDER_PRIORITY_LAYER,
+            .layer = i,
+            .opacity = 255,
+            .blend = LED_LAYER_BLEND_OVER,
+        };
+    }
+
     // Initialize and start the MQTT client
     esp_mqtt_client_handle_t client = esp_mqtt_client_init(&mqtt_cfg);
     esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
     esp_mqtt_client_start(client);
 
-    // Initialize the ledStates array with default values
-    for (int i = 0; i < CONFIG_LED_COUNT; i++)
-    {
-        ledStates[i].red = 0;
-        ledStates[i].green = 0;
-        ledStates[i].blue = 0;
-    }
+#if CONFIG_MQTT_STATS_INTERVAL > 0
+    // Start the periodic stats publish
+    esp_timer_handle_t statsTimer;
+    const esp_timer_create_args_t statsTimerArgs = {
+        .callback = mqtt_publish_stats,
+        .arg = client,
+        .name = "mqtt_stats",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&statsTimerArgs, &statsTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(statsTimer, CONFIG_MQTT_STATS_INTERVAL * 1000000ULL));
+#endif
 
     // Publish the LED count and type to MQTT topics
     char ledCount[6];
     snprintf(ledCount, sizeof(ledCount), "%d", CONFIG_LED_COUNT);
     esp_mqtt_client_enqueue(client, MQTT_DEVICE_ID "/lights/count", ledCount, 0, 2, 1, false);
-    esp_mqtt_client_enqueue(client, MQTT_DEVICE_ID "/lights/type", "WS2812", 0, 2, 1, false);
+    esp_mqtt_client_enqueue(client, MQTT_DEVICE_ID "/lights/type", MQTT_LED_TYPE, 0, 2, 1, false);
 
-    // Publish the LED state to the MQTT state topic
-    mqtt_publish_led_state(client);
+    // The render task publishes the LED state now, and from then on after rendering commands
+    render_set_frame_callback(mqtt_on_frame_rendered, client);
 }
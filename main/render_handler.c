@@ -0,0 +1,1717 @@
+/**
+ * @file render_handler.c
+ * @brief This file contains the implementation of the render module.
+ *
+ * The render module owns the frame shown on the LED strip. A render task applies the frames queued on the
+ * normal lane one by one. Commands of the priority lane (blackout, master dimmer, scenes) have their own queue,
+ * which is drained before every frame, so they never wait for more than the frame currently being rendered.
+ * Blackout and scene recall also flush the frames still pending on the normal lane, as they are stale.
+ *
+ * The LED strip driver's pixel buffer is the only copy of the frame, it is read back for the state publish and the frame hash.
+ * The master dimmer, gamma and white balance form a color lookup table, which the LED strip driver applies when it encodes
+ * the frame for the LEDs, so changing them takes a single refresh and leaves the frame unchanged. With a backend without
+ * lookup table, gamma and white balance are ignored, and while the master dimmer is below full level the strip holds
+ * the dimmed colors, so a copy of the undimmed frame is kept until the dimmer is back at full level.
+ *
+ * With temporal dithering, gamma, white balance and master dimmer are applied by the render module instead, into a frame
+ * of 8.8 fixed point levels. The LED strip is refreshed at a fixed rate, each channel showing the integer part of its
+ * level plus the carry of an error accumulator, so over a few frames the LEDs average out to levels between
+ * the 8-bit steps, which are coarse at low brightness once the gamma is applied.
+ *
+ * The power limiter keeps a running sum of the output of each channel, updated with every LED write like the frame hash.
+ * Before each refresh, it estimates the current of the LED strip from the sums and lowers the output level below the master
+ * dimmer as far as needed to stay within the power supply budget. The limited level keeps some headroom and only goes up
+ * again once the frame leaves enough room, so an animated frame keeps the same level instead of changing it at every refresh.
+ * A change of level scales the color curves, computed once from the gamma and white balance, without any power function.
+ *
+ * Effects (rainbow, chase, breathe, twinkle, fire, gradient) are rendered by the render task itself, at the frame rate of
+ * the effect, from a single effect command. An LED command, blackout or scene recall stops the running effect.
+ *
+ * A frame with a transition fades its LEDs from their current color instead of setting them at once. Each LED in transition
+ * holds its level in 8.16 fixed point and the change per step, computed when the transition starts, so a step costs one
+ * addition per channel. The steps only visit the LEDs still in transition, the other LEDs of the strip are not touched.
+ *
+ * LED commands and effects draw on the base layer, or on one of the overlay layers composited over it with their own
+ * opacity and blend mode. The frame is then the composite of the layers: while an overlay is in use, a copy of the base
+ * layer is kept, and every change of a layer composites the LEDs it changed into the frame again. Without overlays,
+ * the frame is the base layer, as before layers were added.
+ *
+ * The frame is addressed in the order of the layout of the LED strip, row by row for a matrix. A layout that does not
+ * follow the wiring keeps a copy of the frame in the order of the wiring: every LED written goes to its place in the copy
+ * with one lookup in the table of the layout, and the LEDs changed are written to the LED strip as one span before the
+ * refresh. The frame hash, scenes, layers and effects all stay in the order of the layout. Every layout queued gets the
+ * next generation number, and the frames queued after it carry it, so the frames still pending when the render task
+ * switches layouts, numbered in the previous layout, are dropped instead of being remapped through the new one.
+ *
+ * The statistics and the frame hash are copied for the other tasks at the end of every pass of the render task, under
+ * a spinlock shared with the frame callback, so the other tasks never read the state of the render task while it changes.
+ *
+ * Frames with a presentation timestamp are held in a jitter buffer and latched at their scheduled local time,
+ * so the network jitter does not show in streamed animations. The sender clock is mapped to the local clock
+ * by the smallest transit time seen recently, the frames are played out a fixed delay after that.
+ */
+
+#include <stdio.h>    // Standard input/output functions
+#include <stdlib.h>   // Memory allocation functions
+#include <stdint.h>   // Standard integer types
+#include <stdbool.h>  // Boolean type
+#include <stddef.h>   // Standard definitions
+#include <string.h>   // String manipulation functions
+#include <inttypes.h> // Integer format macros
+#include <math.h>     // Math functions
+
+#include "freertos/FreeRTOS.h" // FreeRTOS real-time operating system
+#include "freertos/task.h"     // FreeRTOS task functions
+#include "freertos/queue.h"    // FreeRTOS queue functions
+
+#include "esp_log.h"   // ESP32 logging library
+#include "esp_err.h"   // ESP32 error codes
+#include "esp_timer.h" // ESP32 high resolution timer
+
+#include "led_strip.h"      // LED strip library
+#include "render_handler.h" // Render handler functions
+#include "led_effect.h"     // LED effect functions
+#include "led_layer.h"      // LED layer functions
+#include "led_layout.h"     // LED layout functions
+
+#define RENDER_TASK_STACK_SIZE CONFIG_LED_RENDER_TASK_STACK_SIZE
+#define RENDER_TASK_PRIORITY 6 // Above the MQTT task, so frames are rendered as soon as they are queued
+#define RENDER_SPAN_CHUNK 64    // LEDs handled on the stack at once when writing a span to the LED strip
+
+#define RENDER_JITTER_DELAY_US (CONFIG_LED_JITTER_BUFFER_MS * 1000LL)
+#define RENDER_CLOCK_WINDOW_US 2000000LL // The clock offset is the minimum transit time of the last one to two windows
+#define RENDER_CLOCK_RESET_US 1000000LL  // A stream pausing for longer than this starts a new clock mapping
+
+#define RENDER_DITHER_PERIOD_US (1000000 / CONFIG_LED_DITHER_REFRESH_HZ)
+#define RENDER_DITHER_LEVEL_MAX 0xFF00 // Level of a channel at full output, the carry of the error accumulator never exceeds 255
+
+#define RENDER_TRANSITION_PERIOD_US (1000000 / CONFIG_LED_TRANSITION_FPS)
+#define RENDER_TRANSITION_NONE 0xFFFF // Slot of an LED without transition
+
+#define RENDER_POWER_LEVEL_MAX 0xFFFF // Output of a channel at full level in the power estimate
+#define RENDER_POWER_HYSTERESIS 8      // Headroom of the limited output level, so small changes of the frame keep the same level
+#define RENDER_POWER_IDLE_MA ((CONFIG_LED_CURRENT_IDLE_UA * CONFIG_LED_COUNT + 999) / 1000)
+
+static const char *TAG = "RENDER_HANDLER"; // Tag for logging
+
+static led_strip_handle_t led_strip; // Handle for the LED strip
+static TaskHandle_t renderTask;      // Handle for the render task
+static QueueHandle_t frameQueue;     // Normal lane, holds render_frame_t pointers
+static QueueHandle_t priorityQueue;  // Priority lane, holds render_priority_cmd_t
+
+static render_frame_cb_t frameCallback; // Called after rendering the queued commands
+static void *frameCallbackArg;
+static bool frameCallbackPending; // Set when the callback is registered, the render task invokes it once
+
+// An LED fading to the color of a frame with a transition
+typedef struct
+{
+    uint16_t index;         // LED number
+    uint16_t steps;         // Steps left until the LED shows the target color, 0 once the transition is cancelled
+    uint32_t level[3];      // Current level of red, green and blue in 8.16 fixed point
+    int32_t delta[3];       // Change of each level per step
+    struct ledState target; // Color at the end of the transition
+} render_transition_t;
+
+// An overlay layer, composited over the layers below it
+typedef struct
+{
+    uint32_t *pixels;        // Color and coverage of each LED, as LED_LAYER_PIXEL, only allocated while the layer is in use
+    uint8_t opacity;         // Opacity of the whole layer
+    led_layer_blend_t blend; // Blend mode over the layers below
+    uint16_t first;          // First LED drawn on the layer, the LEDs outside first to end are transparent
+    uint16_t end;            // LED after the last one drawn on the layer, equal to first while nothing is drawn
+} render_layer_t;
+
+// The frame is handed to the LED strip as RGB bytes, so the LED states must not be padded
+_Static_assert(sizeof(struct ledState) == 3, "struct ledState must be 3 bytes");
+
+static struct ledState *frameStates;                   // Copy of the frame, only kept while the LED strip holds dimmed or dithered colors
+static struct ledState *scenes[CONFIG_LED_SCENE_COUNT]; // Stored scenes, allocated on first store
+static uint8_t masterDimmer = 255;                      // Master dimmer level
+static uint8_t dimmer = 255;                            // Output level, the master dimmer lowered by the power limiter
+static led_strip_color_lut_t colorLut;                  // Gamma, white balance and master dimmer, applied by the LED strip driver
+static bool colorLutSupported;                          // The LED strip backend applies colorLut, otherwise the dimmer scales the frame
+static float colorGamma = 1.0f;                         // Gamma of the LEDs, 1 sends the colors linearly
+static uint8_t colorGain[4] = {255, 255, 255, 255};     // White balance, gain of red, green, blue and white
+static uint32_t blackHash;                              // Hash of the all-black frame
+
+// Temporal dithering, the buffers are only allocated while it is on
+static uint16_t *ditherFrame;          // Output level of each channel in 8.8 fixed point, in the order of struct ledState
+static uint8_t *ditherError;           // Error accumulator of each channel, the fraction not shown yet
+static uint16_t colorCurve[4][256];    // Output level of each color value in 8.8 fixed point, gamma and white balance applied
+static uint16_t ditherCurve[3][256];   // Output level of each color value, gamma, white balance and master dimmer applied
+static uint32_t ditherFractional;      // Number of channels with a fractional level, the LED strip is only refreshed for them
+static int64_t ditherRefreshedUs;      // Time of the last refresh of the LED strip
+static esp_timer_handle_t ditherTimer; // Wakes the render task at the dithering refresh rate
+
+// Power limiter, the current of each channel at full level and the running sums of the output of each channel
+static const uint32_t ledCurrentMa[3] = {CONFIG_LED_CURRENT_RED_MA, CONFIG_LED_CURRENT_GREEN_MA, CONFIG_LED_CURRENT_BLUE_MA};
+static uint16_t powerCurve[256]; // Output of each color value at full level, before the white balance, 0 - RENDER_POWER_LEVEL_MAX
+static uint32_t powerSum[3];     // Sum of the output of each channel over the frame
+
+// Effect rendered on the device, the frame of the effect is only allocated while it runs
+static led_effect_t effect;            // Running effect, LED_EFFECT_NONE if none
+static struct ledState *effectStates;  // Frame of the effect, rendered before it is written to the LED strip
+static int64_t effectStartUs;          // Time the effect started
+static int64_t effectRenderedUs;       // Time of the last frame of the effect
+static int64_t effectPeriodUs;         // Frame period of the effect
+static esp_timer_handle_t effectTimer; // Wakes the render task at the frame rate of the effect
+static uint8_t effectLayer;            // Layer the effect is drawn on
+
+// Transitions, only allocated while an LED is in transition
+static render_transition_t *transitions;   // LEDs in transition, in the order they started
+static uint16_t *transitionSlot;           // Slot of each LED in transitions, RENDER_TRANSITION_NONE if it is not in transition
+static uint32_t transitionCount;           // Slots in use, including cancelled transitions not removed yet
+static int64_t transitionSteppedUs;        // Time of the last step
+static esp_timer_handle_t transitionTimer; // Wakes the render task at the transition frame rate
+
+// Layers, layer 0 is the base layer and has no pixels of its own
+static render_layer_t layers[CONFIG_LED_LAYER_COUNT];
+static struct ledState *baseStates; // Copy of the base layer, only kept while an overlay is in use, otherwise the frame is the base layer
+
+// Layout of the LED strip
+static led_layout_t *layout;                    // Current layout, NULL while the LEDs are addressed in the order of the wiring
+static struct ledState *layoutPixels;           // Frame in the order of the wiring, only kept while the layout remaps the LEDs
+static int layoutDirtyFirst = CONFIG_LED_COUNT; // Span of layoutPixels changed since it was written to the LED strip
+static int layoutDirtyEnd;
+static uint32_t layoutGeneration; // Generation of the current layout
+static uint32_t layoutQueued;     // Generation of the last layout queued, only used by the task queuing the commands
+
+// Rolling hash of the frame, the sum of a per-LED hash of index and color.
+// It is updated on every LED write, so comparing frames never needs a full-frame scan.
+static uint32_t frameHash;
+static uint32_t refreshedHash; // Hash of the frame last sent to the LED strip
+static bool refreshForced;     // Set when the output changed without a frame change, e.g. by the dimmer
+
+static render_stats_t stats; // Written by the render task only
+
+// State shared with the other tasks, under sharedLock
+static portMUX_TYPE sharedLock = portMUX_INITIALIZER_UNLOCKED;
+static render_stats_t sharedStats; // Copy of stats at the end of the last pass of the render task
+static uint32_t sharedHash;        // Copy of frameHash at the end of the last pass of the render task
+static uint32_t framesDropped;     // Frames dropped by the task queuing them
+
+// Jitter buffer, the timed frames sorted by playout time
+static render_frame_t *jitterBuffer[CONFIG_LED_JITTER_BUFFER_LENGTH];
+static uint32_t jitterDepth;
+static esp_timer_handle_t playoutTimer; // Wakes the render task when the first frame of the jitter buffer is due
+
+// Mapping of the sender clock to the local clock
+static bool clockValid;
+static int64_t clockMinCurrent;  // Minimum transit time (local receive time - pts) of the current window
+static int64_t clockMinPrevious; // Minimum transit time of the previous window
+static int64_t clockWindowStart;
+static int64_t clockLastReceived;
+
+// Function to hash the state of a single LED
+static uint32_t led_state_hash(int index, const struct ledState *state)
+{
+    uint32_t h = (uint32_t)index * 0x9E3779B1u ^ ((uint32_t)state->red << 16 | (uint32_t)state->green << 8 | state->blue);
+
+    // Murmur3 finalizer, so that neighbouring LEDs and colors spread over the whole hash
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// Function to scale a color value by the master dimmer
+static inline uint32_t dim(uint8_t value)
+{
+    return ((uint32_t)value * (dimmer + 1)) >> 8;
+}
+
+// Function to write consecutive LEDs to the LED strip, at their place in the wiring
+static void render_strip_write(int start, const struct ledState *colors, int count)
+{
+    if (layoutPixels == NULL)
+    {
+        ESP_ERROR_CHECK(led_strip_set_pixels(led_strip, start, (const uint8_t *)colors, count, LED_STRIP_SRC_FORMAT_RGB));
+        return;
+    }
+
+    // The LEDs are written to the LED strip as one span before the next refresh
+    const uint16_t *physical = &layout->physical[start];
+    int first = layoutDirtyFirst;
+    int end = layoutDirtyEnd;
+    for (int i = 0; i < count; i++)
+    {
+        int index = physical[i];
+        layoutPixels[index] = colors[i];
+        first = index < first ? index : first;
+        end = index >= end ? index + 1 : end;
+    }
+    layoutDirtyFirst = first;
+    layoutDirtyEnd = end;
+}
+
+// Function to read consecutive LEDs back from the LED strip, from their place in the wiring
+static void render_strip_read(int start, struct ledState *states, int count)
+{
+    if (layoutPixels == NULL)
+    {
+        ESP_ERROR_CHECK(led_strip_get_pixels(led_strip, start, (uint8_t *)states, count, LED_STRIP_SRC_FORMAT_RGB));
+        return;
+    }
+    const uint16_t *physical = &layout->physical[start];
+    for (int i = 0; i < count; i++)
+    {
+        states[i] = layoutPixels[physical[i]];
+    }
+}
+
+// Function to refresh the LED strip, once the LEDs remapped by the layout are written to it
+static void render_strip_refresh(void)
+{
+    if (layoutDirtyEnd > layoutDirtyFirst)
+    {
+        ESP_ERROR_CHECK(led_strip_set_pixels(led_strip, layoutDirtyFirst, (const uint8_t *)&layoutPixels[layoutDirtyFirst],
+                                             layoutDirtyEnd - layoutDirtyFirst, LED_STRIP_SRC_FORMAT_RGB));
+        layoutDirtyFirst = CONFIG_LED_COUNT;
+        layoutDirtyEnd = 0;
+    }
+    ESP_ERROR_CHECK(led_strip_refresh(led_strip));
+}
+
+// Function to read consecutive LEDs of the current frame, before the master dimmer
+static void render_read_states(int start, struct ledState *states, int count)
+{
+    if (frameStates != NULL)
+    {
+        memcpy(states, &frameStates[start], count * sizeof(struct ledState));
+    }
+    else
+    {
+        // The LED strip shows the frame as it is
+        render_strip_read(start, states, count);
+    }
+}
+
+// Function to write consecutive LEDs of the frame to the LED strip with the master dimmer applied, the frame hash is not updated
+static void render_write_dimmed(int start, const struct ledState *colors, int count)
+{
+    if (dimmer == 255 || colorLutSupported)
+    {
+        // The dimmer leaves the colors unchanged or is applied by the LED strip driver, so the LED states are written as they are
+        render_strip_write(start, colors, count);
+        return;
+    }
+    struct ledState dimmed[RENDER_SPAN_CHUNK];
+    while (count > 0)
+    {
+        int chunk = count < RENDER_SPAN_CHUNK ? count : RENDER_SPAN_CHUNK;
+        for (int i = 0; i < chunk; i++)
+        {
+            dimmed[i].red = dim(colors[i].red);
+            dimmed[i].green = dim(colors[i].green);
+            dimmed[i].blue = dim(colors[i].blue);
+        }
+        render_strip_write(start, dimmed, chunk);
+        start += chunk;
+        colors += chunk;
+        count -= chunk;
+    }
+}
+
+// Function to set the output levels of consecutive LEDs of the dithered frame
+static void render_dither_write(int start, const struct ledState *colors, int count)
+{
+    uint16_t *level = &ditherFrame[start * 3];
+    for (int i = 0; i < count; i++)
+    {
+        const uint8_t rgb[3] = {colors[i].red, colors[i].green, colors[i].blue};
+        for (int c = 0; c < 3; c++, level++)
+        {
+            ditherFractional -= (*level & 0xFF) != 0;
+            *level = ditherCurve[c][rgb[c]];
+            ditherFractional += (*level & 0xFF) != 0;
+        }
+    }
+}
+
+// Function to write the next dithered frame to the LED strip. Each channel shows the integer part of its level, the
+// fraction adds up in the error accumulator of the channel and shows as one step more whenever it carries over.
+static void render_dither_output(void)
+{
+    struct ledState states[RENDER_SPAN_CHUNK];
+    for (int start = 0; start < CONFIG_LED_COUNT; start += RENDER_SPAN_CHUNK)
+    {
+        int chunk = CONFIG_LED_COUNT - start < RENDER_SPAN_CHUNK ? CONFIG_LED_COUNT - start : RENDER_SPAN_CHUNK;
+        const uint16_t *level = &ditherFrame[start * 3];
+        uint8_t *error = &ditherError[start * 3];
+        uint8_t *rgb = (uint8_t *)states; // In the order of the channels of struct ledState, like the levels
+        for (int i = 0; i < chunk * 3; i++)
+        {
+            uint32_t sum = level[i] + error[i];
+            rgb[i] = sum >> 8;
+            error[i] = sum & 0xFF;
+        }
+        render_strip_write(start, states, chunk);
+    }
+    ditherRefreshedUs = esp_timer_get_time();
+}
+
+// Function to rebuild the output levels of the dithered frame from the color curves and the master dimmer
+static void render_dither_update(void)
+{
+    for (int c = 0; c < 3; c++)
+    {
+        for (int v = 0; v < 256; v++)
+        {
+            ditherCurve[c][v] = ((uint32_t)colorCurve[c][v] * dimmer + 127) / 255;
+        }
+    }
+    render_dither_write(0, frameStates, CONFIG_LED_COUNT);
+}
+
+// Function to set the colors of consecutive LEDs and keep the frame hash up to date
+static void render_write_span(int start, const struct ledState *colors, int count)
+{
+    struct ledState previous[RENDER_SPAN_CHUNK];
+    while (count > 0)
+    {
+        int chunk = count < RENDER_SPAN_CHUNK ? count : RENDER_SPAN_CHUNK;
+        render_read_states(start, previous, chunk);
+        for (int i = 0; i < chunk; i++)
+        {
+            frameHash -= led_state_hash(start + i, &previous[i]);
+            frameHash += led_state_hash(start + i, &colors[i]);
+            powerSum[0] += powerCurve[colors[i].red] - powerCurve[previous[i].red];
+            powerSum[1] += powerCurve[colors[i].green] - powerCurve[previous[i].green];
+            powerSum[2] += powerCurve[colors[i].blue] - powerCurve[previous[i].blue];
+        }
+        if (frameStates != NULL)
+        {
+            memcpy(&frameStates[start], colors, chunk * sizeof(struct ledState));
+        }
+        if (ditherFrame != NULL)
+        {
+            render_dither_write(start, colors, chunk);
+        }
+        else
+        {
+            render_write_dimmed(start, colors, chunk);
+        }
+        start += chunk;
+        colors += chunk;
+        count -= chunk;
+    }
+}
+
+// Function to composite the layers over consecutive LEDs of the base layer, and set them in the frame
+static void render_composite_span(int start, int count)
+{
+    struct ledState colors[RENDER_SPAN_CHUNK];
+    while (count > 0)
+    {
+        int chunk = count < RENDER_SPAN_CHUNK ? count : RENDER_SPAN_CHUNK;
+        memcpy(colors, &baseStates[start], chunk * sizeof(struct ledState));
+        for (int i = 1; i < CONFIG_LED_LAYER_COUNT; i++)
+        {
+            // Only the part of the layer that was drawn on is blended, the rest is transparent
+            const render_layer_t *layer = &layers[i];
+            int first = layer->first > start ? layer->first : start;
+            int end = layer->end < start + chunk ? layer->end : start + chunk;
+            if (layer->pixels != NULL && layer->opacity > 0 && first < end)
+            {
+                led_layer_blend(&colors[first - start], &layer->pixels[first], end - first, layer->opacity, layer->blend);
+            }
+        }
+        render_write_span(start, colors, chunk);
+        start += chunk;
+        count -= chunk;
+    }
+}
+
+// Function to read consecutive LEDs of the base layer
+static void render_read_base(int start, struct ledState *states, int count)
+{
+    if (baseStates != NULL)
+    {
+        memcpy(states, &baseStates[start], count * sizeof(struct ledState));
+    }
+    else
+    {
+        render_read_states(start, states, count);
+    }
+}
+
+// Function to set consecutive LEDs of the base layer, and the frame with the overlays composited over them
+static void render_write_base(int start, const struct ledState *colors, int count)
+{
+    if (baseStates == NULL)
+    {
+        render_write_span(start, colors, count);
+        return;
+    }
+    memcpy(&baseStates[start], colors, count * sizeof(struct ledState));
+    render_composite_span(start, count);
+}
+
+// Function to drop the copy of the base layer once no overlay is in use, the frame is the base layer again
+static void render_layer_release_base(void)
+{
+    for (int i = 1; i < CONFIG_LED_LAYER_COUNT; i++)
+    {
+        if (layers[i].pixels != NULL)
+        {
+            return;
+        }
+    }
+    free(baseStates);
+    baseStates = NULL;
+}
+
+// Function to get an overlay layer ready to draw on, the first overlay in use takes a copy of the base layer
+static bool render_layer_alloc(int index)
+{
+    render_layer_t *layer = &layers[index];
+    if (layer->pixels != NULL)
+    {
+        return true;
+    }
+    if (baseStates == NULL)
+    {
+        baseStates = malloc(CONFIG_LED_COUNT * sizeof(struct ledState));
+        if (baseStates == NULL)
+        {
+            ESP_LOGE(TAG, "No memory for the base layer, layer %d not drawn", index);
+            return false;
+        }
+        render_read_states(0, baseStates, CONFIG_LED_COUNT); // Read from the frame, which is the base layer until now
+    }
+    layer->pixels = calloc(CONFIG_LED_COUNT, sizeof(uint32_t));
+    if (layer->pixels == NULL)
+    {
+        ESP_LOGE(TAG, "No memory for layer %d", index);
+        render_layer_release_base();
+        return false;
+    }
+    layer->first = 0;
+    layer->end = 0;
+    return true;
+}
+
+// Function to add LEDs to the part of an overlay layer that was drawn on, and composite them into the frame
+static void render_layer_drawn(render_layer_t *layer, int first, int end)
+{
+    if (layer->first == layer->end)
+    {
+        layer->first = first;
+        layer->end = end;
+    }
+    else
+    {
+        layer->first = first < layer->first ? first : layer->first;
+        layer->end = end > layer->end ? end : layer->end;
+    }
+    render_composite_span(first, end - first);
+}
+
+// Function to set consecutive LEDs of an overlay layer, fully covering the layers below
+static void render_write_overlay(int index, int start, const struct ledState *colors, int count)
+{
+    uint32_t *pixels = &layers[index].pixels[start];
+    for (int i = 0; i < count; i++)
+    {
+        pixels[i] = LED_LAYER_PIXEL(colors[i].red, colors[i].green, colors[i].blue, 255);
+    }
+    render_layer_drawn(&layers[index], start, start + count);
+}
+
+// Function to make an overlay layer transparent, and free it
+static void render_layer_clear(int index)
+{
+    render_layer_t *layer = &layers[index];
+    if (layer->pixels == NULL)
+    {
+        return;
+    }
+    free(layer->pixels);
+    layer->pixels = NULL;
+    if (layer->first < layer->end)
+    {
+        // The layers below show again where the layer was drawn on
+        render_composite_span(layer->first, layer->end - layer->first);
+    }
+    render_layer_release_base();
+}
+
+// Function to free all overlay layers without compositing, before the whole frame is set
+static void render_layer_reset(void)
+{
+    for (int i = 1; i < CONFIG_LED_LAYER_COUNT; i++)
+    {
+        free(layers[i].pixels);
+        layers[i].pixels = NULL;
+    }
+    free(baseStates);
+    baseStates = NULL;
+}
+
+// Function to rebuild the color curves from the gamma and white balance, the master dimmer then only scales them
+static void render_color_curve_update(void)
+{
+    for (int v = 0; v < 256; v++)
+    {
+        float curve = powf(v / 255.0f, colorGamma) * RENDER_DITHER_LEVEL_MAX / 255.0f;
+        for (int c = 0; c < 4; c++)
+        {
+            colorCurve[c][v] = (uint16_t)(curve * colorGain[c] + 0.5f);
+        }
+    }
+}
+
+// Function to apply the color settings and the master dimmer, through the dithered frame or the color lookup table of the LED strip
+static void render_update_color(void)
+{
+    if (ditherFrame != NULL)
+    {
+        render_dither_update();
+    }
+    else
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            for (int v = 0; v < 256; v++)
+            {
+                colorLut.channel[c][v] = ((uint32_t)colorCurve[c][v] * dimmer + RENDER_DITHER_LEVEL_MAX / 2) / RENDER_DITHER_LEVEL_MAX;
+            }
+        }
+        ESP_ERROR_CHECK(led_strip_set_color_lut(led_strip, &colorLut));
+    }
+    refreshForced = true;
+}
+
+// Function to turn temporal dithering on, the render module takes over the color lookup table of the LED strip
+static void render_dither_start(void)
+{
+    if (frameStates == NULL)
+    {
+        struct ledState *states = malloc(CONFIG_LED_COUNT * sizeof(struct ledState));
+        if (states == NULL)
+        {
+            ESP_LOGE(TAG, "No memory for the dithered frame, dithering stays off");
+            return;
+        }
+        render_read_states(0, states, CONFIG_LED_COUNT); // Read from the LED strip, before the copy is in use
+        frameStates = states;
+    }
+    ditherFrame = malloc(CONFIG_LED_COUNT * 3 * sizeof(uint16_t));
+    ditherError = calloc(CONFIG_LED_COUNT * 3, sizeof(uint8_t));
+    if (ditherFrame == NULL || ditherError == NULL)
+    {
+        ESP_LOGE(TAG, "No memory for the dithered frame, dithering stays off");
+        free(ditherFrame);
+        free(ditherError);
+        ditherFrame = NULL;
+        ditherError = NULL;
+        if (colorLutSupported || dimmer == 255)
+        {
+            free(frameStates);
+            frameStates = NULL;
+        }
+        return;
+    }
+    memset(ditherFrame, 0, CONFIG_LED_COUNT * 3 * sizeof(uint16_t));
+    ditherFractional = 0;
+    if (colorLutSupported)
+    {
+        ESP_ERROR_CHECK(led_strip_set_color_lut(led_strip, NULL));
+    }
+    render_update_color();
+    ESP_ERROR_CHECK(esp_timer_start_periodic(ditherTimer, RENDER_DITHER_PERIOD_US));
+}
+
+// Function to turn temporal dithering off, the LED strip gets the frame as it is again
+static void render_dither_stop(void)
+{
+    esp_timer_stop(ditherTimer);
+    free(ditherFrame);
+    free(ditherError);
+    ditherFrame = NULL;
+    ditherError = NULL;
+    if (colorLutSupported)
+    {
+        render_update_color();
+    }
+    render_write_dimmed(0, frameStates, CONFIG_LED_COUNT);
+    if (colorLutSupported || dimmer == 255)
+    {
+        // The LED strip holds the frame as it is
+        free(frameStates);
+        frameStates = NULL;
+    }
+    refreshForced = true;
+}
+
+// Function to rebuild the power estimate of the color values and sum up the frame again, after a change of the gamma
+static void render_power_update(void)
+{
+    // The gamma only applies with dithering or the color lookup table, otherwise the LED strip gets the colors as they are
+    float gamma = ditherFrame != NULL || colorLutSupported ? colorGamma : 1.0f;
+    for (int v = 0; v < 256; v++)
+    {
+        powerCurve[v] = (uint16_t)(powf(v / 255.0f, gamma) * RENDER_POWER_LEVEL_MAX + 0.5f);
+    }
+
+    struct ledState states[RENDER_SPAN_CHUNK];
+    memset(powerSum, 0, sizeof(powerSum));
+    for (int start = 0; start < CONFIG_LED_COUNT; start += RENDER_SPAN_CHUNK)
+    {
+        int chunk = CONFIG_LED_COUNT - start < RENDER_SPAN_CHUNK ? CONFIG_LED_COUNT - start : RENDER_SPAN_CHUNK;
+        render_read_states(start, states, chunk);
+        for (int i = 0; i < chunk; i++)
+        {
+            powerSum[0] += powerCurve[states[i].red];
+            powerSum[1] += powerCurve[states[i].green];
+            powerSum[2] += powerCurve[states[i].blue];
+        }
+    }
+}
+
+// Function to get the output level of the master dimmer within the power budget, from the running sums of the frame
+static uint8_t render_power_limit(void)
+{
+    // Current of the colors at full level, in units of 1 / (255 * RENDER_POWER_LEVEL_MAX) mA
+    bool balanced = ditherFrame != NULL || colorLutSupported;
+    uint64_t full = 0;
+    for (int c = 0; c < 3; c++)
+    {
+        full += (uint64_t)ledCurrentMa[c] * (balanced ? colorGain[c] : 255) * powerSum[c];
+    }
+
+    // Budget left for the colors once the LEDs are powered, in the units of full multiplied by a level
+    uint64_t budget = CONFIG_LED_POWER_BUDGET_MA > RENDER_POWER_IDLE_MA ? CONFIG_LED_POWER_BUDGET_MA - RENDER_POWER_IDLE_MA : 0;
+    budget *= 255ULL * 255 * RENDER_POWER_LEVEL_MAX;
+
+    uint8_t level = masterDimmer;
+    if (CONFIG_LED_POWER_BUDGET_MA > 0 && full > 0)
+    {
+        // Highest level within the budget. The level is lowered at once with some headroom, but only raised again once
+        // the frame leaves enough room, so it does not follow every small change of an animated frame.
+        uint64_t allowed = budget / full;
+        uint64_t limited = dimmer;
+        if (allowed < dimmer)
+        {
+            limited = allowed > RENDER_POWER_HYSTERESIS ? allowed - RENDER_POWER_HYSTERESIS : 0;
+        }
+        else if (allowed >= dimmer + 2 * RENDER_POWER_HYSTERESIS || allowed >= masterDimmer + RENDER_POWER_HYSTERESIS)
+        {
+            limited = allowed - RENDER_POWER_HYSTERESIS;
+        }
+        level = limited < masterDimmer ? limited : masterDimmer;
+    }
+    stats.power_estimate_ma = RENDER_POWER_IDLE_MA + (uint32_t)(full * level / (255ULL * 255 * RENDER_POWER_LEVEL_MAX));
+    stats.power_scale = masterDimmer > 0 ? level * 255 / masterDimmer : 255;
+    return level;
+}
+
+// Function to set the gamma, white balance and temporal dithering
+static void render_set_color_config(const render_priority_cmd_t *cmd)
+{
+    colorGamma = cmd->gamma;
+    memcpy(colorGain, cmd->white_balance, sizeof(colorGain));
+    render_color_curve_update();
+    if (cmd->dither && ditherFrame == NULL)
+    {
+        render_dither_start();
+    }
+    else if (!cmd->dither && ditherFrame != NULL)
+    {
+        render_dither_stop();
+    }
+    else if (ditherFrame != NULL || colorLutSupported)
+    {
+        render_update_color();
+    }
+    if (ditherFrame == NULL && !colorLutSupported)
+    {
+        ESP_LOGW(TAG, "The LED strip backend has no color lookup table, gamma and white balance only apply with dithering");
+    }
+    render_power_update();
+}
+
+// Function to set the output level, through the color lookup table or by writing the whole frame to the LED strip again
+static void render_set_dimmer(uint8_t level)
+{
+    if (level == dimmer)
+    {
+        return;
+    }
+    if (ditherFrame != NULL || colorLutSupported)
+    {
+        // The frame stays as it is, it is dimmed with the dithered levels or by the LED strip driver when it encodes it
+        dimmer = level;
+        render_update_color();
+        return;
+    }
+    if (level < 255 && frameStates == NULL)
+    {
+        // Keep the undimmed frame, the LED strip will only hold the dimmed one
+        struct ledState *states = malloc(CONFIG_LED_COUNT * sizeof(struct ledState));
+        if (states == NULL)
+        {
+            ESP_LOGE(TAG, "No memory for the undimmed frame, dimmer ignored");
+            return;
+        }
+        render_read_states(0, states, CONFIG_LED_COUNT); // Read from the LED strip, before the copy is in use
+        frameStates = states;
+    }
+    if (frameStates == NULL)
+    {
+        // The dimmer stays at full level
+        return;
+    }
+    dimmer = level;
+    render_write_dimmed(0, frameStates, CONFIG_LED_COUNT);
+    refreshForced = true;
+    if (dimmer == 255)
+    {
+        // The LED strip holds the undimmed frame again
+        free(frameStates);
+        frameStates = NULL;
+    }
+}
+
+// Function to refresh the LED strip, unless it already shows the current frame
+static void render_refresh(void)
+{
+    // Keep the frame within the power budget, the limit only changes the output level, not the frame
+    render_set_dimmer(render_power_limit());
+
+    if (frameHash != refreshedHash || refreshForced)
+    {
+        if (ditherFrame != NULL)
+        {
+            render_dither_output();
+        }
+        render_strip_refresh();
+        refreshedHash = frameHash;
+        refreshForced = false;
+    }
+    else
+    {
+        stats.refresh_skipped++;
+        ESP_LOGD(TAG, "Frame unchanged, refresh skipped");
+    }
+}
+
+// Function to render the next frame of the running effect and draw it on its layer, the caller refreshes the LED strip
+static void render_effect_frame(void)
+{
+    int64_t now = esp_timer_get_time();
+    led_effect_render(&effect, (uint32_t)((now - effectStartUs) / 1000), effectStates);
+    uint32_t renderUs = (uint32_t)(esp_timer_get_time() - now);
+    if (renderUs > stats.effect_render_max_us)
+    {
+        stats.effect_render_max_us = renderUs;
+    }
+    if (effectLayer == 0)
+    {
+        render_write_base(0, effectStates, CONFIG_LED_COUNT);
+    }
+    else
+    {
+        render_write_overlay(effectLayer, 0, effectStates, CONFIG_LED_COUNT);
+    }
+    effectRenderedUs = now;
+    stats.effect_frames++;
+}
+
+// Function to stop the running effect, the LEDs keep its last frame
+static void render_effect_stop(void)
+{
+    if (effect.params.type == LED_EFFECT_NONE)
+    {
+        return;
+    }
+    esp_timer_stop(effectTimer);
+    led_effect_deinit(&effect);
+    free(effectStates);
+    effectStates = NULL;
+}
+
+// Function to start an effect on a layer in place of the running one, and draw its first frame
+static void render_effect_start(const led_effect_params_t *params, uint8_t layer)
+{
+    render_effect_stop();
+    if (params->type == LED_EFFECT_NONE)
+    {
+        return;
+    }
+    // The effect takes the shader program first, so it is freed with the effect on any error
+    esp_err_t err = led_effect_init(&effect, params, CONFIG_LED_COUNT);
+    if (err == ESP_OK)
+    {
+        effectStates = malloc(CONFIG_LED_COUNT * sizeof(struct ledState));
+        err = effectStates != NULL && (layer == 0 || render_layer_alloc(layer)) ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Effect %s not started: %s", led_effect_name(params->type), esp_err_to_name(err));
+        led_effect_deinit(&effect);
+        free(effectStates);
+        effectStates = NULL;
+        return;
+    }
+    effectLayer = layer;
+    effectPeriodUs = 1000000 / (params->fps > 0 ? params->fps : CONFIG_LED_EFFECT_FPS);
+    effectStartUs = esp_timer_get_time();
+    render_effect_frame();
+    ESP_ERROR_CHECK(esp_timer_start_periodic(effectTimer, effectPeriodUs));
+}
+
+// Function to advance the transitions by a number of steps and write the LEDs still in transition. Finished and cancelled
+// transitions are removed, the others keep their order so consecutive LEDs are written as one span. Returns true once
+// no LED is left in transition.
+static bool render_transition_step(uint32_t steps)
+{
+    struct ledState run[RENDER_SPAN_CHUNK];
+    int runStart = 0;
+    int runLength = 0;
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < transitionCount; i++)
+    {
+        render_transition_t *transition = &transitions[i];
+        if (transition->steps == 0)
+        {
+            // Cancelled, the LED was set at once since
+            continue;
+        }
+        if (steps > 0)
+        {
+            struct ledState color = transition->target;
+            if (transition->steps <= steps)
+            {
+                // Last step, the LED gets the exact target color
+                transition->steps = 0;
+                transitionSlot[transition->index] = RENDER_TRANSITION_NONE;
+            }
+            else
+            {
+                transition->steps -= steps;
+                for (int c = 0; c < 3; c++)
+                {
+                    transition->level[c] += transition->delta[c] * (int32_t)steps;
+                }
+                color.red = (transition->level[0] + 0x8000) >> 16;
+                color.green = (transition->level[1] + 0x8000) >> 16;
+                color.blue = (transition->level[2] + 0x8000) >> 16;
+            }
+            if (runLength > 0 && (transition->index != runStart + runLength || runLength == RENDER_SPAN_CHUNK))
+            {
+                render_write_base(runStart, run, runLength);
+                runLength = 0;
+            }
+            if (runLength == 0)
+            {
+                runStart = transition->index;
+            }
+            run[runLength++] = color;
+        }
+        if (transition->steps > 0)
+        {
+            transitionSlot[transition->index] = kept;
+            transitions[kept++] = *transition;
+        }
+    }
+    if (runLength > 0)
+    {
+        render_write_base(runStart, run, runLength);
+    }
+    transitionCount = kept;
+    return transitionCount == 0;
+}
+
+// Function to stop all transitions, the LEDs keep their current color
+static void render_transition_stop(void)
+{
+    if (transitions == NULL)
+    {
+        return;
+    }
+    esp_timer_stop(transitionTimer);
+    free(transitions);
+    free(transitionSlot);
+    transitions = NULL;
+    transitionSlot = NULL;
+    transitionCount = 0;
+}
+
+// Function to cancel the transition of an LED, before it is set at once
+static void render_transition_cancel(uint16_t index)
+{
+    if (transitions != NULL && transitionSlot[index] != RENDER_TRANSITION_NONE)
+    {
+        transitions[transitionSlot[index]].steps = 0;
+        transitionSlot[index] = RENDER_TRANSITION_NONE;
+    }
+}
+
+// Function to start the fade of the LEDs of a frame from their current color, returns false if there is no memory for it
+static bool render_transition_start(const render_frame_t *frame)
+{
+    if (transitions == NULL)
+    {
+        transitions = malloc(CONFIG_LED_COUNT * sizeof(render_transition_t));
+        transitionSlot = malloc(CONFIG_LED_COUNT * sizeof(uint16_t));
+        if (transitions == NULL || transitionSlot == NULL)
+        {
+            ESP_LOGE(TAG, "No memory for the transition, the LEDs are set at once");
+            free(transitions);
+            free(transitionSlot);
+            transitions = NULL;
+            transitionSlot = NULL;
+            return false;
+        }
+        memset(transitionSlot, 0xFF, CONFIG_LED_COUNT * sizeof(uint16_t));
+        transitionCount = 0;
+        transitionSteppedUs = esp_timer_get_time();
+        ESP_ERROR_CHECK(esp_timer_start_periodic(transitionTimer, RENDER_TRANSITION_PERIOD_US));
+    }
+
+    uint64_t steps = ((uint64_t)frame->transition_ms * 1000 + RENDER_TRANSITION_PERIOD_US / 2) / RENDER_TRANSITION_PERIOD_US;
+    steps = steps < 1 ? 1 : steps > UINT16_MAX ? UINT16_MAX : steps;
+    for (uint32_t i = 0; i < frame->count; i++)
+    {
+        const render_pixel_t *pixel = &frame->pixels[i];
+        render_transition_t *transition;
+        if (transitionSlot[pixel->index] != RENDER_TRANSITION_NONE)
+        {
+            // Already in transition, the new fade starts from where the LED is now
+            transition = &transitions[transitionSlot[pixel->index]];
+        }
+        else
+        {
+            struct ledState current;
+            render_read_base(pixel->index, &current, 1);
+            if (memcmp(&current, &pixel->color, sizeof(current)) == 0)
+            {
+                continue;
+            }
+            if (transitionCount == CONFIG_LED_COUNT)
+            {
+                // Remove the cancelled transitions to make room
+                render_transition_step(0);
+            }
+            transitionSlot[pixel->index] = transitionCount;
+            transition = &transitions[transitionCount++];
+            transition->index = pixel->index;
+            transition->level[0] = (uint32_t)current.red << 16;
+            transition->level[1] = (uint32_t)current.green << 16;
+            transition->level[2] = (uint32_t)current.blue << 16;
+        }
+        transition->target = pixel->color;
+        transition->steps = steps;
+        const uint8_t target[3] = {pixel->color.red, pixel->color.green, pixel->color.blue};
+        for (int c = 0; c < 3; c++)
+        {
+            transition->delta[c] = ((int32_t)((uint32_t)target[c] << 16) - (int32_t)transition->level[c]) / (int32_t)steps;
+        }
+    }
+    return true;
+}
+
+// Function to set the opacity and blend mode of an overlay layer, or clear it
+static void render_set_layer(const render_priority_cmd_t *cmd)
+{
+    render_layer_t *layer = &layers[cmd->layer];
+    layer->opacity = cmd->opacity;
+    layer->blend = cmd->blend;
+    if (cmd->clear)
+    {
+        if (effect.params.type != LED_EFFECT_NONE && effectLayer == cmd->layer)
+        {
+            // The layer is cleared from under the effect drawing on it
+            render_effect_stop();
+        }
+        render_layer_clear(cmd->layer);
+    }
+    else if (layer->pixels != NULL && layer->first < layer->end)
+    {
+        render_composite_span(layer->first, layer->end - layer->first);
+    }
+}
+
+// Function to address the LEDs in the order of a new layout, the frame keeps its colors in the order of the commands
+static void render_set_layout(led_layout_t *newLayout)
+{
+    bool remap = newLayout != NULL && !newLayout->wiring_order;
+    struct ledState *states = frameStates;
+    struct ledState *pixels = remap ? layoutPixels : NULL;
+    if (states == NULL)
+    {
+        states = malloc(CONFIG_LED_COUNT * sizeof(struct ledState));
+    }
+    if (remap && pixels == NULL)
+    {
+        pixels = malloc(CONFIG_LED_COUNT * sizeof(struct ledState));
+    }
+    if (states == NULL || (remap && pixels == NULL))
+    {
+        ESP_LOGE(TAG, "No memory to remap the LEDs, layout ignored");
+        if (states != frameStates)
+        {
+            free(states);
+        }
+        if (pixels != layoutPixels)
+        {
+            free(pixels);
+        }
+        led_layout_free(newLayout);
+        return;
+    }
+
+    // Read the frame through the current layout, then write all of it again through the new one
+    if (states != frameStates)
+    {
+        render_strip_read(0, states, CONFIG_LED_COUNT);
+    }
+    if (pixels != layoutPixels)
+    {
+        free(layoutPixels);
+    }
+    led_layout_free(layout);
+    layout = newLayout;
+    layoutPixels = pixels;
+    layoutDirtyFirst = CONFIG_LED_COUNT;
+    layoutDirtyEnd = 0;
+    if (ditherFrame == NULL)
+    {
+        // The dithered frame is written in full at every refresh
+        render_write_dimmed(0, states, CONFIG_LED_COUNT);
+    }
+    if (states != frameStates)
+    {
+        free(states);
+    }
+    refreshForced = true;
+}
+
+// Function to drop all frames pending on the normal lane and in the jitter buffer
+static void render_flush_frames(void)
+{
+    render_frame_t *frame;
+    while (xQueueReceive(frameQueue, &frame, 0) == pdTRUE)
+    {
+        free(frame);
+        stats.frames_flushed++;
+    }
+    while (jitterDepth > 0)
+    {
+        free(jitterBuffer[--jitterDepth]);
+        stats.frames_flushed++;
+    }
+    stats.jitter_depth = 0;
+}
+
+// Function to execute a command of the priority lane
+static void render_execute_priority(const render_priority_cmd_t *cmd)
+{
+    switch (cmd->type)
+    {
+    case RENDER_PRIORITY_BLACKOUT:
+        render_flush_frames();
+        render_effect_stop();
+        render_transition_stop();
+        render_layer_reset();
+        if (frameStates != NULL)
+        {
+            memset(frameStates, 0, CONFIG_LED_COUNT * sizeof(struct ledState));
+        }
+        if (ditherFrame != NULL)
+        {
+            memset(ditherFrame, 0, CONFIG_LED_COUNT * 3 * sizeof(uint16_t));
+            ditherFractional = 0;
+        }
+        if (layoutPixels != NULL)
+        {
+            memset(layoutPixels, 0, CONFIG_LED_COUNT * sizeof(struct ledState));
+        }
+        ESP_ERROR_CHECK(led_strip_fill(led_strip, 0, CONFIG_LED_COUNT, 0, 0, 0));
+        frameHash = blackHash;
+        memset(powerSum, 0, sizeof(powerSum));
+        break;
+    case RENDER_PRIORITY_DIMMER:
+        masterDimmer = cmd->value;
+        break;
+    case RENDER_PRIORITY_SCENE_STORE:
+        if (scenes[cmd->value] == NULL)
+        {
+            scenes[cmd->value] = malloc(CONFIG_LED_COUNT * sizeof(struct ledState));
+        }
+        if (scenes[cmd->value] != NULL)
+        {
+            render_read_base(0, scenes[cmd->value], CONFIG_LED_COUNT);
+        }
+        else
+        {
+            ESP_LOGE(TAG, "No memory for scene %d", cmd->value);
+        }
+        break;
+    case RENDER_PRIORITY_SCENE_RECALL:
+        render_flush_frames();
+        if (effectLayer == 0)
+        {
+            render_effect_stop();
+        }
+        render_transition_stop();
+        if (scenes[cmd->value] != NULL)
+        {
+            // The scene is the base layer, the overlays stay over it
+            render_write_base(0, scenes[cmd->value], CONFIG_LED_COUNT);
+        }
+        else
+        {
+            ESP_LOGW(TAG, "Scene %d is empty", cmd->value);
+        }
+        break;
+    case RENDER_PRIORITY_COLOR_CONFIG:
+        render_set_color_config(cmd);
+        break;
+    case RENDER_PRIORITY_EFFECT:
+        if (cmd->layer == 0)
+        {
+            render_transition_stop();
+        }
+        render_effect_start(&cmd->effect, cmd->layer);
+        break;
+    case RENDER_PRIORITY_LAYER:
+        render_set_layer(cmd);
+        break;
+    case RENDER_PRIORITY_LAYOUT:
+        render_set_layout(cmd->layout);
+        layoutGeneration = cmd->layout_generation;
+        break;
+    }
+    render_refresh();
+
+    // Measure the time from the reception of the command to the refresh of the LED strip
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - cmd->received_us);
+    if (latency > stats.priority_latency_max_us)
+    {
+        stats.priority_latency_max_us = latency;
+    }
+    stats.priority_commands++;
+    ESP_LOGD(TAG, "Priority command %d executed after %" PRIu32 " us", cmd->type, latency);
+}
+
+// Function to draw the LEDs of a frame on an overlay layer, and composite the LEDs it changed into the frame
+static void render_draw_overlay(const render_frame_t *frame)
+{
+    if (frame->count == 0 || !render_layer_alloc(frame->layer))
+    {
+        return;
+    }
+    render_layer_t *layer = &layers[frame->layer];
+    int first = CONFIG_LED_COUNT;
+    int end = 0;
+    for (uint32_t i = 0; i < frame->count; i++)
+    {
+        const render_pixel_t *pixel = &frame->pixels[i];
+        layer->pixels[pixel->index] = LED_LAYER_PIXEL(pixel->color.red, pixel->color.green, pixel->color.blue, pixel->alpha);
+        first = pixel->index < first ? pixel->index : first;
+        end = pixel->index >= end ? pixel->index + 1 : end;
+    }
+    render_layer_drawn(layer, first, end);
+}
+
+// Function to apply a frame of the normal lane
+static void render_apply_frame(render_frame_t *frame)
+{
+    if (frame->layout != layoutGeneration)
+    {
+        // Numbered in the layout before the current one
+        stats.frames_flushed++;
+        return;
+    }
+
+    // The LED command takes over the layer from the effect running on it
+    if (effectLayer == frame->layer)
+    {
+        render_effect_stop();
+    }
+
+    if (frame->layer > 0)
+    {
+        // Overlays are drawn at once, only the base layer has transitions
+        render_draw_overlay(frame);
+        render_refresh();
+        stats.frames_rendered++;
+        return;
+    }
+
+    if (frame->transition_ms > 0 && render_transition_start(frame))
+    {
+        // The LEDs fade to the colors of the frame, written by the render task at the transition frame rate
+        stats.frames_rendered++;
+        return;
+    }
+
+    // Runs of consecutive LED numbers, e.g. a whole strip sent in order, are written to the LED strip as one span
+    struct ledState run[RENDER_SPAN_CHUNK];
+    int runLength = 0;
+    for (uint32_t i = 0; i < frame->count; i++)
+    {
+        render_transition_cancel(frame->pixels[i].index);
+        run[runLength++] = frame->pixels[i].color;
+        if (i + 1 == frame->count || frame->pixels[i + 1].index != frame->pixels[i].index + 1 || runLength == RENDER_SPAN_CHUNK)
+        {
+            render_write_base(frame->pixels[i].index + 1 - runLength, run, runLength);
+            runLength = 0;
+        }
+    }
+    render_refresh();
+    stats.frames_rendered++;
+}
+
+// Function to update the mapping of the sender clock to the local clock with a timed frame
+static int64_t render_clock_offset(const render_frame_t *frame)
+{
+    int64_t transit = frame->received_us - frame->pts_us;
+
+    if (!clockValid || frame->received_us - clockLastReceived > RENDER_CLOCK_RESET_US)
+    {
+        // New stream, the sender may have restarted its clock
+        clockValid = true;
+        clockMinCurrent = transit;
+        clockMinPrevious = transit;
+        clockWindowStart = frame->received_us;
+    }
+    else if (frame->received_us - clockWindowStart > RENDER_CLOCK_WINDOW_US)
+    {
+        // Forget old minimums, so the mapping follows a drift between both clocks
+        clockMinPrevious = clockMinCurrent;
+        clockMinCurrent = transit;
+        clockWindowStart = frame->received_us;
+    }
+    else if (transit < clockMinCurrent)
+    {
+        clockMinCurrent = transit;
+    }
+    clockLastReceived = frame->received_us;
+
+    return clockMinCurrent < clockMinPrevious ? clockMinCurrent : clockMinPrevious;
+}
+
+// Function to arm the playout timer for the first frame of the jitter buffer
+static void render_arm_playout_timer(void)
+{
+    esp_timer_stop(playoutTimer);
+    if (jitterDepth > 0)
+    {
+        int64_t delay = jitterBuffer[0]->play_at_us - esp_timer_get_time();
+        ESP_ERROR_CHECK(esp_timer_start_once(playoutTimer, delay > 0 ? delay : 0));
+    }
+}
+
+// Function to schedule a timed frame in the jitter buffer
+static void render_schedule_frame(render_frame_t *frame)
+{
+    frame->play_at_us = frame->pts_us + render_clock_offset(frame) + RENDER_JITTER_DELAY_US;
+    if (frame->play_at_us < frame->received_us)
+    {
+        // The frame arrived after its playout time, showing it now would distort the motion
+        if (jitterDepth == 0)
+        {
+            // Nothing was left to show when the frame was due, the stream stalled. The first frame of a stream is
+            // never late, so this is not the end of a stream.
+            stats.jitter_underruns++;
+        }
+        free(frame);
+        stats.jitter_late_drops++;
+        return;
+    }
+
+    if (jitterDepth == CONFIG_LED_JITTER_BUFFER_LENGTH)
+    {
+        // The jitter buffer is full, latch the first frame early to make room
+        render_frame_t *first = jitterBuffer[0];
+        memmove(&jitterBuffer[0], &jitterBuffer[1], --jitterDepth * sizeof(jitterBuffer[0]));
+        render_apply_frame(first);
+        free(first);
+    }
+
+    // Insert the frame sorted by playout time, frames usually arrive in order so the search starts at the end
+    uint32_t i = jitterDepth;
+    while (i > 0 && jitterBuffer[i - 1]->play_at_us > frame->play_at_us)
+    {
+        jitterBuffer[i] = jitterBuffer[i - 1];
+        i--;
+    }
+    jitterBuffer[i] = frame;
+    jitterDepth++;
+    stats.jitter_depth = jitterDepth;
+}
+
+// Function to latch the frames of the jitter buffer whose playout time has come, returns the number of frames latched
+static uint32_t render_play_due_frames(void)
+{
+    uint32_t due = 0;
+    int64_t now = esp_timer_get_time();
+
+    while (due < jitterDepth && jitterBuffer[due]->play_at_us <= now)
+    {
+        render_apply_frame(jitterBuffer[due]);
+        free(jitterBuffer[due]);
+        due++;
+    }
+    if (due > 0)
+    {
+        jitterDepth -= due;
+        memmove(&jitterBuffer[0], &jitterBuffer[due], jitterDepth * sizeof(jitterBuffer[0]));
+        stats.jitter_depth = jitterDepth;
+    }
+    return due;
+}
+
+// Function to wake the render task from the playout, dithering, effect and transition timers
+static void render_timer_cb(void *arg)
+{
+    xTaskNotifyGive(renderTask);
+}
+
+/**
+ * @brief Render task
+ *
+ * The task sleeps until a command is queued on one of the lanes. The priority lane is drained before every frame
+ * of the normal lane, so a priority command waits at most for the frame being rendered when it arrives.
+ * Timed frames go to the jitter buffer instead, and the playout timer wakes the task when the first of them is due.
+ * The frame callback is invoked once no more work is pending, so bursts of frames result in a single state publish.
+ * While dithering, the dithering timer also wakes the task to refresh the LED strip with the next dithered frame.
+ * While an effect runs, the effect timer wakes the task to render its next frame. The frame callback is not invoked
+ * for these frames, so the state is only published when the effect starts and not at its frame rate.
+ * While LEDs are in transition, the transition timer wakes the task to move them one step closer to their color.
+ * The state is published once the last transition ended.
+ *
+ * @param arg Unused.
+ */
+static void render_task(void *arg)
+{
+    render_priority_cmd_t cmd;
+    render_frame_t *frame;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        bool rendered = false;
+        while (true)
+        {
+            while (xQueueReceive(priorityQueue, &cmd, 0) == pdTRUE)
+            {
+                render_execute_priority(&cmd);
+                rendered = true;
+            }
+            if (render_play_due_frames() > 0)
+            {
+                rendered = true;
+            }
+            if (xQueueReceive(frameQueue, &frame, 0) != pdTRUE)
+            {
+                break;
+            }
+            rendered = true;
+            if (frame->timed)
+            {
+                render_schedule_frame(frame);
+            }
+            else
+            {
+                render_apply_frame(frame);
+                free(frame);
+            }
+        }
+        render_arm_playout_timer();
+
+        // Show the next frame of the running effect, unless it was just started
+        if (effect.params.type != LED_EFFECT_NONE && esp_timer_get_time() - effectRenderedUs >= effectPeriodUs / 2)
+        {
+            render_effect_frame();
+            render_refresh();
+        }
+
+        // Move the LEDs in transition by the steps due since the last one, usually one
+        if (transitions != NULL)
+        {
+            int64_t due = (esp_timer_get_time() - transitionSteppedUs) / RENDER_TRANSITION_PERIOD_US;
+            if (due > 0)
+            {
+                transitionSteppedUs += due * RENDER_TRANSITION_PERIOD_US;
+                if (render_transition_step(due > UINT16_MAX ? UINT16_MAX : (uint32_t)due))
+                {
+                    render_transition_stop();
+                    rendered = true;
+                }
+                render_refresh();
+            }
+        }
+
+        // Show the next dithered frame, unless a frame was just sent or all levels are whole steps
+        if (ditherFrame != NULL && ditherFractional > 0 && esp_timer_get_time() - ditherRefreshedUs >= RENDER_DITHER_PERIOD_US / 2)
+        {
+            render_dither_output();
+            render_strip_refresh();
+        }
+
+        // Share the statistics and the frame hash, and get the callback registered by the other tasks
+        taskENTER_CRITICAL(&sharedLock);
+        sharedStats = stats;
+        sharedHash = frameHash;
+        render_frame_cb_t callback = frameCallback;
+        void *callbackArg = frameCallbackArg;
+        bool pending = frameCallbackPending;
+        frameCallbackPending = false;
+        taskEXIT_CRITICAL(&sharedLock);
+
+        if ((rendered || pending) && callback != NULL)
+        {
+            callback(callbackArg);
+        }
+    }
+}
+
+/**
+ * @brief Starts the render task.
+ *
+ * @param strip The handle to the LED strip, which must have been cleared.
+ */
+void render_start(led_strip_handle_t strip)
+{
+    led_strip = strip;
+
+    // The LED strip was cleared at startup, so it already shows the initial black frame
+    const struct ledState black = {0};
+    blackHash = 0;
+    for (int i = 0; i < CONFIG_LED_COUNT; i++)
+    {
+        blackHash += led_state_hash(i, &black);
+    }
+    frameHash = blackHash;
+    refreshedHash = frameHash;
+    render_power_update();
+    stats.power_estimate_ma = RENDER_POWER_IDLE_MA;
+    stats.power_scale = 255;
+    sharedStats = stats;
+    sharedHash = frameHash;
+
+    // Start with the colors sent as they are, the color config arrives over MQTT
+    render_color_curve_update();
+    ESP_ERROR_CHECK(led_strip_color_lut_init(&colorLut, colorGamma, colorGain, dimmer));
+    esp_err_t err = led_strip_set_color_lut(led_strip, &colorLut);
+    if (err == ESP_ERR_NOT_SUPPORTED)
+    {
+        ESP_LOGW(TAG, "The LED strip backend has no color lookup table, the master dimmer rewrites the frame");
+    }
+    else
+    {
+        ESP_ERROR_CHECK(err);
+        colorLutSupported = true;
+    }
+
+    const esp_timer_create_args_t playoutTimerArgs = {
+        .callback = render_timer_cb,
+        .name = "render_playout",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&playoutTimerArgs, &playoutTimer));
+    const esp_timer_create_args_t ditherTimerArgs = {
+        .callback = render_timer_cb,
+        .name = "render_dither",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&ditherTimerArgs, &ditherTimer));
+    const esp_timer_create_args_t effectTimerArgs = {
+        .callback = render_timer_cb,
+        .name = "render_effect",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&effectTimerArgs, &effectTimer));
+    const esp_timer_create_args_t transitionTimerArgs = {
+        .callback = render_timer_cb,
+        .name = "render_transition",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&transitionTimerArgs, &transitionTimer));
+
+    // Overlay layers cover the layers below until a layer command sets their opacity and blend mode
+    for (int i = 1; i < CONFIG_LED_LAYER_COUNT; i++)
+    {
+        layers[i].opacity = 255;
+        layers[i].blend = LED_LAYER_BLEND_OVER;
+    }
+
+    frameQueue = xQueueCreate(CONFIG_LED_FRAME_QUEUE_LENGTH, sizeof(render_frame_t *));
+    priorityQueue = xQueueCreate(CONFIG_LED_PRIORITY_QUEUE_LENGTH, sizeof(render_priority_cmd_t));
+    if (frameQueue == NULL || priorityQueue == NULL ||
+        xTaskCreate(render_task, "render", RENDER_TASK_STACK_SIZE, NULL, RENDER_TASK_PRIORITY, &renderTask) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to start the render task");
+        abort();
+    }
+
+    if (RENDER_DITHER_DEFAULT)
+    {
+        // Dithering is turned on by the render task, as if the color config had been received
+        const render_priority_cmd_t ditherCmd = {
+            .type = RENDER_PRIORITY_COLOR_CONFIG,
+            .gamma = colorGamma,
+            .white_balance = {255, 255, 255, 255},
+            .dither = true,
+            .received_us = esp_timer_get_time(),
+        };
+        ESP_ERROR_CHECK(render_submit_priority(&ditherCmd));
+    }
+}
+
+/**
+ * @brief Registers the callback invoked by the render task after rendering the queued commands.
+ *
+ * The render task also invokes it once after it is registered, so the callback gets the current frame.
+ *
+ * @param cb The callback function.
+ * @param arg The argument passed to the callback.
+ */
+void render_set_frame_callback(render_frame_cb_t cb, void *arg)
+{
+    taskENTER_CRITICAL(&sharedLock);
+    frameCallback = cb;
+    frameCallbackArg = arg;
+    frameCallbackPending = true;
+    taskEXIT_CRITICAL(&sharedLock);
+    xTaskNotifyGive(renderTask);
+}
+
+/**
+ * @brief Allocates a frame for the normal lane, its LEDs are numbered in the last layout queued.
+ *
+ * @param count The number of LED updates of the frame.
+ * @return The frame, or NULL if out of memory.
+ */
+render_frame_t *render_frame_alloc(uint32_t count)
+{
+    render_frame_t *frame = malloc(sizeof(render_frame_t) + count * sizeof(render_pixel_t));
+    if (frame != NULL)
+    {
+        frame->timed = false;
+        frame->transition_ms = 0;
+        frame->layer = 0;
+        frame->layout = layoutQueued;
+        frame->count = 0;
+    }
+    return frame;
+}
+
+/**
+ * @brief Queues a frame on the normal lane.
+ *
+ * The function never blocks: if the normal lane is full, the oldest pending frame is dropped,
+ * so the caller (the MQTT task) can always go on receiving priority commands.
+ *
+ * @param frame The frame, the render module takes ownership of it.
+ * @return ESP_OK, or ESP_FAIL if the frame could not be queued.
+ */
+esp_err_t render_submit_frame(render_frame_t *frame)
+{
+    if (xQueueSend(frameQueue, &frame, 0) != pdTRUE)
+    {
+        render_frame_t *oldest;
+        if (xQueueReceive(frameQueue, &oldest, 0) == pdTRUE)
+        {
+            free(oldest);
+            taskENTER_CRITICAL(&sharedLock);
+            framesDropped++;
+            taskEXIT_CRITICAL(&sharedLock);
+        }
+        if (xQueueSend(frameQueue, &frame, 0) != pdTRUE)
+        {
+            free(frame);
+            taskENTER_CRITICAL(&sharedLock);
+            framesDropped++;
+            taskEXIT_CRITICAL(&sharedLock);
+            return ESP_FAIL;
+        }
+    }
+    xTaskNotifyGive(renderTask);
+    return ESP_OK;
+}
+
+/**
+ * @brief Queues a command on the priority lane.
+ *
+ * @note The render task takes the shader program of an effect command and the layout of a layout command once they are
+ *       queued, the caller frees them otherwise.
+ *
+ * @param cmd The command.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for an invalid scene slot or layer, or ESP_FAIL if the priority lane is full.
+ */
+esp_err_t render_submit_priority(const render_priority_cmd_t *cmd)
+{
+    if ((cmd->type == RENDER_PRIORITY_SCENE_STORE || cmd->type == RENDER_PRIORITY_SCENE_RECALL) && cmd->value >= CONFIG_LED_SCENE_COUNT)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if ((cmd->type == RENDER_PRIORITY_EFFECT && cmd->layer >= CONFIG_LED_LAYER_COUNT) ||
+        (cmd->type == RENDER_PRIORITY_LAYER && (cmd->layer == 0 || cmd->layer >= CONFIG_LED_LAYER_COUNT || cmd->blend >= LED_LAYER_BLEND_COUNT)))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (cmd->type == RENDER_PRIORITY_LAYOUT)
+    {
+        // The frames queued from now on are numbered in the new layout
+        render_priority_cmd_t layoutCmd = *cmd;
+        layoutCmd.layout_generation = layoutQueued + 1;
+        if (xQueueSend(priorityQueue, &layoutCmd, 0) != pdTRUE)
+        {
+            return ESP_FAIL;
+        }
+        layoutQueued++;
+    }
+    else if (xQueueSend(priorityQueue, cmd, 0) != pdTRUE)
+    {
+        return ESP_FAIL;
+    }
+    xTaskNotifyGive(renderTask);
+    return ESP_OK;
+}
+
+/**
+ * @brief Reads consecutive LEDs of the current frame.
+ *
+ * @note The frame is written by the render task, call this function from the frame callback.
+ *
+ * @param start The first LED to read.
+ * @param[out] states The color of each LED, before the master dimmer.
+ * @param count The number of LEDs to read.
+ */
+void render_read_led_states(int start, struct ledState *states, int count)
+{
+    render_read_states(start, states, count);
+}
+
+/**
+ * @brief Gets the rolling hash of the current frame, as of the last pass of the render task.
+ *
+ * @return The hash.
+ */
+uint32_t render_get_frame_hash(void)
+{
+    taskENTER_CRITICAL(&sharedLock);
+    uint32_t hash = sharedHash;
+    taskEXIT_CRITICAL(&sharedLock);
+    return hash;
+}
+
+/**
+ * @brief Gets the render statistics, as of the last pass of the render task.
+ *
+ * @param[out] out The statistics.
+ */
+void render_get_stats(render_stats_t *out)
+{
+    taskENTER_CRITICAL(&sharedLock);
+    *out = sharedStats;
+    out->frames_dropped = framesDropped;
+    taskEXIT_CRITICAL(&sharedLock);
+    out->stack_free = uxTaskGetStackHighWaterMark(renderTask);
+}
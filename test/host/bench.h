@@ -0,0 +1,26 @@
+/**
+ * @file bench.h
+ * @brief Helpers of the host benchmarks: a monotonic clock, and barriers that keep the compiler from optimizing the
+ * measured loops away.
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+#include <stdint.h>
+#include <time.h>
+
+// Keeps the stores of the measured loop, as if the memory were read after it
+#define BENCH_CLOBBER() __asm__ volatile("" ::: "memory")
+
+// Hides a value from the compiler, so a loop on a constant input is not folded
+#define BENCH_OPAQUE(x) ({ __typeof__(x) opaque_ = (x); __asm__ volatile("" : "+r"(opaque_)); opaque_; })
+
+// Current time of the monotonic clock, in ns
+static inline int64_t bench_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+#endif /* BENCH_H_ */
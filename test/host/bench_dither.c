@@ -0,0 +1,89 @@
+/**
+ * @file bench_dither.c
+ * @brief Host benchmark of the temporal dithering of the render module, in us per frame of CONFIG_LED_COUNT LEDs (the
+ * build sets 300 or 600): writing a frame without dithering, writing it with dithering (the 8.8 levels are rebuilt
+ * in place of the strip write), the level rebuild alone, and the dithering pass of a refresh. The render module is built into the benchmark to
+ * reach its internal functions, over the RMT backend with the mock driver; the refresh and the encoding of the RMT
+ * symbols are not part of the timings.
+ */
+
+#include "render_handler.c" // Render module, with its internal functions
+
+#include "bench.h"     // Benchmark helpers
+#include "rmt_mock.h"  // RMT mock
+#include "rtos_mock.h" // RTOS mock
+
+#define BENCH_ROUNDS 20000
+
+static struct ledState frames[2][CONFIG_LED_COUNT];
+
+// Function to time the write of whole frames through the render module, in us per frame
+static double bench_write(void)
+{
+    int64_t start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        render_write_span(0, frames[r & 1], CONFIG_LED_COUNT);
+        BENCH_CLOBBER();
+    }
+    return (double)(bench_now_ns() - start) / BENCH_ROUNDS / 1000;
+}
+
+int main(void)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = CONFIG_LED_COUNT,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+    };
+    led_strip_rmt_config_t rmtConfig = {0};
+    led_strip_handle_t strip;
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfig, &strip));
+    render_start(strip);
+    for (int i = 0; i < CONFIG_LED_COUNT * 3; i++)
+    {
+        ((uint8_t *)frames[0])[i] = rand();
+        ((uint8_t *)frames[1])[i] = rand();
+    }
+
+    render_priority_cmd_t colorConfig = {
+        .type = RENDER_PRIORITY_COLOR_CONFIG,
+        .gamma = 2.2f,
+        .white_balance = {255, 255, 255, 255},
+        .dither = false,
+    };
+    render_execute_priority(&colorConfig);
+    double plain = bench_write();
+
+    colorConfig.dither = true;
+    render_execute_priority(&colorConfig);
+    int failed = ditherFrame == NULL;
+    double levels = bench_write();
+
+    int64_t start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        render_dither_write(0, frames[r & 1], CONFIG_LED_COUNT);
+        BENCH_CLOBBER();
+    }
+    double rebuild = (double)(bench_now_ns() - start) / BENCH_ROUNDS / 1000;
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        render_dither_output();
+        BENCH_CLOBBER();
+    }
+    double pass = (double)(bench_now_ns() - start) / BENCH_ROUNDS / 1000;
+
+    printf("Dithering, %d LEDs, us per frame:\n", CONFIG_LED_COUNT);
+    printf("  frame write, plain     %6.2f\n", plain);
+    printf("  frame write, dithered  %6.2f\n", levels);
+    printf("  level rebuild          %6.2f\n", rebuild);
+    printf("  dither pass            %6.2f\n", pass);
+    if (failed)
+    {
+        printf("FAIL: the color config did not turn dithering on\n");
+    }
+    return failed;
+}
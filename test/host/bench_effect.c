@@ -0,0 +1,62 @@
+/**
+ * @file bench_effect.c
+ * @brief Host benchmark of the effects rendered on the device, in us per frame of CONFIG_LED_COUNT LEDs (the build sets
+ * 300 or 600): each effect of the effect command renders frames 20 ms apart, the shader effect with a rainbow program.
+ */
+
+#include <stdio.h>  // Standard input/output functions
+#include <stdint.h> // Standard integer types
+
+#include "bench.h"          // Benchmark helpers
+#include "sdkconfig.h"      // Configuration
+#include "render_handler.h" // LED state
+#include "led_effect.h"     // LED effect functions
+#include "led_shader.h"     // LED shader functions
+
+#define BENCH_ROUNDS 5000
+#define BENCH_FRAME_MS 20
+
+// Shader of the shader effect: a rainbow moving along the strip, one cycle per second
+static const uint8_t RainbowShader[] = {
+    LED_SHADER_OP_POS,
+    LED_SHADER_OP_TIME,
+    LED_SHADER_OP_ADD,
+    LED_SHADER_OP_PUSH, 0x00, 0x01,
+    LED_SHADER_OP_PUSH, 0x00, 0x01,
+    LED_SHADER_OP_HSV,
+};
+
+static struct ledState states[CONFIG_LED_COUNT];
+
+int main(void)
+{
+    printf("Effects, %d LEDs, us per frame:\n", CONFIG_LED_COUNT);
+    for (led_effect_type_t type = LED_EFFECT_NONE + 1; type < LED_EFFECT_COUNT; type++)
+    {
+        led_effect_params_t params = {
+            .type = type,
+            .colors = {{250, 40, 10}, {5, 20, 200}},
+            .period_ms = 1700,
+            .size = 37,
+            .density = 64,
+            .seed = 7,
+        };
+        if (type == LED_EFFECT_SHADER)
+        {
+            ESP_ERROR_CHECK(led_shader_load(RainbowShader, sizeof(RainbowShader), CONFIG_LED_SHADER_BUDGET, &params.shader));
+        }
+        led_effect_t effect;
+        ESP_ERROR_CHECK(led_effect_init(&effect, &params, CONFIG_LED_COUNT));
+
+        int64_t start = bench_now_ns();
+        for (int r = 0; r < BENCH_ROUNDS; r++)
+        {
+            led_effect_render(&effect, BENCH_OPAQUE(r * BENCH_FRAME_MS), states);
+            BENCH_CLOBBER();
+        }
+        double perFrame = (double)(bench_now_ns() - start) / BENCH_ROUNDS / 1000;
+        led_effect_deinit(&effect);
+        printf("  %-10s %8.2f\n", led_effect_name(type), perFrame);
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file bench_hsv.c
+ * @brief Host benchmark of the HSV colors, in ns per pixel of a span of 300 LEDs: led_strip_set_pixel_hsv pixel by
+ * pixel against the batch led_strip_hsv_to_rgb over the span set with one led_strip_set_pixels, and
+ * led_strip_set_pixels_hsv. The pixels set are compared before the timings are printed.
+ */
+
+#include <stdio.h>  // Standard input/output functions
+#include <stdint.h> // Standard integer types
+#include <string.h> // String manipulation functions
+
+#include "bench.h"               // Benchmark helpers
+#include "led_strip.h"           // LED strip library
+#include "led_strip_interface.h" // LED strip driver interface
+
+#define BENCH_PIXELS 300
+#define BENCH_ROUNDS 20000
+
+static led_strip_hsv_t hsv[BENCH_PIXELS];
+static uint8_t rgb[BENCH_PIXELS * 3];
+static uint8_t captured[BENCH_PIXELS * 3]; // Pixels set on the benchmark strip
+
+// Function to store a pixel set on the benchmark strip
+static esp_err_t capture_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    captured[index * 3] = red;
+    captured[index * 3 + 1] = green;
+    captured[index * 3 + 2] = blue;
+    return ESP_OK;
+}
+
+// Function to store a span set on the benchmark strip
+static esp_err_t capture_pixels(led_strip_t *strip, uint32_t offset, const uint8_t *src, uint32_t count, led_strip_src_format_t format)
+{
+    memcpy(&captured[offset * 3], src, count * 3);
+    return ESP_OK;
+}
+
+// Function to set the span pixel by pixel with led_strip_set_pixel_hsv
+static void set_per_pixel(led_strip_t *strip)
+{
+    for (int i = 0; i < BENCH_PIXELS; i++)
+    {
+        led_strip_set_pixel_hsv(strip, i, hsv[i].hue, hsv[i].saturation, hsv[i].value);
+    }
+}
+
+// Function to convert the span at once and set it with one led_strip_set_pixels
+static void set_batch(led_strip_t *strip)
+{
+    led_strip_hsv_to_rgb(hsv, rgb, BENCH_PIXELS);
+    led_strip_set_pixels(strip, 0, rgb, BENCH_PIXELS, LED_STRIP_SRC_FORMAT_RGB);
+}
+
+// Function to set the span with led_strip_set_pixels_hsv, converted chunk by chunk on the stack
+static void set_chunked(led_strip_t *strip)
+{
+    led_strip_set_pixels_hsv(strip, 0, hsv, BENCH_PIXELS);
+}
+
+// Function to time a way of setting the span, in ns per pixel
+static double bench_set(void (*set)(led_strip_t *strip), led_strip_t *strip)
+{
+    int64_t start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        set(BENCH_OPAQUE(strip));
+        BENCH_CLOBBER();
+    }
+    return (double)(bench_now_ns() - start) / BENCH_ROUNDS / BENCH_PIXELS;
+}
+
+int main(void)
+{
+    led_strip_t strip = {
+        .set_pixel = capture_pixel,
+        .set_pixels = capture_pixels,
+    };
+    for (int i = 0; i < BENCH_PIXELS; i++)
+    {
+        hsv[i] = (led_strip_hsv_t){.hue = i * 360 / BENCH_PIXELS, .saturation = 255 - i % 64, .value = 128 + i % 128};
+    }
+
+    uint8_t expected[BENCH_PIXELS * 3];
+    int failed = 0;
+    set_per_pixel(&strip);
+    memcpy(expected, captured, sizeof(expected));
+    memset(captured, 0, sizeof(captured));
+    set_batch(&strip);
+    failed |= memcmp(captured, expected, sizeof(expected)) != 0;
+    memset(captured, 0, sizeof(captured));
+    set_chunked(&strip);
+    failed |= memcmp(captured, expected, sizeof(expected)) != 0;
+
+    printf("HSV, %d pixels, ns per pixel:\n", BENCH_PIXELS);
+    printf("  set_pixel_hsv per pixel  %6.2f\n", bench_set(set_per_pixel, &strip));
+    printf("  hsv_to_rgb span          %6.2f\n", bench_set(set_batch, &strip));
+    printf("  set_pixels_hsv           %6.2f\n", bench_set(set_chunked, &strip));
+    if (failed)
+    {
+        printf("FAIL: the batch conversion does not match led_strip_set_pixel_hsv\n");
+    }
+    return failed;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file bench_i2s_encoder.c
+ * @brief Host benchmark of the I2S/LCD parallel encoder, in MB/s of pixel bytes of all lanes: the bit matrix
+ * transpose of 8 and 16 lanes against a reference encoder that sets the data slot of each lane bit by bit. The
+ * bitstreams are compared before the timings are printed.
+ */
+
+#include <stdio.h>  // Standard input/output functions
+#include <stdint.h> // Standard integer types
+#include <stdlib.h> // Standard library functions
+#include <string.h> // String manipulation functions
+
+#include "bench.h"                 // Benchmark helpers
+#include "led_strip_i2s_encoder.h" // I2S encoder functions
+
+#define BENCH_MAX_LANES 16
+#define BENCH_LANE_BYTES 900 // 300 RGB LEDs on each lane
+#define BENCH_ROUNDS 2000
+
+static uint8_t data[BENCH_MAX_LANES][BENCH_LANE_BYTES];
+static uint16_t referenceBuf[BENCH_LANE_BYTES * 8 * LED_STRIP_I2S_SLOTS_PER_BIT];
+static uint16_t transposeBuf[BENCH_LANE_BYTES * 8 * LED_STRIP_I2S_SLOTS_PER_BIT];
+
+// Function to encode the data slots bit by bit, one lane at a time
+static void reference_encode(const uint8_t *const lanes[], uint8_t laneCount, size_t laneBytes, void *buf)
+{
+    for (size_t k = 0; k < laneBytes; k++)
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            size_t slot = (k * 8 + bit) * LED_STRIP_I2S_SLOTS_PER_BIT + 1;
+            unsigned levels = 0;
+            for (int l = 0; l < laneCount; l++)
+            {
+                levels |= ((lanes[l][k] >> (7 - bit)) & 1u) << l;
+            }
+            if (laneCount == 8)
+            {
+                ((uint8_t *)buf)[slot] = levels;
+            }
+            else
+            {
+                ((uint16_t *)buf)[slot] = levels;
+            }
+        }
+    }
+}
+
+// Function to encode the data slots with the transpose of the backend
+static void transpose_encode(const uint8_t *const lanes[], uint8_t laneCount, size_t laneBytes, void *buf)
+{
+    if (laneCount == 8)
+    {
+        led_strip_i2s_encode_8(lanes, laneBytes, buf);
+    }
+    else
+    {
+        led_strip_i2s_encode_16(lanes, laneBytes, buf);
+    }
+}
+
+// Function to time an encoder, in MB/s of pixel bytes
+static double bench_encoder(void (*encode)(const uint8_t *const lanes[], uint8_t laneCount, size_t laneBytes, void *buf),
+                            const uint8_t *const lanes[], uint8_t laneCount, void *buf)
+{
+    int64_t start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        encode(lanes, BENCH_OPAQUE(laneCount), BENCH_LANE_BYTES, buf);
+        BENCH_CLOBBER();
+    }
+    double ns = (double)(bench_now_ns() - start) / BENCH_ROUNDS;
+    return (double)laneCount * BENCH_LANE_BYTES / ns * 1000;
+}
+
+int main(void)
+{
+    const uint8_t *lanes[BENCH_MAX_LANES];
+    for (int l = 0; l < BENCH_MAX_LANES; l++)
+    {
+        for (int k = 0; k < BENCH_LANE_BYTES; k++)
+        {
+            data[l][k] = (uint8_t)rand();
+        }
+        lanes[l] = data[l];
+    }
+
+    int failed = 0;
+    printf("I2S encoder, %d bytes per lane, MB/s of pixel bytes:\n", BENCH_LANE_BYTES);
+    for (uint8_t laneCount = 8; laneCount <= BENCH_MAX_LANES; laneCount += 8)
+    {
+        led_strip_i2s_prepare_bitstream((uint8_t *)referenceBuf, BENCH_LANE_BYTES, laneCount);
+        led_strip_i2s_prepare_bitstream((uint8_t *)transposeBuf, BENCH_LANE_BYTES, laneCount);
+        double reference = bench_encoder(reference_encode, lanes, laneCount, referenceBuf);
+        double transpose = bench_encoder(transpose_encode, lanes, laneCount, transposeBuf);
+        size_t size = BENCH_LANE_BYTES * LED_STRIP_I2S_BYTES_PER_LANE_BYTE(laneCount);
+        failed |= memcmp(referenceBuf, transposeBuf, size) != 0;
+        printf("  %2d lanes  reference %8.1f  transpose %8.1f  (x%.1f)\n", laneCount, reference, transpose,
+               transpose / reference);
+    }
+    if (failed)
+    {
+        printf("FAIL: the transpose does not match the reference encoder\n");
+    }
+    return failed;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file bench_layer_composite.c
+ * @brief Host benchmark of the compositing of the overlay layers, in us per frame of 300 LEDs: the base layer is copied
+ * and 1 to 4 overlays are blended over it in 64 LED chunks, as the render task does, with the overlays fully covered
+ * and with one LED in ten covered.
+ */
+
+#include <stdio.h>  // Standard input/output functions
+#include <stdint.h> // Standard integer types
+#include <string.h> // String manipulation functions
+
+#include "bench.h"          // Benchmark helpers
+#include "render_handler.h" // LED state
+#include "led_layer.h"      // LED layer functions
+
+#define BENCH_LEDS 300
+#define BENCH_CHUNK 64 // RENDER_SPAN_CHUNK of the render task
+#define BENCH_OVERLAYS 4
+#define BENCH_ROUNDS 20000
+
+static struct ledState base[BENCH_LEDS];
+static struct ledState frame[BENCH_LEDS];
+static uint32_t overlays[BENCH_OVERLAYS][BENCH_LEDS];
+
+// Function to composite a number of overlays over the base layer, a blend mode each
+static void composite(int overlayCount)
+{
+    for (int start = 0; start < BENCH_LEDS; start += BENCH_CHUNK)
+    {
+        int chunk = BENCH_LEDS - start < BENCH_CHUNK ? BENCH_LEDS - start : BENCH_CHUNK;
+        memcpy(&frame[start], &base[start], chunk * sizeof(struct ledState));
+        for (int layer = 0; layer < overlayCount; layer++)
+        {
+            led_layer_blend(&frame[start], &overlays[layer][start], chunk, 180, layer % LED_LAYER_BLEND_COUNT);
+        }
+    }
+}
+
+int main(void)
+{
+    for (int i = 0; i < BENCH_LEDS; i++)
+    {
+        base[i] = (struct ledState){i, i * 3, i * 7};
+    }
+    printf("Layer composite, %d LEDs, us per frame:\n", BENCH_LEDS);
+    printf("  overlays  full coverage  10%% coverage\n");
+    double perFrame[2][BENCH_OVERLAYS];
+    for (int sparse = 0; sparse < 2; sparse++)
+    {
+        for (int layer = 0; layer < BENCH_OVERLAYS; layer++)
+        {
+            for (int i = 0; i < BENCH_LEDS; i++)
+            {
+                overlays[layer][i] = sparse && i % 10 ? 0 : LED_LAYER_PIXEL(i * 5, layer * 60, 255 - i, 200);
+            }
+        }
+        for (int overlayCount = 1; overlayCount <= BENCH_OVERLAYS; overlayCount++)
+        {
+            int64_t start = bench_now_ns();
+            for (int r = 0; r < BENCH_ROUNDS; r++)
+            {
+                composite(BENCH_OPAQUE(overlayCount));
+                BENCH_CLOBBER();
+            }
+            perFrame[sparse][overlayCount - 1] = (double)(bench_now_ns() - start) / BENCH_ROUNDS / 1000;
+        }
+    }
+    for (int overlayCount = 1; overlayCount <= BENCH_OVERLAYS; overlayCount++)
+    {
+        printf("  %d         %6.2f         %6.2f\n", overlayCount, perFrame[0][overlayCount - 1],
+               perFrame[1][overlayCount - 1]);
+    }
+    return 0;
+}
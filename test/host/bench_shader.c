@@ -0,0 +1,196 @@
+/**
+ * @file bench_shader.c
+ * @brief Host benchmark of the shader interpreter, in us per frame of 600 LEDs against the 16.7 ms of a frame at
+ * 60 fps, for a gradient, a plasma of three sines, a noise fire, and a program that takes the whole default budget of
+ * CONFIG_LED_SHADER_BUDGET / 600 instructions per LED.
+ */
+
+#include <stdio.h>  // Standard input/output functions
+#include <stdint.h> // Standard integer types
+#include <math.h>   // Math functions
+
+#include "sdkconfig.h"      // Project configuration
+#include "bench.h"          // Benchmark helpers
+#include "render_handler.h" // LED state
+#include "led_shader.h"     // LED shader functions
+
+#define BENCH_LEDS 600
+#define BENCH_FRAMES 3000
+#define BENCH_BUDGET (CONFIG_LED_SHADER_BUDGET / BENCH_LEDS)
+
+// Bytecode of a program being written
+typedef struct
+{
+    uint8_t code[LED_SHADER_MAX_LENGTH];
+    size_t length;
+} bench_program_t;
+
+// Function to append an instruction without operand
+static void op(bench_program_t *program, led_shader_op_t instruction)
+{
+    program->code[program->length++] = instruction;
+}
+
+// Function to append an instruction with a one byte operand
+static void op8(bench_program_t *program, led_shader_op_t instruction, uint8_t operand)
+{
+    program->code[program->length++] = instruction;
+    program->code[program->length++] = operand;
+}
+
+// Function to append the push of a constant, in steps of 1 / 256
+static void push(bench_program_t *program, double value)
+{
+    int16_t fixed = (int16_t)lround(value * 256);
+    program->code[program->length++] = LED_SHADER_OP_PUSH;
+    program->code[program->length++] = (uint16_t)fixed;
+    program->code[program->length++] = (uint16_t)fixed >> 8;
+}
+
+// Function to write the gradient: a rainbow along the strip, a quarter cycle per second
+static void write_gradient(bench_program_t *p)
+{
+    op(p, LED_SHADER_OP_POS);
+    op(p, LED_SHADER_OP_TIME);
+    push(p, 0.25);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_ADD);
+    push(p, 1);
+    push(p, 1);
+    op(p, LED_SHADER_OP_HSV);
+}
+
+// Function to write the plasma: v = sin(pos * 3 + t / 2) + sin(pos * 5 - t * 0.3) + sin((pos + t / 10) * 7), each
+// channel (sin(v / 4 + c / 3) + 1) / 2
+static void write_plasma(bench_program_t *p)
+{
+    op(p, LED_SHADER_OP_POS);
+    push(p, 3);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_TIME);
+    push(p, 0.5);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_ADD);
+    op(p, LED_SHADER_OP_SIN);
+    op(p, LED_SHADER_OP_POS);
+    push(p, 5);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_TIME);
+    push(p, 0.3);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_SUB);
+    op(p, LED_SHADER_OP_SIN);
+    op(p, LED_SHADER_OP_ADD);
+    op(p, LED_SHADER_OP_POS);
+    op(p, LED_SHADER_OP_TIME);
+    push(p, 0.1);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_ADD);
+    push(p, 7);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_SIN);
+    op(p, LED_SHADER_OP_ADD);
+    push(p, 0.25);
+    op(p, LED_SHADER_OP_MUL);
+    op8(p, LED_SHADER_OP_STORE, 0);
+    for (int c = 0; c < 3; c++)
+    {
+        op8(p, LED_SHADER_OP_LOAD, 0);
+        push(p, c / 3.0);
+        op(p, LED_SHADER_OP_ADD);
+        op(p, LED_SHADER_OP_SIN);
+        push(p, 1);
+        op(p, LED_SHADER_OP_ADD);
+        push(p, 0.5);
+        op(p, LED_SHADER_OP_MUL);
+    }
+    op(p, LED_SHADER_OP_RGB);
+}
+
+// Function to write the noise fire: heat = noise(pos * 8 - t * 2) * (1 - pos), red heat * 2, green heat^2
+static void write_fire(bench_program_t *p)
+{
+    op(p, LED_SHADER_OP_POS);
+    push(p, 8);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_TIME);
+    push(p, 2);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_SUB);
+    op(p, LED_SHADER_OP_NOISE);
+    push(p, 1);
+    op(p, LED_SHADER_OP_POS);
+    op(p, LED_SHADER_OP_SUB);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_DUP);
+    push(p, 2);
+    op(p, LED_SHADER_OP_MUL);
+    op(p, LED_SHADER_OP_SWAP);
+    op(p, LED_SHADER_OP_DUP);
+    op(p, LED_SHADER_OP_MUL);
+    push(p, 0);
+    op(p, LED_SHADER_OP_RGB);
+}
+
+// Function to write a program that runs the whole budget: sines of sums and products, padded with absolute values
+static void write_budget(bench_program_t *p)
+{
+    int cost = 1;
+    op(p, LED_SHADER_OP_POS);
+    for (int i = 0; cost + 6 <= BENCH_BUDGET; i++)
+    {
+        push(p, 1.01);
+        op(p, i % 2 ? LED_SHADER_OP_MUL : LED_SHADER_OP_ADD);
+        op(p, LED_SHADER_OP_SIN);
+        cost += 3;
+    }
+    for (int pad = BENCH_BUDGET - 3 - cost; pad > 0; pad--)
+    {
+        op(p, LED_SHADER_OP_ABS);
+    }
+    op(p, LED_SHADER_OP_DUP);
+    op(p, LED_SHADER_OP_DUP);
+    op(p, LED_SHADER_OP_RGB);
+}
+
+int main(void)
+{
+    static const struct
+    {
+        const char *name;
+        void (*write)(bench_program_t *program);
+    } programs[] = {
+        {"gradient", write_gradient},
+        {"plasma, 3 sines", write_plasma},
+        {"noise fire", write_fire},
+        {"full default budget", write_budget},
+    };
+    static struct ledState states[BENCH_LEDS];
+    int failed = 0;
+
+    printf("Shader, %d LEDs, budget %d instructions per LED:\n", BENCH_LEDS, BENCH_BUDGET);
+    for (size_t n = 0; n < sizeof(programs) / sizeof(programs[0]); n++)
+    {
+        bench_program_t program = {.length = 0};
+        programs[n].write(&program);
+        led_shader_t *shader;
+        if (led_shader_load(program.code, program.length, BENCH_BUDGET, &shader) != ESP_OK)
+        {
+            printf("FAIL: %s does not load\n", programs[n].name);
+            failed++;
+            continue;
+        }
+        uint32_t cost = led_shader_cost(shader);
+        int64_t start = bench_now_ns();
+        for (int f = 0; f < BENCH_FRAMES; f++)
+        {
+            led_shader_run(shader, f * 16, BENCH_LEDS, states);
+            BENCH_CLOBBER();
+        }
+        double us = (double)(bench_now_ns() - start) / BENCH_FRAMES / 1000;
+        printf("  %-20s %3u instr/LED  %7.1f us/frame  %.2f ns/instr  %.2f%% of 16.7 ms\n", programs[n].name, cost, us,
+               us * 1000 / ((double)BENCH_LEDS * cost), us / 16667 * 100);
+        led_shader_free(shader);
+    }
+    return failed;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file bench_spi_encoder.c
+ * @brief Host benchmark of the SPI backend encoder, in ns per pixel of 3 bytes: set_pixel and clear with the former
+ * bit by bit encoder and with the table encoder, and the span encoder. The outputs are compared before the timings
+ * are printed.
+ */
+
+#include <stdio.h>  // Standard input/output functions
+#include <stdint.h> // Standard integer types
+#include <stdlib.h> // Standard library functions
+#include <string.h> // String manipulation functions
+
+#include "bench.h"                 // Benchmark helpers
+#include "led_strip_spi_encoder.h" // SPI encoder functions
+
+#define BENCH_PIXELS 1024
+#define BENCH_ROUNDS 2000
+
+// Function to encode an LED data byte bit by bit in the 3 bits pattern, as the SPI backend did before the table
+static void old_encode_bit(uint8_t data, uint8_t *buf)
+{
+    buf[2] |= data & 0x01 ? 0x06 : 0x04;
+    buf[2] |= data & 0x02 ? 0x30 : 0x20;
+    buf[2] |= data & 0x04 ? 0x80 : 0x00;
+    buf[1] |= 0x01;
+    buf[1] |= data & 0x08 ? 0x0C : 0x08;
+    buf[1] |= data & 0x10 ? 0x60 : 0x40;
+    buf[0] |= data & 0x20 ? 0x03 : 0x02;
+    buf[0] |= data & 0x40 ? 0x18 : 0x10;
+    buf[0] |= data & 0x80 ? 0xC0 : 0x80;
+}
+
+// Function to set a GRB pixel as the SPI backend did before the table
+static void old_set_pixel(uint8_t *buf, uint32_t index, uint8_t red, uint8_t green, uint8_t blue)
+{
+    uint8_t *pixel = buf + index * 9;
+    memset(pixel, 0, 9);
+    old_encode_bit(green, pixel);
+    old_encode_bit(red, pixel + 3);
+    old_encode_bit(blue, pixel + 6);
+}
+
+// Function to set a GRB pixel as the SPI backend does with the table
+static void new_set_pixel(uint8_t *buf, uint32_t index, uint8_t red, uint8_t green, uint8_t blue)
+{
+    uint8_t pixel[4] = {green, red, blue, 0};
+    led_strip_spi_encode(pixel, 3, buf + index * 9);
+}
+
+int main(void)
+{
+    static uint8_t oldBuf[BENCH_PIXELS * 9] __attribute__((aligned(4)));
+    static uint8_t newBuf[BENCH_PIXELS * 9] __attribute__((aligned(4)));
+    static uint8_t src[BENCH_PIXELS * 3];
+    for (int i = 0; i < BENCH_PIXELS * 3; i++)
+    {
+        src[i] = (uint8_t)rand();
+    }
+
+    int64_t start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        for (int i = 0; i < BENCH_PIXELS; i++)
+        {
+            old_set_pixel(oldBuf, i, src[i * 3], src[i * 3 + 1], src[i * 3 + 2]);
+        }
+        BENCH_CLOBBER();
+    }
+    double oldSet = (double)(bench_now_ns() - start) / BENCH_ROUNDS / BENCH_PIXELS;
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        for (int i = 0; i < BENCH_PIXELS; i++)
+        {
+            new_set_pixel(newBuf, i, src[i * 3], src[i * 3 + 1], src[i * 3 + 2]);
+        }
+        BENCH_CLOBBER();
+    }
+    double newSet = (double)(bench_now_ns() - start) / BENCH_ROUNDS / BENCH_PIXELS;
+    int failed = memcmp(oldBuf, newBuf, sizeof(oldBuf)) != 0;
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        led_strip_spi_encode(src, BENCH_PIXELS * 3, newBuf);
+        BENCH_CLOBBER();
+    }
+    double span = (double)(bench_now_ns() - start) / BENCH_ROUNDS / BENCH_PIXELS;
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        memset(oldBuf, 0, sizeof(oldBuf));
+        for (int i = 0; i < BENCH_PIXELS * 3; i++)
+        {
+            old_encode_bit(BENCH_OPAQUE(0), oldBuf + i * 3);
+        }
+        BENCH_CLOBBER();
+    }
+    double oldClear = (double)(bench_now_ns() - start) / BENCH_ROUNDS / BENCH_PIXELS;
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        led_strip_spi_encode_fill(0, BENCH_PIXELS * 3, newBuf);
+        BENCH_CLOBBER();
+    }
+    double newClear = (double)(bench_now_ns() - start) / BENCH_ROUNDS / BENCH_PIXELS;
+    failed |= memcmp(oldBuf, newBuf, sizeof(oldBuf)) != 0;
+
+    printf("SPI encoder, %d GRB pixels, ns per pixel:\n", BENCH_PIXELS);
+    printf("  set_pixel  old %6.2f  new %6.2f\n", oldSet, newSet);
+    printf("  span encode    %6.2f\n", span);
+    printf("  clear      old %6.2f  new %6.2f\n", oldClear, newClear);
+    if (failed)
+    {
+        printf("FAIL: the table encoder does not match the former encoder\n");
+    }
+    return failed;
+}
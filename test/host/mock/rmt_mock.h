@@ -0,0 +1,20 @@
+/**
+ * @file rmt_mock.h
+ * @brief Host mock of the ESP-IDF 5 RMT TX driver: the copy encoder, and a TX channel that runs the encoder of each
+ * transmission until it completes, with a given free RMT memory per refill, and captures the symbols it produced.
+ */
+
+#ifndef RMT_MOCK_H_
+#define RMT_MOCK_H_
+#include <stddef.h>
+#include "driver/rmt_tx.h"
+
+#define RMT_MOCK_MAX_SYMBOLS (1 << 17) // Symbols captured per transmission
+
+extern rmt_symbol_word_t rmt_mock_symbols[RMT_MOCK_MAX_SYMBOLS]; // Symbols of the last transmission
+extern size_t rmt_mock_symbol_count;                            // Symbols of the last transmission
+extern size_t rmt_mock_refill_symbols;                          // Free RMT memory for each call of the encoder, in symbols
+
+size_t rmt_mock_encode(rmt_encoder_handle_t encoder, const void *data, size_t size); // Run an encoder until it completes, returns the encoder calls
+
+#endif /* RMT_MOCK_H_ */
@@ -0,0 +1,83 @@
+/**
+ * @file rtos_mock.c
+ * @brief Host mock of FreeRTOS and of the ESP-IDF high resolution timer.
+ */
+
+#include <stdint.h> // Standard integer types
+
+#include "freertos/FreeRTOS.h" // FreeRTOS types
+#include "freertos/task.h"     // FreeRTOS task functions
+#include "freertos/queue.h"    // FreeRTOS queue functions
+#include "esp_timer.h"         // ESP32 high resolution timer
+#include "rtos_mock.h"         // RTOS mock
+
+int64_t rtos_mock_time_us;
+
+// The handles only need to be distinct from NULL
+static int mockHandle;
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack, void *arg, UBaseType_t priority,
+                       TaskHandle_t *handle)
+{
+    if (handle != NULL)
+    {
+        *handle = (TaskHandle_t)&mockHandle;
+    }
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait)
+{
+    return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return pdPASS;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return 0;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    return (QueueHandle_t)&mockHandle;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    return pdFALSE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    return pdFALSE;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return rtos_mock_time_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *timer)
+{
+    *timer = (esp_timer_handle_t)&mockHandle;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    return ESP_OK;
+}
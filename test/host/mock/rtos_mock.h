@@ -0,0 +1,13 @@
+/**
+ * @file rtos_mock.h
+ * @brief Host mock of FreeRTOS and of the ESP-IDF high resolution timer, for the modules of the render task run
+ * without the task: the queues are always empty, the timers never fire, and the time is set by the test.
+ */
+
+#ifndef RTOS_MOCK_H_
+#define RTOS_MOCK_H_
+#include <stdint.h>
+
+extern int64_t rtos_mock_time_us; // Time returned by esp_timer_get_time
+
+#endif /* RTOS_MOCK_H_ */
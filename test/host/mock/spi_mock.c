@@ -0,0 +1,127 @@
+/**
+ * @file spi_mock.c
+ * @brief Host mock of the ESP-IDF SPI master driver. The clock of a device is the source clock divided by the
+ * smallest divider that does not exceed the requested clock, as the ESP-IDF driver computes it. A transaction is
+ * captured when it is queued or transmitted, and the queued ones complete in order.
+ */
+
+#include <stdint.h> // Standard integer types
+#include <stdlib.h> // Memory allocation functions
+#include <string.h> // String manipulation functions
+
+#include "esp_clk_tree.h"     // ESP32 clock tree
+#include "soc/spi_periph.h"   // SPI peripheral signals
+#include "spi_mock.h"         // SPI mock
+
+#define SPI_MOCK_QUEUE_SIZE 8 // Transactions queued and not yet returned by spi_device_get_trans_result
+
+uint8_t spi_mock_bytes[SPI_MOCK_MAX_BYTES];
+size_t spi_mock_byte_count;
+size_t spi_mock_transactions;
+uint32_t spi_mock_source_hz = 80000000;
+int spi_mock_clock_khz;
+
+const spi_signal_conn_t spi_periph_signal[3];
+
+struct spi_device_t
+{
+    int clock_khz;
+    spi_transaction_t *queue[SPI_MOCK_QUEUE_SIZE];
+    int queued;
+};
+
+// Function to capture the bytes of a transaction
+static esp_err_t spi_mock_send(const spi_transaction_t *trans)
+{
+    size_t bytes = (trans->length + 7) / 8;
+    if (spi_mock_byte_count + bytes > SPI_MOCK_MAX_BYTES)
+    {
+        abort();
+    }
+    memcpy(&spi_mock_bytes[spi_mock_byte_count], trans->tx_buffer, bytes);
+    spi_mock_byte_count += bytes;
+    spi_mock_transactions++;
+    return ESP_OK;
+}
+
+int spi_get_actual_clock(int fapb, int hz, int duty_cycle)
+{
+    int divider = (fapb + hz - 1) / hz;
+    return fapb / divider;
+}
+
+esp_err_t esp_clk_tree_src_get_freq_hz(soc_module_clk_t clk_src, esp_clk_tree_src_freq_precision_t precision, uint32_t *freq_hz)
+{
+    *freq_hz = spi_mock_source_hz;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, spi_common_dma_t dma)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config, spi_device_handle_t *handle)
+{
+    struct spi_device_t *device = calloc(1, sizeof(struct spi_device_t));
+    if (device == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    device->clock_khz = spi_get_actual_clock(spi_mock_source_hz, config->clock_speed_hz, 128) / 1000;
+    spi_mock_clock_khz = device->clock_khz;
+    *handle = device;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_actual_freq(spi_device_handle_t handle, int *freq_khz)
+{
+    *freq_khz = handle->clock_khz;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    return spi_mock_send(trans);
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t wait)
+{
+    if (handle->queued == SPI_MOCK_QUEUE_SIZE)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    handle->queue[handle->queued++] = trans;
+    return spi_mock_send(trans);
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t wait)
+{
+    if (handle->queued == 0)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    *trans = handle->queue[0];
+    memmove(&handle->queue[0], &handle->queue[1], --handle->queued * sizeof(spi_transaction_t *));
+    return ESP_OK;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait)
+{
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t handle)
+{
+}
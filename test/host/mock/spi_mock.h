@@ -0,0 +1,21 @@
+/**
+ * @file spi_mock.h
+ * @brief Host mock of the ESP-IDF SPI master driver: one SPI bus, whose devices run at the clock a divider of the
+ * source clock gives, and whose transactions are captured byte by byte in the order they are sent.
+ */
+
+#ifndef SPI_MOCK_H_
+#define SPI_MOCK_H_
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/spi_master.h"
+
+#define SPI_MOCK_MAX_BYTES (1 << 17) // Bytes captured between two resets
+
+extern uint8_t spi_mock_bytes[SPI_MOCK_MAX_BYTES]; // Bytes sent since the last reset of spi_mock_byte_count
+extern size_t spi_mock_byte_count;                 // Bytes sent since it was last set to 0
+extern size_t spi_mock_transactions;               // Transactions sent since it was last set to 0
+extern uint32_t spi_mock_source_hz;                // Frequency of the SPI clock source
+extern int spi_mock_clock_khz;                     // Clock of the last device added
+
+#endif /* SPI_MOCK_H_ */
@@ -0,0 +1,25 @@
+// Host stub of the ESP-IDF RMT types
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef int rmt_clock_source_t;
+
+#define RMT_CLK_SRC_DEFAULT 1
+
+typedef struct rmt_channel_t *rmt_channel_handle_t;
+typedef struct rmt_encoder_t rmt_encoder_t;
+typedef struct rmt_encoder_t *rmt_encoder_handle_t;
+
+typedef union
+{
+    struct
+    {
+        uint16_t duration0 : 15;
+        uint16_t level0 : 1;
+        uint16_t duration1 : 15;
+        uint16_t level1 : 1;
+    };
+    uint32_t val;
+} rmt_symbol_word_t;
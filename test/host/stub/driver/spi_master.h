@@ -0,0 +1,72 @@
+// Host stub of the ESP-IDF SPI master driver used by the SPI backends, implemented by mock/spi_mock.c
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_heap_caps.h" // Included by the ESP-IDF SPI headers, the SPI backends rely on it
+#include "freertos/FreeRTOS.h"
+
+typedef int spi_clock_source_t;
+
+typedef enum
+{
+    SPI1_HOST,
+    SPI2_HOST,
+    SPI3_HOST,
+} spi_host_device_t;
+
+typedef enum
+{
+    SPI_DMA_DISABLED = 0,
+    SPI_DMA_CH_AUTO = 3,
+} spi_common_dma_t;
+
+#define SPI_CLK_SRC_DEFAULT 1
+
+typedef struct spi_device_t *spi_device_handle_t;
+
+typedef struct
+{
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+    uint32_t flags;
+} spi_bus_config_t;
+
+typedef struct
+{
+    spi_clock_source_t clock_source;
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    uint8_t mode;
+    int clock_speed_hz;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+} spi_device_interface_config_t;
+
+typedef struct
+{
+    uint32_t flags;
+    size_t length; // Bits to send
+    size_t rxlength;
+    void *user;
+    const void *tx_buffer;
+    void *rx_buffer;
+} spi_transaction_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, spi_common_dma_t dma);
+esp_err_t spi_bus_free(spi_host_device_t host);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config, spi_device_handle_t *handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_get_actual_freq(spi_device_handle_t handle, int *freq_khz);
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t wait);
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait);
+void spi_device_release_bus(spi_device_handle_t handle);
+int spi_get_actual_clock(int fapb, int hz, int duty_cycle);
@@ -0,0 +1,33 @@
+// Host stub of the ESP-IDF error codes
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_NOT_SUPPORTED 0x106
+#define ESP_ERR_TIMEOUT 0x107
+
+#define ESP_ERROR_CHECK(x)                                                             \
+    do                                                                                 \
+    {                                                                                  \
+        esp_err_t err_rc_ = (x);                                                       \
+        if (err_rc_ != ESP_OK)                                                         \
+        {                                                                              \
+            fprintf(stderr, "%s:%d: %s failed: 0x%x\n", __FILE__, __LINE__, #x, err_rc_); \
+            abort();                                                                   \
+        }                                                                              \
+    } while (0)
+
+// Name of an error code, the host stub only gives the code
+static inline const char *esp_err_to_name(esp_err_t code)
+{
+    return code == ESP_OK ? "ESP_OK" : "ESP_ERR";
+}
@@ -0,0 +1,25 @@
+// Host stub of the ESP-IDF heap allocation by memory capabilities, the host has one kind of memory
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+static inline void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    return calloc(n, size);
+}
+
+static inline void *heap_caps_aligned_calloc(size_t alignment, size_t n, size_t size, uint32_t caps)
+{
+    void *p = aligned_alloc(alignment, (n * size + alignment - 1) / alignment * alignment);
+    return p ? memset(p, 0, n * size) : NULL;
+}
+
+static inline void heap_caps_free(void *p)
+{
+    free(p);
+}
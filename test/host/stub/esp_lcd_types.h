@@ -0,0 +1,6 @@
+// Host stub of the ESP-IDF LCD types used by the I2S/LCD parallel backend configuration
+#pragma once
+
+typedef int lcd_clock_source_t;
+
+#define LCD_CLK_SRC_DEFAULT 1
@@ -0,0 +1,8 @@
+// Host stub of the ESP ROM GPIO matrix, there is no GPIO on the host
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+static inline void esp_rom_gpio_connect_out_signal(uint32_t gpio, uint32_t signal, bool out_inv, bool oen_inv)
+{
+}
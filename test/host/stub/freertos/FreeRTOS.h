@@ -0,0 +1,17 @@
+// Host stub of the FreeRTOS types, the render task is not run on the host
+#pragma once
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// The render task is the only task on the host, the critical sections need no lock
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
@@ -0,0 +1,9 @@
+// Host stub of the FreeRTOS queues, implemented by mock/rtos_mock.c
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
@@ -0,0 +1,15 @@
+// Host stub of the FreeRTOS tasks, implemented by mock/rtos_mock.c
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack, void *arg, UBaseType_t priority,
+                       TaskHandle_t *handle);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+#define taskENTER_CRITICAL(lock) ((void)(lock))
+#define taskEXIT_CRITICAL(lock) ((void)(lock))
@@ -0,0 +1,3 @@
+// Host stub of the SPI HAL, the SPI backends only take spi_get_actual_clock from it (see driver/spi_master.h)
+#pragma once
+#include "driver/spi_master.h"
@@ -0,0 +1,35 @@
+// Host stub of the project configuration, the defaults of main/Kconfig.projbuild
+#pragma once
+
+#define CONFIG_LED_GPIO 22
+#ifndef CONFIG_LED_COUNT
+#define CONFIG_LED_COUNT 12 // Set by the builds that size the render buffers for another strip
+#endif
+#define CONFIG_LED_RMT_RES_HZ 4900000
+#define CONFIG_LED_MODEL_WS2812 1
+#define CONFIG_LED_CLK_GPIO 23
+#define CONFIG_LED_CLOCK_HZ 0
+#define CONFIG_LED_PIXEL_FORMAT_GRB 1
+#define CONFIG_LED_WHITE_EXTRACTION_NONE 1
+#define CONFIG_LED_WHITE_RED 255
+#define CONFIG_LED_WHITE_GREEN 210
+#define CONFIG_LED_WHITE_BLUE 160
+#define CONFIG_LED_BACKEND_AUTO 1
+#define CONFIG_LED_FRAME_QUEUE_LENGTH 8
+#define CONFIG_LED_PRIORITY_QUEUE_LENGTH 4
+#define CONFIG_LED_RENDER_TASK_STACK_SIZE 6144
+#define CONFIG_LED_JITTER_BUFFER_MS 100
+#define CONFIG_LED_JITTER_BUFFER_LENGTH 16
+#define CONFIG_LED_SCENE_COUNT 4
+#define CONFIG_LED_LAYER_COUNT 3
+#define CONFIG_LED_EFFECT_FPS 50
+#define CONFIG_LED_SHADER_BUDGET 65536
+#define CONFIG_LED_TRANSITION_FPS 50
+#define CONFIG_LED_DITHER_REFRESH_HZ 200
+#ifndef CONFIG_LED_POWER_BUDGET_MA
+#define CONFIG_LED_POWER_BUDGET_MA 0 // Set by the test of the power limiter
+#endif
+#define CONFIG_LED_CURRENT_RED_MA 20
+#define CONFIG_LED_CURRENT_GREEN_MA 20
+#define CONFIG_LED_CURRENT_BLUE_MA 20
+#define CONFIG_LED_CURRENT_IDLE_UA 1000
@@ -0,0 +1,11 @@
+// Host stub of the SPI peripheral signals, defined by mock/spi_mock.c
+#pragma once
+#include <stdint.h>
+
+typedef struct
+{
+    uint8_t spid_out;
+    uint8_t spiclk_out;
+} spi_signal_conn_t;
+
+extern const spi_signal_conn_t spi_periph_signal[3];
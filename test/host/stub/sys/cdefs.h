@@ -0,0 +1,8 @@
+// Host stub of the newlib sys/cdefs.h additions the ESP-IDF code relies on
+#pragma once
+#include_next <sys/cdefs.h>
+#include <stddef.h>
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
@@ -0,0 +1,206 @@
+/**
+ * @file test_color_lut.c
+ * @brief Host test of the color lookup table of the backends: a strip with a table and a reference strip without one,
+ * set to the colors mapped through the table, take random frames and must send the same data at every refresh, while
+ * the strip with the table reads back the colors as set. The table is changed, removed and set again during the test.
+ * The RMT backend runs with and without the symbol cache, the SPI backend with and without streaming.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Standard library functions
+#include <string.h>  // String manipulation functions
+
+#include "rmt_mock.h"  // RMT mock
+#include "spi_mock.h"  // SPI mock
+#include "led_strip.h" // LED strip library
+
+#define TEST_PIXELS 150 // Two chunks of the streaming mode, the second one starts within a pixel
+#define TEST_RMT_FRAMES 1800
+#define TEST_SPI_FRAMES 750
+
+static uint8_t model[TEST_PIXELS][3]; // Colors as set on the strip with the table
+static led_strip_color_lut_t colorLut;
+static rmt_symbol_word_t rmtSent[RMT_MOCK_MAX_SYMBOLS];
+static uint8_t spiSent[SPI_MOCK_MAX_BYTES];
+
+// Function to build a random table, from a gamma, a white balance and a brightness
+static void random_lut(void)
+{
+    const float gammas[] = {1.0f, 1.8f, 2.2f, 2.8f};
+    uint8_t gain[4] = {255 - rand() % 64, 255 - rand() % 64, 255 - rand() % 64, 255};
+    ESP_ERROR_CHECK(led_strip_color_lut_init(&colorLut, gammas[rand() % 4], gain, rand()));
+}
+
+// Function to write random LEDs to the strip with the table, and update the model
+static void random_writes(led_strip_handle_t strip)
+{
+    int writes = 1 + rand() % 8;
+    for (int w = 0; w < writes; w++)
+    {
+        uint32_t offset = rand() % TEST_PIXELS;
+        uint32_t count = 1 + rand() % (TEST_PIXELS - offset);
+        uint8_t color[3] = {rand(), rand(), rand()};
+        switch (rand() % 3)
+        {
+        case 0:
+            ESP_ERROR_CHECK(led_strip_set_pixel(strip, offset, color[0], color[1], color[2]));
+            memcpy(model[offset], color, 3);
+            break;
+        case 1:
+        {
+            uint8_t src[TEST_PIXELS * 3];
+            for (uint32_t i = 0; i < count * 3; i++)
+            {
+                src[i] = rand();
+            }
+            ESP_ERROR_CHECK(led_strip_set_pixels(strip, offset, src, count, LED_STRIP_SRC_FORMAT_RGB));
+            memcpy(model[offset], src, count * 3);
+            break;
+        }
+        default:
+            ESP_ERROR_CHECK(led_strip_fill(strip, offset, count, color[0], color[1], color[2]));
+            for (uint32_t i = 0; i < count; i++)
+            {
+                memcpy(model[offset + i], color, 3);
+            }
+            break;
+        }
+    }
+}
+
+// Function to change the table at the start of each sixth of the frames: three tables, none, then two tables again.
+// Returns true while a table is set.
+static bool update_lut(led_strip_handle_t strip, int frame, int frames)
+{
+    int phase = frame / (frames / 6);
+    if (frame % (frames / 6) == 0)
+    {
+        random_lut();
+        ESP_ERROR_CHECK(led_strip_set_color_lut(strip, phase == 3 ? NULL : &colorLut));
+    }
+    return phase != 3;
+}
+
+// Function to set the reference strip to the model, mapped through the table if one is set
+static void write_reference(led_strip_handle_t reference, bool useLut)
+{
+    uint8_t mapped[TEST_PIXELS][3];
+    for (int i = 0; i < TEST_PIXELS; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            mapped[i][c] = useLut ? colorLut.channel[c][model[i][c]] : model[i][c];
+        }
+    }
+    ESP_ERROR_CHECK(led_strip_set_pixels(reference, 0, (const uint8_t *)mapped, TEST_PIXELS, LED_STRIP_SRC_FORMAT_RGB));
+}
+
+// Function to check that the strip with the table reads back the colors as set
+static bool check_read_back(led_strip_handle_t strip)
+{
+    uint8_t back[TEST_PIXELS][3];
+    ESP_ERROR_CHECK(led_strip_get_pixels(strip, 0, (uint8_t *)back, TEST_PIXELS, LED_STRIP_SRC_FORMAT_RGB));
+    return memcmp(back, model, sizeof(model)) == 0;
+}
+
+// Function to test the RMT backend. Returns the number of wrong frames.
+static int test_rmt(bool symbolCache, int *frames)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = TEST_PIXELS,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+        .full_refresh_interval = 1,
+    };
+    led_strip_rmt_config_t rmtConfig = {.flags.symbol_cache = symbolCache};
+    led_strip_handle_t strip;
+    led_strip_handle_t reference;
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfig, &strip));
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfig, &reference));
+    memset(model, 0, sizeof(model));
+    ESP_ERROR_CHECK(led_strip_clear(strip));
+
+    int wrong = 0;
+    for (int frame = 0; frame < TEST_RMT_FRAMES; frame++)
+    {
+        bool useLut = update_lut(strip, frame, TEST_RMT_FRAMES);
+        random_writes(strip);
+        write_reference(reference, useLut);
+        ESP_ERROR_CHECK(led_strip_refresh(strip));
+        size_t count = rmt_mock_symbol_count;
+        memcpy(rmtSent, rmt_mock_symbols, count * sizeof(rmt_symbol_word_t));
+        ESP_ERROR_CHECK(led_strip_refresh(reference));
+        bool match = count == rmt_mock_symbol_count && memcmp(rmtSent, rmt_mock_symbols, count * sizeof(rmt_symbol_word_t)) == 0;
+        wrong += !(match && check_read_back(strip));
+        (*frames)++;
+    }
+    ESP_ERROR_CHECK(led_strip_del(strip));
+    ESP_ERROR_CHECK(led_strip_del(reference));
+    return wrong;
+}
+
+// Function to test the SPI backend. Returns the number of wrong frames.
+static int test_spi(bool streaming, int *frames)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = TEST_PIXELS,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+        .full_refresh_interval = 1,
+    };
+    led_strip_spi_config_t spiConfig = {.flags.with_dma = true, .flags.streaming = streaming};
+    led_strip_handle_t strip;
+    led_strip_handle_t reference;
+    spi_mock_source_hz = 80000000;
+    ESP_ERROR_CHECK(led_strip_new_spi_device(&stripConfig, &spiConfig, &strip));
+    ESP_ERROR_CHECK(led_strip_new_spi_device(&stripConfig, &spiConfig, &reference));
+    memset(model, 0, sizeof(model));
+    ESP_ERROR_CHECK(led_strip_clear(strip));
+
+    int wrong = 0;
+    for (int frame = 0; frame < TEST_SPI_FRAMES; frame++)
+    {
+        bool useLut = update_lut(strip, frame, TEST_SPI_FRAMES);
+        random_writes(strip);
+        write_reference(reference, useLut);
+        spi_mock_byte_count = 0;
+        ESP_ERROR_CHECK(led_strip_refresh(strip));
+        size_t count = spi_mock_byte_count;
+        memcpy(spiSent, spi_mock_bytes, count);
+        spi_mock_byte_count = 0;
+        ESP_ERROR_CHECK(led_strip_refresh(reference));
+        bool match = count > 0 && count == spi_mock_byte_count && memcmp(spiSent, spi_mock_bytes, count) == 0;
+        wrong += !(match && check_read_back(strip));
+        (*frames)++;
+    }
+    ESP_ERROR_CHECK(led_strip_del(strip));
+    ESP_ERROR_CHECK(led_strip_del(reference));
+    return wrong;
+}
+
+int main(void)
+{
+    srand(1);
+    int failed = 0;
+    int frames = 0;
+    for (int variant = 0; variant < 2; variant++)
+    {
+        int wrong = test_rmt(variant, &frames);
+        if (wrong)
+        {
+            printf("FAIL: RMT, symbol cache %d: %d wrong frames\n", variant, wrong);
+            failed++;
+        }
+        wrong = test_spi(variant, &frames);
+        if (wrong)
+        {
+            printf("FAIL: SPI, streaming %d: %d wrong frames\n", variant, wrong);
+            failed++;
+        }
+    }
+
+    printf("Color lookup table: %d frames, %d failed\n", frames, failed);
+    return failed != 0;
+}
@@ -0,0 +1,260 @@
+/**
+ * @file test_effect.c
+ * @brief Host test of the effects rendered on the device. Rainbow, chase, breathe and gradient are checked against
+ * floating point models of the effects, twinkle and fire for the same frames from the same seed and colors in range,
+ * and every effect against golden frames: the hash of the frames of a fixed command at fixed times, so a change of
+ * the rendering shows up even where the models leave some rounding slack.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdlib.h>  // Standard library functions
+#include <string.h>  // String manipulation functions
+#include <math.h>    // Math functions
+
+#include "led_strip.h"      // LED strip library, for the HSV conversion
+#include "render_handler.h" // LED state
+#include "led_effect.h"     // LED effect functions
+#include "led_shader.h"     // LED shader functions
+
+#define TEST_LEDS 300
+
+// Hash of the frames of each effect, rendered every 20 ms for the first second
+static const uint32_t GoldenFrames[LED_EFFECT_COUNT] = {
+    [LED_EFFECT_RAINBOW] = 0x5028b89c,
+    [LED_EFFECT_CHASE] = 0x1455a1a6,
+    [LED_EFFECT_BREATHE] = 0xa685d1f9,
+    [LED_EFFECT_TWINKLE] = 0x3f9cd913,
+    [LED_EFFECT_FIRE] = 0xa0c7576a,
+    [LED_EFFECT_GRADIENT] = 0x1b3aa075,
+    [LED_EFFECT_SHADER] = 0x8ef5354b,
+};
+
+// Shader of the golden frames: a rainbow moving along the strip, one cycle per second
+static const uint8_t RainbowShader[] = {
+    LED_SHADER_OP_POS,
+    LED_SHADER_OP_TIME,
+    LED_SHADER_OP_ADD,
+    LED_SHADER_OP_PUSH, 0x00, 0x01,
+    LED_SHADER_OP_PUSH, 0x00, 0x01,
+    LED_SHADER_OP_HSV,
+};
+
+static const led_effect_params_t TestParams = {
+    .colors = {{250, 40, 10}, {5, 20, 200}},
+    .period_ms = 1700,
+    .size = 37,
+    .density = 64,
+    .seed = 7,
+};
+
+static struct ledState states[TEST_LEDS];
+static int failed;
+
+// Function to start an effect of the test command
+static void start_effect(led_effect_t *effect, led_effect_type_t type, uint32_t seed)
+{
+    led_effect_params_t params = TestParams;
+    params.type = type;
+    params.seed = seed;
+    if (type == LED_EFFECT_SHADER)
+    {
+        ESP_ERROR_CHECK(led_shader_load(RainbowShader, sizeof(RainbowShader), CONFIG_LED_SHADER_BUDGET, &params.shader));
+    }
+    ESP_ERROR_CHECK(led_effect_init(effect, &params, TEST_LEDS));
+}
+
+// Function to mix the two colors of the test command, weight 1 for the first color
+static void mix_model(double weight, double rgb[3])
+{
+    for (int c = 0; c < 3; c++)
+    {
+        rgb[c] = TestParams.colors[0][c] * weight + TestParams.colors[1][c] * (1 - weight);
+    }
+}
+
+// Function to check an LED against the color of a model, within a tolerance
+static void check_model(const char *name, uint32_t timeMs, int i, const double rgb[3], double tolerance)
+{
+    const uint8_t got[3] = {states[i].red, states[i].green, states[i].blue};
+    for (int c = 0; c < 3; c++)
+    {
+        if (fabs(got[c] - rgb[c]) > tolerance)
+        {
+            if (failed < 10)
+            {
+                printf("FAIL: %s at %u ms, LED %d: %d %d %d, model %.1f %.1f %.1f\n", name, timeMs, i, got[0], got[1],
+                       got[2], rgb[0], rgb[1], rgb[2]);
+            }
+            failed++;
+            return;
+        }
+    }
+}
+
+// Function to check the effects that only depend on the time against their models
+static void test_models(void)
+{
+    led_effect_t effect;
+    for (uint32_t timeMs = 0; timeMs < 5000; timeMs += 13)
+    {
+        double phase = (double)(timeMs % TestParams.period_ms) / TestParams.period_ms;
+
+        // the hue of the fixed point phase may be one degree lower than the hue of the model
+        start_effect(&effect, LED_EFFECT_RAINBOW, TestParams.seed);
+        led_effect_render(&effect, timeMs, states);
+        for (int i = 0; i < TEST_LEDS; i++)
+        {
+            double hue = fmod(phase + (double)i / TestParams.size, 1.0) * 360;
+            led_strip_hsv_t hsv[2] = {{(uint16_t)hue, 255, 255}, {(uint16_t)(hue >= 1 ? hue - 1 : 359), 255, 255}};
+            uint8_t rgb[2][3];
+            led_strip_hsv_to_rgb(hsv, rgb[0], 2);
+            if (memcmp(rgb[0], &states[i], 3) != 0 && memcmp(rgb[1], &states[i], 3) != 0)
+            {
+                printf("FAIL: rainbow at %u ms, LED %d\n", timeMs, i);
+                failed++;
+            }
+        }
+        led_effect_deinit(&effect);
+
+        start_effect(&effect, LED_EFFECT_CHASE, TestParams.seed);
+        led_effect_render(&effect, timeMs, states);
+        int head = (int)((timeMs % TestParams.period_ms) * TEST_LEDS / TestParams.period_ms);
+        for (int i = 0; i < TEST_LEDS; i++)
+        {
+            int behind = ((head - i) % TEST_LEDS + TEST_LEDS) % TEST_LEDS;
+            double rgb[3];
+            mix_model(behind < TestParams.size ? (double)(TestParams.size - behind) / TestParams.size : 0, rgb);
+            check_model("chase", timeMs, i, rgb, 1);
+        }
+        led_effect_deinit(&effect);
+
+        // the breath is a smoothstep of a triangle
+        start_effect(&effect, LED_EFFECT_BREATHE, TestParams.seed);
+        led_effect_render(&effect, timeMs, states);
+        double x = phase < 0.5 ? 2 * phase : 2 - 2 * phase;
+        double rgb[3];
+        mix_model(x * x * (3 - 2 * x), rgb);
+        for (int i = 0; i < TEST_LEDS; i++)
+        {
+            check_model("breathe", timeMs, i, rgb, 1);
+        }
+        led_effect_deinit(&effect);
+
+        start_effect(&effect, LED_EFFECT_GRADIENT, TestParams.seed);
+        led_effect_render(&effect, timeMs, states);
+        for (int i = 0; i < TEST_LEDS; i++)
+        {
+            double ledPhase = fmod(phase + (double)i / TestParams.size, 1.0);
+            mix_model(1 - (ledPhase < 0.5 ? 2 * ledPhase : 2 - 2 * ledPhase), rgb);
+            check_model("gradient", timeMs, i, rgb, 2);
+        }
+        led_effect_deinit(&effect);
+    }
+}
+
+// Function to check that twinkle and fire render the same frames from the same seed, other frames from another seed,
+// and colors in the range of the effect
+static void test_random(led_effect_type_t type)
+{
+    static struct ledState again[TEST_LEDS];
+    static struct ledState reseeded[TEST_LEDS];
+    led_effect_t effect[3];
+    start_effect(&effect[0], type, TestParams.seed);
+    start_effect(&effect[1], type, TestParams.seed);
+    start_effect(&effect[2], type, TestParams.seed + 1);
+    bool differ = false;
+    int lit = 0;
+    int outOfRange = 0;
+    for (uint32_t timeMs = 0; timeMs < 3000; timeMs += 20)
+    {
+        led_effect_render(&effect[0], timeMs, states);
+        led_effect_render(&effect[1], timeMs, again);
+        led_effect_render(&effect[2], timeMs, reseeded);
+        if (memcmp(states, again, sizeof(states)) != 0)
+        {
+            printf("FAIL: %s at %u ms differs from the same seed\n", led_effect_name(type), timeMs);
+            failed++;
+            break;
+        }
+        differ |= memcmp(states, reseeded, sizeof(states)) != 0;
+        for (int i = 0; i < TEST_LEDS; i++)
+        {
+            const uint8_t rgb[3] = {states[i].red, states[i].green, states[i].blue};
+            lit += rgb[0] > 100;
+            if (type == LED_EFFECT_TWINKLE)
+            {
+                // between the two colors
+                for (int c = 0; c < 3; c++)
+                {
+                    uint8_t low = TestParams.colors[0][c] < TestParams.colors[1][c] ? TestParams.colors[0][c] : TestParams.colors[1][c];
+                    uint8_t high = TestParams.colors[0][c] + TestParams.colors[1][c] - low;
+                    outOfRange += rgb[c] < low || rgb[c] > high;
+                }
+            }
+            else
+            {
+                // the heat turns blue only once red and green are full
+                outOfRange += rgb[2] && (rgb[0] != 255 || rgb[1] != 255);
+            }
+        }
+    }
+    if (!differ || !lit || outOfRange)
+    {
+        printf("FAIL: %s: %s from another seed, %d LEDs lit, %d out of range\n", led_effect_name(type),
+               differ ? "differs" : "same frames", lit, outOfRange);
+        failed++;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        led_effect_deinit(&effect[i]);
+    }
+}
+
+// Function to hash the frames of an effect, FNV-1a of the frames every 20 ms for the first second
+static uint32_t hash_frames(led_effect_type_t type)
+{
+    led_effect_t effect;
+    start_effect(&effect, type, TestParams.seed);
+    uint32_t hash = 2166136261u;
+    for (uint32_t timeMs = 0; timeMs <= 1000; timeMs += 20)
+    {
+        led_effect_render(&effect, timeMs, states);
+        const uint8_t *bytes = (const uint8_t *)states;
+        for (size_t i = 0; i < sizeof(states); i++)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    }
+    led_effect_deinit(&effect);
+    return hash;
+}
+
+int main(void)
+{
+    test_models();
+    test_random(LED_EFFECT_TWINKLE);
+    test_random(LED_EFFECT_FIRE);
+    int cases = 3;
+
+    for (int type = LED_EFFECT_NONE + 1; type < LED_EFFECT_COUNT; type++)
+    {
+        uint32_t hash = hash_frames(type);
+        if (hash != GoldenFrames[type])
+        {
+            printf("FAIL: %s frames hash to 0x%08x, golden 0x%08x\n", led_effect_name(type), hash, GoldenFrames[type]);
+            failed++;
+        }
+        cases++;
+    }
+
+    for (int type = 0; type < LED_EFFECT_COUNT; type++)
+    {
+        failed += (int)led_effect_from_name(led_effect_name(type)) != type;
+    }
+    failed += led_effect_from_name("strobe") != LED_EFFECT_COUNT;
+    cases += 2;
+
+    printf("Effects: %d cases, %d failed\n", cases, failed);
+    return failed != 0;
+}
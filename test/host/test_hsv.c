@@ -0,0 +1,137 @@
+/**
+ * @file test_hsv.c
+ * @brief Host test of the batch HSV to RGB conversion against the per-pixel code it replaced, directly, through
+ * led_strip_set_pixel_hsv and through the chunks of led_strip_set_pixels_hsv.
+ */
+
+#include <stdio.h>  // Standard input/output functions
+#include <stdint.h> // Standard integer types
+#include <string.h> // String manipulation functions
+
+#include "led_strip.h"           // LED strip library
+#include "led_strip_interface.h" // LED strip driver interface
+
+#define TEST_SPAN 100 // Pixels of the spans set with led_strip_set_pixels_hsv, more than one chunk
+
+static uint8_t captured[TEST_SPAN * 3]; // Pixels set on the test strip
+
+// Function to convert a color from HSV to RGB with the per-pixel code of led_strip_set_pixel_hsv before the batch conversion
+static void reference_hsv(uint16_t hue, uint8_t saturation, uint8_t value, uint8_t *rgb)
+{
+    uint32_t red = 0;
+    uint32_t green = 0;
+    uint32_t blue = 0;
+    uint32_t rgb_max = value;
+    uint32_t rgb_min = rgb_max * (255 - saturation) / 255.0f;
+    uint32_t i = hue / 60;
+    uint32_t diff = hue % 60;
+    uint32_t rgb_adj = (rgb_max - rgb_min) * diff / 60;
+    switch (i)
+    {
+    case 0:
+        red = rgb_max;
+        green = rgb_min + rgb_adj;
+        blue = rgb_min;
+        break;
+    case 1:
+        red = rgb_max - rgb_adj;
+        green = rgb_max;
+        blue = rgb_min;
+        break;
+    case 2:
+        red = rgb_min;
+        green = rgb_max;
+        blue = rgb_min + rgb_adj;
+        break;
+    case 3:
+        red = rgb_min;
+        green = rgb_max - rgb_adj;
+        blue = rgb_max;
+        break;
+    case 4:
+        red = rgb_min + rgb_adj;
+        green = rgb_min;
+        blue = rgb_max;
+        break;
+    default:
+        red = rgb_max;
+        green = rgb_min;
+        blue = rgb_max - rgb_adj;
+        break;
+    }
+    rgb[0] = red;
+    rgb[1] = green;
+    rgb[2] = blue;
+}
+
+// Function to capture a pixel set on the test strip
+static esp_err_t capture_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    captured[index * 3] = red;
+    captured[index * 3 + 1] = green;
+    captured[index * 3 + 2] = blue;
+    return ESP_OK;
+}
+
+// Function to capture a span set on the test strip
+static esp_err_t capture_pixels(led_strip_t *strip, uint32_t offset, const uint8_t *src, uint32_t count, led_strip_src_format_t format)
+{
+    if (format != LED_STRIP_SRC_FORMAT_RGB || offset + count > TEST_SPAN)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(&captured[offset * 3], src, count * 3);
+    return ESP_OK;
+}
+
+int main(void)
+{
+    led_strip_t strip = {
+        .set_pixel = capture_pixel,
+        .set_pixels = capture_pixels,
+    };
+    led_strip_hsv_t hsv[256];
+    uint8_t rgb[256 * 3];
+    uint8_t expected[TEST_SPAN * 3];
+    long conversions = 0;
+    long failed = 0;
+
+    // every saturation and value, for the hues of the first turns and a spread of the others up to 65535
+    for (uint32_t hue = 0; hue < 65536; hue += hue < 720 ? 1 : 251)
+    {
+        for (int saturation = 0; saturation < 256; saturation++)
+        {
+            for (int value = 0; value < 256; value++)
+            {
+                hsv[value] = (led_strip_hsv_t){.hue = hue, .saturation = saturation, .value = value};
+            }
+            led_strip_hsv_to_rgb(hsv, rgb, 256);
+            for (int value = 0; value < 256; value++, conversions++)
+            {
+                reference_hsv(hue, saturation, value, expected);
+                failed += memcmp(&rgb[value * 3], expected, 3) != 0;
+            }
+            int value = (hue + saturation) & 0xFF;
+            led_strip_set_pixel_hsv(&strip, 0, hue, saturation, value);
+            reference_hsv(hue, saturation, value, expected);
+            failed += memcmp(captured, expected, 3) != 0;
+        }
+    }
+
+    // spans of every length up to TEST_SPAN, converted chunk by chunk
+    for (uint32_t count = 0; count <= TEST_SPAN; count++)
+    {
+        uint32_t offset = TEST_SPAN - count;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            hsv[i] = (led_strip_hsv_t){.hue = (i * 37 + count) % 360, .saturation = i * 11, .value = 255 - i};
+            reference_hsv(hsv[i].hue, hsv[i].saturation, hsv[i].value, &expected[(offset + i) * 3]);
+        }
+        memset(captured, 0, sizeof(captured));
+        failed += led_strip_set_pixels_hsv(&strip, offset, hsv, count) != ESP_OK;
+        failed += memcmp(&captured[offset * 3], &expected[offset * 3], count * 3) != 0;
+    }
+
+    printf("HSV: %ld conversions and %d spans, %ld failed\n", conversions, TEST_SPAN + 1, failed);
+    return failed != 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file test_i2s_encoder.c
+ * @brief Host test of the I2S/LCD parallel encoder: the bit matrix transpose of 8 and 16 lanes against a reference
+ * encoder, which sends each bit of each lane as a high slot, a data slot and a low slot.
+ */
+
+#include <stdio.h>  // Standard input/output functions
+#include <stdint.h> // Standard integer types
+#include <stdlib.h> // Memory allocation functions
+
+#include "led_strip_i2s_encoder.h" // I2S encoder functions
+
+#define TEST_MAX_LANES 16
+#define TEST_MAX_LANE_BYTES 61
+
+// Function to get the level of a lane in a slot of the reference bitstream
+static int reference_level(const uint8_t *lane, size_t byte, int bit, int slot)
+{
+    switch (slot)
+    {
+    case 0:
+        return 1;
+    case 1:
+        return (lane[byte] >> (7 - bit)) & 1;
+    default:
+        return 0;
+    }
+}
+
+// Function to encode random lanes and compare every slot with the reference. Returns the number of wrong levels.
+static int test_lanes(uint8_t laneCount, size_t laneBytes)
+{
+    static uint8_t data[TEST_MAX_LANES][TEST_MAX_LANE_BYTES];
+    const uint8_t *lanes[TEST_MAX_LANES];
+    for (int l = 0; l < laneCount; l++)
+    {
+        for (size_t k = 0; k < laneBytes; k++)
+        {
+            data[l][k] = (uint8_t)rand();
+        }
+        lanes[l] = data[l];
+    }
+
+    size_t slotSize = laneCount / 8;
+    uint8_t *buf = malloc(laneBytes * LED_STRIP_I2S_BYTES_PER_LANE_BYTE(laneCount) + 1);
+    led_strip_i2s_prepare_bitstream(buf, laneBytes, laneCount);
+    if (laneCount == 8)
+    {
+        led_strip_i2s_encode_8(lanes, laneBytes, buf);
+    }
+    else
+    {
+        led_strip_i2s_encode_16(lanes, laneBytes, (uint16_t *)buf);
+    }
+
+    int wrong = 0;
+    for (size_t k = 0; k < laneBytes; k++)
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            for (int slot = 0; slot < LED_STRIP_I2S_SLOTS_PER_BIT; slot++)
+            {
+                size_t index = (k * 8 + bit) * LED_STRIP_I2S_SLOTS_PER_BIT + slot;
+                unsigned levels = slotSize == 1 ? buf[index] : ((uint16_t *)buf)[index];
+                for (int l = 0; l < laneCount; l++)
+                {
+                    wrong += (int)((levels >> l) & 1) != reference_level(data[l], k, bit, slot);
+                }
+            }
+        }
+    }
+    free(buf);
+    return wrong;
+}
+
+int main(void)
+{
+    int failed = 0;
+    int cases = 0;
+    srand(1);
+    for (uint8_t laneCount = 8; laneCount <= TEST_MAX_LANES; laneCount += 8)
+    {
+        for (size_t laneBytes = 0; laneBytes <= TEST_MAX_LANE_BYTES; laneBytes += 1 + laneBytes / 4)
+        {
+            int wrong = test_lanes(laneCount, laneBytes);
+            if (wrong)
+            {
+                printf("FAIL: %d lanes, %zu bytes per lane: %d wrong levels\n", laneCount, laneBytes, wrong);
+                failed++;
+            }
+            cases++;
+        }
+    }
+    printf("I2S encoder: %d cases, %d failed\n", cases, failed);
+    return failed != 0;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file test_layer_blend.c
+ * @brief Host test of the SWAR blend kernels of the overlay layers. Every blend mode is checked against a scalar
+ * reference that blends one channel at a time with the same integer weights, which the kernels must match exactly,
+ * and against a floating point model of the mode, which they must match within one level once rounded.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdlib.h>  // Standard library functions
+#include <string.h>  // String manipulation functions
+#include <math.h>    // Math functions
+
+#include "render_handler.h" // LED state
+#include "led_layer.h"      // LED layer functions
+
+#define TEST_SPAN 61
+
+static int failed;
+
+// Function to get the weight (0 - 256) of a pixel of a given coverage on a layer of a given opacity
+static int reference_weight(int alpha, int opacity)
+{
+    uint32_t opacityScale = ((uint32_t)opacity * (256u << 16) + 65025 / 2) / 65025;
+    return (alpha * opacityScale + 0x8000) >> 16;
+}
+
+// Function to blend a channel of the layer into a channel of the frame, one channel at a time
+static int reference_blend(int dst, int src, int weight, led_layer_blend_t blend)
+{
+    switch (blend)
+    {
+    case LED_LAYER_BLEND_ADD:
+    {
+        int sum = dst + ((src * weight + 128) >> 8);
+        return sum > 255 ? 255 : sum;
+    }
+    case LED_LAYER_BLEND_MULTIPLY:
+    {
+        int product = dst * src + 128;
+        product = (product + (product >> 8)) >> 8;
+        return (dst * (256 - weight) + product * weight + 128) >> 8;
+    }
+    case LED_LAYER_BLEND_MAX:
+    {
+        int scaled = (src * weight + 128) >> 8;
+        return scaled > dst ? scaled : dst;
+    }
+    default:
+        return (dst * (256 - weight) + src * weight + 128) >> 8;
+    }
+}
+
+// Function to blend a channel with the floating point model of a blend mode
+static double model_blend(int dst, int src, int alpha, int opacity, led_layer_blend_t blend)
+{
+    double weight = alpha / 255.0 * opacity / 255.0;
+    switch (blend)
+    {
+    case LED_LAYER_BLEND_ADD:
+        return fmin(dst + src * weight, 255);
+    case LED_LAYER_BLEND_MULTIPLY:
+        return dst + (dst * src / 255.0 - dst) * weight;
+    case LED_LAYER_BLEND_MAX:
+        return fmax(dst, src * weight);
+    default:
+        return dst + (src - dst) * weight;
+    }
+}
+
+// Function to check one blended pixel against the scalar reference and the model
+static void check_pixel(const struct ledState *before, const struct ledState *after, uint32_t pixel, int opacity,
+                        led_layer_blend_t blend)
+{
+    const uint8_t dst[3] = {before->red, before->green, before->blue};
+    const uint8_t got[3] = {after->red, after->green, after->blue};
+    const uint8_t src[3] = {pixel, pixel >> 8, pixel >> 16};
+    int alpha = pixel >> 24;
+    int weight = reference_weight(alpha, opacity);
+    for (int c = 0; c < 3; c++)
+    {
+        int expected = alpha == 0 ? dst[c] : reference_blend(dst[c], src[c], weight, blend);
+        double model = model_blend(dst[c], src[c], alpha, opacity, blend);
+        if (got[c] != expected || abs(got[c] - (int)lround(model)) > 1)
+        {
+            if (failed < 10)
+            {
+                printf("FAIL: %s, alpha %d, opacity %d, channel %d: %d over %d gives %d, reference %d, model %.2f\n",
+                       led_layer_blend_name(blend), alpha, opacity, c, src[c], dst[c], got[c], expected, model);
+            }
+            failed++;
+            return;
+        }
+    }
+}
+
+// Function to blend a grid of levels, coverages and opacities one pixel at a time
+static void test_grid(led_layer_blend_t blend)
+{
+    for (int opacity = 0; opacity < 256; opacity += 15)
+    {
+        for (int alpha = 0; alpha < 256; alpha += 5)
+        {
+            for (int dst = 0; dst < 256; dst += 5)
+            {
+                for (int src = 0; src < 256; src += 3)
+                {
+                    struct ledState before = {dst, 255 - dst, (dst * 7) & 0xFF};
+                    struct ledState after = before;
+                    uint32_t pixel = LED_LAYER_PIXEL(src, (src * 3) & 0xFF, 255 - src, alpha);
+                    led_layer_blend(&after, &pixel, 1, opacity, blend);
+                    check_pixel(&before, &after, pixel, opacity, blend);
+                }
+            }
+        }
+    }
+}
+
+// Function to blend random spans, a third of the pixels transparent, with random coverages and opacities
+static void test_spans(led_layer_blend_t blend)
+{
+    struct ledState before[TEST_SPAN];
+    struct ledState after[TEST_SPAN];
+    uint32_t pixels[TEST_SPAN];
+    for (int round = 0; round < 20000; round++)
+    {
+        int opacity = round & 1 ? 255 : rand() & 0xFF;
+        for (int i = 0; i < TEST_SPAN; i++)
+        {
+            before[i] = (struct ledState){rand() & 0xFF, rand() & 0xFF, rand() & 0xFF};
+            int alpha = rand() % 3 == 0 ? 0 : (rand() & 1 ? 255 : rand() & 0xFF);
+            pixels[i] = LED_LAYER_PIXEL(rand() & 0xFF, rand() & 0xFF, rand() & 0xFF, alpha);
+        }
+        memcpy(after, before, sizeof(after));
+        led_layer_blend(after, pixels, TEST_SPAN, opacity, blend);
+        for (int i = 0; i < TEST_SPAN; i++)
+        {
+            check_pixel(&before[i], &after[i], pixels[i], opacity, blend);
+        }
+    }
+}
+
+int main(void)
+{
+    srand(1);
+    int cases = 0;
+    for (led_layer_blend_t blend = 0; blend < LED_LAYER_BLEND_COUNT; blend++)
+    {
+        test_grid(blend);
+        test_spans(blend);
+        failed += led_layer_blend_from_name(led_layer_blend_name(blend)) != blend;
+        cases += 3;
+    }
+    failed += led_layer_blend_name(LED_LAYER_BLEND_COUNT) != NULL;
+    failed += led_layer_blend_from_name("screen") != LED_LAYER_BLEND_COUNT;
+    cases += 2;
+
+    printf("Layer blend: %d cases, %d failed\n", cases, failed);
+    return failed != 0;
+}
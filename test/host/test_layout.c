@@ -0,0 +1,345 @@
+/**
+ * @file test_layout.c
+ * @brief Host test of the layouts of the LED strip, built for CONFIG_LED_COUNT LEDs (the build sets 300 and 600). The
+ * compiled tables of small matrices, serpentine, mirrored and rotated, and of lists of coordinates are checked against
+ * tables worked out by hand, random layouts against the properties of the tables, and invalid layouts must be
+ * rejected. Random layout changes, frames, blackouts and master dimmer levels then run through the render module,
+ * with and without the color lookup table of the LED strip. After each step, the frame read back and the frame hash
+ * must match a model of the frame in the order of the layout, and the LED strip must hold the model remapped to the
+ * wiring through the layout, dimmed once the test turns the table off. Frames numbered in the layout before the
+ * current one must be dropped. The render module is built into the test to reach its internal functions, over the RMT
+ * backend with the mock driver.
+ */
+
+#include "render_handler.c" // Render module, with its internal functions
+
+#include "rmt_mock.h"  // RMT mock
+#include "rtos_mock.h" // RTOS mock
+
+#define TEST_STEPS 10000
+#define TEST_MAX_SIDE 40 // Largest width and height of the random layouts
+
+// A layout worked out by hand, compiled for a number of LEDs
+typedef struct
+{
+    const char *name;
+    led_layout_desc_t desc;
+    int count;
+    uint16_t physical[8]; // Index on the LED strip of each LED, in the order of the rows of the layout
+} test_table_t;
+
+static const uint16_t Coordinates[] = {1, 0, 0, 0, 0, 1};
+
+static const test_table_t Tables[] = {
+    {"3x2", {.width = 3, .height = 2}, 6, {0, 1, 2, 3, 4, 5}},
+    {"3x2 serpentine", {.width = 3, .height = 2, .serpentine = true}, 6, {0, 1, 2, 5, 4, 3}},
+    {"3x2 mirror", {.width = 3, .height = 2, .mirror = true}, 6, {2, 1, 0, 5, 4, 3}},
+    {"3x2 rotated by 90", {.width = 3, .height = 2, .rotation = 90}, 6, {4, 2, 0, 5, 3, 1}},
+    {"3x2 rotated by 180", {.width = 3, .height = 2, .rotation = 180}, 6, {5, 4, 3, 2, 1, 0}},
+    {"3x2 rotated by 270", {.width = 3, .height = 2, .rotation = 270}, 6, {1, 3, 5, 0, 2, 4}},
+    {"3x2 serpentine rotated by 90", {.width = 3, .height = 2, .serpentine = true, .rotation = 90}, 6, {4, 3, 0, 5, 2, 1}},
+    {"2x2 serpentine, 6 LEDs", {.width = 2, .height = 2, .serpentine = true}, 6, {0, 1, 3, 2, 4, 5}},
+    {"3x2, 4 LEDs", {.width = 3, .height = 2}, 4, {0, 1, 2, 3}},
+    {"coordinates", {.width = 2, .height = 2, .coordinates = Coordinates, .coordinate_count = 3}, 4, {1, 0, 2, 3}},
+};
+
+static struct ledState model[CONFIG_LED_COUNT]; // Frame in the order of the layout
+static uint8_t modelDimmer = 255;
+static led_layout_t *modelLayout; // Copy of the layout of the render module, NULL for the order of the wiring
+static uint16_t cellList[TEST_MAX_SIDE * TEST_MAX_SIDE];
+static uint16_t coordinates[CONFIG_LED_COUNT * 2];
+
+// Function to check the tables of the layouts worked out by hand. Returns the number of wrong layouts.
+static int test_tables(void)
+{
+    int wrong = 0;
+    for (size_t t = 0; t < sizeof(Tables) / sizeof(Tables[0]); t++)
+    {
+        const test_table_t *table = &Tables[t];
+        led_layout_t *layout;
+        bool match = led_layout_compile(&table->desc, table->count, &layout) == ESP_OK;
+        match = match && memcmp(layout->physical, table->physical, table->count * sizeof(uint16_t)) == 0;
+        bool identity = true;
+        for (int i = 0; i < table->count; i++)
+        {
+            identity = identity && table->physical[i] == i;
+        }
+        match = match && layout->wiring_order == identity;
+        if (!match)
+        {
+            printf("FAIL: layout %s\n", table->name);
+            wrong++;
+        }
+        led_layout_free(layout);
+    }
+
+    // The cells without an LED, and the positions out of the layout
+    led_layout_t *layout;
+    ESP_ERROR_CHECK(led_layout_compile(&Tables[9].desc, Tables[9].count, &layout));
+    bool match = led_layout_index(layout, 1, 0) == 1 && led_layout_index(layout, 0, 1) == 2;
+    match = match && led_layout_index(layout, 1, 1) == -1 && led_layout_index(layout, 2, 0) == -1;
+    match = match && led_layout_index(layout, 0, -1) == -1 && led_layout_index(layout, -1, 0) == -1;
+    led_layout_free(layout);
+    ESP_ERROR_CHECK(led_layout_compile(&Tables[8].desc, Tables[8].count, &layout));
+    match = match && led_layout_index(layout, 0, 1) == 3 && led_layout_index(layout, 1, 1) == -1;
+    led_layout_free(layout);
+    if (!match)
+    {
+        printf("FAIL: positions of the layouts\n");
+        wrong++;
+    }
+    return wrong;
+}
+
+// Function to check that invalid layouts are rejected. Returns the number of layouts not rejected as they should be.
+static int test_rejections(void)
+{
+    static const uint16_t taken[] = {0, 0, 1, 0, 0, 0};
+    static const uint16_t outside[] = {0, 0, 2, 0};
+    static const struct
+    {
+        led_layout_desc_t desc;
+        int count;
+        esp_err_t err;
+    } Invalid[] = {
+        {{.width = 0, .height = 2}, 10, ESP_ERR_INVALID_ARG},
+        {{.width = 2, .height = 0}, 10, ESP_ERR_INVALID_ARG},
+        {{.width = 2, .height = 2, .rotation = 45}, 10, ESP_ERR_INVALID_ARG},
+        {{.width = 2, .height = 2}, 0, ESP_ERR_INVALID_ARG},
+        {{.width = 2, .height = 2}, LED_LAYOUT_NONE, ESP_ERR_INVALID_ARG},
+        {{.width = 2, .height = 2, .coordinate_count = 2}, 10, ESP_ERR_INVALID_ARG},
+        {{.width = 2, .height = 2, .coordinates = taken, .coordinate_count = 3}, 10, ESP_ERR_INVALID_ARG},
+        {{.width = 2, .height = 2, .coordinates = outside, .coordinate_count = 2}, 10, ESP_ERR_INVALID_ARG},
+        {{.width = 2, .height = 2, .coordinates = taken, .coordinate_count = 3}, 2, ESP_ERR_INVALID_SIZE},
+        {{.width = 100, .height = 100}, 10, ESP_ERR_INVALID_SIZE},
+        {{.width = 65535, .height = 65535}, 10, ESP_ERR_INVALID_SIZE},
+    };
+    int wrong = 0;
+    for (size_t i = 0; i < sizeof(Invalid) / sizeof(Invalid[0]); i++)
+    {
+        led_layout_t *layout = (led_layout_t *)1;
+        if (led_layout_compile(&Invalid[i].desc, Invalid[i].count, &layout) != Invalid[i].err || layout != NULL)
+        {
+            printf("FAIL: invalid layout %d not rejected\n", (int)i);
+            wrong++;
+        }
+    }
+    return wrong;
+}
+
+// Function to describe a random layout for the LED strip: a matrix, smaller or larger than the strip, serpentine,
+// mirrored and rotated, or a list of random coordinates. Returns the number of LEDs laid out.
+static int random_layout(led_layout_desc_t *desc)
+{
+    *desc = (led_layout_desc_t){
+        .width = 1 + rand() % TEST_MAX_SIDE,
+        .height = 1 + rand() % TEST_MAX_SIDE,
+        .serpentine = rand() % 2,
+        .mirror = rand() % 2,
+        .rotation = 90 * (rand() % 4),
+    };
+    int cellCount = desc->width * desc->height;
+    int placed = cellCount < CONFIG_LED_COUNT ? cellCount : CONFIG_LED_COUNT;
+    if (rand() % 3 == 0)
+    {
+        // Random cells, shuffled
+        for (int i = 0; i < cellCount; i++)
+        {
+            cellList[i] = i;
+        }
+        placed = 1 + rand() % placed;
+        for (int i = 0; i < placed; i++)
+        {
+            int j = i + rand() % (cellCount - i);
+            uint16_t cell = cellList[j];
+            cellList[j] = cellList[i];
+            cellList[i] = cell;
+            coordinates[i * 2] = cell % desc->width;
+            coordinates[i * 2 + 1] = cell / desc->width;
+        }
+        desc->coordinates = coordinates;
+        desc->coordinate_count = placed;
+    }
+    return placed;
+}
+
+// Function to check the properties of the tables of a layout: the LEDs laid out fill their cells in the order of the
+// rows, each LED of the wiring has one place, and the LEDs past the layout keep their order. Returns true if they hold.
+static bool check_layout(const led_layout_t *layout, int placed)
+{
+    static bool seen[CONFIG_LED_COUNT];
+    memset(seen, 0, sizeof(seen));
+    bool match = layout->count == CONFIG_LED_COUNT;
+    bool identity = true;
+    int index = 0;
+    for (int y = 0; y < layout->height; y++)
+    {
+        for (int x = 0; x < layout->width; x++)
+        {
+            int led = led_layout_index(layout, x, y);
+            match = match && (led < 0 || led == index++);
+        }
+    }
+    match = match && index == placed;
+    for (int i = 0; i < CONFIG_LED_COUNT && match; i++)
+    {
+        int wiring = layout->physical[i];
+        match = match && !seen[wiring] && (i < placed ? wiring < placed : wiring == i);
+        seen[wiring] = true;
+        identity = identity && wiring == i;
+    }
+    return match && layout->wiring_order == identity;
+}
+
+// Function to execute a priority command
+static void test_priority(render_priority_type_t type, uint8_t value)
+{
+    const render_priority_cmd_t cmd = {.type = type, .value = value};
+    render_execute_priority(&cmd);
+}
+
+// Function to apply a frame of random LEDs, in runs of consecutive LEDs or scattered, numbered in a layout. The model
+// only takes the frame if it is numbered in the current layout.
+static void test_frame(uint32_t generation)
+{
+    uint32_t count = 1 + rand() % (rand() % 4 ? 16 : CONFIG_LED_COUNT);
+    render_frame_t *frame = render_frame_alloc(count);
+    uint16_t index = rand() % CONFIG_LED_COUNT;
+    bool run = rand() % 2;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        render_pixel_t *pixel = &frame->pixels[i];
+        index = run ? (index + 1) % CONFIG_LED_COUNT : rand() % CONFIG_LED_COUNT;
+        pixel->index = index;
+        pixel->color.red = rand();
+        pixel->color.green = rand() % 8 ? rand() : 0;
+        pixel->color.blue = rand();
+        if (generation == layoutGeneration)
+        {
+            model[index] = pixel->color;
+        }
+    }
+    frame->count = count;
+    frame->layout = generation;
+    render_apply_frame(frame);
+    free(frame);
+}
+
+// Function to check the frame read back, the frame hash and the LED strip against the model. Returns true if they match.
+static bool test_check(bool lut)
+{
+    static struct ledState states[CONFIG_LED_COUNT];
+    static struct ledState strip[CONFIG_LED_COUNT];
+    render_read_led_states(0, states, CONFIG_LED_COUNT);
+    bool match = memcmp(states, model, sizeof(model)) == 0;
+
+    uint32_t hash = 0;
+    for (int i = 0; i < CONFIG_LED_COUNT; i++)
+    {
+        hash += led_state_hash(i, &model[i]);
+    }
+    match = match && frameHash == hash;
+
+    // The LED strip holds each LED at its place in the wiring, dimmed without the table
+    ESP_ERROR_CHECK(led_strip_get_pixels(led_strip, 0, (uint8_t *)strip, CONFIG_LED_COUNT, LED_STRIP_SRC_FORMAT_RGB));
+    for (int i = 0; i < CONFIG_LED_COUNT && match; i++)
+    {
+        const uint8_t *set = &model[i].red;
+        const uint8_t *held = &strip[modelLayout != NULL ? modelLayout->physical[i] : i].red;
+        for (int c = 0; c < 3; c++)
+        {
+            match = match && held[c] == (lut ? set[c] : (set[c] * (modelDimmer + 1)) >> 8);
+        }
+    }
+    return match && masterDimmer == modelDimmer;
+}
+
+// Function to run random steps. Returns the number of steps after which the render module and the model differ.
+static int test_steps(bool lut, int *steps, int *layouts)
+{
+    int wrong = 0;
+    for (int step = 0; step < TEST_STEPS; step++)
+    {
+        int kind = rand() % 100;
+        if (kind < 8)
+        {
+            // A new layout, or back to the order of the wiring. The render module and the model get their own copy.
+            render_priority_cmd_t cmd = {.type = RENDER_PRIORITY_LAYOUT, .layout_generation = layoutGeneration + 1};
+            led_layout_free(modelLayout);
+            modelLayout = NULL;
+            if (rand() % 8)
+            {
+                led_layout_desc_t desc;
+                int placed = random_layout(&desc);
+                ESP_ERROR_CHECK(led_layout_compile(&desc, CONFIG_LED_COUNT, &cmd.layout));
+                ESP_ERROR_CHECK(led_layout_compile(&desc, CONFIG_LED_COUNT, &modelLayout));
+                wrong += !check_layout(modelLayout, placed);
+            }
+            render_execute_priority(&cmd);
+            (*layouts)++;
+        }
+        else if (kind < 12)
+        {
+            // Queued before the last layout change
+            test_frame(layoutGeneration - 1);
+        }
+        else if (kind < 82)
+        {
+            test_frame(layoutGeneration);
+        }
+        else if (kind < 85)
+        {
+            test_priority(RENDER_PRIORITY_BLACKOUT, 0);
+            memset(model, 0, sizeof(model));
+        }
+        else
+        {
+            modelDimmer = rand() % 3 ? rand() : 255;
+            test_priority(RENDER_PRIORITY_DIMMER, modelDimmer);
+        }
+        wrong += !test_check(lut);
+        (*steps)++;
+    }
+    return wrong;
+}
+
+int main(void)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = CONFIG_LED_COUNT,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+    };
+    led_strip_rmt_config_t rmtConfig = {0};
+    led_strip_handle_t strip;
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfig, &strip));
+    ESP_ERROR_CHECK(led_strip_clear(strip));
+    render_start(strip);
+    srand(1);
+
+    int failed = test_tables() + test_rejections();
+    int steps = 0;
+    int layouts = 0;
+    for (int lut = 1; lut >= 0; lut--)
+    {
+        if (!lut)
+        {
+            // Back to full level, then take the table away as if the backend had none
+            modelDimmer = 255;
+            test_priority(RENDER_PRIORITY_DIMMER, modelDimmer);
+            ESP_ERROR_CHECK(led_strip_set_color_lut(led_strip, NULL));
+            colorLutSupported = false;
+        }
+        uint32_t flushed = stats.frames_flushed;
+        int wrong = test_steps(lut, &steps, &layouts);
+        if (wrong || stats.frames_flushed == flushed)
+        {
+            printf("FAIL: color lookup table %d, %d wrong steps\n", lut, wrong);
+            failed++;
+        }
+    }
+    led_layout_free(modelLayout);
+
+    printf("Layouts of %d LEDs: %d steps, %d layouts, %d failed\n", CONFIG_LED_COUNT, steps, layouts, failed);
+    return failed != 0;
+}
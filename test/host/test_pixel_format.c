@@ -0,0 +1,170 @@
+/**
+ * @file test_pixel_format.c
+ * @brief Host test of the pixel formats through the SPI backend, with and without streaming: random set_pixel,
+ * set_pixel_rgbw, set_pixels and fill operations on a strip of each format. After each operation, the LED data sent by
+ * a refresh must hold the channels of each pixel in the order of the format, and the strip must read back as set.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Standard library functions
+#include <string.h>  // String manipulation functions
+
+#include "spi_mock.h"  // SPI mock
+#include "led_strip.h" // LED strip library
+
+#define TEST_PIXELS 64
+#define TEST_OPERATIONS 300
+
+typedef struct
+{
+    led_pixel_format_t format;
+    const char *name;
+    int bytes;
+    uint8_t order[4]; // Channel of each LED data byte: 0 red, 1 green, 2 blue, 3 white
+} test_format_t;
+
+static const test_format_t Formats[] = {
+    {LED_PIXEL_FORMAT_GRB, "GRB", 3, {1, 0, 2}},
+    {LED_PIXEL_FORMAT_GRBW, "GRBW", 4, {1, 0, 2, 3}},
+    {LED_PIXEL_FORMAT_RGB, "RGB", 3, {0, 1, 2}},
+    {LED_PIXEL_FORMAT_BGR, "BGR", 3, {2, 1, 0}},
+    {LED_PIXEL_FORMAT_RGBW, "RGBW", 4, {0, 1, 2, 3}},
+};
+
+static uint8_t model[TEST_PIXELS][4]; // Red, green, blue and white of each pixel
+
+// Function to check the LED data sent by a refresh of the whole strip, with the 3-bit SPI pattern of the 80 MHz clock:
+// the middle SPI bit of each LED bit is the LED bit
+static bool check_sent(const test_format_t *format)
+{
+    for (int i = 0; i < TEST_PIXELS; i++)
+    {
+        for (int b = 0; b < format->bytes; b++)
+        {
+            int value = 0;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                size_t spiBit = ((size_t)(i * format->bytes + b) * 8 + bit) * 3 + 1;
+                value = value << 1 | (spi_mock_bytes[spiBit / 8] >> (7 - spiBit % 8) & 1);
+            }
+            if (value != model[i][format->order[b]])
+            {
+                return false;
+            }
+        }
+    }
+    return spi_mock_byte_count == TEST_PIXELS * format->bytes * 3;
+}
+
+// Function to run random operations on a strip of a format. Returns the number of wrong operations.
+static int test_format(const test_format_t *format, bool streaming, int *operations)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = TEST_PIXELS,
+        .led_pixel_format = format->format,
+        .led_model = LED_MODEL_WS2812,
+        .full_refresh_interval = 1,
+    };
+    led_strip_spi_config_t spiConfig = {.flags.with_dma = true, .flags.streaming = streaming};
+    led_strip_handle_t strip;
+    spi_mock_source_hz = 80000000;
+    ESP_ERROR_CHECK(led_strip_new_spi_device(&stripConfig, &spiConfig, &strip));
+    ESP_ERROR_CHECK(led_strip_clear(strip));
+    memset(model, 0, sizeof(model));
+    bool rgbw = format->bytes == 4;
+
+    int wrong = 0;
+    for (int op = 0; op < TEST_OPERATIONS; op++)
+    {
+        uint32_t offset = rand() % TEST_PIXELS;
+        uint32_t count = 1 + rand() % (TEST_PIXELS - offset);
+        uint8_t color[4] = {rand(), rand(), rand(), rgbw ? rand() : 0};
+        int kind = rand() % 4;
+        if (kind == 0 || (kind == 1 && !rgbw))
+        {
+            ESP_ERROR_CHECK(led_strip_set_pixel(strip, offset, color[0], color[1], color[2]));
+            color[3] = 0;
+            memcpy(model[offset], color, 4);
+        }
+        else if (kind == 1)
+        {
+            ESP_ERROR_CHECK(led_strip_set_pixel_rgbw(strip, offset, color[0], color[1], color[2], color[3]));
+            memcpy(model[offset], color, 4);
+        }
+        else if (kind == 2)
+        {
+            uint8_t src[TEST_PIXELS * 4];
+            bool srcRgbw = rgbw && rand() % 2;
+            int srcBytes = srcRgbw ? 4 : 3;
+            for (uint32_t i = 0; i < count * srcBytes; i++)
+            {
+                src[i] = rand();
+            }
+            ESP_ERROR_CHECK(led_strip_set_pixels(strip, offset, src, count, srcRgbw ? LED_STRIP_SRC_FORMAT_RGBW : LED_STRIP_SRC_FORMAT_RGB));
+            for (uint32_t i = 0; i < count; i++)
+            {
+                memcpy(model[offset + i], &src[i * srcBytes], 3);
+                model[offset + i][3] = srcRgbw ? src[i * srcBytes + 3] : 0;
+            }
+        }
+        else
+        {
+            if (rgbw)
+            {
+                ESP_ERROR_CHECK(led_strip_fill_rgbw(strip, offset, count, color[0], color[1], color[2], color[3]));
+            }
+            else
+            {
+                ESP_ERROR_CHECK(led_strip_fill(strip, offset, count, color[0], color[1], color[2]));
+            }
+            for (uint32_t i = 0; i < count; i++)
+            {
+                memcpy(model[offset + i], color, 4);
+            }
+        }
+
+        spi_mock_byte_count = 0;
+        ESP_ERROR_CHECK(led_strip_refresh(strip));
+        bool match = check_sent(format);
+        uint8_t back[TEST_PIXELS][4];
+        ESP_ERROR_CHECK(led_strip_get_pixels(strip, 0, (uint8_t *)back, TEST_PIXELS, rgbw ? LED_STRIP_SRC_FORMAT_RGBW : LED_STRIP_SRC_FORMAT_RGB));
+        for (int i = 0; i < TEST_PIXELS; i++)
+        {
+            match = match && memcmp(&((uint8_t *)back)[i * format->bytes], model[i], format->bytes) == 0;
+        }
+        wrong += !match;
+        (*operations)++;
+    }
+
+    // a 3 bytes strip has no white channel to set
+    uint8_t src[4] = {1, 2, 3, 4};
+    wrong += !rgbw && led_strip_set_pixel_rgbw(strip, 0, 1, 2, 3, 4) != ESP_ERR_INVALID_ARG;
+    wrong += !rgbw && led_strip_set_pixels(strip, 0, src, 1, LED_STRIP_SRC_FORMAT_RGBW) != ESP_ERR_INVALID_ARG;
+    wrong += !rgbw && led_strip_fill_rgbw(strip, 0, 1, 1, 2, 3, 4) != ESP_ERR_INVALID_ARG;
+    ESP_ERROR_CHECK(led_strip_del(strip));
+    return wrong;
+}
+
+int main(void)
+{
+    srand(1);
+    int failed = 0;
+    int operations = 0;
+    for (size_t f = 0; f < sizeof(Formats) / sizeof(Formats[0]); f++)
+    {
+        for (int streaming = 0; streaming < 2; streaming++)
+        {
+            int wrong = test_format(&Formats[f], streaming, &operations);
+            if (wrong)
+            {
+                printf("FAIL: %s, streaming %d: %d wrong operations\n", Formats[f].name, streaming, wrong);
+                failed++;
+            }
+        }
+    }
+
+    printf("Pixel formats: %d operations, %d failed\n", operations, failed);
+    return failed != 0;
+}
@@ -0,0 +1,226 @@
+/**
+ * @file test_power_limit.c
+ * @brief Host test of the power limiter of the render module, built for CONFIG_LED_COUNT LEDs and a budget of
+ * CONFIG_LED_POWER_BUDGET_MA (the build sets 300 LEDs and 3000 mA). Random frames, master dimmer levels, scenes and
+ * color configs, with and without dithering, run with and without the color lookup table of the LED strip. After each
+ * step, the running sums must equal a rescan of the frame, the published estimate must match a floating point model
+ * of the current, and the output level must keep the frame within the budget, without staying further below the
+ * highest level within the budget than the headroom allows, and keep the headroom when it changes. An animated frame
+ * near the budget must keep its level. The render module is built into the test to reach its internal functions,
+ * over the RMT backend with the mock driver.
+ */
+
+#include "render_handler.c" // Render module, with its internal functions
+
+#include "rmt_mock.h"  // RMT mock
+#include "rtos_mock.h" // RTOS mock
+
+#define TEST_STEPS 2000
+#define TEST_ANIMATED_FRAMES 1000
+
+static const float Gammas[] = {1.0f, 1.8f, 2.2f, 2.8f};
+
+// Function to execute a priority command
+static void test_priority(render_priority_type_t type, uint8_t value)
+{
+    const render_priority_cmd_t cmd = {.type = type, .value = value};
+    render_execute_priority(&cmd);
+}
+
+// Function to set the gamma, white balance and dithering
+static void test_color_config(float gamma, const uint8_t gain[4], bool dither)
+{
+    render_priority_cmd_t cmd = {.type = RENDER_PRIORITY_COLOR_CONFIG, .gamma = gamma, .dither = dither};
+    memcpy(cmd.white_balance, gain, sizeof(cmd.white_balance));
+    render_execute_priority(&cmd);
+}
+
+// Function to apply a frame of random LEDs, bright enough to go over the budget or dark enough to fit
+static void test_frame(void)
+{
+    uint32_t count = 1 + rand() % CONFIG_LED_COUNT;
+    int level = rand() % 4 == 0 ? 40 : 256;
+    render_frame_t *frame = render_frame_alloc(count);
+    uint16_t start = rand() % CONFIG_LED_COUNT;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        render_pixel_t *pixel = &frame->pixels[i];
+        pixel->index = (start + i) % CONFIG_LED_COUNT;
+        pixel->color.red = rand() % level;
+        pixel->color.green = rand() % level;
+        pixel->color.blue = rand() % level;
+    }
+    frame->count = count;
+    render_apply_frame(frame);
+    free(frame);
+}
+
+// Function to get the current of the frame at full output level, in mA, from a floating point model
+static double model_current(void)
+{
+    static struct ledState states[CONFIG_LED_COUNT];
+    render_read_led_states(0, states, CONFIG_LED_COUNT);
+    bool balanced = ditherFrame != NULL || colorLutSupported;
+    double gamma = balanced ? colorGamma : 1.0;
+    const double current[3] = {CONFIG_LED_CURRENT_RED_MA, CONFIG_LED_CURRENT_GREEN_MA, CONFIG_LED_CURRENT_BLUE_MA};
+    double sum = 0;
+    for (int i = 0; i < CONFIG_LED_COUNT; i++)
+    {
+        const uint8_t *colors = &states[i].red;
+        for (int c = 0; c < 3; c++)
+        {
+            sum += current[c] * (balanced ? colorGain[c] / 255.0 : 1.0) * pow(colors[c] / 255.0, gamma);
+        }
+    }
+    return sum;
+}
+
+// Function to check the running sums, the estimate and the output level, given the level before the step. Returns true
+// if they are right.
+static bool test_check(uint8_t previous)
+{
+    // The running sums against a rescan of the frame
+    static struct ledState states[CONFIG_LED_COUNT];
+    render_read_led_states(0, states, CONFIG_LED_COUNT);
+    float gamma = ditherFrame != NULL || colorLutSupported ? colorGamma : 1.0f;
+    uint32_t sum[3] = {0};
+    for (int i = 0; i < CONFIG_LED_COUNT; i++)
+    {
+        const uint8_t *colors = &states[i].red;
+        for (int c = 0; c < 3; c++)
+        {
+            sum[c] += (uint16_t)(powf(colors[c] / 255.0f, gamma) * RENDER_POWER_LEVEL_MAX + 0.5f);
+        }
+    }
+    bool match = memcmp(sum, powerSum, sizeof(sum)) == 0;
+
+    // The estimate, and the level within the budget, not lower than the headroom allows, with the headroom kept when the
+    // limited level changes
+    double idle = RENDER_POWER_IDLE_MA;
+    double full = model_current();
+    double estimate = idle + full * dimmer / 255;
+    double highest = full > 0 ? (CONFIG_LED_POWER_BUDGET_MA - idle) * 255 / full : 255;
+    match = match && fabs(stats.power_estimate_ma - estimate) <= 2;
+    match = match && dimmer <= masterDimmer && estimate <= CONFIG_LED_POWER_BUDGET_MA + 1;
+    match = match && (dimmer == masterDimmer || dimmer + 2 * RENDER_POWER_HYSTERESIS + 1 > highest);
+    match = match && (dimmer == masterDimmer || dimmer == previous || dimmer + RENDER_POWER_HYSTERESIS <= highest + 1);
+    return match;
+}
+
+// Function to run random steps. Returns the number of wrong steps.
+static int test_steps(int *steps, int *limited)
+{
+    int wrong = 0;
+    for (int step = 0; step < TEST_STEPS; step++)
+    {
+        uint8_t previous = dimmer;
+        int kind = rand() % 100;
+        if (kind < 60)
+        {
+            test_frame();
+        }
+        else if (kind < 72)
+        {
+            test_priority(RENDER_PRIORITY_DIMMER, rand() % 2 ? 255 : rand());
+        }
+        else if (kind < 80)
+        {
+            test_priority(rand() % 2 ? RENDER_PRIORITY_SCENE_STORE : RENDER_PRIORITY_SCENE_RECALL, rand() % CONFIG_LED_SCENE_COUNT);
+        }
+        else if (kind < 98)
+        {
+            const uint8_t gain[4] = {255 - rand() % 96, 255 - rand() % 96, 255 - rand() % 96, 255};
+            test_color_config(Gammas[rand() % 4], gain, rand() % 3 == 0);
+        }
+        else
+        {
+            test_priority(RENDER_PRIORITY_BLACKOUT, 0);
+        }
+        wrong += !test_check(previous);
+        *limited += dimmer < masterDimmer;
+        (*steps)++;
+    }
+    return wrong;
+}
+
+// Function to animate a frame near the budget, a few LEDs changing by a level at each frame. Returns the number of
+// changes of the output level.
+static int test_animated(void)
+{
+    render_frame_t *frame = render_frame_alloc(CONFIG_LED_COUNT);
+    for (int i = 0; i < CONFIG_LED_COUNT; i++)
+    {
+        frame->pixels[i].index = i;
+        frame->pixels[i].color = (struct ledState){200, 120, 60};
+    }
+    frame->count = CONFIG_LED_COUNT;
+    render_apply_frame(frame);
+    uint8_t level = dimmer;
+    int changes = 0;
+    for (int f = 0; f < TEST_ANIMATED_FRAMES; f++)
+    {
+        frame->count = 4;
+        for (int i = 0; i < 4; i++)
+        {
+            frame->pixels[i].index = rand() % CONFIG_LED_COUNT;
+            frame->pixels[i].color = (struct ledState){200 + rand() % 3 - 1, 120 + rand() % 3 - 1, 60 + rand() % 3 - 1};
+        }
+        render_apply_frame(frame);
+        changes += dimmer != level;
+        level = dimmer;
+    }
+    free(frame);
+    return changes;
+}
+
+int main(void)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = CONFIG_LED_COUNT,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+    };
+    led_strip_rmt_config_t rmtConfig = {0};
+    led_strip_handle_t strip;
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfig, &strip));
+    ESP_ERROR_CHECK(led_strip_clear(strip));
+    render_start(strip);
+    srand(1);
+
+    int failed = 0;
+    int steps = 0;
+    int limited = 0;
+    const uint8_t neutral[4] = {255, 255, 255, 255};
+    for (int lut = 1; lut >= 0; lut--)
+    {
+        if (!lut)
+        {
+            // Back to a black frame at full level without dithering, then take the table away as if the backend had none
+            test_color_config(1.0f, neutral, false);
+            test_priority(RENDER_PRIORITY_BLACKOUT, 0);
+            test_priority(RENDER_PRIORITY_DIMMER, 255);
+            ESP_ERROR_CHECK(led_strip_set_color_lut(led_strip, NULL));
+            colorLutSupported = false;
+            render_power_update();
+        }
+        int wrong = test_steps(&steps, &limited);
+        if (wrong)
+        {
+            printf("FAIL: color lookup table %d, %d wrong steps\n", lut, wrong);
+            failed++;
+        }
+
+        test_color_config(2.2f, neutral, false);
+        test_priority(RENDER_PRIORITY_DIMMER, 255);
+        int changes = test_animated();
+        if (changes > 1 || dimmer == masterDimmer)
+        {
+            printf("FAIL: color lookup table %d, the animated frame changed the level %d times in %d frames\n", lut, changes,
+                   TEST_ANIMATED_FRAMES);
+            failed++;
+        }
+    }
+
+    printf("Power limit: %d steps, %d limited, %d failed\n", steps, limited, failed);
+    return failed != 0;
+}
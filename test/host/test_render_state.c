@@ -0,0 +1,176 @@
+/**
+ * @file test_render_state.c
+ * @brief Host test of the frame of the render module, now that the LED strip holds it: random frames, blackouts,
+ * master dimmer levels, scene stores and recalls are checked against a model of the frame. After each step, the frame
+ * read back, the frame hash and the LED strip must match the model: the strip holds the frame as it is while the
+ * driver applies the master dimmer through its color lookup table, and the dimmed frame once the test turns the
+ * table off, as with a backend without one. The render module is built into the test to reach its internal
+ * functions, over the RMT backend with the mock driver.
+ */
+
+#include "render_handler.c" // Render module, with its internal functions
+
+#include "rmt_mock.h"  // RMT mock
+#include "rtos_mock.h" // RTOS mock
+
+#define TEST_STEPS 4000
+
+static struct ledState model[CONFIG_LED_COUNT];
+static struct ledState modelScenes[CONFIG_LED_SCENE_COUNT][CONFIG_LED_COUNT];
+static bool modelSceneStored[CONFIG_LED_SCENE_COUNT];
+static uint8_t modelDimmer = 255;
+
+// Function to execute a priority command
+static void test_priority(render_priority_type_t type, uint8_t value)
+{
+    const render_priority_cmd_t cmd = {.type = type, .value = value};
+    render_execute_priority(&cmd);
+}
+
+// Function to apply a frame of random LEDs, in runs of consecutive LEDs or scattered, some of them set twice
+static void test_frame(void)
+{
+    uint32_t count = 1 + rand() % (rand() % 4 ? 16 : CONFIG_LED_COUNT);
+    render_frame_t *frame = render_frame_alloc(count);
+    uint16_t index = rand() % CONFIG_LED_COUNT;
+    bool run = rand() % 2;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        render_pixel_t *pixel = &frame->pixels[i];
+        index = run ? (index + 1) % CONFIG_LED_COUNT : rand() % CONFIG_LED_COUNT;
+        pixel->index = index;
+        pixel->color.red = rand();
+        pixel->color.green = rand() % 8 ? rand() : 0;
+        pixel->color.blue = rand();
+        model[index] = pixel->color;
+    }
+    frame->count = count;
+    render_apply_frame(frame);
+    free(frame);
+}
+
+// Function to check the frame read back, the frame hash and the LED strip against the model. Returns true if they match.
+static bool test_check(bool lut)
+{
+    static struct ledState states[CONFIG_LED_COUNT];
+    static struct ledState strip[CONFIG_LED_COUNT];
+    render_read_led_states(0, states, CONFIG_LED_COUNT);
+    bool match = memcmp(states, model, sizeof(model)) == 0;
+
+    uint32_t hash = 0;
+    for (int i = 0; i < CONFIG_LED_COUNT; i++)
+    {
+        hash += led_state_hash(i, &model[i]);
+    }
+    match = match && frameHash == hash;
+
+    // Without the table, the LED strip holds the dimmed frame
+    ESP_ERROR_CHECK(led_strip_get_pixels(led_strip, 0, (uint8_t *)strip, CONFIG_LED_COUNT, LED_STRIP_SRC_FORMAT_RGB));
+    for (int i = 0; i < CONFIG_LED_COUNT && match; i++)
+    {
+        const uint8_t *set = &model[i].red;
+        const uint8_t *held = &strip[i].red;
+        for (int c = 0; c < 3; c++)
+        {
+            match = match && held[c] == (lut ? set[c] : (set[c] * (modelDimmer + 1)) >> 8);
+        }
+    }
+
+    // With the table, the driver scales the colors by the master dimmer when it encodes them
+    for (int v = 0; v < 256 && lut && match; v++)
+    {
+        int dimmed = (v * modelDimmer + 127) / 255;
+        for (int c = 0; c < 3; c++)
+        {
+            match = match && abs(colorLut.channel[c][v] - dimmed) <= 1;
+        }
+    }
+    return match && masterDimmer == modelDimmer;
+}
+
+// Function to run random steps. Returns the number of steps after which the render module and the model differ.
+static int test_steps(bool lut, int *steps)
+{
+    int wrong = 0;
+    for (int step = 0; step < TEST_STEPS; step++)
+    {
+        int kind = rand() % 100;
+        uint8_t slot = rand() % CONFIG_LED_SCENE_COUNT;
+        if (kind < 70)
+        {
+            test_frame();
+        }
+        else if (kind < 73)
+        {
+            test_priority(RENDER_PRIORITY_BLACKOUT, 0);
+            memset(model, 0, sizeof(model));
+        }
+        else if (kind < 85)
+        {
+            // Full level often, so the copy of the undimmed frame is dropped and taken again
+            modelDimmer = rand() % 3 ? rand() : 255;
+            test_priority(RENDER_PRIORITY_DIMMER, modelDimmer);
+        }
+        else if (kind < 92)
+        {
+            test_priority(RENDER_PRIORITY_SCENE_STORE, slot);
+            memcpy(modelScenes[slot], model, sizeof(model));
+            modelSceneStored[slot] = true;
+        }
+        else
+        {
+            test_priority(RENDER_PRIORITY_SCENE_RECALL, slot);
+            if (modelSceneStored[slot])
+            {
+                memcpy(model, modelScenes[slot], sizeof(model));
+            }
+        }
+        wrong += !test_check(lut);
+        (*steps)++;
+    }
+    return wrong;
+}
+
+int main(void)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = CONFIG_LED_COUNT,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+    };
+    led_strip_rmt_config_t rmtConfig = {0};
+    led_strip_handle_t strip;
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfig, &strip));
+    ESP_ERROR_CHECK(led_strip_clear(strip));
+    render_start(strip);
+    srand(1);
+
+    int failed = 0;
+    int steps = 0;
+    if (!colorLutSupported)
+    {
+        printf("FAIL: the color lookup table of the RMT backend is not used\n");
+        failed++;
+    }
+    int wrong = test_steps(true, &steps);
+    if (wrong)
+    {
+        printf("FAIL: with the color lookup table, %d wrong steps\n", wrong);
+        failed++;
+    }
+
+    // Back to full level, then take the table away as if the backend had none
+    modelDimmer = 255;
+    test_priority(RENDER_PRIORITY_DIMMER, modelDimmer);
+    ESP_ERROR_CHECK(led_strip_set_color_lut(led_strip, NULL));
+    colorLutSupported = false;
+    wrong = test_steps(false, &steps);
+    if (wrong)
+    {
+        printf("FAIL: without the color lookup table, %d wrong steps\n", wrong);
+        failed++;
+    }
+
+    printf("Render state: %d steps, %d failed\n", steps, failed);
+    return failed != 0;
+}
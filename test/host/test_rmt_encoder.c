@@ -0,0 +1,125 @@
+/**
+ * @file test_rmt_encoder.c
+ * @brief Host test of the RMT symbol lookup table and of the ESP-IDF 5 strip encoder built on it, against the ESP-IDF
+ * bytes encoder they replaced: one bit0 or bit1 symbol per bit, MSB first, then the reset code. The strip encoder runs
+ * with the mock copy encoder, for refills of 1 symbol to more than a whole strip.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Standard library functions
+
+#include "rmt_mock.h"              // RMT mock
+#include "led_strip_symbol_lut.h"  // RMT symbol lookup table
+#include "led_strip_rmt_encoder.h" // RMT strip encoder
+
+#define TEST_MAX_LEN 600
+
+// Function to get the symbols of the bytes encoder configured by the strip encoder before the lookup table
+static void reference_symbols(led_model_t model, uint32_t resolution, rmt_symbol_word_t *bit0, rmt_symbol_word_t *bit1,
+                              rmt_symbol_word_t *reset)
+{
+    double ticksPerUs = resolution / 1000000.0;
+    *bit0 = (rmt_symbol_word_t){.level0 = 1, .duration0 = 0.3 * ticksPerUs, .level1 = 0, .duration1 = 0.9 * ticksPerUs};
+    if (model == LED_MODEL_SK6812)
+    {
+        *bit1 = (rmt_symbol_word_t){.level0 = 1, .duration0 = 0.6 * ticksPerUs, .level1 = 0, .duration1 = 0.6 * ticksPerUs};
+    }
+    else
+    {
+        *bit1 = (rmt_symbol_word_t){.level0 = 1, .duration0 = 0.9 * ticksPerUs, .level1 = 0, .duration1 = 0.3 * ticksPerUs};
+    }
+    uint32_t resetTicks = resolution / 1000000 * 50 / 2;
+    *reset = (rmt_symbol_word_t){.level0 = 0, .duration0 = resetTicks, .level1 = 0, .duration1 = resetTicks};
+}
+
+// Function to compare the expansion of every byte through the lookup table with the bit loop. Returns the number of
+// wrong bytes.
+static int test_lut(void)
+{
+    led_strip_symbol_lut_t lut;
+    led_strip_symbol_lut_init(&lut, 0x12345678, 0x9ABCDEF0);
+    int wrong = 0;
+    for (int value = 0; value < 256; value++)
+    {
+        uint32_t symbols[8];
+        led_strip_symbol_lut_expand(&lut, value, symbols);
+        for (int b = 0; b < 8; b++)
+        {
+            if (symbols[b] != ((value >> (7 - b)) & 1 ? 0x9ABCDEF0 : 0x12345678))
+            {
+                wrong++;
+                break;
+            }
+        }
+    }
+    return wrong;
+}
+
+// Function to encode random data twice with the same encoder, and compare the symbols with the bytes encoder. Returns
+// true if they match.
+static bool test_encoder(led_model_t model, uint32_t resolution, size_t len, size_t refill)
+{
+    led_strip_encoder_config_t config = {
+        .resolution = resolution,
+        .led_model = model,
+    };
+    rmt_encoder_handle_t encoder;
+    if (rmt_new_led_strip_encoder(&config, &encoder) != ESP_OK)
+    {
+        return false;
+    }
+    rmt_symbol_word_t bit0, bit1, reset;
+    reference_symbols(model, resolution, &bit0, &bit1, &reset);
+
+    static uint8_t data[TEST_MAX_LEN];
+    bool match = true;
+    rmt_mock_refill_symbols = refill;
+    for (int round = 0; round < 2 && match; round++) // the encoder is reused once the first strip completed
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            data[i] = (uint8_t)rand();
+        }
+        match = rmt_mock_encode(encoder, data, len) && rmt_mock_symbol_count == len * 8 + 1;
+        for (size_t i = 0; i < len * 8 && match; i++)
+        {
+            match = rmt_mock_symbols[i].val == ((data[i / 8] >> (7 - i % 8)) & 1 ? bit1.val : bit0.val);
+        }
+        match = match && rmt_mock_symbols[len * 8].val == reset.val;
+    }
+    rmt_del_encoder(encoder);
+    return match;
+}
+
+int main(void)
+{
+    static const size_t lens[] = {0, 1, 3, 12, 15, 16, 17, 36, 48, 300, 599};
+    static const size_t refills[] = {1, 7, 24, 32, 48, 64, 1000, 8192};
+    static const uint32_t resolutions[] = {10000000, 4900000};
+    srand(1);
+    int failed = test_lut();
+    int cases = 0;
+    for (led_model_t model = LED_MODEL_WS2812; model <= LED_MODEL_SK6812; model++)
+    {
+        for (size_t r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); r++)
+        {
+            for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++)
+            {
+                for (size_t f = 0; f < sizeof(refills) / sizeof(refills[0]); f++)
+                {
+                    if (!test_encoder(model, resolutions[r], lens[l], refills[f]))
+                    {
+                        printf("FAIL: model %d, %u Hz, %zu bytes, refill of %zu symbols\n", model,
+                               (unsigned)resolutions[r], lens[l], refills[f]);
+                        failed++;
+                    }
+                    cases++;
+                }
+            }
+        }
+    }
+    printf("RMT encoder: lookup table and %d strip encoder cases, %d failed\n", cases, failed);
+    return failed != 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file test_rmt_symbol_cache.c
+ * @brief Host test of the symbol cache of the RMT backend: a strip with the cache and a strip without it get the same
+ * random sequence of writes, color lookup tables and refreshes, and must send the same RMT symbols at every refresh.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Standard library functions
+#include <string.h>  // String manipulation functions
+
+#include "rmt_mock.h"  // RMT mock
+#include "led_strip.h" // LED strip library
+
+#define TEST_LEDS 150
+#define TEST_FRAMES 200
+
+static rmt_symbol_word_t expected[RMT_MOCK_MAX_SYMBOLS];
+
+// Function to apply one random operation to both strips. Returns true if the operation refreshed them.
+static bool random_operation(led_strip_handle_t strips[2], bool rgbw, const led_strip_color_lut_t *lut)
+{
+    uint8_t src[TEST_LEDS * 4];
+    uint32_t offset = rand() % TEST_LEDS;
+    uint32_t count = rand() % (TEST_LEDS - offset + 1);
+    uint32_t color[4] = {rand() & 0xFF, rand() & 0xFF, rand() & 0xFF, rand() & 0xFF};
+    const led_strip_color_lut_t *newLut = rand() & 1 ? lut : NULL;
+    int op = rand() % 16;
+    for (size_t i = 0; i < sizeof(src); i++)
+    {
+        src[i] = (uint8_t)rand();
+    }
+    for (int s = 0; s < 2; s++)
+    {
+        switch (op)
+        {
+        case 0:
+            ESP_ERROR_CHECK(led_strip_clear(strips[s]));
+            break;
+        case 1:
+            ESP_ERROR_CHECK(led_strip_set_color_lut(strips[s], newLut));
+            break;
+        case 2:
+        case 3:
+            ESP_ERROR_CHECK(led_strip_set_pixels(strips[s], offset, src, count, rgbw ? LED_STRIP_SRC_FORMAT_RGBW : LED_STRIP_SRC_FORMAT_RGB));
+            break;
+        case 4:
+            ESP_ERROR_CHECK(led_strip_fill(strips[s], offset, count, color[0], color[1], color[2]));
+            break;
+        default:
+            if (rgbw)
+            {
+                ESP_ERROR_CHECK(led_strip_set_pixel_rgbw(strips[s], offset, color[0], color[1], color[2], color[3]));
+            }
+            else
+            {
+                ESP_ERROR_CHECK(led_strip_set_pixel(strips[s], offset, color[0], color[1], color[2]));
+            }
+            break;
+        }
+    }
+    return op == 0;
+}
+
+// Function to run random frames on a strip with and a strip without the symbol cache. Returns the number of refreshes
+// that differed.
+static int test_cache(led_pixel_format_t format, led_model_t model, size_t refill)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = TEST_LEDS,
+        .led_pixel_format = format,
+        .led_model = model,
+        .full_refresh_interval = 7,
+    };
+    led_strip_rmt_config_t rmtConfigs[2] = {{.flags.symbol_cache = false}, {.flags.symbol_cache = true}};
+    led_strip_handle_t strips[2];
+    for (int s = 0; s < 2; s++)
+    {
+        ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfigs[s], &strips[s]));
+    }
+    led_strip_color_lut_t lut;
+    ESP_ERROR_CHECK(led_strip_color_lut_init(&lut, 2.2f, (const uint8_t[4]){255, 200, 180, 255}, 128));
+
+    bool rgbw = format == LED_PIXEL_FORMAT_GRBW || format == LED_PIXEL_FORMAT_RGBW;
+    rmt_mock_refill_symbols = refill;
+    int differed = 0;
+    for (int frame = 0; frame < TEST_FRAMES; frame++)
+    {
+        int writes = rand() % 8;
+        for (int w = 0; w < writes; w++)
+        {
+            // a clear refreshes both strips, the first one has to be captured before the second one
+            if (random_operation(strips, rgbw, &lut))
+            {
+                break;
+            }
+        }
+        ESP_ERROR_CHECK(led_strip_refresh(strips[0]));
+        size_t count = rmt_mock_symbol_count;
+        memcpy(expected, rmt_mock_symbols, count * sizeof(rmt_symbol_word_t));
+        ESP_ERROR_CHECK(led_strip_refresh(strips[1]));
+        differed += count != rmt_mock_symbol_count || memcmp(expected, rmt_mock_symbols, count * sizeof(rmt_symbol_word_t));
+    }
+    for (int s = 0; s < 2; s++)
+    {
+        ESP_ERROR_CHECK(led_strip_del(strips[s]));
+    }
+    return differed;
+}
+
+int main(void)
+{
+    static const led_pixel_format_t formats[] = {LED_PIXEL_FORMAT_GRB, LED_PIXEL_FORMAT_GRBW};
+    static const size_t refills[] = {1, 48, 4096};
+    srand(1);
+    int failed = 0;
+    int cases = 0;
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++)
+    {
+        for (led_model_t model = LED_MODEL_WS2812; model <= LED_MODEL_SK6812; model++)
+        {
+            for (size_t r = 0; r < sizeof(refills) / sizeof(refills[0]); r++)
+            {
+                int differed = test_cache(formats[f], model, refills[r]);
+                if (differed)
+                {
+                    printf("FAIL: format %d, model %d, refill of %zu symbols: %d refreshes differ\n", formats[f], model,
+                           refills[r], differed);
+                    failed++;
+                }
+                cases++;
+            }
+        }
+    }
+    printf("RMT symbol cache: %d cases of %d frames, %d failed\n", cases, TEST_FRAMES, failed);
+    return failed != 0;
+}
@@ -0,0 +1,393 @@
+/**
+ * @file test_shader_fuzz.c
+ * @brief Fuzz test of the shader verifier and interpreter, run under the sanitizers. Random bytecode and mutations of
+ * valid programs are loaded; every program the verifier accepts is run by a reference interpreter that checks the
+ * stack, the registers and the jumps at each instruction. An accepted program must never fault, never run more
+ * instructions than its cost, and must give the same colors as the threaded interpreter, which checks nothing.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Standard library functions
+#include <string.h>  // String manipulation functions
+#include <math.h>    // Math functions
+
+#include "led_strip.h"      // LED strip library, for the HSV conversion
+#include "render_handler.h" // LED state
+#include "led_shader.h"     // LED shader functions
+
+#define TEST_LEDS 13
+#define TEST_PROGRAMS 40000
+#define TEST_ONE 65536
+
+// Operand size and stack effect of each instruction, as documented in led_shader.h
+static const struct
+{
+    uint8_t operand;
+    uint8_t pops;
+    uint8_t pushes;
+} OpInfo[LED_SHADER_OP_COUNT] = {
+    [LED_SHADER_OP_PUSH] = {2, 0, 1},  [LED_SHADER_OP_PUSHW] = {4, 0, 1}, [LED_SHADER_OP_INDEX] = {0, 0, 1},
+    [LED_SHADER_OP_POS] = {0, 0, 1},   [LED_SHADER_OP_TIME] = {0, 0, 1},  [LED_SHADER_OP_LOAD] = {1, 0, 1},
+    [LED_SHADER_OP_STORE] = {1, 1, 0}, [LED_SHADER_OP_DUP] = {0, 1, 2},   [LED_SHADER_OP_DROP] = {0, 1, 0},
+    [LED_SHADER_OP_SWAP] = {0, 2, 2},  [LED_SHADER_OP_OVER] = {0, 2, 3},  [LED_SHADER_OP_ADD] = {0, 2, 1},
+    [LED_SHADER_OP_SUB] = {0, 2, 1},   [LED_SHADER_OP_MUL] = {0, 2, 1},   [LED_SHADER_OP_DIV] = {0, 2, 1},
+    [LED_SHADER_OP_MOD] = {0, 2, 1},   [LED_SHADER_OP_NEG] = {0, 1, 1},   [LED_SHADER_OP_ABS] = {0, 1, 1},
+    [LED_SHADER_OP_FLOOR] = {0, 1, 1}, [LED_SHADER_OP_FRACT] = {0, 1, 1}, [LED_SHADER_OP_MIN] = {0, 2, 1},
+    [LED_SHADER_OP_MAX] = {0, 2, 1},   [LED_SHADER_OP_SIN] = {0, 1, 1},   [LED_SHADER_OP_NOISE] = {0, 1, 1},
+    [LED_SHADER_OP_LT] = {0, 2, 1},    [LED_SHADER_OP_JZ] = {1, 1, 0},    [LED_SHADER_OP_JMP] = {1, 0, 0},
+    [LED_SHADER_OP_RGB] = {0, 3, 0},   [LED_SHADER_OP_HSV] = {0, 3, 0},
+};
+
+static int32_t sinTable[257];
+static int failed;
+
+// Function to get the sine of a number of turns in 16.16, interpolated over 256 steps
+static int32_t reference_sin(int32_t turns)
+{
+    uint32_t phase = (uint32_t)turns & (TEST_ONE - 1);
+    int32_t fraction = phase & 0xFF;
+    return sinTable[phase >> 8] + (((sinTable[(phase >> 8) + 1] - sinTable[phase >> 8]) * fraction) >> 8);
+}
+
+// Function to hash an integer to a value from 0 to 1 in 16.16
+static int32_t reference_hash(int32_t x)
+{
+    uint32_t h = (uint32_t)x * 0x9E3779B1u;
+    h ^= h >> 15;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    return h >> 16;
+}
+
+// Function to get the smooth value noise of a number in 16.16
+static int32_t reference_noise(int32_t x)
+{
+    int64_t fraction = x & (TEST_ONE - 1);
+    int64_t ease = (fraction * fraction >> 16) * (3 * TEST_ONE - 2 * fraction) >> 16;
+    int32_t a = reference_hash(x >> 16);
+    int32_t b = reference_hash((x >> 16) + 1);
+    return a + (int32_t)(((int64_t)(b - a) * ease) >> 16);
+}
+
+// Function to get a color channel from a level from 0 to 1 in 16.16
+static uint8_t reference_channel(int32_t level)
+{
+    return level <= 0 ? 0 : level >= TEST_ONE ? 255 : (level * 255 + TEST_ONE / 2) >> 16;
+}
+
+// Function to run a program for one LED, checking every access. Returns false if the program faults, and sets the
+// number of instructions run and the color of the LED.
+static bool reference_run(const uint8_t *code, size_t length, uint32_t timeMs, int index, int count, uint32_t *steps,
+                          uint8_t rgb[3])
+{
+    int32_t stack[LED_SHADER_STACK_SIZE];
+    int32_t registers[LED_SHADER_REGISTERS] = {0};
+    int depth = 0;
+    size_t offset = 0;
+    *steps = 0;
+    for (;;)
+    {
+        if (offset >= length || code[offset] >= LED_SHADER_OP_COUNT)
+        {
+            return false;
+        }
+        uint8_t op = code[offset];
+        if (offset + 1 + OpInfo[op].operand > length || depth < OpInfo[op].pops ||
+            depth - OpInfo[op].pops + OpInfo[op].pushes > LED_SHADER_STACK_SIZE)
+        {
+            return false;
+        }
+        const uint8_t *operand = &code[offset + 1];
+        offset += 1 + OpInfo[op].operand;
+        (*steps)++;
+        int32_t b = depth >= 1 ? stack[depth - 1] : 0;
+        int32_t a = depth >= 2 ? stack[depth - 2] : 0;
+        int32_t result = 0;
+        switch (op)
+        {
+        case LED_SHADER_OP_PUSH:
+            result = (int32_t)(int16_t)(operand[0] | operand[1] << 8) * 256;
+            break;
+        case LED_SHADER_OP_PUSHW:
+            result = (int32_t)((uint32_t)operand[0] | (uint32_t)operand[1] << 8 | (uint32_t)operand[2] << 16 |
+                               (uint32_t)operand[3] << 24);
+            break;
+        case LED_SHADER_OP_INDEX:
+            result = index * TEST_ONE;
+            break;
+        case LED_SHADER_OP_POS:
+            result = (int32_t)((int64_t)index * TEST_ONE / count);
+            break;
+        case LED_SHADER_OP_TIME:
+            result = (int32_t)((uint64_t)timeMs * TEST_ONE / 1000);
+            break;
+        case LED_SHADER_OP_LOAD:
+        case LED_SHADER_OP_STORE:
+            if (operand[0] >= LED_SHADER_REGISTERS)
+            {
+                return false;
+            }
+            if (op == LED_SHADER_OP_STORE)
+            {
+                registers[operand[0]] = b;
+            }
+            result = registers[operand[0]];
+            break;
+        case LED_SHADER_OP_DUP:
+            result = b;
+            break;
+        case LED_SHADER_OP_SWAP:
+            stack[depth - 1] = a;
+            stack[depth - 2] = b;
+            break;
+        case LED_SHADER_OP_OVER:
+            result = a;
+            break;
+        case LED_SHADER_OP_ADD:
+            result = (int32_t)((uint32_t)a + (uint32_t)b);
+            break;
+        case LED_SHADER_OP_SUB:
+            result = (int32_t)((uint32_t)a - (uint32_t)b);
+            break;
+        case LED_SHADER_OP_MUL:
+            result = (int32_t)(((int64_t)a * b) >> 16);
+            break;
+        case LED_SHADER_OP_DIV:
+            result = b != 0 ? (int32_t)((int64_t)a * TEST_ONE / b) : 0;
+            break;
+        case LED_SHADER_OP_MOD:
+        {
+            int64_t remainder = b != 0 ? (int64_t)a % b : 0;
+            result = (int32_t)(remainder != 0 && (remainder < 0) != (b < 0) ? remainder + b : remainder);
+            break;
+        }
+        case LED_SHADER_OP_NEG:
+            result = (int32_t)(0u - (uint32_t)b);
+            break;
+        case LED_SHADER_OP_ABS:
+            result = b < 0 ? (int32_t)(0u - (uint32_t)b) : b;
+            break;
+        case LED_SHADER_OP_FLOOR:
+            result = b & ~(TEST_ONE - 1);
+            break;
+        case LED_SHADER_OP_FRACT:
+            result = b & (TEST_ONE - 1);
+            break;
+        case LED_SHADER_OP_MIN:
+            result = a < b ? a : b;
+            break;
+        case LED_SHADER_OP_MAX:
+            result = a > b ? a : b;
+            break;
+        case LED_SHADER_OP_SIN:
+            result = reference_sin(b);
+            break;
+        case LED_SHADER_OP_NOISE:
+            result = reference_noise(b);
+            break;
+        case LED_SHADER_OP_LT:
+            result = a < b ? TEST_ONE : 0;
+            break;
+        case LED_SHADER_OP_JZ:
+        case LED_SHADER_OP_JMP:
+            if (op == LED_SHADER_OP_JMP || b == 0)
+            {
+                offset += operand[0];
+            }
+            break;
+        case LED_SHADER_OP_RGB:
+            rgb[0] = reference_channel(stack[depth - 3]);
+            rgb[1] = reference_channel(a);
+            rgb[2] = reference_channel(b);
+            return true;
+        case LED_SHADER_OP_HSV:
+        {
+            led_strip_hsv_t hsv = {
+                .hue = (((uint32_t)stack[depth - 3] & (TEST_ONE - 1)) * 360) >> 16,
+                .saturation = reference_channel(a),
+                .value = reference_channel(b),
+            };
+            led_strip_hsv_to_rgb(&hsv, rgb, 1);
+            return true;
+        }
+        }
+        if (op == LED_SHADER_OP_DUP || op == LED_SHADER_OP_OVER)
+        {
+            // The operands stay below the copy
+            stack[depth++] = result;
+        }
+        else if (op != LED_SHADER_OP_SWAP)
+        {
+            depth -= OpInfo[op].pops;
+            if (OpInfo[op].pushes)
+            {
+                stack[depth++] = result;
+            }
+        }
+    }
+}
+
+// Function to load a program and, if the verifier accepts it, check it against the reference interpreter
+static bool check_program(const uint8_t *code, size_t length)
+{
+    led_shader_t *shader;
+    esp_err_t err = led_shader_load(code, length, LED_SHADER_MAX_LENGTH, &shader);
+    if ((err == ESP_OK) != (shader != NULL))
+    {
+        printf("FAIL: load returned %d with program %p\n", err, (void *)shader);
+        failed++;
+        return false;
+    }
+    if (err != ESP_OK)
+    {
+        return false;
+    }
+    uint32_t cost = led_shader_cost(shader);
+    led_shader_t *overBudget;
+    if (led_shader_load(code, length, cost - 1, &overBudget) != ESP_ERR_INVALID_SIZE || overBudget != NULL)
+    {
+        printf("FAIL: a program of cost %u loads with a budget of %u\n", cost, cost - 1);
+        failed++;
+    }
+
+    static const uint32_t Times[] = {0, 1234, 987654321};
+    for (size_t t = 0; t < sizeof(Times) / sizeof(Times[0]); t++)
+    {
+        struct ledState states[TEST_LEDS];
+        led_shader_run(shader, Times[t], TEST_LEDS, states);
+        for (int i = 0; i < TEST_LEDS; i++)
+        {
+            uint32_t steps;
+            uint8_t rgb[3];
+            if (!reference_run(code, length, Times[t], i, TEST_LEDS, &steps, rgb) || steps > cost ||
+                memcmp(rgb, &states[i], 3) != 0)
+            {
+                if (failed < 10)
+                {
+                    printf("FAIL: accepted program of %zu bytes, cost %u, LED %d at %u ms: ran %u instructions\n",
+                           length, cost, i, Times[t], steps);
+                }
+                failed++;
+                break;
+            }
+        }
+    }
+    led_shader_free(shader);
+    return true;
+}
+
+// Function to append an instruction with a random operand
+static size_t emit(uint8_t *code, size_t length, uint8_t op)
+{
+    code[length++] = op;
+    for (int i = 0; i < OpInfo[op].operand; i++)
+    {
+        code[length++] = op == LED_SHADER_OP_LOAD || op == LED_SHADER_OP_STORE ? rand() % LED_SHADER_REGISTERS : rand();
+    }
+    return length;
+}
+
+// Function to generate a valid program: random instructions that keep the stack in range, with jumps over blocks
+// that leave the stack as they found it, ended by a color
+static size_t generate(uint8_t *code)
+{
+    size_t length = 0;
+    int depth = 0;
+    int instructions = 1 + rand() % 60;
+    for (int n = 0; n < instructions && length < LED_SHADER_MAX_LENGTH - 64; n++)
+    {
+        if (depth >= 1 && rand() % 8 == 0)
+        {
+            // if (top) { registers or pushes and drops } else skip
+            uint8_t jump = rand() % 2 ? LED_SHADER_OP_JZ : LED_SHADER_OP_JMP;
+            size_t at = length;
+            length = emit(code, length, jump);
+            size_t block = length;
+            for (int k = rand() % 4; k > 0; k--)
+            {
+                length = emit(code, length, rand() % 2 ? LED_SHADER_OP_PUSHW : LED_SHADER_OP_LOAD);
+                length = emit(code, length, rand() % 2 ? LED_SHADER_OP_STORE : LED_SHADER_OP_DROP);
+            }
+            code[at + 1] = length - block;
+            depth -= jump == LED_SHADER_OP_JZ;
+            continue;
+        }
+        uint8_t op;
+        do
+        {
+            op = rand() % LED_SHADER_OP_JZ;
+        } while (depth < OpInfo[op].pops || depth - OpInfo[op].pops + OpInfo[op].pushes > LED_SHADER_STACK_SIZE);
+        length = emit(code, length, op);
+        depth += OpInfo[op].pushes - OpInfo[op].pops;
+    }
+    for (; depth < 3; depth++)
+    {
+        length = emit(code, length, LED_SHADER_OP_PUSH);
+    }
+    return emit(code, length, rand() % 2 ? LED_SHADER_OP_RGB : LED_SHADER_OP_HSV);
+}
+
+int main(void)
+{
+    srand(1);
+    for (int i = 0; i <= 256; i++)
+    {
+        sinTable[i] = (int32_t)lroundf(sinf(2.0f * (float)M_PI * (i & 0xFF) / 256) * TEST_ONE);
+    }
+
+    uint8_t code[LED_SHADER_MAX_LENGTH + 1];
+    int generated = 0;
+    int mutated = 0;
+    int random = 0;
+    for (int n = 0; n < TEST_PROGRAMS; n++)
+    {
+        size_t length = generate(code);
+        if (!check_program(code, length))
+        {
+            printf("FAIL: generated program of %zu bytes rejected\n", length);
+            failed++;
+        }
+        generated++;
+
+        // Flip, replace, insert or cut bytes of the valid program
+        for (int m = 1 + rand() % 3; m > 0; m--)
+        {
+            size_t at = rand() % length;
+            switch (rand() % 4)
+            {
+            case 0:
+                code[at] ^= 1 << (rand() % 8);
+                break;
+            case 1:
+                code[at] = rand() % (LED_SHADER_OP_COUNT + 2);
+                break;
+            case 2:
+                if (length < LED_SHADER_MAX_LENGTH)
+                {
+                    memmove(&code[at + 1], &code[at], length - at);
+                    code[at] = rand();
+                    length++;
+                }
+                break;
+            default:
+                length = at > 0 ? at : 1;
+                break;
+            }
+        }
+        mutated += check_program(code, length);
+
+        // Random bytes, mostly instructions
+        length = 1 + rand() % 64;
+        for (size_t i = 0; i < length; i++)
+        {
+            code[i] = rand() % 4 ? rand() % LED_SHADER_OP_COUNT : rand();
+        }
+        random += check_program(code, length);
+    }
+
+    printf("Shader fuzz: %d generated, %d of %d mutated and %d of %d random programs accepted, %d failed\n", generated,
+           mutated, TEST_PROGRAMS, random, TEST_PROGRAMS, failed);
+    return failed != 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file test_spi_clocked.c
+ * @brief Host test of the clocked SPI backend: BGR strips of APA102, SK9822 and HD108 LEDs take random pixel, span,
+ * fill and brightness operations, and the bytes sent by each refresh must be those of a reference built from the
+ * frame formats of the LEDs: start frame, LED frames with the brightness field kept across color changes, the SK9822
+ * reset frame and the end frame. The pixels must read back as set, and what the LEDs cannot take must be rejected.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Standard library functions
+#include <string.h>  // String manipulation functions
+
+#include "spi_mock.h"  // SPI mock
+#include "led_strip.h" // LED strip library
+
+#define TEST_PIXELS 100
+#define TEST_OPERATIONS 500
+
+static uint8_t model[TEST_PIXELS][3]; // Red, green and blue of each pixel
+static uint8_t brightness[TEST_PIXELS];
+static uint8_t expected[SPI_MOCK_MAX_BYTES];
+
+// Function to build the bytes of a refresh from the model. Returns their number.
+static size_t reference_frames(led_model_t ledModel)
+{
+    size_t n = 0;
+    int start = ledModel == LED_MODEL_HD108 ? 16 : 4;
+    memset(expected, 0, start);
+    n += start;
+    for (int i = 0; i < TEST_PIXELS; i++)
+    {
+        // BGR order
+        const uint8_t colors[3] = {model[i][2], model[i][1], model[i][0]};
+        if (ledModel == LED_MODEL_HD108)
+        {
+            // 1 bit set and the brightness of each color, then 16 bits per color
+            uint16_t header = 0x8000 | brightness[i] << 10 | brightness[i] << 5 | brightness[i];
+            expected[n++] = header >> 8;
+            expected[n++] = header & 0xFF;
+            for (int c = 0; c < 3; c++)
+            {
+                uint16_t level = colors[c] * 257;
+                expected[n++] = level >> 8;
+                expected[n++] = level & 0xFF;
+            }
+        }
+        else
+        {
+            expected[n++] = 0xE0 | brightness[i];
+            memcpy(&expected[n], colors, 3);
+            n += 3;
+        }
+    }
+    if (ledModel == LED_MODEL_SK9822)
+    {
+        memset(&expected[n], 0, 4);
+        n += 4;
+    }
+
+    // Half a clock of delay per LED, at least 32 clocks
+    int end = (TEST_PIXELS + 15) / 16 > 4 ? (TEST_PIXELS + 15) / 16 : 4;
+    memset(&expected[n], ledModel == LED_MODEL_APA102 ? 0xFF : 0x00, end);
+    return n + end;
+}
+
+// Function to run random operations on a strip of a clocked model. Returns the number of wrong operations.
+static int test_model(led_model_t ledModel, int clockKhz, int *operations)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = TEST_PIXELS,
+        .led_pixel_format = LED_PIXEL_FORMAT_BGR,
+        .led_model = ledModel,
+    };
+    led_strip_spi_config_t spiConfig = {.clk_gpio_num = 23, .flags.with_dma = true};
+    led_strip_handle_t strip;
+    spi_mock_source_hz = 80000000;
+    ESP_ERROR_CHECK(led_strip_new_spi_device(&stripConfig, &spiConfig, &strip));
+    memset(model, 0, sizeof(model));
+    memset(brightness, LED_STRIP_BRIGHTNESS_MAX, sizeof(brightness));
+    int wrong = spi_mock_clock_khz != clockKhz;
+
+    for (int op = 0; op < TEST_OPERATIONS; op++)
+    {
+        uint32_t offset = rand() % TEST_PIXELS;
+        uint32_t count = 1 + rand() % (TEST_PIXELS - offset);
+        uint8_t color[3] = {rand(), rand(), rand()};
+        switch (rand() % 4)
+        {
+        case 0:
+            ESP_ERROR_CHECK(led_strip_set_pixel(strip, offset, color[0], color[1], color[2]));
+            memcpy(model[offset], color, 3);
+            break;
+        case 1:
+        {
+            uint8_t src[TEST_PIXELS * 3];
+            for (uint32_t i = 0; i < count * 3; i++)
+            {
+                src[i] = rand();
+            }
+            ESP_ERROR_CHECK(led_strip_set_pixels(strip, offset, src, count, LED_STRIP_SRC_FORMAT_RGB));
+            memcpy(model[offset], src, count * 3);
+            break;
+        }
+        case 2:
+            ESP_ERROR_CHECK(led_strip_fill(strip, offset, count, color[0], color[1], color[2]));
+            for (uint32_t i = 0; i < count; i++)
+            {
+                memcpy(model[offset + i], color, 3);
+            }
+            break;
+        default:
+            brightness[offset] = rand() % (LED_STRIP_BRIGHTNESS_MAX + 1);
+            ESP_ERROR_CHECK(led_strip_set_pixel_brightness(strip, offset, brightness[offset]));
+            break;
+        }
+
+        spi_mock_byte_count = 0;
+        spi_mock_transactions = 0;
+        ESP_ERROR_CHECK(led_strip_refresh(strip));
+        size_t bytes = reference_frames(ledModel);
+        bool match = spi_mock_transactions == 1 && spi_mock_byte_count == bytes && memcmp(spi_mock_bytes, expected, bytes) == 0;
+        uint8_t back[TEST_PIXELS][3];
+        ESP_ERROR_CHECK(led_strip_get_pixels(strip, 0, (uint8_t *)back, TEST_PIXELS, LED_STRIP_SRC_FORMAT_RGB));
+        match = match && memcmp(back, model, sizeof(model)) == 0;
+        wrong += !match;
+        (*operations)++;
+    }
+
+    // No white channel, and a 5-bit brightness field
+    uint8_t src[4] = {1, 2, 3, 4};
+    wrong += led_strip_set_pixel_rgbw(strip, 0, 1, 2, 3, 4) != ESP_ERR_INVALID_ARG;
+    wrong += led_strip_set_pixels(strip, 0, src, 1, LED_STRIP_SRC_FORMAT_RGBW) != ESP_ERR_INVALID_ARG;
+    wrong += led_strip_set_pixel_brightness(strip, 0, LED_STRIP_BRIGHTNESS_MAX + 1) != ESP_ERR_INVALID_ARG;
+    wrong += led_strip_set_pixel_brightness(strip, TEST_PIXELS, 0) != ESP_ERR_INVALID_ARG;
+    ESP_ERROR_CHECK(led_strip_del(strip));
+    return wrong;
+}
+
+int main(void)
+{
+    srand(1);
+    int failed = 0;
+    int operations = 0;
+    static const struct
+    {
+        led_model_t model;
+        const char *name;
+        int clockKhz; // Default clock of the model
+    } models[] = {
+        {LED_MODEL_APA102, "APA102", 10000},
+        {LED_MODEL_SK9822, "SK9822", 10000},
+        {LED_MODEL_HD108, "HD108", 20000},
+    };
+    for (size_t m = 0; m < sizeof(models) / sizeof(models[0]); m++)
+    {
+        int wrong = test_model(models[m].model, models[m].clockKhz, &operations);
+        if (wrong)
+        {
+            printf("FAIL: %s: %d wrong operations\n", models[m].name, wrong);
+            failed++;
+        }
+    }
+
+    // The clock is set by the config, RGBW strips and streaming are rejected
+    led_strip_config_t stripConfig = {.max_leds = TEST_PIXELS, .led_pixel_format = LED_PIXEL_FORMAT_BGR, .led_model = LED_MODEL_APA102};
+    led_strip_spi_config_t spiConfig = {.clock_hz = 4000000};
+    led_strip_handle_t strip;
+    ESP_ERROR_CHECK(led_strip_new_spi_device(&stripConfig, &spiConfig, &strip));
+    failed += spi_mock_clock_khz != 4000;
+    ESP_ERROR_CHECK(led_strip_del(strip));
+    spiConfig.flags.with_dma = true;
+    spiConfig.flags.streaming = true;
+    failed += led_strip_new_spi_device(&stripConfig, &spiConfig, &strip) != ESP_ERR_NOT_SUPPORTED;
+    spiConfig.flags.streaming = false;
+    stripConfig.led_pixel_format = LED_PIXEL_FORMAT_GRBW;
+    failed += led_strip_new_spi_device(&stripConfig, &spiConfig, &strip) != ESP_ERR_INVALID_ARG;
+
+    printf("Clocked SPI: %d operations, %d failed\n", operations, failed);
+    return failed != 0;
+}
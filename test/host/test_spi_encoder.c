@@ -0,0 +1,174 @@
+/**
+ * @file test_spi_encoder.c
+ * @brief Host test of the SPI pattern encoder: the 3 bits table encoder against the former bit by bit encoder, and the
+ * encoder, decoder and fill of every SPI bit pattern against a reference encoder, at every alignment of the buffer.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Standard library functions
+#include <string.h>  // String manipulation functions
+
+#include "led_strip_spi_encoder.h" // SPI encoder functions
+
+#define TEST_MAX_LEN 40 // LED data bytes encoded per case
+#define TEST_MARGIN 8   // Bytes checked untouched around the encoded bytes
+
+// Function to encode an LED data byte bit by bit in the 3 bits pattern, as the SPI backend did before the table
+static void reference_encode_3(uint8_t data, uint8_t *buf)
+{
+    memset(buf, 0, 3);
+    buf[2] |= data & 0x01 ? 0x06 : 0x04;
+    buf[2] |= data & 0x02 ? 0x30 : 0x20;
+    buf[2] |= data & 0x04 ? 0x80 : 0x00;
+    buf[1] |= 0x01;
+    buf[1] |= data & 0x08 ? 0x0C : 0x08;
+    buf[1] |= data & 0x10 ? 0x60 : 0x40;
+    buf[0] |= data & 0x20 ? 0x03 : 0x02;
+    buf[0] |= data & 0x40 ? 0x18 : 0x10;
+    buf[0] |= data & 0x80 ? 0xC0 : 0x80;
+}
+
+// Function to encode LED data bytes with a pattern, one SPI bit at a time, MSB first
+static void reference_encode(const led_strip_spi_pattern_t *pattern, const uint8_t *data, size_t len, uint8_t *buf)
+{
+    memset(buf, 0, len * pattern->bits_per_bit);
+    size_t bit = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        for (int b = 7; b >= 0; b--)
+        {
+            int high = (data[i] >> b) & 1 ? pattern->t1h_bits : pattern->t0h_bits;
+            for (int s = 0; s < pattern->bits_per_bit; s++, bit++)
+            {
+                if (s < high)
+                {
+                    buf[bit / 8] |= 0x80 >> (bit % 8);
+                }
+            }
+        }
+    }
+}
+
+// Function to check the encoded bytes and the untouched margins around them. Returns true if they match.
+static bool check_encoded(const uint8_t *buf, size_t offset, const uint8_t *expected, size_t size)
+{
+    for (size_t i = 0; i < offset; i++)
+    {
+        if (buf[i] != 0xA5)
+        {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < TEST_MARGIN; i++)
+    {
+        if (buf[offset + size + i] != 0xA5)
+        {
+            return false;
+        }
+    }
+    return memcmp(buf + offset, expected, size) == 0;
+}
+
+// Function to test the 3 bits table encoder and its fill. Returns the number of failed cases.
+static int test_encode_3(void)
+{
+    uint8_t data[TEST_MAX_LEN];
+    uint8_t expected[TEST_MAX_LEN * 3];
+    uint8_t buf[4 + TEST_MAX_LEN * 3 + TEST_MARGIN];
+    int failed = 0;
+    for (int value = 0; value < 256; value++)
+    {
+        uint8_t byte = value;
+        reference_encode_3(byte, expected);
+        led_strip_spi_encode(&byte, 1, buf);
+        failed += memcmp(buf, expected, 3) != 0;
+    }
+    for (size_t offset = 0; offset < 4; offset++)
+    {
+        for (size_t len = 0; len <= TEST_MAX_LEN; len++)
+        {
+            for (size_t i = 0; i < len; i++)
+            {
+                data[i] = (uint8_t)rand();
+                reference_encode_3(data[i], &expected[i * 3]);
+            }
+            memset(buf, 0xA5, sizeof(buf));
+            led_strip_spi_encode(data, len, buf + offset);
+            failed += !check_encoded(buf, offset, expected, len * 3);
+
+            for (size_t i = 0; i < len; i++)
+            {
+                reference_encode_3(data[0], &expected[i * 3]);
+            }
+            memset(buf, 0xA5, sizeof(buf));
+            led_strip_spi_encode_fill(data[0], len, buf + offset);
+            failed += len && !check_encoded(buf, offset, expected, len * 3);
+        }
+    }
+    return failed;
+}
+
+// Function to test the encoder, decoder and fill of a pattern. Returns the number of failed cases.
+static int test_pattern(const led_strip_spi_pattern_t *pattern)
+{
+    uint8_t data[TEST_MAX_LEN];
+    uint8_t decoded[TEST_MAX_LEN];
+    uint8_t fill[TEST_MAX_LEN];
+    uint8_t expected[TEST_MAX_LEN * LED_STRIP_SPI_MAX_BITS_PER_BIT];
+    uint8_t buf[4 + TEST_MAX_LEN * LED_STRIP_SPI_MAX_BITS_PER_BIT + TEST_MARGIN];
+    size_t n = pattern->bits_per_bit;
+    int failed = 0;
+    for (size_t offset = 0; offset < 4; offset++)
+    {
+        for (size_t len = 0; len <= TEST_MAX_LEN; len++)
+        {
+            for (size_t i = 0; i < len; i++)
+            {
+                data[i] = (uint8_t)rand();
+            }
+            reference_encode(pattern, data, len, expected);
+            memset(buf, 0xA5, sizeof(buf));
+            led_strip_spi_pattern_encode(pattern, data, len, buf + offset);
+            failed += !check_encoded(buf, offset, expected, len * n);
+
+            led_strip_spi_pattern_decode(pattern, buf + offset, len, decoded);
+            failed += memcmp(decoded, data, len) != 0;
+
+            memset(fill, data[0], sizeof(fill));
+            reference_encode(pattern, fill, len, expected);
+            memset(buf, 0xA5, sizeof(buf));
+            led_strip_spi_pattern_fill(pattern, data[0], len, buf + offset);
+            failed += len && !check_encoded(buf, offset, expected, len * n);
+        }
+    }
+    return failed;
+}
+
+int main(void)
+{
+    srand(1);
+    int failed = test_encode_3();
+    int patterns = 0;
+    for (uint8_t n = LED_STRIP_SPI_MIN_BITS_PER_BIT; n <= LED_STRIP_SPI_MAX_BITS_PER_BIT; n++)
+    {
+        for (uint8_t t1h = 2; t1h < n; t1h++)
+        {
+            for (uint8_t t0h = 1; t0h < t1h; t0h++)
+            {
+                led_strip_spi_pattern_t pattern;
+                led_strip_spi_pattern_init(&pattern, n, t0h, t1h);
+                int wrong = test_pattern(&pattern);
+                if (wrong)
+                {
+                    printf("FAIL: %d bits per bit, T0H %d, T1H %d: %d cases\n", n, t0h, t1h, wrong);
+                }
+                failed += wrong;
+                patterns++;
+            }
+        }
+    }
+    printf("SPI encoder: 3 bits table and %d patterns, %d failed cases\n", patterns, failed);
+    return failed != 0;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file test_spi_readback.c
+ * @brief Host test of the read-back of the SPI backend: random set_pixel, set_pixel_rgbw, set_pixels and fill
+ * operations on GRB and GRBW strips, with and without streaming, for each SPI bit pattern the backend selects from the
+ * clock the mock driver sets up. The pixels read back must be those of a model of the strip, and the SPI bits sent
+ * by a refresh must decode to the LED data bytes of the model.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Standard library functions
+#include <string.h>  // String manipulation functions
+
+#include "led_strip_spi_dev.c" // SPI backend, with its internal pattern
+#include "spi_mock.h"          // SPI mock
+
+#define TEST_PIXELS 150
+#define TEST_OPERATIONS 400
+
+typedef struct
+{
+    led_model_t model;
+    uint32_t source_hz; // SPI source clock, the backend selects its pattern from the clock it gets
+    uint8_t bits_per_bit;
+    uint8_t t0h_bits;
+    uint8_t t1h_bits;
+} test_pattern_t;
+
+static const test_pattern_t Patterns[] = {
+    {LED_MODEL_WS2812, 80000000, 3, 1, 2},
+    {LED_MODEL_SK6812, 4000000, 4, 1, 2},
+    {LED_MODEL_SK6812, 5000000, 5, 1, 3},
+    {LED_MODEL_WS2812, 4000000, 5, 2, 3},
+    {LED_MODEL_WS2812, 6000000, 7, 2, 5},
+};
+
+static uint8_t model[TEST_PIXELS][4]; // Red, green, blue and white of each pixel
+
+// Function to decode the LED data bytes of the SPI bits sent: an LED bit is high if the SPI bit after the high time of
+// a 0 is still high
+static void decode_sent(const test_pattern_t *pattern, size_t bytes, uint8_t *data)
+{
+    memset(data, 0, bytes);
+    for (size_t bit = 0; bit < bytes * 8; bit++)
+    {
+        size_t spiBit = bit * pattern->bits_per_bit + pattern->t0h_bits;
+        if (spi_mock_bytes[spiBit / 8] & (0x80 >> (spiBit % 8)))
+        {
+            data[bit / 8] |= 0x80 >> (bit % 8);
+        }
+    }
+}
+
+// Function to run random operations on a strip and check its pixels against the model. Returns the number of
+// wrong checks.
+static int test_strip(const test_pattern_t *pattern, led_pixel_format_t format, bool streaming, int *checks)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = TEST_PIXELS,
+        .led_pixel_format = format,
+        .led_model = pattern->model,
+        .full_refresh_interval = 1,
+    };
+    led_strip_spi_config_t spiConfig = {.flags.with_dma = true, .flags.streaming = streaming};
+    led_strip_handle_t strip;
+    spi_mock_source_hz = pattern->source_hz;
+    ESP_ERROR_CHECK(led_strip_new_spi_device(&stripConfig, &spiConfig, &strip));
+    const led_strip_spi_obj *spiStrip = __containerof(strip, led_strip_spi_obj, base);
+    const led_strip_pixel_format_ops_t *ops = led_strip_pixel_format_get_ops(format);
+    bool rgbw = ops->bytes_per_pixel == 4;
+    int wrong = spiStrip->pattern.bits_per_bit != pattern->bits_per_bit || spiStrip->pattern.t0h_bits != pattern->t0h_bits ||
+                spiStrip->pattern.t1h_bits != pattern->t1h_bits;
+
+    ESP_ERROR_CHECK(led_strip_clear(strip));
+    memset(model, 0, sizeof(model));
+    for (int op = 0; op < TEST_OPERATIONS; op++)
+    {
+        uint32_t offset = rand() % TEST_PIXELS;
+        uint32_t count = 1 + rand() % (TEST_PIXELS - offset);
+        uint8_t color[4] = {rand(), rand(), rand(), rgbw ? rand() : 0};
+        static uint8_t src[TEST_PIXELS * 4];
+        bool srcRgbw = rgbw && rand() % 2;
+        int kind = rand() % 4;
+        switch (kind == 1 && !rgbw ? 0 : kind)
+        {
+        case 0:
+            ESP_ERROR_CHECK(led_strip_set_pixel(strip, offset, color[0], color[1], color[2]));
+            color[3] = 0;
+            count = 1;
+            break;
+        case 1:
+            ESP_ERROR_CHECK(led_strip_set_pixel_rgbw(strip, offset, color[0], color[1], color[2], color[3]));
+            count = 1;
+            break;
+        case 2:
+            for (uint32_t i = 0; i < count * 4; i++)
+            {
+                src[i] = rand();
+            }
+            ESP_ERROR_CHECK(led_strip_set_pixels(strip, offset, src, count, srcRgbw ? LED_STRIP_SRC_FORMAT_RGBW : LED_STRIP_SRC_FORMAT_RGB));
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const uint8_t *pixel = &src[i * (srcRgbw ? 4 : 3)];
+                memcpy(model[offset + i], pixel, 3);
+                model[offset + i][3] = srcRgbw ? pixel[3] : 0;
+            }
+            count = 0;
+            break;
+        default:
+            if (rgbw)
+            {
+                ESP_ERROR_CHECK(led_strip_fill_rgbw(strip, offset, count, color[0], color[1], color[2], color[3]));
+            }
+            else
+            {
+                ESP_ERROR_CHECK(led_strip_fill(strip, offset, count, color[0], color[1], color[2]));
+            }
+            break;
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            memcpy(model[offset + i], color, 4);
+        }
+
+        // read back a random span in a random source layout
+        uint32_t readOffset = rand() % TEST_PIXELS;
+        uint32_t readCount = 1 + rand() % (TEST_PIXELS - readOffset);
+        bool readRgbw = rgbw && rand() % 2;
+        static uint8_t back[TEST_PIXELS * 4];
+        ESP_ERROR_CHECK(led_strip_get_pixels(strip, readOffset, back, readCount, readRgbw ? LED_STRIP_SRC_FORMAT_RGBW : LED_STRIP_SRC_FORMAT_RGB));
+        bool match = true;
+        for (uint32_t i = 0; i < readCount; i++)
+        {
+            match = match && memcmp(&back[i * (readRgbw ? 4 : 3)], model[readOffset + i], readRgbw ? 4 : 3) == 0;
+        }
+        uint8_t red, green, blue;
+        ESP_ERROR_CHECK(led_strip_get_pixel(strip, offset, &red, &green, &blue));
+        match = match && red == model[offset][0] && green == model[offset][1] && blue == model[offset][2];
+
+        // the whole strip is sent at every refresh
+        if (op % 8 == 7)
+        {
+            static uint8_t sent[TEST_PIXELS * 4];
+            static uint8_t expected[TEST_PIXELS * 4];
+            size_t bytes = TEST_PIXELS * ops->bytes_per_pixel;
+            spi_mock_byte_count = 0;
+            ESP_ERROR_CHECK(led_strip_refresh(strip));
+            for (uint32_t i = 0; i < TEST_PIXELS; i++)
+            {
+                ops->set(&expected[i * ops->bytes_per_pixel], model[i][0], model[i][1], model[i][2], model[i][3]);
+            }
+            decode_sent(pattern, bytes, sent);
+            match = match && spi_mock_byte_count == bytes * pattern->bits_per_bit && memcmp(sent, expected, bytes) == 0;
+        }
+        wrong += !match;
+        (*checks)++;
+    }
+
+    uint8_t back[4];
+    wrong += led_strip_get_pixels(strip, TEST_PIXELS, back, 1, LED_STRIP_SRC_FORMAT_RGB) != ESP_ERR_INVALID_ARG;
+    // a 3 bytes strip has no white channel
+    wrong += !rgbw && led_strip_set_pixel_rgbw(strip, 0, 1, 2, 3, 4) != ESP_ERR_INVALID_ARG;
+    wrong += !rgbw && led_strip_get_pixels(strip, 0, back, 1, LED_STRIP_SRC_FORMAT_RGBW) != ESP_ERR_INVALID_ARG;
+    ESP_ERROR_CHECK(led_strip_del(strip));
+    return wrong;
+}
+
+int main(void)
+{
+    static const led_pixel_format_t formats[] = {LED_PIXEL_FORMAT_GRB, LED_PIXEL_FORMAT_GRBW};
+    srand(1);
+    int failed = 0;
+    int cases = 0;
+    int checks = 0;
+    for (size_t p = 0; p < sizeof(Patterns) / sizeof(Patterns[0]); p++)
+    {
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++)
+        {
+            for (int streaming = 0; streaming < 2; streaming++)
+            {
+                int wrong = test_strip(&Patterns[p], formats[f], streaming, &checks);
+                if (wrong)
+                {
+                    printf("FAIL: pattern %d/%d/%d, format %d, streaming %d: %d wrong checks\n", Patterns[p].bits_per_bit,
+                           Patterns[p].t0h_bits, Patterns[p].t1h_bits, formats[f], streaming, wrong);
+                    failed++;
+                }
+                cases++;
+            }
+        }
+    }
+
+    printf("SPI read-back: %d cases, %d checks, %d failed\n", cases, checks, failed);
+    return failed != 0;
+}
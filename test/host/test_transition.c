@@ -0,0 +1,303 @@
+/**
+ * @file test_transition.c
+ * @brief Host test of the transitions of the render module, built for CONFIG_LED_COUNT LEDs (the build sets 300), with
+ * the time of the render task simulated. A 1 s fade of half the strip must stay within 1 level of a linear fade at
+ * each step and end on the exact target, the other LEDs untouched. Random frames with and without transitions, ticks
+ * of the render task on time, late or before a step is due, blackouts, scene stores and recalls are then checked
+ * against a model of linear fades: fades retargeted from where the LED is, fades cancelled by a frame setting the LED
+ * at once, fades stopped by a blackout or a recall. After each step, the frame read back must match the model, the
+ * LEDs not in transition exactly, the frame hash must match the frame, and the transitions must only be allocated
+ * while they run. The render module is built into the test to reach its internal functions, over the RMT backend
+ * with the mock driver.
+ */
+
+#include "render_handler.c" // Render module, with its internal functions
+
+#include "rmt_mock.h"  // RMT mock
+#include "rtos_mock.h" // RTOS mock
+
+#define TEST_STEPS 6000
+#define TEST_FADE_MS 1000
+
+// An LED of the model, fading linearly from a level to its color
+typedef struct
+{
+    struct ledState color; // Color once the fade ended
+    double from[3];        // Levels at the start of the fade
+    uint32_t steps;        // Steps of the fade, 0 if the LED is not in transition
+    uint32_t done;         // Steps of the fade done
+} test_led_t;
+
+static test_led_t model[CONFIG_LED_COUNT];
+static struct ledState modelScenes[CONFIG_LED_SCENE_COUNT][CONFIG_LED_COUNT];
+static bool modelSceneStored[CONFIG_LED_SCENE_COUNT];
+static bool modelActive;       // Transitions allocated
+static int64_t modelSteppedUs; // Time of the last step
+
+// Function to execute a priority command
+static void test_priority(render_priority_type_t type, uint8_t value)
+{
+    const render_priority_cmd_t cmd = {.type = type, .value = value};
+    render_execute_priority(&cmd);
+}
+
+// Function to get the level of a channel of an LED of the model
+static double model_level(const test_led_t *led, int c)
+{
+    double to = (&led->color.red)[c];
+    return led->steps == 0 ? to : led->from[c] + (to - led->from[c]) * led->done / led->steps;
+}
+
+// Function to stop the fades of the model, the LEDs keep the color they show, checked against the model before
+static void model_stop(void)
+{
+    static struct ledState states[CONFIG_LED_COUNT];
+    render_read_led_states(0, states, CONFIG_LED_COUNT);
+    for (int i = 0; i < CONFIG_LED_COUNT; i++)
+    {
+        if (model[i].steps > 0)
+        {
+            model[i].color = states[i];
+            model[i].steps = 0;
+        }
+    }
+    modelActive = false;
+}
+
+// Function to run the transition part of the render task after the time moved on, on the render module and the model
+static void test_tick(int64_t us)
+{
+    rtos_mock_time_us += us;
+    if (transitions != NULL)
+    {
+        int64_t due = (esp_timer_get_time() - transitionSteppedUs) / RENDER_TRANSITION_PERIOD_US;
+        if (due > 0)
+        {
+            transitionSteppedUs += due * RENDER_TRANSITION_PERIOD_US;
+            if (render_transition_step(due > UINT16_MAX ? UINT16_MAX : (uint32_t)due))
+            {
+                render_transition_stop();
+            }
+            render_refresh();
+        }
+    }
+
+    int64_t due = modelActive ? (rtos_mock_time_us - modelSteppedUs) / (1000000 / CONFIG_LED_TRANSITION_FPS) : 0;
+    if (due > 0)
+    {
+        modelSteppedUs += due * (1000000 / CONFIG_LED_TRANSITION_FPS);
+        bool fading = false;
+        for (int i = 0; i < CONFIG_LED_COUNT; i++)
+        {
+            test_led_t *led = &model[i];
+            led->done += due;
+            if (led->done >= led->steps)
+            {
+                led->steps = 0;
+            }
+            fading = fading || led->steps > 0;
+        }
+        modelActive = fading;
+    }
+}
+
+// Function to apply a frame, with a transition if transitionMs is not 0, on the render module and the model
+static void test_apply(render_frame_t *frame, uint32_t transitionMs)
+{
+    frame->transition_ms = transitionMs;
+    if (transitionMs > 0 && !modelActive)
+    {
+        modelActive = true;
+        modelSteppedUs = rtos_mock_time_us;
+    }
+    uint32_t steps = (uint32_t)(transitionMs / (1000.0 / CONFIG_LED_TRANSITION_FPS) + 0.5);
+    steps = steps < 1 ? 1 : steps;
+    for (uint32_t i = 0; i < frame->count; i++)
+    {
+        test_led_t *led = &model[frame->pixels[i].index];
+        if (transitionMs == 0 || (led->steps == 0 && memcmp(&led->color, &frame->pixels[i].color, sizeof(led->color)) == 0))
+        {
+            led->steps = 0;
+        }
+        else
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                led->from[c] = model_level(led, c);
+            }
+            led->steps = steps;
+            led->done = 0;
+        }
+        led->color = frame->pixels[i].color;
+    }
+    render_apply_frame(frame);
+}
+
+// Function to check the frame read back, the frame hash and the allocation of the transitions against the model.
+// Returns true if they match.
+static bool test_check(void)
+{
+    static struct ledState states[CONFIG_LED_COUNT];
+    render_read_led_states(0, states, CONFIG_LED_COUNT);
+    bool match = (transitions != NULL) == modelActive;
+    uint32_t hash = 0;
+    for (int i = 0; i < CONFIG_LED_COUNT; i++)
+    {
+        const test_led_t *led = &model[i];
+        const uint8_t *state = &states[i].red;
+        for (int c = 0; c < 3; c++)
+        {
+            double level = model_level(led, c);
+            match = match && (led->steps > 0 ? fabs(state[c] - level) <= 1 : state[c] == level);
+        }
+        hash += led_state_hash(i, &states[i]);
+    }
+    return match && frameHash == hash;
+}
+
+// Function to fade half the strip for 1 s. Returns true if each step is within 1 level of a linear fade and the fade
+// ends on the exact target.
+static bool test_fade(void)
+{
+    render_frame_t *frame = render_frame_alloc(CONFIG_LED_COUNT);
+    for (int i = 0; i < CONFIG_LED_COUNT; i++)
+    {
+        frame->pixels[i].index = i;
+        frame->pixels[i].color = (struct ledState){(uint8_t)i, 255 - i % 256, i % 2 ? 255 : 0};
+    }
+    frame->count = CONFIG_LED_COUNT;
+    test_apply(frame, 0);
+    bool match = test_check();
+
+    // Each LED of the first half fades to the color of the LED of the second half across the strip
+    for (int i = 0; i < CONFIG_LED_COUNT / 2; i++)
+    {
+        frame->pixels[i].color = frame->pixels[CONFIG_LED_COUNT - 1 - i].color;
+    }
+    frame->count = CONFIG_LED_COUNT / 2;
+    test_apply(frame, TEST_FADE_MS);
+    match = match && test_check() && model[0].steps == TEST_FADE_MS * CONFIG_LED_TRANSITION_FPS / 1000;
+    for (int step = 0; step < TEST_FADE_MS * CONFIG_LED_TRANSITION_FPS / 1000; step++)
+    {
+        test_tick(1000000 / CONFIG_LED_TRANSITION_FPS);
+        match = match && test_check();
+    }
+    match = match && transitions == NULL;
+    free(frame);
+    return match;
+}
+
+// Function to build a frame of random LEDs, in runs of consecutive LEDs or scattered, some of them set twice
+static render_frame_t *test_frame(void)
+{
+    uint32_t count = 1 + rand() % (rand() % 4 ? 16 : CONFIG_LED_COUNT);
+    render_frame_t *frame = render_frame_alloc(count);
+    uint16_t index = rand() % CONFIG_LED_COUNT;
+    bool run = rand() % 2;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        render_pixel_t *pixel = &frame->pixels[i];
+        index = run ? (index + 1) % CONFIG_LED_COUNT : rand() % CONFIG_LED_COUNT;
+        pixel->index = index;
+        pixel->color.red = rand();
+        pixel->color.green = rand() % 8 ? rand() : 0;
+        pixel->color.blue = rand();
+    }
+    frame->count = count;
+    return frame;
+}
+
+// Function to run random steps. Returns the number of steps after which the render module and the model differ.
+static int test_steps(int *steps)
+{
+    const int64_t period = 1000000 / CONFIG_LED_TRANSITION_FPS;
+    int wrong = 0;
+    for (int step = 0; step < TEST_STEPS; step++)
+    {
+        int kind = rand() % 100;
+        uint8_t slot = rand() % CONFIG_LED_SCENE_COUNT;
+        if (kind < 25)
+        {
+            // Fades from a single step, shorter than a period, to a few seconds
+            render_frame_t *frame = test_frame();
+            test_apply(frame, rand() % 4 ? 1 + rand() % 3000 : 1 + rand() % 15);
+            free(frame);
+        }
+        else if (kind < 35)
+        {
+            render_frame_t *frame = test_frame();
+            test_apply(frame, 0);
+            free(frame);
+        }
+        else if (kind < 60)
+        {
+            test_tick(period);
+        }
+        else if (kind < 75)
+        {
+            test_tick(rand() % period);
+        }
+        else if (kind < 85)
+        {
+            // Late, several steps at once
+            test_tick((2 + rand() % 20) * period + rand() % period);
+        }
+        else if (kind < 88)
+        {
+            test_priority(RENDER_PRIORITY_BLACKOUT, 0);
+            modelActive = false;
+            memset(model, 0, sizeof(model));
+        }
+        else if (kind < 94)
+        {
+            // The scene takes the LEDs in transition as they show now
+            test_priority(RENDER_PRIORITY_SCENE_STORE, slot);
+            render_read_led_states(0, modelScenes[slot], CONFIG_LED_COUNT);
+            modelSceneStored[slot] = true;
+        }
+        else
+        {
+            model_stop();
+            test_priority(RENDER_PRIORITY_SCENE_RECALL, slot);
+            for (int i = 0; i < CONFIG_LED_COUNT && modelSceneStored[slot]; i++)
+            {
+                model[i].color = modelScenes[slot][i];
+            }
+        }
+        wrong += !test_check();
+        (*steps)++;
+    }
+    return wrong;
+}
+
+int main(void)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = CONFIG_LED_COUNT,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+    };
+    led_strip_rmt_config_t rmtConfig = {0};
+    led_strip_handle_t strip;
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfig, &strip));
+    ESP_ERROR_CHECK(led_strip_clear(strip));
+    render_start(strip);
+    srand(1);
+
+    int failed = 0;
+    int steps = 0;
+    if (!test_fade())
+    {
+        printf("FAIL: the fade of 1 s\n");
+        failed++;
+    }
+    int wrong = test_steps(&steps);
+    if (wrong)
+    {
+        printf("FAIL: %d wrong steps\n", wrong);
+        failed++;
+    }
+
+    printf("Transitions: %d steps, %d failed\n", steps, failed);
+    return failed != 0;
+}
@@ -0,0 +1,228 @@
+/**
+ * @file test_white_extraction.c
+ * @brief Host test of the white extraction of RGBW pixels against a reference model: the white LED takes the highest
+ * level whose light fits in the three colors and in what the white channel has left, and its light is removed from the
+ * colors. The kernels are checked through the pixel lookup table of the backends, with and without a color lookup
+ * table, then end to end through the RMT backend with and without the symbol cache.
+ */
+
+#include <stdio.h>   // Standard input/output functions
+#include <stdint.h>  // Standard integer types
+#include <stdbool.h> // Boolean type
+#include <stdlib.h>  // Standard library functions
+#include <string.h>  // String manipulation functions
+#include <math.h>    // Math functions
+
+#include "rmt_mock.h"          // RMT mock
+#include "led_strip.h"         // LED strip library
+#include "led_strip_pixels.h"  // LED strip pixel formats
+
+#define TEST_PIXELS 97
+#define TEST_FRAMES 120
+
+static const uint8_t WhiteColors[][3] = {{255, 255, 255}, {255, 200, 140}, {255, 0, 255}, {40, 40, 40}, {250, 181, 97}};
+static led_strip_color_lut_t colorLut;
+static rmt_symbol_word_t expected[RMT_MOCK_MAX_SYMBOLS];
+
+// Function to extract the white of an RGBW color, after the color lookup table if any
+static void reference_white(const uint8_t rgbw[4], const uint8_t whiteRgb[3], bool useLut, uint8_t out[4])
+{
+    int mapped[4];
+    for (int c = 0; c < 4; c++)
+    {
+        mapped[c] = useLut ? colorLut.channel[c][rgbw[c]] : rgbw[c];
+    }
+    int level = 255 - mapped[3];
+    for (int c = 0; c < 3; c++)
+    {
+        if (whiteRgb[c])
+        {
+            int fits = (int)floor(mapped[c] * 255.0 / whiteRgb[c] + 1e-9);
+            level = fits < level ? fits : level;
+        }
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        out[c] = mapped[c] - (int)floor(level * whiteRgb[c] / 255.0 + 0.5);
+    }
+    out[3] = mapped[3] + level;
+}
+
+// Function to get a random level, half of them near full level where the white channel saturates
+static uint8_t random_level(void)
+{
+    return rand() % 2 ? (uint8_t)rand() : 200 + rand() % 56;
+}
+
+// Function to test the extraction kernel of a pixel format through the pixel lookup table. Returns the number of
+// wrong pixels.
+static int test_kernel(led_pixel_format_t format, const uint8_t whiteRgb[3], bool useLut)
+{
+    const led_strip_pixel_format_ops_t *ops = led_strip_pixel_format_get_ops(format);
+    led_strip_white_lut_t whiteLut;
+    led_strip_white_lut_init(&whiteLut, whiteRgb);
+    led_strip_pixel_lut_t pixelLut;
+    led_strip_pixel_lut_init(&pixelLut, ops, useLut ? &colorLut : NULL, &whiteLut);
+
+    uint8_t src[TEST_PIXELS * 4];
+    uint8_t dst[TEST_PIXELS * 4];
+    uint8_t rgbw[TEST_PIXELS][4];
+    int wrong = 0;
+    for (int round = 0; round < 200; round++)
+    {
+        for (int i = 0; i < TEST_PIXELS; i++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                rgbw[i][c] = random_level();
+            }
+            ops->set(&src[i * 4], rgbw[i][0], rgbw[i][1], rgbw[i][2], rgbw[i][3]);
+        }
+        led_strip_pixel_lut_map(&pixelLut, dst, src, sizeof(src), 0);
+        for (int i = 0; i < TEST_PIXELS; i++)
+        {
+            uint8_t out[4];
+            uint8_t pixel[4];
+            reference_white(rgbw[i], whiteRgb, useLut, out);
+            ops->set(pixel, out[0], out[1], out[2], out[3]);
+            wrong += memcmp(&dst[i * 4], pixel, 4) != 0;
+        }
+    }
+    return wrong;
+}
+
+// Function to test the white extraction of the RMT backend: a strip with the white table and a strip set to the
+// output of the reference must send the same symbols, and the first one must read back the colors as set. Returns
+// the number of wrong frames.
+static int test_rmt(led_pixel_format_t format, const uint8_t whiteRgb[3], bool symbolCache)
+{
+    led_strip_config_t stripConfig = {
+        .max_leds = TEST_PIXELS,
+        .led_pixel_format = format,
+        .led_model = LED_MODEL_SK6812,
+        .full_refresh_interval = 5,
+    };
+    led_strip_rmt_config_t rmtConfig = {.flags.symbol_cache = symbolCache};
+    led_strip_handle_t extracted;
+    led_strip_handle_t reference;
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfig, &extracted));
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfig, &reference));
+    led_strip_white_lut_t whiteLut;
+    led_strip_white_lut_init(&whiteLut, whiteRgb);
+
+    static uint8_t set[TEST_PIXELS][4];
+    memset(set, 0, sizeof(set));
+    int wrong = 0;
+    for (int frame = 0; frame < TEST_FRAMES; frame++)
+    {
+        // the white table alone, with the color table, the color table alone, then both again
+        if (frame == 0 || frame == 90)
+        {
+            ESP_ERROR_CHECK(led_strip_set_white_lut(extracted, &whiteLut));
+        }
+        if (frame == 30)
+        {
+            ESP_ERROR_CHECK(led_strip_set_color_lut(extracted, &colorLut));
+        }
+        if (frame == 60)
+        {
+            ESP_ERROR_CHECK(led_strip_set_white_lut(extracted, NULL));
+        }
+        bool useLut = frame >= 30;
+        bool useWhite = frame < 60 || frame >= 90;
+
+        int writes = rand() % 30;
+        for (int w = 0; w < writes; w++)
+        {
+            uint32_t i = rand() % TEST_PIXELS;
+            for (int c = 0; c < 4; c++)
+            {
+                set[i][c] = random_level();
+            }
+            ESP_ERROR_CHECK(led_strip_set_pixel_rgbw(extracted, i, set[i][0], set[i][1], set[i][2], set[i][3]));
+        }
+        for (uint32_t i = 0; i < TEST_PIXELS; i++)
+        {
+            uint8_t out[4];
+            if (useWhite)
+            {
+                reference_white(set[i], whiteRgb, useLut, out);
+            }
+            else
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    out[c] = useLut ? colorLut.channel[c][set[i][c]] : set[i][c];
+                }
+            }
+            ESP_ERROR_CHECK(led_strip_set_pixel_rgbw(reference, i, out[0], out[1], out[2], out[3]));
+        }
+
+        // the extracted strip only sends the pixels up to the last one changed, the reference sends them all
+        ESP_ERROR_CHECK(led_strip_refresh(extracted));
+        size_t count = rmt_mock_symbol_count;
+        memcpy(expected, rmt_mock_symbols, count * sizeof(rmt_symbol_word_t));
+        ESP_ERROR_CHECK(led_strip_refresh(reference));
+        bool match = count <= rmt_mock_symbol_count &&
+                     (count == 0 || memcmp(expected, rmt_mock_symbols, (count - 1) * sizeof(rmt_symbol_word_t)) == 0);
+
+        uint8_t back[TEST_PIXELS * 4];
+        ESP_ERROR_CHECK(led_strip_get_pixels(extracted, 0, back, TEST_PIXELS, LED_STRIP_SRC_FORMAT_RGBW));
+        match = match && memcmp(back, set, sizeof(back)) == 0;
+        wrong += !match;
+    }
+    ESP_ERROR_CHECK(led_strip_del(extracted));
+    ESP_ERROR_CHECK(led_strip_del(reference));
+    return wrong;
+}
+
+int main(void)
+{
+    static const led_pixel_format_t formats[] = {LED_PIXEL_FORMAT_GRBW, LED_PIXEL_FORMAT_RGBW};
+    srand(1);
+    for (int c = 0; c < 4; c++)
+    {
+        for (int v = 0; v < 256; v++)
+        {
+            colorLut.channel[c][v] = (uint8_t)(v * (7 + c * 13) + c * 31);
+        }
+    }
+
+    int failed = 0;
+    int cases = 0;
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++)
+    {
+        for (size_t w = 0; w < sizeof(WhiteColors) / sizeof(WhiteColors[0]); w++)
+        {
+            for (int variant = 0; variant < 2; variant++)
+            {
+                int wrong = test_kernel(formats[f], WhiteColors[w], variant);
+                if (wrong)
+                {
+                    printf("FAIL: kernel, format %d, white %zu, color table %d: %d wrong pixels\n", formats[f], w, variant, wrong);
+                    failed++;
+                }
+                wrong = test_rmt(formats[f], WhiteColors[w], variant);
+                if (wrong)
+                {
+                    printf("FAIL: RMT, format %d, white %zu, symbol cache %d: %d wrong frames\n", formats[f], w, variant, wrong);
+                    failed++;
+                }
+                cases += 2;
+            }
+        }
+    }
+
+    // the 3 bytes formats have no white channel to extract to
+    led_strip_config_t stripConfig = {.max_leds = TEST_PIXELS, .led_pixel_format = LED_PIXEL_FORMAT_GRB};
+    led_strip_rmt_config_t rmtConfig = {0};
+    led_strip_handle_t strip;
+    led_strip_white_lut_t whiteLut;
+    led_strip_white_lut_init(&whiteLut, WhiteColors[0]);
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&stripConfig, &rmtConfig, &strip));
+    failed += led_strip_set_white_lut(strip, &whiteLut) != ESP_ERR_INVALID_ARG;
+    ESP_ERROR_CHECK(led_strip_del(strip));
+
+    printf("White extraction: %d cases, %d failed\n", cases + 1, failed);
+    return failed != 0;
+}